@@ -1,14 +1,14 @@
-// stdafx.h : include file for standard system include files,
-// or project specific include files that are used frequently, but
-// are changed infrequently
-//
-
-#pragma once
-
-#include <stdio.h>
-#include <tchar.h>
-#include <windows.h>
-#include <inttypes.h>
-extern "C" {
-    #include <ganxo.h>
-}
+// stdafx.h : include file for standard system include files,
+// or project specific include files that are used frequently, but
+// are changed infrequently
+//
+
+#pragma once
+
+#include <stdio.h>
+#include <tchar.h>
+#include <windows.h>
+#include <inttypes.h>
+extern "C" {
+    #include <ganxo.h>
+}
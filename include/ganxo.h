@@ -1,491 +1,1206 @@
-#ifndef __GANXO_INC__
-#define __GANXO_INC__
-
-/*
-
-Ganxo - An opensource API hooking framework by Elias Bachaalany - < elias at passingtheknowledge.net >
-
-*/
-
-#include <stdint.h>
-#include <stdbool.h>
-
-/*! \file ganxo.h
-    \brief Ganxo library header file.
-           It contains all the support public APIs and data structures
-*/
-
-
-//--------------------------------------------------------------------------
-// Architecture and platform definitions
-
-//
-// Architecture specific macros
-#if defined(GANXO_ARCH_X86)
-    #define GANXO_MAX_INSTR_SIZE 15
-#elif defined(GANXO_ARCH_X64)
-    #define GANXO_MAX_INSTR_SIZE 15
-#else
-    #error No architecture defined for Ganxo. Please specify either GANXO_ARCH_X86 or GANXO_ARCH_X64
-#endif
-
-//
-// Verify that a platform was selected
-#if !defined (GANXO_PLATFORM_WINDOWS)
-    #error No platform defined for Ganxo. Please specify GANXO_PLATFORM_WINDOWS
-#endif
-
-//
-// Compiler specifics
-//
-// Calling convention and exported functions
-#ifdef _MSC_VER
-    #define GANXO_API __cdecl
-    #ifdef GANXO_LIBRARY
-        #define GANXO_EXPORT __declspec(dllexport)
-    #else
-        #define GANXO_EXPORT
-    #endif
-#endif
-
-//--------------------------------------------------------------------------
-// Types and macros
-//--------------------------------------------------------------------------
-
-/// Ganxo opaque handle
-typedef struct __gnx_handle_t { int __dummy; } *gnx_handle_t;
-
-/// Invalid Ganxo handle value
-#define GNX_INVALID_HANDLE ((gnx_handle_t)NULL)
-
-/// Tests if all flags are set
-#define GNX_HAVE_FLAGS(val, fl) ((val & (fl)) == (fl))
-
-/// Tests if a single flag is set
-#define GNX_HAS_FLAG(val, fl) ((val & (fl)) != 0)
-
-/// Round up division
-#define GNX_ROUND_UP_DIV(m, n) ( ((m) + (n) - 1) / (n) )
-
-/// Align up
-#define GNX_ALIGN_UP(val, aln) ( ((val) + ((aln)-1)) & ~((aln)-1) )
-
-/// Returns the parent structure address given an address of a member
-/// \note This is very similar to NT's CONTAINING_RECORD
-#define GNX_CONTAINING_RECORD(ptr, type, member) \
-    (type *)((char *)(ptr) - offsetof(type, member))
-
-/// Ganxo virtual memory flags
-typedef enum __gnx_mem_flags_t
-{
-    GNX_MEM_NONE    = 0x00000000,   ///< No memory access
-    GNX_MEM_READ    = 0x00000001,   ///< Read flag is always present
-    GNX_MEM_WRITE   = 0x00000002,   ///< Write
-    GNX_MEM_EXEC    = 0x00000004,   ///< Executable
-
-    GNX_MEM_RWX     = GNX_MEM_READ | GNX_MEM_WRITE | GNX_MEM_EXEC, ///< Read/Write/Execute
-} gnx_mem_flags_t;
-
-/// Ganxo error codes
-typedef enum __gnx_error_t
-{
-    GNX_ERR_OK = 0,                             ///< Success
-    GNX_ERR_FAILED,                             ///< Unspecified failure
-    GNX_ERR_NO_MEM,                             ///< Not enough memory
-    GNX_ERR_INVALID_ARGS,                       ///< Invalid arguments or flags
-    GNX_ERR_NOT_SUPPORTED,                      /*!< Operation not supported. Usually due to third part libraries (ex: Capstone not 
-                                                     having the desired architecture compiled in). */
-    GNX_ERR_DISASM,                             ///< Disassembler error
-    GNX_ERR_INST_COPY,                          /*!< Don't know how to copy instruction. The instruction
-                                                     could be not relocatable or supported. */
-    GNX_ERR_PARTIAL,                            ///< Operation succeeded only partially
-    GNX_ERR_BUFFER_TOO_SMALL,                   ///< The destination buffer is too small.
-    GNX_ERR_FUNCTION_TOO_SMALL,                 ///< Function is too small to be copied and replaced with a springboard.
-    GNX_ERR_NOT_IMPLEMENTED                     ///< Functionality not implemented
-} gnx_err_t;
-
-//--------------------------------------------------------------------------
-// Platform independent APIs (Memory functions, etc.)
-//--------------------------------------------------------------------------
-
-/// \name Platform independent functions prototypes
-/// @{
-typedef void *(GANXO_API *gnx_malloc_proto)(size_t size);
-typedef void  (GANXO_API *gnx_mfree_proto)(void *block);
-
-typedef void *(GANXO_API *gnx_vmalloc_proto)(
-    size_t size,
-    gnx_mem_flags_t flags);
-
-typedef gnx_err_t (GANXO_API *gnx_vmfree_proto)(void *block);
-
-typedef gnx_err_t (GANXO_API *gnx_vmprotect_proto)(
-    const void *block,
-    size_t size,
-    gnx_mem_flags_t flags,
-    gnx_mem_flags_t *old_flags ///< Optional. Contains the old protection value
-    );
-
-typedef gnx_err_t (GANXO_API *gnx_flush_instruction_cache_proto)(
-    void *proc,             ///< Reserved. Pass NULL
-    const void *address,    ///< Address
-    size_t size             ///< Flush size
-    );
-/// @}
-
-/// Platform independent APIs structure
-typedef struct __gnx_platform_apis_t
-{
-    ///< Platform structure size. (Used to identify versions)
-    uint32_t cb;
-
-    ///< Memory allocate
-    gnx_malloc_proto    malloc;
-
-    ///< Memory free
-    gnx_mfree_proto     mfree;
-
-    ///< Virtual memory allocation
-    /// \return The returned memory block is OS/architecture page aligned.
-    gnx_vmalloc_proto   vmalloc;
-
-    ///< Change virtual memory protection
-    gnx_vmprotect_proto vmprotect;
-
-    ///< Virtual memory free
-    gnx_vmfree_proto    vmfree;
-
-    ///< Flush instruction cache
-    gnx_flush_instruction_cache_proto flush_instruction_cache;
-
-} gnx_platform_apis_t;
-
-/// Ganxo malloc() a type (ala C++'s new operator)
-#define GNX_ALLOC(type) ((type *)gnx_malloc(sizeof(type)))
-
-/// Ganxo mfree() a type (ala C++'s delete operator)
-#define GNX_FREE(ptr) gnx_mfree((void *)(ptr))
-
-/// Allocate memory
-GANXO_EXPORT void *GANXO_API gnx_malloc(size_t size);
-
-/// Free memory
-GANXO_EXPORT void GANXO_API gnx_mfree(void *block);
-
-/// Virtual alloc
-GANXO_EXPORT void *GANXO_API gnx_vmalloc(
-    size_t size, 
-    gnx_mem_flags_t flags); 
-
-/// Change virtual memory protection
-/// \param flags New protection value
-/// \param old_flags Optional out parameter to hold the previous protection value
-GANXO_EXPORT gnx_err_t GANXO_API gnx_vmprotect(
-    const void *block,
-    size_t size,
-    gnx_mem_flags_t flags,
-    gnx_mem_flags_t *old_flags);
-
-/// Virtual free
-GANXO_EXPORT gnx_err_t GANXO_API gnx_vmfree(void *block);
-
-/// Flush instruction cache
-/// \param proc Process identification object (pass NULL)
-/// \param address Address to flush
-/// \param Size Size
-GANXO_EXPORT gnx_err_t GANXO_API gnx_flush_instruction_cache(
-    void *proc,
-    const void *address,
-    size_t size);
-
-//--------------------------------------------------------------------------
-// Ganxo functions
-//--------------------------------------------------------------------------
-
-/// Initialize the Ganxo library.
-/// \note: Must be called before any other APIs.
-GANXO_EXPORT gnx_err_t GANXO_API gnx_init(void);
-
-
-/// Set platform APIs
-/// You may call this function many times to update/switch the platform apis.
-/// This is not a thread safe function.
-/// \param apis Platform APIs pointers. If any function pointer that is set to NULL will
-///             the system default API will be used. A copy of the passed parameters will be
-///             stored in the Ganxo library.
-GANXO_EXPORT gnx_err_t GANXO_API gnx_set_platform_apis(gnx_platform_apis_t *apis);
-
-
-/// Create a new Ganxo workspace
-GANXO_EXPORT gnx_err_t GANXO_API gnx_open(gnx_handle_t *handle);
-
-
-/// Free a workspace
-GANXO_EXPORT void GANXO_API gnx_close(gnx_handle_t handle);
-
-
-//--------------------------------------------------------------------------
-// Assembler & Disassembler functions
-//--------------------------------------------------------------------------
-
-
-/// Create a disassembler subsystem
-GANXO_EXPORT gnx_handle_t GANXO_API gnx_disasm_create(void);
-
-/// Returns the internal disassembler handler from the Ganxo workspace
-GANXO_EXPORT gnx_handle_t GANXO_API gnx_disasm_from_workspace(gnx_handle_t wks_handle);
-
-/// De-initialize disassembler
-GANXO_EXPORT void GANXO_API gnx_disasm_free(gnx_handle_t dishandle);
-
-
-/// Copy a single instruction and advances the source and destination
-/// pointers accordingly.
-/// \param src The source instruction address
-/// \param dest The destination instruction address. The destination size must be
-///        at least \sa GANXO_MAX_INSTR_SIZE.
-/// \note The copied instruction may not necessarily look like the source one
-///       because relative jumps and calls will be relocated accordingly.
-GANXO_EXPORT gnx_err_t GANXO_API gnx_disasm_copy_instruction(
-    gnx_handle_t dishandle,
-    const void **src,
-    void **dest);
-
-
-/// Skip all unconditional jumps and land in the actual target.
-/// \note This function will not follow indirect branches
-/// \return The actual target of the passed address after all the jumps are skipped.
-GANXO_EXPORT const void *GANXO_API gnx_disasm_skip_jumps(
-    gnx_handle_t dishandle,
-    const void *addr);
-
-
-/// Disassemble a single instruction.
-/// \param src The address to disassemble
-/// \param size Optional output parameter that will contain the instruction size
-/// \note The Disassembled instruction will be remembered as long
-///       as no other instruction has been disassembled and overwritten the result.
-///       For thread safety, create a disassembler instance in each thread (\ref gnx_disasm_create).
-GANXO_EXPORT gnx_err_t GANXO_API gnx_disasm_instruction(
-    gnx_handle_t dishandle,
-    const void *src,
-    size_t *size);
-
-
-/// Checks if a previously disassembled instruction is a call (SysCall and INT included)
-/// \note See \ref gnx_disasm_instruction
-GANXO_EXPORT bool GANXO_API gnx_disasm_is_call(gnx_handle_t handle);
-
-
-/// Checks if a previously disassembled instruction is a branch
-/// \param conditional Returns whether this is a conditional or unconditional branch
-GANXO_EXPORT bool GANXO_API gnx_disasm_is_jump(
-    gnx_handle_t dishandle,
-    bool *conditional);
-
-
-/// Checks if a previously disassembled instruction is a RET (or IRET)
-GANXO_EXPORT bool GANXO_API gnx_disasm_is_ret(gnx_handle_t handle);
-
-
-/// Check if a previously disassembled instruction is used for alignment 
-/// \return Optionally returns the alignment instruction size
-GANXO_EXPORT bool GANXO_API gnx_disasm_is_align(
-    gnx_handle_t handle,
-    size_t *size);
-
-
-/// Generate a relative jump or call instruction.
-/// \param target This argument can be computed using the \sa GNX_DISASM_GET_X86_RELADDR_OPERAND
-/// \param dest In/out argument pointing to the destination buffer that will contain the generated instruction. The destination size must be
-///        at least \sa GANXO_MAX_INSTR_SIZE.
-GANXO_EXPORT gnx_err_t GANXO_API gnx_asm_gen_relbranch(
-    gnx_handle_t dishandle,
-    bool call_or_jmp,
-    const void *target,
-    void **dest);
-
-//--------------------------------------------------------------------------
-// Memory blocks functions
-//--------------------------------------------------------------------------
-
-/// Each block will contain equal number of chunks.
-/// There will be additional bytes taken out of the block size to describe
-//  the block's meta information (free chunk bitmap, etc.)
-typedef struct __gnx_block_options_t
-{
-    size_t block_size;          ///< Total block size. It should be aligned to the size of a page (4kb, etc.)
-    size_t chunk_size;          ///< The chunk size in the block
-    size_t chunk_align;         ///< Chunk alignment
-    gnx_mem_flags_t vmflags;    ///< The mem flags used internally when vmalloc()ing a new block.
-} gnx_block_options_t;
-
-
-/// Opaque block chunk iterator
-typedef struct __gnx_block_chunk_iterator_t
-{
-    char __dummy[sizeof(void *) * 3];
-} gnx_block_chunk_iterator_t;
-
-
-/// Create a new block
-/// A block is very useful for allocating various equal sized chunks using the VM allocation routines.
-/// When a block is full, a new block is automatically created. The returned block handle should be kept 
-// alive during the lifetime of all the blocks and the chunks that are created.
-GANXO_EXPORT gnx_handle_t GANXO_API gnx_block_create(gnx_block_options_t *options);
-
-
-/// Frees all the blocks
-GANXO_EXPORT void GANXO_API gnx_block_free(gnx_handle_t handle);
-
-
-/// Allocates a chunk inside a free block. Previously freed chunks will be recycled without
-/// causing a new memory allocations. If all blocks are full, a new block is automatically allocated.
-GANXO_EXPORT void *GANXO_API gnx_block_chunk_alloc(gnx_handle_t handle);
-
-
-/// Returns a previously allocated chunk to the freed chunks pool.
-/// Note: No memory is reclaimed back to the operating system. A freed chunk
-///       will be recycled for use in a subsequent \sa gnx_block_alloc_chunk call.
-GANXO_EXPORT gnx_err_t GANXO_API gnx_block_chunk_free(
-    gnx_handle_t handle,
-    void *chunk);
-
-
-/// Change the memory protection of all blocks (and their chunks therein)
-/// \note May return \sa GNX_ERR_PARTIAL in case of partial success
-GANXO_EXPORT gnx_err_t GANXO_API gnx_block_protect(
-    gnx_handle_t handle,
-    gnx_mem_flags_t mem_prot);
-
-
-/// Initializes the iterator
-GANXO_EXPORT void GANXO_API gnx_block_chunk_iter_begin(
-    gnx_handle_t handle,
-    gnx_block_chunk_iterator_t *iterator);
-
-
-/// Iterate next
-GANXO_EXPORT bool GANXO_API gnx_block_chunk_iter_next(
-    gnx_block_chunk_iterator_t *iterator,
-    void **chunk);
-
-
-/// Allocate a new chunk of the desired type
-#define GNX_ALLOC_CHUNK(handle, type) \
-        (type *)gnx_block_chunk_alloc(handle)
-
-//--------------------------------------------------------------------------
-// Data structures
-//--------------------------------------------------------------------------
-
-/// Singly list item
-/// Note: Embed it inside a structure or use the \sa GNX_SINGLY_LIST_ITEM_DEFINE macro
-typedef struct __gnx_singly_list_item_t
-{
-    struct __gnx_singly_list_item_t *next;
-} gnx_singly_list_item_t;
-
-/// Macro that is used to declare the singly list entry inside a structure
-/// \note This simply declares a known name for the singly list item.
-///       This will facilitate the use of the other \ref GNX_SINGLY_LIST_ITEM_xxxx macros
-#define GNX_SINGLY_LIST_ITEM_DEFINE \
-    gnx_singly_list_item_t slist_entry
-
-/// \defgroup GNX_SINGLY_LIST_ITEM_xxxx Singly list helper macros
-/// @{
-/// Pushes a structure into the singly linked list
-#define GNX_SINGLY_LIST_ITEM_PUSH(head, pstruct) \
-    gnx_singly_list_push((head), &((pstruct)->slist_entry))
-
-/// Pops a structure from the singly list
-#define GNX_SINGLY_LIST_ITEM_POP(head, type) \
-    ((type *)((char *)gnx_singly_list_pop((head)) - offsetof(type, slist_entry)))
-
-/// Returns the containing record of the singly list entry
-#define GNX_SINGLY_LIST_RECORD(entry, type) \
-    GNX_CONTAINING_RECORD(entry, type, slist_entry)
-
-/// Initializes the singly list
-#define GNX_SINGLY_LIST_DECLARE(head_name) \
-    gnx_singly_list_item_t head_name; \
-    gnx_singly_list_init(&head_name)
-
-/// @}
-
-/// Initializes the list head
-inline void GANXO_API gnx_singly_list_init(
-    gnx_singly_list_item_t *list_head)
-{
-    list_head->next = NULL;
-}
-
-/// Pushes an item to the list head.
-inline void GANXO_API gnx_singly_list_push(
-    gnx_singly_list_item_t *head,
-    gnx_singly_list_item_t *entry)
-{
-    gnx_singly_list_item_t *head_next = head->next;
-    head->next = entry;
-    entry->next = head_next;
-}
-
-
-/// Pops an item from the list head
-inline gnx_singly_list_item_t *GANXO_API gnx_singly_list_pop(
-    gnx_singly_list_item_t *head)
-{
-    gnx_singly_list_item_t *next = head->next;
-    if (next != NULL)
-        head->next = next->next;
-
-    return next;
-}
-
-
-/// Finds and unlinks a list entry
-GANXO_EXPORT bool GANXO_API gnx_singly_list_remove(
-    gnx_singly_list_item_t *head,
-    gnx_singly_list_item_t *entry);
-
-
-//--------------------------------------------------------------------------
-// Transactions and function hooking
-//--------------------------------------------------------------------------
-
-/// Define user function hook params
-#define GNX_ADD_HOOK_PARAMS(pOrig, hook) (void **)&(pOrig), (void *)(hook) 
-
-
-/// Start a transaction
-GANXO_EXPORT gnx_err_t gnx_transaction_begin(
-    gnx_handle_t g,
-    gnx_handle_t *handle);
-
-
-/// Abort a transaction
-GANXO_EXPORT gnx_err_t GANXO_API gnx_transaction_abort(
-    gnx_handle_t handle);
-
-
-/// Commit a transaction
-GANXO_EXPORT gnx_err_t GANXO_API gnx_transaction_commit(
-    gnx_handle_t handle);
-
-
-/// Hook a function hook
-/// \note The hook is not completed until the \sa gnx_transaction_commit or \sa gnx_transaction_abort is called
-/// \retval GNX_ERR_FUNCTION_TOO_SMALL if the function could not be copied
-/// \retval Not_GNX_ERR_OK Any other error value depending on what fails internally
-GANXO_EXPORT gnx_err_t GANXO_API gnx_transaction_add_hook(
-    gnx_handle_t handle,
-    void **psrc,
-    void *hook);
-
-
-/// Add a remove function hook request to the transaction
-GANXO_EXPORT gnx_err_t GANXO_API gnx_transaction_remove_hook(
-    gnx_handle_t handle,
-    void **psrc);
-
-#endif
+#ifndef __GANXO_INC__
+#define __GANXO_INC__
+
+/*
+
+Ganxo - An opensource API hooking framework by Elias Bachaalany - < elias at passingtheknowledge.net >
+
+*/
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/*! \file ganxo.h
+    \brief Ganxo library header file.
+           It contains all the support public APIs and data structures
+*/
+
+
+//--------------------------------------------------------------------------
+// Architecture and platform definitions
+
+//
+// Architecture specific macros
+#if defined(GANXO_ARCH_X86)
+    #define GANXO_MAX_INSTR_SIZE 15
+#elif defined(GANXO_ARCH_X64)
+    #define GANXO_MAX_INSTR_SIZE 15
+#else
+    #error No architecture defined for Ganxo. Please specify either GANXO_ARCH_X86 or GANXO_ARCH_X64
+#endif
+
+/// Biggest leaf function that can be relocated as a whole into its springboard (\ref GNX_OPT_LEAF_RELOC_MAX_SIZE)
+#define GANXO_MAX_LEAF_FUNCTION_SIZE 64
+
+//
+// Verify that a platform was selected
+#if !defined (GANXO_PLATFORM_WINDOWS)
+    #error No platform defined for Ganxo. Please specify GANXO_PLATFORM_WINDOWS
+#endif
+
+//
+// Compiler specifics
+//
+// Calling convention and exported functions
+#ifdef _MSC_VER
+    #define GANXO_API __cdecl
+    #ifdef GANXO_LIBRARY
+        #define GANXO_EXPORT __declspec(dllexport)
+    #else
+        #define GANXO_EXPORT
+    #endif
+#endif
+
+//--------------------------------------------------------------------------
+// Types and macros
+//--------------------------------------------------------------------------
+
+/// Ganxo opaque handle
+typedef struct __gnx_handle_t { int __dummy; } *gnx_handle_t;
+
+/// Invalid Ganxo handle value
+#define GNX_INVALID_HANDLE ((gnx_handle_t)NULL)
+
+/// Tests if all flags are set
+#define GNX_HAVE_FLAGS(val, fl) ((val & (fl)) == (fl))
+
+/// Tests if a single flag is set
+#define GNX_HAS_FLAG(val, fl) ((val & (fl)) != 0)
+
+/// Round up division
+#define GNX_ROUND_UP_DIV(m, n) ( ((m) + (n) - 1) / (n) )
+
+/// Align up
+#define GNX_ALIGN_UP(val, aln) ( ((val) + ((aln)-1)) & ~((aln)-1) )
+
+/// Returns the parent structure address given an address of a member
+/// \note This is very similar to NT's CONTAINING_RECORD
+#define GNX_CONTAINING_RECORD(ptr, type, member) \
+    (type *)((char *)(ptr) - offsetof(type, member))
+
+/// Ganxo virtual memory flags
+typedef enum __gnx_mem_flags_t
+{
+    GNX_MEM_NONE    = 0x00000000,   ///< No memory access
+    GNX_MEM_READ    = 0x00000001,   ///< Read flag is always present
+    GNX_MEM_WRITE   = 0x00000002,   ///< Write
+    GNX_MEM_EXEC    = 0x00000004,   ///< Executable
+
+    GNX_MEM_RWX     = GNX_MEM_READ | GNX_MEM_WRITE | GNX_MEM_EXEC, ///< Read/Write/Execute
+} gnx_mem_flags_t;
+
+/// Ganxo error codes
+typedef enum __gnx_error_t
+{
+    GNX_ERR_OK = 0,                             ///< Success
+    GNX_ERR_FAILED,                             ///< Unspecified failure
+    GNX_ERR_NO_MEM,                             ///< Not enough memory
+    GNX_ERR_INVALID_ARGS,                       ///< Invalid arguments or flags
+    GNX_ERR_NOT_SUPPORTED,                      /*!< Operation not supported. Usually due to third part libraries (ex: Capstone not 
+                                                     having the desired architecture compiled in). */
+    GNX_ERR_DISASM,                             ///< Disassembler error
+    GNX_ERR_INST_COPY,                          /*!< Don't know how to copy instruction. The instruction
+                                                     could be not relocatable or supported. */
+    GNX_ERR_PARTIAL,                            ///< Operation succeeded only partially
+    GNX_ERR_BUFFER_TOO_SMALL,                   ///< The destination buffer is too small.
+    GNX_ERR_FUNCTION_TOO_SMALL,                 ///< Function is too small to be copied and replaced with a springboard.
+    GNX_ERR_NOT_IMPLEMENTED,                    ///< Functionality not implemented
+    GNX_ERR_NOT_FOUND                           ///< The module or the symbol was not found
+} gnx_err_t;
+
+/// Ganxo workspace options (\ref gnx_set_option)
+typedef enum __gnx_option_t
+{
+    GNX_OPT_LEAF_RELOC_MAX_SIZE = 1,            /*!< Short leaf functions (no calls, no indirect branches) up to this size are
+                                                     relocated as a whole into their springboard, so calling the original
+                                                     never jumps back into the hooked function. 0 disables (default);
+                                                     the maximum is \ref GANXO_MAX_LEAF_FUNCTION_SIZE. */
+    GNX_OPT_SPRINGBOARD_CACHE,                  /*!< Non-zero (default) caches the springboard templates so that functions starting
+                                                     with the same instructions (ex: "mov edi, edi; push ebp; mov ebp, esp") are not
+                                                     disassembled and relocated again. 0 disables the cache: the templates already
+                                                     cached are kept until \ref gnx_close and used again once re-enabled. */
+    GNX_OPT_WORKER_THREADS,                     /*!< Count of threads preparing the springboards in \ref gnx_transaction_add_hooks.
+                                                     0 uses one per processor (default), 1 prepares them on the calling thread. */
+    GNX_OPT_COMMIT_MODE,                        ///< How the transactions patch the functions (\ref gnx_commit_mode_t)
+    GNX_OPT_REGISTERED_THREADS_ONLY,            /*!< Non-zero promises that only the threads registered with \ref gnx_thread_register
+                                                     run the hooked functions: the unhooked springboards are freed as soon as the
+                                                     registered threads' epochs allow it, without scanning the threads. 0 (default)
+                                                     also waits for a scan of all the threads to find no reference to them. */
+} gnx_option_t;
+
+/// Transaction commit modes (\ref GNX_OPT_COMMIT_MODE)
+typedef enum __gnx_commit_mode_t
+{
+    GNX_COMMIT_PLAIN = 0,                       ///< Plain writes: the other threads must not run the patched functions (default)
+    GNX_COMMIT_LIVE,                            /*!< The functions may run meanwhile: patches fitting an aligned qword are written
+                                                     atomically, the others are staged with breakpoints whose hits are
+                                                     redirected to the hook (or to the springboard when unhooking). */
+    GNX_COMMIT_STOP_THREADS,                    /*!< All the other threads are suspended while the functions are patched. A thread
+                                                     stopped inside a patched function prologue is moved to the same instruction in
+                                                     the springboard (and back to the function when unhooking). */
+} gnx_commit_mode_t;
+
+/// Workspace statistics (\ref gnx_get_stats)
+typedef struct __gnx_stats_t
+{
+    uint32_t cb;                                ///< Structure size (set by the caller)
+    uint32_t nb_ip_fixups;                      ///< Count of threads moved out of a patched prologue (\ref GNX_COMMIT_STOP_THREADS)
+    uint64_t last_pause_us;                     ///< How long the last commit suspended the other threads, in microseconds
+    uint64_t max_pause_us;                      ///< Longest commit pause, in microseconds
+    uint32_t nb_limbo;                          ///< Count of unhooked springboards not freed yet (\ref gnx_thread_register)
+    uint32_t nb_sb_cache_hits;                  ///< Count of springboard templates taken from the cache (\ref GNX_OPT_SPRINGBOARD_CACHE)
+} gnx_stats_t;
+
+//--------------------------------------------------------------------------
+// Platform independent APIs (Memory functions, etc.)
+//--------------------------------------------------------------------------
+
+/// \name Platform independent functions prototypes
+/// @{
+typedef void *(GANXO_API *gnx_malloc_proto)(size_t size);
+typedef void  (GANXO_API *gnx_mfree_proto)(void *block);
+
+typedef void *(GANXO_API *gnx_vmalloc_proto)(
+    size_t size,
+    gnx_mem_flags_t flags);
+
+typedef gnx_err_t (GANXO_API *gnx_vmfree_proto)(void *block);
+
+typedef gnx_err_t (GANXO_API *gnx_vmprotect_proto)(
+    const void *block,
+    size_t size,
+    gnx_mem_flags_t flags,
+    gnx_mem_flags_t *old_flags ///< Optional. Contains the old protection value
+    );
+
+typedef gnx_err_t (GANXO_API *gnx_flush_instruction_cache_proto)(
+    void *proc,             ///< Reserved. Pass NULL
+    const void *address,    ///< Address
+    size_t size             ///< Flush size
+    );
+/// @}
+
+/// Platform independent APIs structure
+typedef struct __gnx_platform_apis_t
+{
+    ///< Platform structure size. (Used to identify versions)
+    uint32_t cb;
+
+    ///< Memory allocate
+    gnx_malloc_proto    malloc;
+
+    ///< Memory free
+    gnx_mfree_proto     mfree;
+
+    ///< Virtual memory allocation
+    /// \return The returned memory block is OS/architecture page aligned.
+    gnx_vmalloc_proto   vmalloc;
+
+    ///< Change virtual memory protection
+    gnx_vmprotect_proto vmprotect;
+
+    ///< Virtual memory free
+    gnx_vmfree_proto    vmfree;
+
+    ///< Flush instruction cache
+    gnx_flush_instruction_cache_proto flush_instruction_cache;
+
+} gnx_platform_apis_t;
+
+/// Ganxo malloc() a type (ala C++'s new operator)
+#define GNX_ALLOC(type) ((type *)gnx_malloc(sizeof(type)))
+
+/// Ganxo mfree() a type (ala C++'s delete operator)
+#define GNX_FREE(ptr) gnx_mfree((void *)(ptr))
+
+/// Allocate memory
+GANXO_EXPORT void *GANXO_API gnx_malloc(size_t size);
+
+/// Free memory
+GANXO_EXPORT void GANXO_API gnx_mfree(void *block);
+
+/// Virtual alloc
+GANXO_EXPORT void *GANXO_API gnx_vmalloc(
+    size_t size, 
+    gnx_mem_flags_t flags); 
+
+/// Change virtual memory protection
+/// \param flags New protection value
+/// \param old_flags Optional out parameter to hold the previous protection value
+GANXO_EXPORT gnx_err_t GANXO_API gnx_vmprotect(
+    const void *block,
+    size_t size,
+    gnx_mem_flags_t flags,
+    gnx_mem_flags_t *old_flags);
+
+/// Virtual free
+GANXO_EXPORT gnx_err_t GANXO_API gnx_vmfree(void *block);
+
+/// Flush instruction cache
+/// \param proc Process identification object (pass NULL)
+/// \param address Address to flush
+/// \param Size Size
+GANXO_EXPORT gnx_err_t GANXO_API gnx_flush_instruction_cache(
+    void *proc,
+    const void *address,
+    size_t size);
+
+//--------------------------------------------------------------------------
+// Ganxo functions
+//--------------------------------------------------------------------------
+
+/// Initialize the Ganxo library.
+/// \note: Must be called before any other APIs.
+GANXO_EXPORT gnx_err_t GANXO_API gnx_init(void);
+
+
+/// Set platform APIs
+/// You may call this function many times to update/switch the platform apis.
+/// This is not a thread safe function.
+/// \param apis Platform APIs pointers. If any function pointer that is set to NULL will
+///             the system default API will be used. A copy of the passed parameters will be
+///             stored in the Ganxo library.
+GANXO_EXPORT gnx_err_t GANXO_API gnx_set_platform_apis(gnx_platform_apis_t *apis);
+
+
+/// Create a new Ganxo workspace
+GANXO_EXPORT gnx_err_t GANXO_API gnx_open(gnx_handle_t *handle);
+
+
+/// Free a workspace
+/// \note The installed hooks are left in place and jump into freed memory: unhook them first
+///       (\ref gnx_unhook_all, \ref gnx_close_ex)
+GANXO_EXPORT void GANXO_API gnx_close(gnx_handle_t handle);
+
+
+/// Workspace closing flags (\ref gnx_close_ex)
+#define GNX_CLOSE_UNHOOK 0x00000001     ///< Unhook all the installed hooks first (\ref gnx_unhook_all)
+
+/// Free a workspace, unhooking its hooks first when asked to
+/// \return The \ref gnx_unhook_all result. The workspace is freed anyway.
+GANXO_EXPORT gnx_err_t GANXO_API gnx_close_ex(
+    gnx_handle_t handle,
+    uint32_t flags);
+
+
+/// Unhook all the installed hooks of the workspace at once, with a single protection change and a
+/// single instruction cache flush per group of patched pages.
+/// The function pointers passed when hooking get the original functions back (if they still point
+/// to the springboards), and the chained hooks pointers too.
+/// \note Like a plain commit, the other threads must not run the hooked functions meanwhile, and no
+///       transaction may be in progress. The pointers passed when hooking must still be valid.
+/// \retval GNX_ERR_PARTIAL Some pages could not be made writable: their hooks are still installed
+GANXO_EXPORT gnx_err_t GANXO_API gnx_unhook_all(gnx_handle_t handle);
+
+
+/// Set a workspace option
+/// \param option The option to change \ref gnx_option_t
+/// \param value The new option value
+/// \retval GNX_ERR_INVALID_ARGS Unknown option or value out of range
+GANXO_EXPORT gnx_err_t GANXO_API gnx_set_option(
+    gnx_handle_t handle,
+    gnx_option_t option,
+    size_t value);
+
+
+/// Get the workspace statistics
+/// \param stats The 'cb' member must be set to sizeof(gnx_stats_t)
+GANXO_EXPORT gnx_err_t GANXO_API gnx_get_stats(
+    gnx_handle_t handle,
+    gnx_stats_t *stats);
+
+
+/// Resolve the addresses of functions exported by a loaded module, by name.
+/// The export names table is binary searched once per name (no GetProcAddress call, except for
+/// the forwarded exports). The sizes are the distances to the next exported function, within
+/// the function's section: they suit \ref gnx_hook_desc_t::func_size.
+/// \param module Base name of the module (ex: "kernel32.dll")
+/// \param addrs Returns the address of each function, NULL when not exported
+/// \param sizes Returns the size of each function, 0 when unknown (forwarded exports). May be NULL.
+/// \retval GNX_ERR_PARTIAL Some functions are not exported
+/// \retval GNX_ERR_NOT_FOUND The module is not loaded
+GANXO_EXPORT gnx_err_t GANXO_API gnx_resolve_symbols(
+    const char *module,
+    const char **names,
+    size_t nb_names,
+    void **addrs,
+    size_t *sizes);
+
+
+//--------------------------------------------------------------------------
+// Assembler & Disassembler functions
+//--------------------------------------------------------------------------
+
+
+/// Create a disassembler subsystem
+GANXO_EXPORT gnx_handle_t GANXO_API gnx_disasm_create(void);
+
+/// Returns the internal disassembler handler from the Ganxo workspace
+GANXO_EXPORT gnx_handle_t GANXO_API gnx_disasm_from_workspace(gnx_handle_t wks_handle);
+
+/// De-initialize disassembler
+GANXO_EXPORT void GANXO_API gnx_disasm_free(gnx_handle_t dishandle);
+
+
+/// Copy a single instruction and advances the source and destination
+/// pointers accordingly.
+/// \param src The source instruction address
+/// \param dest The destination instruction address. The destination size must be
+///        at least \sa GANXO_MAX_INSTR_SIZE.
+/// \note The copied instruction may not necessarily look like the source one
+///       because relative jumps and calls will be relocated accordingly.
+GANXO_EXPORT gnx_err_t GANXO_API gnx_disasm_copy_instruction(
+    gnx_handle_t dishandle,
+    const void **src,
+    void **dest);
+
+
+/// Skip all unconditional jumps and land in the actual target.
+/// \note This function will not follow indirect branches
+/// \return The actual target of the passed address after all the jumps are skipped.
+GANXO_EXPORT const void *GANXO_API gnx_disasm_skip_jumps(
+    gnx_handle_t dishandle,
+    const void *addr);
+
+
+/// Disassemble a single instruction.
+/// \param src The address to disassemble
+/// \param size Optional output parameter that will contain the instruction size
+/// \note The Disassembled instruction will be remembered as long
+///       as no other instruction has been disassembled and overwritten the result.
+///       For thread safety, create a disassembler instance in each thread (\ref gnx_disasm_create).
+GANXO_EXPORT gnx_err_t GANXO_API gnx_disasm_instruction(
+    gnx_handle_t dishandle,
+    const void *src,
+    size_t *size);
+
+
+/// Checks if a previously disassembled instruction is a call (SysCall and INT included)
+/// \note See \ref gnx_disasm_instruction
+GANXO_EXPORT bool GANXO_API gnx_disasm_is_call(gnx_handle_t handle);
+
+
+/// Checks if a previously disassembled instruction is a branch
+/// \param conditional Returns whether this is a conditional or unconditional branch
+GANXO_EXPORT bool GANXO_API gnx_disasm_is_jump(
+    gnx_handle_t dishandle,
+    bool *conditional);
+
+
+/// Checks if a previously disassembled instruction is a RET (or IRET)
+GANXO_EXPORT bool GANXO_API gnx_disasm_is_ret(gnx_handle_t handle);
+
+
+/// Check if a previously disassembled instruction is used for alignment 
+/// \return Optionally returns the alignment instruction size
+GANXO_EXPORT bool GANXO_API gnx_disasm_is_align(
+    gnx_handle_t handle,
+    size_t *size);
+
+
+/// Generate a relative jump or call instruction.
+/// \param target This argument can be computed using the \sa GNX_DISASM_GET_X86_RELADDR_OPERAND
+/// \param dest In/out argument pointing to the destination buffer that will contain the generated instruction. The destination size must be
+///        at least \sa GANXO_MAX_INSTR_SIZE.
+GANXO_EXPORT gnx_err_t GANXO_API gnx_asm_gen_relbranch(
+    gnx_handle_t dishandle,
+    bool call_or_jmp,
+    const void *target,
+    void **dest);
+
+
+/// Generate an indirect jump through a pointer in memory (jmp [slot]).
+/// \param dest In/out argument pointing to the destination buffer that will contain the generated instruction. The destination size must be
+///        at least \sa GANXO_MAX_INSTR_SIZE.
+GANXO_EXPORT gnx_err_t GANXO_API gnx_asm_gen_indirect_jump(
+    gnx_handle_t dishandle,
+    const void *slot,
+    void **dest);
+
+//--------------------------------------------------------------------------
+// Memory blocks functions
+//--------------------------------------------------------------------------
+
+/// Each block will contain equal number of chunks.
+/// There will be additional bytes taken out of the block size to describe
+//  the block's meta information (free chunk bitmap, etc.)
+typedef struct __gnx_block_options_t
+{
+    size_t block_size;          ///< Total block size. It should be aligned to the size of a page (4kb, etc.)
+    size_t chunk_size;          ///< The chunk size in the block
+    size_t chunk_align;         ///< Chunk alignment
+    gnx_mem_flags_t vmflags;    ///< The mem flags used internally when vmalloc()ing a new block.
+} gnx_block_options_t;
+
+
+/// Opaque block chunk iterator
+typedef struct __gnx_block_chunk_iterator_t
+{
+    char __dummy[sizeof(void *) * 3];
+} gnx_block_chunk_iterator_t;
+
+
+/// Create a new block
+/// A block is very useful for allocating various equal sized chunks using the VM allocation routines.
+/// When a block is full, a new block is automatically created. The returned block handle should be kept 
+// alive during the lifetime of all the blocks and the chunks that are created.
+GANXO_EXPORT gnx_handle_t GANXO_API gnx_block_create(gnx_block_options_t *options);
+
+
+/// Frees all the blocks
+GANXO_EXPORT void GANXO_API gnx_block_free(gnx_handle_t handle);
+
+
+/// Allocates a chunk inside a free block. Previously freed chunks will be recycled without
+/// causing a new memory allocations. If all blocks are full, a new block is automatically allocated.
+GANXO_EXPORT void *GANXO_API gnx_block_chunk_alloc(gnx_handle_t handle);
+
+
+/// Returns a previously allocated chunk to the freed chunks pool.
+/// Note: No memory is reclaimed back to the operating system. A freed chunk
+///       will be recycled for use in a subsequent \sa gnx_block_alloc_chunk call.
+GANXO_EXPORT gnx_err_t GANXO_API gnx_block_chunk_free(
+    gnx_handle_t handle,
+    void *chunk);
+
+
+/// Change the memory protection of all blocks (and their chunks therein)
+/// \note May return \sa GNX_ERR_PARTIAL in case of partial success
+GANXO_EXPORT gnx_err_t GANXO_API gnx_block_protect(
+    gnx_handle_t handle,
+    gnx_mem_flags_t mem_prot);
+
+
+/// Initializes the iterator
+GANXO_EXPORT void GANXO_API gnx_block_chunk_iter_begin(
+    gnx_handle_t handle,
+    gnx_block_chunk_iterator_t *iterator);
+
+
+/// Iterate next
+GANXO_EXPORT bool GANXO_API gnx_block_chunk_iter_next(
+    gnx_block_chunk_iterator_t *iterator,
+    void **chunk);
+
+
+/// Allocate a new chunk of the desired type
+#define GNX_ALLOC_CHUNK(handle, type) \
+        (type *)gnx_block_chunk_alloc(handle)
+
+//--------------------------------------------------------------------------
+// Data structures
+//--------------------------------------------------------------------------
+
+/// Singly list item
+/// Note: Embed it inside a structure or use the \sa GNX_SINGLY_LIST_ITEM_DEFINE macro
+typedef struct __gnx_singly_list_item_t
+{
+    struct __gnx_singly_list_item_t *next;
+} gnx_singly_list_item_t;
+
+/// Macro that is used to declare the singly list entry inside a structure
+/// \note This simply declares a known name for the singly list item.
+///       This will facilitate the use of the other \ref GNX_SINGLY_LIST_ITEM_xxxx macros
+#define GNX_SINGLY_LIST_ITEM_DEFINE \
+    gnx_singly_list_item_t slist_entry
+
+/// \defgroup GNX_SINGLY_LIST_ITEM_xxxx Singly list helper macros
+/// @{
+/// Pushes a structure into the singly linked list
+#define GNX_SINGLY_LIST_ITEM_PUSH(head, pstruct) \
+    gnx_singly_list_push((head), &((pstruct)->slist_entry))
+
+/// Pops a structure from the singly list
+#define GNX_SINGLY_LIST_ITEM_POP(head, type) \
+    ((type *)((char *)gnx_singly_list_pop((head)) - offsetof(type, slist_entry)))
+
+/// Returns the containing record of the singly list entry
+#define GNX_SINGLY_LIST_RECORD(entry, type) \
+    GNX_CONTAINING_RECORD(entry, type, slist_entry)
+
+/// Initializes the singly list
+#define GNX_SINGLY_LIST_DECLARE(head_name) \
+    gnx_singly_list_item_t head_name; \
+    gnx_singly_list_init(&head_name)
+
+/// @}
+
+/// Initializes the list head
+inline void GANXO_API gnx_singly_list_init(
+    gnx_singly_list_item_t *list_head)
+{
+    list_head->next = NULL;
+}
+
+/// Pushes an item to the list head.
+inline void GANXO_API gnx_singly_list_push(
+    gnx_singly_list_item_t *head,
+    gnx_singly_list_item_t *entry)
+{
+    gnx_singly_list_item_t *head_next = head->next;
+    head->next = entry;
+    entry->next = head_next;
+}
+
+
+/// Pops an item from the list head
+inline gnx_singly_list_item_t *GANXO_API gnx_singly_list_pop(
+    gnx_singly_list_item_t *head)
+{
+    gnx_singly_list_item_t *next = head->next;
+    if (next != NULL)
+        head->next = next->next;
+
+    return next;
+}
+
+
+/// Finds and unlinks a list entry
+GANXO_EXPORT bool GANXO_API gnx_singly_list_remove(
+    gnx_singly_list_item_t *head,
+    gnx_singly_list_item_t *entry);
+
+
+/// Address range (\ref gnx_range_map_create)
+typedef struct __gnx_range_t
+{
+    const void *start;
+    size_t size;
+    void *value;        ///< User value
+} gnx_range_t;
+
+
+/// Create an empty map of non-overlapping address ranges.
+/// The lookups are lock-free so they may run from an exception or signal handler. The updates publish a new
+/// sorted copy of the ranges and must be serialized by the caller.
+GANXO_EXPORT gnx_handle_t GANXO_API gnx_range_map_create(void);
+
+
+/// Free a range map
+GANXO_EXPORT void GANXO_API gnx_range_map_free(gnx_handle_t handle);
+
+
+/// Add and remove ranges at once
+/// \param removed Start addresses of the ranges to remove
+/// \retval GNX_ERR_INVALID_ARGS Some ranges would overlap: nothing is changed
+GANXO_EXPORT gnx_err_t GANXO_API gnx_range_map_update(
+    gnx_handle_t handle,
+    const gnx_range_t *added,
+    size_t nb_added,
+    const void * const *removed,
+    size_t nb_removed);
+
+
+/// Find the range containing an address, in O(log n)
+GANXO_EXPORT bool GANXO_API gnx_range_map_find(
+    gnx_handle_t handle,
+    const void *addr,
+    gnx_range_t *range);
+
+
+/// Copy the ranges, sorted by address
+/// \param ranges NULL to count the ranges only
+/// \param max_ranges Size of the ranges array
+/// \return The count of ranges in the map (more than max_ranges if the array is too small)
+GANXO_EXPORT size_t GANXO_API gnx_range_map_copy(
+    gnx_handle_t handle,
+    gnx_range_t *ranges,
+    size_t max_ranges);
+
+
+//--------------------------------------------------------------------------
+// Transactions and function hooking
+//--------------------------------------------------------------------------
+
+/// Define user function hook params
+#define GNX_ADD_HOOK_PARAMS(pOrig, hook) (void **)&(pOrig), (void *)(hook) 
+
+
+/// Start a transaction
+GANXO_EXPORT gnx_err_t gnx_transaction_begin(
+    gnx_handle_t g,
+    gnx_handle_t *handle);
+
+
+/// Abort a transaction: the added hooks are freed (their function pointers get the original functions
+/// back), the hooks to remove are left installed.
+GANXO_EXPORT gnx_err_t GANXO_API gnx_transaction_abort(
+    gnx_handle_t handle);
+
+
+/// Commit a transaction.
+/// The hooks overlapping a hook committed before them (ex: the same function hooked by two transactions
+/// committed concurrently) are not installed: their function pointers get the original function back.
+/// \retval GNX_ERR_PARTIAL Some items failed, or some hooks are installed but could not be indexed
+///         (\ref gnx_hook_find_by_pc does not find them and they cannot be removed)
+GANXO_EXPORT gnx_err_t GANXO_API gnx_transaction_commit(
+    gnx_handle_t handle);
+
+
+/// Result of a transaction item (\ref gnx_transaction_commit_async)
+typedef struct __gnx_commit_result_t
+{
+    void **psrc;                ///< The function pointer the hook was added or removed with
+    bool remove;                ///< The item removes a hook
+    gnx_err_t err;              /*!< GNX_ERR_OK when the function was patched (or restored), GNX_ERR_INVALID_ARGS
+                                     when the hook overlaps one committed before it (the function pointer is restored) */
+} gnx_commit_result_t;
+
+/// Asynchronous commit completion, called on the committer thread
+/// \param err The transaction result, as returned by \ref gnx_transaction_commit
+/// \param results The result of each item (NULL if there was not enough memory to report them)
+typedef void (GANXO_API *gnx_commit_callback_t)(
+    void *ctx,
+    gnx_err_t err,
+    const gnx_commit_result_t *results,
+    size_t nb_results);
+
+/// Commit a transaction on the workspace's committer thread and return right away.
+/// The transactions queued meanwhile are committed together, in order, in a single patching pass.
+/// \param callback Called once the transaction is committed (may be NULL)
+/// \note The transaction handle is not valid anymore once queued. The callback must not close the
+///       workspace; the pending commits are completed when it is closed.
+GANXO_EXPORT gnx_err_t GANXO_API gnx_transaction_commit_async(
+    gnx_handle_t handle,
+    gnx_commit_callback_t callback,
+    void *ctx);
+
+
+/// Return the event signaled each time the committer thread completed asynchronous commits
+/// (an auto-reset event HANDLE on Windows), so a wait loop can be woken up by it.
+/// \return NULL on failure
+GANXO_EXPORT void *GANXO_API gnx_transaction_commit_event(gnx_handle_t handle);
+
+
+/// Hook a function hook
+/// \note The hook is not completed until the \sa gnx_transaction_commit or \sa gnx_transaction_abort is called
+/// \note Several threads may add or remove hooks to the same transaction concurrently.
+///       The commit or the abort must be called once they are all done.
+/// \note A function already hooked keeps its single patch and springboard: the hook joins the
+///       installed one's chain and runs after the hooks installed before it (the previous last hook
+///       now continues to it through its function pointer). The hooks of a chain are removed in any order.
+/// \retval GNX_ERR_FUNCTION_TOO_SMALL if the function could not be copied
+/// \retval GNX_ERR_INVALID_ARGS if the patch would overlap an installed hook or one added to the transaction,
+///         or if the function has a slot hook (see \ref gnx_hook_chain_insert)
+/// \retval Not_GNX_ERR_OK Any other error value depending on what fails internally
+GANXO_EXPORT gnx_err_t GANXO_API gnx_transaction_add_hook(
+    gnx_handle_t handle,
+    void **psrc,
+    void *hook);
+
+
+/// Bulk hook request (\ref gnx_transaction_add_hooks)
+typedef struct __gnx_hook_desc_t
+{
+    void **psrc;        ///< In/out function pointer, as in \ref gnx_transaction_add_hook
+    void *hook;         ///< The hook function
+    size_t func_size;   ///< Optional function size (ex: from the symbols) or 0 if unknown. It bounds the leaf functions relocation.
+} gnx_hook_desc_t;
+
+
+/// Hook many functions at once.
+/// The jumps skipping, disassembly and relocation of the functions are spread over worker
+/// threads (\ref GNX_OPT_WORKER_THREADS), then the hooks are added to the transaction in the
+/// descriptors order.
+/// \param results Optional array receiving the error code of each descriptor
+/// \retval GNX_ERR_PARTIAL Only some functions could be hooked (see the results)
+/// \retval GNX_ERR_FAILED None of the functions could be hooked
+GANXO_EXPORT gnx_err_t GANXO_API gnx_transaction_add_hooks(
+    gnx_handle_t handle,
+    const gnx_hook_desc_t *descs,
+    size_t n,
+    gnx_err_t *results);
+
+
+/// Redirect the import address table slots of a function to a hook.
+/// No code is patched: the slots are written when the transaction is committed, with one protection
+/// change per page of slots and no instruction cache flush. Only the calls going through the imports
+/// of the modules are hooked (not the ones from GetProcAddress pointers nor from the exporting module).
+/// \param module Base name of the importing module (ex: "app.exe"), NULL for all the loaded modules
+/// \param symbol Imported function name, optionally prefixed by the exporting module: "kernel32.dll!Sleep"
+/// \param orig Returns the original function, as found in the first slot
+/// \note To unhook, redirect the slots back to the original function with another transaction.
+///       \ref gnx_unhook_all does not restore them.
+/// \retval GNX_ERR_NOT_FOUND No module imports the function
+GANXO_EXPORT gnx_err_t GANXO_API gnx_transaction_add_iat_hook(
+    gnx_handle_t handle,
+    const char *module,
+    const char *symbol,
+    void *hook,
+    void **orig);
+
+
+/// Also account for the cycles spent in the counted function (\ref gnx_transaction_add_counter_hook)
+#define GNX_COUNT_CYCLES 0x00000001
+
+/// Count of buckets of the cycles histograms: bucket i counts the timed calls that took
+/// less than 16^(i + 1) cycles (and at least 16^i), the last one the longer calls too
+#define GNX_HOOK_HISTOGRAM_SIZE 8
+
+/// Counts of a counter hook (\ref gnx_hook_get_counters)
+typedef struct __gnx_hook_counters_t
+{
+    uint64_t calls;     ///< Calls of the function
+    uint64_t cycles;    ///< Time stamp counter cycles spent in the timed calls (with \ref GNX_COUNT_CYCLES)
+    uint32_t histogram[GNX_HOOK_HISTOGRAM_SIZE]; ///< Timed calls by duration (with \ref GNX_COUNT_CYCLES, registered threads only): their sum is the count of timed calls
+} gnx_hook_counters_t;
+
+/// Count the calls of a function, without any hook function.
+/// The function jumps to a generated stub that counts the call, then runs the original function:
+/// no C code is called. The threads registered with \ref gnx_thread_register count in their own
+/// counters; the other threads count with locked additions and are never timed.
+/// \param flags \ref GNX_COUNT_CYCLES to also bracket the calls with rdtsc (the return address is
+///        replaced while the function runs, so stack walks show the stub's exit instead of the caller)
+/// \param counter Returns the counter handle for \ref gnx_hook_get_counters
+/// \note The counters and their stubs are kept until the workspace is closed, even once unhooked.
+/// \note A timed call left through an exception or a longjmp is not timed.
+/// \retval GNX_ERR_NOT_SUPPORTED Not available on this architecture
+GANXO_EXPORT gnx_err_t GANXO_API gnx_transaction_add_counter_hook(
+    gnx_handle_t handle,
+    void **psrc,
+    uint32_t flags,
+    gnx_handle_t *counter);
+
+
+/// Sum the counts of a counter hook over all the threads.
+/// \note The counts of the running threads are read without stopping them: they may be a few calls behind.
+GANXO_EXPORT gnx_err_t GANXO_API gnx_hook_get_counters(
+    gnx_handle_t handle,
+    gnx_handle_t counter,
+    gnx_hook_counters_t *result);
+
+
+/// Shared counters memory layout (\ref gnx_counters_share)
+#define GNX_SHARED_COUNTERS_MAGIC   0x43584E47 // "GNXC"
+#define GNX_SHARED_COUNTERS_VERSION 1
+
+/// Counter hook description in the shared counters memory
+typedef struct __gnx_shared_hook_t
+{
+    uint64_t address;           ///< Counted function
+    uint32_t rva;               ///< Offset of the function from its module base
+    uint32_t flags;             ///< Counter hook flags (\ref GNX_COUNT_CYCLES)
+    char module[48];            ///< Base name of the function's module, empty if unknown
+} gnx_shared_hook_t;
+
+/// Shared counters memory header. The memory holds the hooks descriptions (\ref gnx_shared_hook_t), then
+/// several counters arrays (\ref gnx_hook_counters_t, indexed like the hooks): the counts of a hook are the
+/// sums of its counters in all the arrays. A reader only relies on the sizes and offsets of the header.
+typedef struct __gnx_shared_counters_t
+{
+    uint32_t magic;             ///< \ref GNX_SHARED_COUNTERS_MAGIC
+    uint32_t version;           ///< \ref GNX_SHARED_COUNTERS_VERSION
+    uint32_t header_size;       ///< sizeof(\ref gnx_shared_counters_t)
+    uint32_t hook_size;         ///< sizeof(\ref gnx_shared_hook_t)
+    uint32_t counter_size;      ///< sizeof(\ref gnx_hook_counters_t)
+    uint32_t max_hooks;         ///< Size of the hooks and counters arrays
+    volatile uint32_t nb_hooks; ///< Hooks described so far
+    uint32_t nb_arrays;         ///< Count of counters arrays
+    uint64_t hooks_ofs;         ///< Offset of the hooks descriptions from the header
+    uint64_t arrays_ofs;        ///< Offset of the first counters array from the header
+    uint64_t arrays_stride;     ///< Distance between two counters arrays
+    volatile uint32_t stats_seq; ///< Odd while the statistics are updated: read them again if it changed meanwhile
+    uint32_t reserved;
+    gnx_stats_t stats;          ///< Workspace statistics as of the last commit
+} gnx_shared_counters_t;
+
+/// Keep the counters of the workspace in a named shared memory, so that another process can map it
+/// read-only and sample the counts at any rate without calling into this process (ex: tools/monitor).
+/// \param name Name of the shared memory (ex: "Local\\ganxo-1234")
+/// \param max_threads Registered threads with their own counters, the next ones are not tracked
+/// \note It must be called before the first counter or trace hook is added.
+/// \note The counts of a thread that unregisters are moved to another array: a sample taken meanwhile may count them twice.
+GANXO_EXPORT gnx_err_t GANXO_API gnx_counters_share(
+    gnx_handle_t handle,
+    const char *name,
+    uint32_t max_threads);
+
+
+/// Sampling of a counter hook that disables it: its stub jumps straight to the original function
+#define GNX_SAMPLING_DISABLED 0
+
+/// Sampling of a counter hook that times all the calls (the default)
+#define GNX_SAMPLING_ALL 1
+
+/// Change the sampling of a counter hook right away, without any transaction.
+/// With a sampling of N, each registered thread only times 1 in N calls (all of them are still counted):
+/// the cycles and the histogram of the counts only cover the timed calls.
+/// \param sampling A power of 2 for the hooks with \ref GNX_COUNT_CYCLES, \ref GNX_SAMPLING_ALL for the
+///        others, or \ref GNX_SAMPLING_DISABLED to stop counting the calls at all
+GANXO_EXPORT gnx_err_t GANXO_API gnx_hook_set_sampling(
+    gnx_handle_t handle,
+    gnx_handle_t counter,
+    uint32_t sampling);
+
+
+/// Called by the overhead governor each time it changes the sampling of a counter hook
+typedef void (GANXO_API *gnx_governor_callback_t)(
+    void *ctx,
+    gnx_handle_t counter,
+    uint32_t old_sampling,
+    uint32_t sampling);
+
+/// Overhead governor options (\ref gnx_governor_start)
+typedef struct __gnx_governor_options_t
+{
+    uint32_t period_ms;         ///< When not zero, a thread checks the overhead at this period (else \ref gnx_governor_check)
+    uint32_t budget_permille;   ///< Instrumentation overhead allowed, in per mille of one processor
+    uint32_t count_cost;        ///< Estimated cycles of a counted call, 0 for \ref GNX_GOVERNOR_COUNT_COST
+    uint32_t timed_cost;        ///< Estimated additional cycles of a timed call, 0 for \ref GNX_GOVERNOR_TIMED_COST
+    uint32_t max_sampling;      ///< Sparsest sampling before disabling a hook (a power of 2), 0 for \ref GNX_GOVERNOR_MAX_SAMPLING
+    gnx_governor_callback_t callback; ///< Optional
+    void *ctx;                  ///< Passed to the callback
+} gnx_governor_options_t;
+
+#define GNX_GOVERNOR_COUNT_COST     10
+#define GNX_GOVERNOR_TIMED_COST     150
+#define GNX_GOVERNOR_MAX_SAMPLING   1024
+
+/// Keep the overhead of the counter hooks within a budget.
+/// At each check, the governor estimates the cost of each hook from its calls and timed calls since
+/// the last check. While the total exceeds the budget, it samples the timed calls of the costliest
+/// hooks more sparsely, then disables the costliest hooks. Once the total falls below half the budget,
+/// it times more calls of the sampled hooks again. The sampling is switched in place
+/// (\ref gnx_hook_set_sampling): no transaction is committed.
+/// \note A disabled hook does not count its calls anymore: only \ref gnx_hook_set_sampling enables it again.
+/// \note The callback is called by the checking thread, without any lock held.
+GANXO_EXPORT gnx_err_t GANXO_API gnx_governor_start(
+    gnx_handle_t handle,
+    const gnx_governor_options_t *options);
+
+
+/// Check the overhead of the counter hooks now and adjust their sampling
+GANXO_EXPORT gnx_err_t GANXO_API gnx_governor_check(gnx_handle_t handle);
+
+
+/// Stop the overhead governor. The hooks keep their current sampling.
+/// \note It waits for the check in progress: do not call it from the governor callback.
+GANXO_EXPORT gnx_err_t GANXO_API gnx_governor_stop(gnx_handle_t handle);
+
+
+/// Called for each code range placed or freed by a workspace (\ref gnx_code_map_start)
+/// \param name Ex: gnx_springboard:kernel32.dll+0x1f3a0
+/// \param removed The range is freed: its address may be reused
+typedef void (GANXO_API *gnx_code_map_callback_t)(
+    void *ctx,
+    const void *start,
+    size_t size,
+    const char *name,
+    bool removed);
+
+/// Code map options (\ref gnx_code_map_start)
+typedef struct __gnx_code_map_options_t
+{
+    const char *path;           ///< perf map file to write, NULL for perf-<pid>.map in the temporary directory, "" for none
+    gnx_code_map_callback_t callback; ///< Optional, ex: to feed a profiler's JIT code API
+    void *ctx;                  ///< Passed to the callback
+} gnx_code_map_options_t;
+
+/// Describe the code placed by the workspace, so that the profilers attribute their samples to the hooks.
+/// Each springboard and stub is written to a file in the perf map format ("<start> <size> <name>" lines, in
+/// hexadecimal) and passed to the callback, named after the hooked function: gnx_springboard:<module>+0x<offset>,
+/// gnx_stub:<module>+0x<offset>, and the shared gnx_*exit_thunk. A freed springboard is written again with a " (freed)" suffix.
+/// \note Only the code placed after this call is described: start the code map before adding the hooks.
+/// \note The callback is called by the hooking thread, with the code map lock held.
+GANXO_EXPORT gnx_err_t GANXO_API gnx_code_map_start(
+    gnx_handle_t handle,
+    const gnx_code_map_options_t *options);
+
+
+/// Stop describing the code placed by the workspace and close the file
+GANXO_EXPORT gnx_err_t GANXO_API gnx_code_map_stop(gnx_handle_t handle);
+
+
+/// Also record the returns of the traced function (\ref gnx_transaction_add_trace_hook)
+#define GNX_TRACE_RETURNS 0x00000001
+
+/// Record the first n (up to 3) stack arguments of the traced function
+#define GNX_TRACE_ARGS(n) ((uint32_t)(n) << 8)
+
+/// Set in the hook identifier of the return records
+#define GNX_TRACE_RETURN_RECORD 0x80000000
+
+/// Trace record: a call (or a return) of a traced function
+typedef struct __gnx_trace_record_t
+{
+    uint32_t hook_id;           ///< Trace hook identifier, with \ref GNX_TRACE_RETURN_RECORD for the returns
+    uint32_t thread_id;         ///< Calling thread
+    uint64_t tsc;               ///< Time stamp counter
+    const void *ret;            ///< Return address (the caller)
+    uint32_t args[3];           ///< First stack arguments (\ref GNX_TRACE_ARGS); for the returns, the returned edx:eax in args[0] and args[1]
+} gnx_trace_record_t;
+
+/// Trace file header, followed by the records
+typedef struct __gnx_trace_file_header_t
+{
+    uint32_t magic;             ///< \ref GNX_TRACE_FILE_MAGIC
+    uint32_t record_size;       ///< sizeof(\ref gnx_trace_record_t)
+    uint64_t nb_records;        ///< Count of records in the file
+    uint64_t nb_dropped;        /*!< Calls not recorded: the thread's ring or the file were full, or the thread was not registered.
+                                     The dropped return records are not counted. */
+} gnx_trace_file_header_t;
+
+#define GNX_TRACE_FILE_MAGIC 0x54584E47 // "GNXT"
+
+/// Record the calls of a function, without any hook function.
+/// The function jumps to a generated stub that appends a record to the calling thread's records ring,
+/// then runs the original function: no C code is called and no lock is taken. Only the threads
+/// registered with \ref gnx_thread_register are traced: the calls of the other ones are counted as dropped.
+/// The rings are copied to the trace file by \ref gnx_trace_drain (or the drain thread of \ref gnx_trace_start).
+/// \param hook_id Identifier of the hook in the records, below \ref GNX_TRACE_RETURN_RECORD
+/// \param flags \ref GNX_TRACE_RETURNS and \ref GNX_TRACE_ARGS
+/// \note The stubs are kept until the workspace is closed, even once unhooked.
+/// \note A registered thread must not unregister while a traced or timed function it called is running.
+/// \retval GNX_ERR_NOT_SUPPORTED Not available on this architecture
+GANXO_EXPORT gnx_err_t GANXO_API gnx_transaction_add_trace_hook(
+    gnx_handle_t handle,
+    void **psrc,
+    uint32_t hook_id,
+    uint32_t flags);
+
+
+/// Hook a function, but only call the hook for the calls matching a filter expression.
+/// The filter is compiled in a stub placed before the hook: the other calls go straight to the original
+/// function without running any C code. The expression compares 32 bits values as unsigned integers:
+///     - the stack arguments arg0 to arg15 (at the function's entry) and the ecx and edx registers,
+///       optionally masked (ex: "(arg1 & 0xFF) == 2" or "arg1 & 0xFF == 2")
+///     - with ==, !=, <, <=, > or >= to decimal or hexadecimal (0x) numbers
+///     - combined with && and || (&& first) and parentheses
+/// Ex: "arg0 == 0x1234 && (arg2 > 4096 || ecx != 0)"
+/// \param psrc Returns the original function, as in \ref gnx_transaction_add_hook
+/// \note The stubs are kept until the workspace is closed, even once unhooked.
+/// \retval GNX_ERR_INVALID_ARGS Syntax error, or more than 8 comparisons
+/// \retval GNX_ERR_NOT_SUPPORTED Not available on this architecture
+GANXO_EXPORT gnx_err_t GANXO_API gnx_transaction_add_filtered_hook(
+    gnx_handle_t handle,
+    void **psrc,
+    void *hook,
+    const char *filter);
+
+
+/// Hook a function for the selected threads only (\ref gnx_hook_thread_enable).
+/// The function jumps to a generated stub that tests the calling thread's enable bit, held in a thread
+/// local slot (a single fs relative load), then jumps to the hook or to the original function: the other
+/// threads run the original function with only that test and branch.
+/// \param psrc Returns the original function, as in \ref gnx_transaction_add_hook
+/// \param thread_hook Returns the handle for \ref gnx_hook_thread_enable
+/// \note A workspace has up to 128 thread-scoped hooks. The stubs and their bits are kept until the workspace is closed.
+/// \retval GNX_ERR_NOT_SUPPORTED Not available on this architecture
+GANXO_EXPORT gnx_err_t GANXO_API gnx_transaction_add_thread_hook(
+    gnx_handle_t handle,
+    void **psrc,
+    void *hook,
+    gnx_handle_t *thread_hook);
+
+
+/// Enable (or disable) a thread-scoped hook for the calling thread. No thread has it enabled at first.
+GANXO_EXPORT gnx_err_t GANXO_API gnx_hook_thread_enable(
+    gnx_handle_t thread_hook,
+    bool enable);
+
+
+/// Recursion guard groups of a workspace (\ref gnx_transaction_add_guarded_hook)
+#define GNX_GUARD_GROUPS 8
+
+/// Hook a function, but route the reentrant calls straight to the original function.
+/// While a thread runs a hook of a guard group, its calls of any hooked function of the same group (made by
+/// the hook itself or by the functions it calls) skip their hooks: the hook bodies need no recursion flag.
+/// The generated stub keeps the calling thread's guard in thread local slots and replaces the return address
+/// while the hook runs (stack walks show the guard's exit instead of the caller).
+/// \param psrc Returns the original function, as in \ref gnx_transaction_add_hook
+/// \param group Guard group, below \ref GNX_GUARD_GROUPS: hooks calling each other (ex: malloc and write) share one
+/// \note A guarded hook left by an exception or a longjmp keeps its group entered for the calls made from deeper
+///       frames only: the first call made from an outer frame enters it again.
+/// \note The stubs are kept until the workspace is closed, even once unhooked.
+/// \retval GNX_ERR_NOT_SUPPORTED Not available on this architecture
+GANXO_EXPORT gnx_err_t GANXO_API gnx_transaction_add_guarded_hook(
+    gnx_handle_t handle,
+    void **psrc,
+    void *hook,
+    uint32_t group);
+
+
+/// Start writing the trace records to a file mapped in memory.
+/// \param max_size Size of the file: once it is full, the records are dropped
+/// \param drain_period_ms When not zero, a thread drains the threads rings at this period
+GANXO_EXPORT gnx_err_t GANXO_API gnx_trace_start(
+    gnx_handle_t handle,
+    const char *path,
+    size_t max_size,
+    uint32_t drain_period_ms);
+
+
+/// Copy the full segments of the threads rings to the trace file.
+/// The traced threads are never blocked: they only stop recording (and drop) while their ring is full.
+GANXO_EXPORT gnx_err_t GANXO_API gnx_trace_drain(gnx_handle_t handle);
+
+
+/// Copy all the remaining records and close the trace file (truncated to its records)
+GANXO_EXPORT gnx_err_t GANXO_API gnx_trace_stop(gnx_handle_t handle);
+
+
+/// Pending hook request (\ref gnx_add_pending_hooks)
+typedef struct __gnx_pending_hook_desc_t
+{
+    const char *module;         ///< Base name of the module exporting the function (ex: "plugin.dll", or "plugin" as for LoadLibrary)
+    const char *symbol;         ///< Exported function name
+    void **psrc;                ///< Returns the original function once hooked, as in \ref gnx_transaction_add_hook
+    void *hook;                 ///< The hook function
+} gnx_pending_hook_desc_t;
+
+/// Hook exported functions as soon as their modules are loaded.
+/// The hooks of the modules already loaded are installed right away. Then, each time a module with
+/// pending hooks is loaded, all its hooks are installed by a single transaction, from the loader
+/// notification. When the module is unloaded, its hooks are forgotten (their function pointers are
+/// set to NULL) and wait for the module to be loaded again.
+/// \note The hooks are installed while the loader lock is held: the hook functions must not be
+///       called with a lock that a loading thread may own.
+/// \retval GNX_ERR_PARTIAL Some hooks were not registered, or some hooks of a loaded module could not be installed
+GANXO_EXPORT gnx_err_t GANXO_API gnx_add_pending_hooks(
+    gnx_handle_t handle,
+    const gnx_pending_hook_desc_t *descs,
+    size_t nb_descs);
+
+
+/// Add a remove function hook request to the transaction
+/// \note Removing a hook that other hooks joined (\ref gnx_transaction_add_hook) does not restore the
+///       function: its patch then jumps to the next hook of the chain. A joined hook is only unlinked.
+/// \retval GNX_ERR_INVALID_ARGS psrc is not the function pointer of a committed hook
+GANXO_EXPORT gnx_err_t GANXO_API gnx_transaction_remove_hook(
+    gnx_handle_t handle,
+    void **psrc);
+
+
+/// Hook a function through a dispatch slot.
+/// The function jumps through a pointer slot kept in a data page (jmp [slot]) instead of jumping
+/// straight to the hook, so that the hook can be switched on and off afterwards with a single atomic
+/// pointer store (\ref gnx_hook_enable, \ref gnx_hook_disable): no memory protection change, no
+/// instruction cache flush and no transaction.
+/// \param enabled The hook state once the transaction is committed
+/// \param hook_handle Returns the hook handle. It is valid until the hook is removed (\ref gnx_transaction_remove_hook).
+/// \note The patch is one byte longer than the \ref gnx_transaction_add_hook one.
+GANXO_EXPORT gnx_err_t GANXO_API gnx_transaction_add_slot_hook(
+    gnx_handle_t handle,
+    void **psrc,
+    void *hook,
+    bool enabled,
+    gnx_handle_t *hook_handle);
+
+
+/// Send the calls of a slot hooked function to its hook (\ref gnx_transaction_add_slot_hook).
+/// \note Threads already past the slot finish their call where they were sent.
+GANXO_EXPORT gnx_err_t GANXO_API gnx_hook_enable(gnx_handle_t hook_handle);
+
+
+/// Send the calls of a slot hooked function to the original function (through its springboard)
+GANXO_EXPORT gnx_err_t GANXO_API gnx_hook_disable(gnx_handle_t hook_handle);
+
+
+/// Chain another hook on a slot hooked function, without touching any code.
+/// The chain starts with the inserted hooks and ends with the slot hook's own hook, each hook
+/// continuing to the next one through its function pointer. So however long the chain, the patched
+/// function still makes a single jump and no springboard is stacked.
+/// \param hook_handle The slot hook (\ref gnx_transaction_add_slot_hook)
+/// \param after The chained hook after which to insert, or NULL to insert the hook first
+/// \param porig Receives where the hook continues (the next hook of the chain): the hook must call through it
+/// \param entry_handle Returns the chained hook handle (\ref gnx_hook_chain_remove)
+/// \note Removing the slot hook removes its chain: the chained hooks function pointers get back the original function.
+GANXO_EXPORT gnx_err_t GANXO_API gnx_hook_chain_insert(
+    gnx_handle_t hook_handle,
+    gnx_handle_t after,
+    void **porig,
+    void *hook,
+    gnx_handle_t *entry_handle);
+
+
+/// Unlink a chained hook (\ref gnx_hook_chain_insert).
+/// The calls already in the hook still continue through its function pointer, which is left unchanged.
+GANXO_EXPORT gnx_err_t GANXO_API gnx_hook_chain_remove(
+    gnx_handle_t hook_handle,
+    gnx_handle_t entry_handle);
+
+
+/// Installed hook information (\ref gnx_hook_find_by_target, \ref gnx_hook_find_by_pc)
+typedef struct __gnx_hook_info_t
+{
+    uint32_t cb;                ///< Structure size (set by the caller)
+    bool in_springboard;        ///< The address is in the springboard, otherwise in the patched function bytes
+    void *func_addr;            ///< The patched function (all the jumps skipped)
+    size_t patch_size;          ///< Count of patched bytes
+    void *springboard;          ///< Calls the original function
+    size_t springboard_size;
+    gnx_handle_t slot_hook;     ///< The slot hook handle (\ref gnx_transaction_add_slot_hook), NULL for a regular hook
+} gnx_hook_info_t;
+
+
+/// Find the committed hook whose patch covers an address.
+/// Lock-free in O(log n): it may be called from an exception or signal handler.
+/// \note A hook being removed concurrently may still be reported.
+GANXO_EXPORT bool GANXO_API gnx_hook_find_by_target(
+    gnx_handle_t handle,
+    const void *target,
+    gnx_hook_info_t *info);
+
+
+/// Find the committed hook whose patch or springboard contains an instruction pointer (ex: a faulting address).
+/// Lock-free in O(log n), as \ref gnx_hook_find_by_target.
+GANXO_EXPORT bool GANXO_API gnx_hook_find_by_pc(
+    gnx_handle_t handle,
+    const void *pc,
+    gnx_hook_info_t *info);
+
+
+/// Register a thread running hooked functions, from a point where it does not run any.
+/// The springboard of an unhooked function is only freed (and reused) once all the registered threads
+/// reported a quiescent point (\ref gnx_thread_quiescent): no thread can still be running it or return into it.
+/// \note While no thread was ever registered in the workspace, the threads are not tracked. While unhooked
+///       springboards wait in limbo, each transaction suspends all the threads and scans their registers and
+///       stacks: a springboard is only freed once no value points into it. A springboard address only kept
+///       elsewhere (ex: a copy of the original function pointer in a global) is not seen: the unhooked
+///       function must not be called through such copies.
+/// \note Once a thread registered, the unregistered threads are still scanned: a springboard is freed once the
+///       registered threads' epochs passed it and no thread references it. When all the threads running hooked
+///       functions are registered, \ref GNX_OPT_REGISTERED_THREADS_ONLY skips the scans.
+GANXO_EXPORT gnx_err_t GANXO_API gnx_thread_register(
+    gnx_handle_t handle,
+    gnx_handle_t *thread_handle);
+
+
+/// Report that the calling registered thread does not run any hooked function (ex: between two requests).
+/// It is a single load and store: call it often. An idle thread must be unregistered, otherwise the unhooked
+/// springboards are never freed.
+GANXO_EXPORT void GANXO_API gnx_thread_quiescent(gnx_handle_t thread_handle);
+
+
+/// Unregister a thread (\ref gnx_thread_register)
+GANXO_EXPORT void GANXO_API gnx_thread_unregister(gnx_handle_t thread_handle);
+
+//--------------------------------------------------------------------------
+// Hook plans
+//--------------------------------------------------------------------------
+
+/// Export the installed hooks of a workspace as a plan file.
+/// For each hooked function, keyed by its module build identifier and offset, the plan remembers
+/// where its jumps lead to and its relocated springboard so they are not computed again by
+/// the next process (\ref gnx_plan_load).
+/// \note Leaf functions relocated as a whole (\ref GNX_OPT_LEAF_RELOC_MAX_SIZE) and functions
+///       outside of any module are not planned.
+GANXO_EXPORT gnx_err_t GANXO_API gnx_plan_export(
+    gnx_handle_t handle,
+    const char *path);
+
+
+/// Map a plan file written by \ref gnx_plan_export and use it in the subsequent \ref gnx_transaction_add_hook calls.
+/// A planned function skips the disassembly when its module build identifier and its first bytes match the plan,
+/// otherwise it is analyzed as usual.
+/// \note Only the modules loaded at the time of this call are matched. Loading a new plan replaces the previous one.
+/// \retval GNX_ERR_INVALID_ARGS The file is not a valid plan for this Ganxo build
+GANXO_EXPORT gnx_err_t GANXO_API gnx_plan_load(
+    gnx_handle_t handle,
+    const char *path);
+
+
+/// Unmap the plan loaded in the workspace, if any
+GANXO_EXPORT void GANXO_API gnx_plan_unload(gnx_handle_t handle);
+
+#endif
@@ -0,0 +1,186 @@
+#ifndef __GANXO_HPP_INC__
+#define __GANXO_HPP_INC__
+
+/*
+
+Ganxo - An opensource API hooking framework by Elias Bachaalany - < elias at passingtheknowledge.net >
+
+*/
+
+extern "C" {
+    #include "ganxo.h"
+}
+
+#include <utility>
+
+/*! \file ganxo.hpp
+    \brief Typed C++ hooks, header only, built on the gnx_transaction_* APIs.
+
+    The signature and the calling convention of a hooked function are derived at compile time from its address:
+
+        typedef GNX_HOOK(&send_packet) send_hook;
+
+        int __stdcall my_send_packet(const void *data, int size)
+        {
+            return send_hook::original(data, size);    // direct call into the springboard
+        }
+
+        send_hook::add(transaction, my_send_packet);  // type checked: no (void **) cast
+
+    A hook that only needs to run code around the calls does not write any trampoline: \ref gnx::typed_hook::add_around
+    hooks the function with a thunk generated by the compiler with the function's exact signature and calling convention,
+    so it only saves the registers the convention requires.
+*/
+
+namespace gnx
+{
+
+namespace detail
+{
+    //--------------------------------------------------------------------------
+    // Call the original function between the entry and exit handlers of Around.
+    // A is the hooked function's parameter list, passed explicitly: the references are kept as such and
+    // the arguments taken by value are moved into the original function (on_exit sees them moved from).
+    template <typename R>
+    struct around_call
+    {
+        template <class Around, typename F, typename... A>
+        static R call(F original, A... args)
+        {
+            Around::on_entry(args...);
+            R result = original(std::forward<A>(args)...);
+            Around::on_exit(result, args...);
+            return result;
+        }
+    };
+
+    template <>
+    struct around_call<void>
+    {
+        template <class Around, typename F, typename... A>
+        static void call(F original, A... args)
+        {
+            Around::on_entry(args...);
+            original(std::forward<A>(args)...);
+            Around::on_exit(args...);
+        }
+    };
+
+    //--------------------------------------------------------------------------
+    // Function pointer types, one specialization per calling convention (they are distinct types on x86 only)
+    template <typename F>
+    struct signature;
+
+    #define GNX_HPP_SIGNATURE(cc)                                                               \
+        template <typename R, typename... A>                                                    \
+        struct signature<R (cc *)(A...)>                                                        \
+        {                                                                                       \
+            typedef R result_type;                                                              \
+            typedef R (cc *pointer_type)(A...);                                                 \
+                                                                                                \
+            template <class Hook, class Around>                                                 \
+            static R cc around_thunk(A... args)                                                 \
+            {                                                                                   \
+                return around_call<R>::template call<Around, pointer_type, A...>(               \
+                    Hook::original,                                                             \
+                    std::forward<A>(args)...);                                                  \
+            }                                                                                   \
+        };
+
+    #if defined(GANXO_ARCH_X86)
+        GNX_HPP_SIGNATURE(__cdecl)
+        GNX_HPP_SIGNATURE(__stdcall)
+        GNX_HPP_SIGNATURE(__fastcall)
+    #else
+        GNX_HPP_SIGNATURE(__cdecl)
+    #endif
+
+    #undef GNX_HPP_SIGNATURE
+}
+
+//--------------------------------------------------------------------------
+/// Typed hook of the function at Target.
+/// Each hooked function has its own class, holding the typed original function.
+/// \note Target must be a constant address: the functions imported from a DLL (__declspec(dllimport))
+///       are not, use the C API for them.
+template <typename F, F Target>
+class typed_hook
+{
+public:
+    typedef F pointer_type;
+    typedef typename detail::signature<F>::result_type result_type;
+
+    /// The original function: Target until hooked, then a direct pointer into the springboard
+    static F original;
+
+    /// Hook the function (\ref gnx_transaction_add_hook)
+    static gnx_err_t add(
+        gnx_handle_t transaction,
+        F detour)
+    {
+        return gnx_transaction_add_hook(
+            transaction,
+            (void **)&original,
+            (void *)detour);
+    }
+
+    /// Hook the function with a thunk calling Around::on_entry(args...) before the original
+    /// function, then Around::on_exit(result, args...) (or on_exit(args...) if it returns void)
+    template <class Around>
+    static gnx_err_t add_around(gnx_handle_t transaction)
+    {
+        return add(
+            transaction,
+            &detail::signature<F>::template around_thunk<typed_hook, Around>);
+    }
+
+    /// Hook the function, calling the original one for the reentrant calls of the guard group (\ref gnx_transaction_add_guarded_hook)
+    static gnx_err_t add_guarded(
+        gnx_handle_t transaction,
+        F detour,
+        uint32_t group)
+    {
+        return gnx_transaction_add_guarded_hook(
+            transaction,
+            (void **)&original,
+            (void *)detour,
+            group);
+    }
+
+    /// Count the calls of the function (\ref gnx_transaction_add_counter_hook)
+    static gnx_err_t add_counter(
+        gnx_handle_t transaction,
+        uint32_t flags,
+        gnx_handle_t *counter)
+    {
+        return gnx_transaction_add_counter_hook(
+            transaction,
+            (void **)&original,
+            flags,
+            counter);
+    }
+
+    /// Unhook the function (\ref gnx_transaction_remove_hook)
+    static gnx_err_t remove(gnx_handle_t transaction)
+    {
+        return gnx_transaction_remove_hook(
+            transaction,
+            (void **)&original);
+    }
+};
+
+template <typename F, F Target>
+F typed_hook<F, Target>::original = Target;
+
+#if defined(__cpp_nontype_template_parameter_auto)
+/// Typed hook of a function (ex: gnx::hook<&send_packet>)
+template <auto Target>
+using hook = typed_hook<decltype(Target), Target>;
+#endif
+
+}
+
+/// Typed hook of a function, without C++17 (ex: GNX_HOOK(&send_packet))
+#define GNX_HOOK(target) ::gnx::typed_hook<decltype(target), target>
+
+#endif
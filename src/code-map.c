@@ -0,0 +1,176 @@
+#include "private.h"
+#include <stdio.h>
+
+//--------------------------------------------------------------------------
+// Code map.
+//
+// The springboards and the stubs live in anonymous executable blocks: the profilers sampling a hooked
+// process cannot tell them apart. Each code range placed by the workspace is described by a line of the
+// perf map format ("<start> <size> <name>", in hexadecimal, without any prefix) and to an optional
+// callback, which can feed a profiler's JIT code API. A freed range is written again with a "(freed)"
+// suffix: its later reuse appends a new line, the last line of an address wins.
+//--------------------------------------------------------------------------
+
+/// Longest line: two pointers, a kind, a module name and an offset
+#define MAX_LINE_SIZE (2 * 16 + GNX_OS_MODULE_NAME_SIZE + 64)
+
+//--------------------------------------------------------------------------
+// Name a code range after the function it belongs to: <kind>:<module>+0x<offset>, or <kind>:0x<address>
+static void format_name(
+    char *name,
+    size_t size,
+    const char *kind,
+    const void *func)
+{
+    gnx_os_module_t mod;
+    if (func == NULL)
+        snprintf(name, size, "%s", kind);
+    else if (gnx_os_module_from_address(func, &mod))
+        snprintf(name, size, "%s:%s+0x%x", kind, mod.name, (unsigned)((const uint8_t *)func - mod.base));
+    else
+        snprintf(name, size, "%s:0x%p", kind, func);
+}
+
+//--------------------------------------------------------------------------
+static void note(
+    gnx_workspace_t *ws,
+    const void *start,
+    size_t size,
+    const char *kind,
+    const void *func,
+    bool removed)
+{
+    gnx_code_map_t *map = &ws->code_map;
+
+    // Nothing to do until the code map is started
+    if (!map->active)
+        return;
+
+    char name[MAX_LINE_SIZE];
+    format_name(name, sizeof(name), kind, func);
+
+    char line[MAX_LINE_SIZE * 2];
+    int len = snprintf(line, sizeof(line), "%p %x %s%s\n", start, (unsigned)size, name, removed ? " (freed)" : "");
+
+    gnx_os_lock_acquire(&map->lock);
+    if (map->active)
+    {
+        if (map->file != NULL && len > 0)
+            gnx_os_file_write(map->file, line, (size_t)len);
+
+        if (map->callback != NULL)
+            map->callback(map->ctx, start, size, name, removed);
+    }
+    gnx_os_lock_release(&map->lock);
+}
+
+//--------------------------------------------------------------------------
+void gnx_code_map_add(
+    gnx_workspace_t *ws,
+    const void *start,
+    size_t size,
+    const char *kind,
+    const void *func)
+{
+    note(ws, start, size, kind, func, false);
+}
+
+//--------------------------------------------------------------------------
+void gnx_code_map_remove(
+    gnx_workspace_t *ws,
+    const void *start,
+    size_t size,
+    const char *kind,
+    const void *func)
+{
+    note(ws, start, size, kind, func, true);
+}
+
+//--------------------------------------------------------------------------
+gnx_err_t GANXO_API gnx_code_map_start(
+    gnx_handle_t handle,
+    const gnx_code_map_options_t *options)
+{
+    GET_WORKSPACE;
+
+    if (options == NULL)
+        return GNX_ERR_INVALID_ARGS;
+
+    gnx_code_map_t *map = &ws->code_map;
+    gnx_err_t err = GNX_ERR_OK;
+
+    gnx_os_lock_acquire(&map->lock);
+    do
+    {
+        if (map->active)
+        {
+            err = GNX_ERR_INVALID_ARGS;
+            break;
+        }
+
+        // perf-<pid>.map in the temporary directory by default, no file at all with an empty path
+        char path[GNX_OS_MAX_PATH];
+        const char *map_path = options->path;
+        if (map_path == NULL)
+        {
+            if (!gnx_os_perf_map_path(path, sizeof(path)))
+            {
+                err = GNX_ERR_FAILED;
+                break;
+            }
+            map_path = path;
+        }
+
+        map->file = NULL;
+        if (map_path[0] != '\0')
+        {
+            map->file = gnx_os_file_create(map_path);
+            if (map->file == NULL)
+            {
+                err = GNX_ERR_FAILED;
+                break;
+            }
+        }
+
+        map->callback = options->callback;
+        map->ctx = options->ctx;
+        map->active = true;
+    } while (false);
+    gnx_os_lock_release(&map->lock);
+
+    return err;
+}
+
+//--------------------------------------------------------------------------
+gnx_err_t GANXO_API gnx_code_map_stop(gnx_handle_t handle)
+{
+    GET_WORKSPACE;
+
+    gnx_code_map_t *map = &ws->code_map;
+    gnx_err_t err = GNX_ERR_OK;
+
+    gnx_os_lock_acquire(&map->lock);
+    if (!map->active)
+    {
+        err = GNX_ERR_INVALID_ARGS;
+    }
+    else
+    {
+        if (map->file != NULL)
+            gnx_os_file_close(map->file);
+
+        map->file = NULL;
+        map->callback = NULL;
+        map->active = false;
+    }
+    gnx_os_lock_release(&map->lock);
+
+    return err;
+}
+
+//--------------------------------------------------------------------------
+void gnx_code_map_free(gnx_workspace_t *ws)
+{
+    if (ws->code_map.active)
+        gnx_code_map_stop((gnx_handle_t)ws);
+}
@@ -0,0 +1,245 @@
+#include "private.h"
+
+//--------------------------------------------------------------------------
+// Asynchronous commits.
+//
+// The transactions committed with \ref gnx_transaction_commit_async are queued to the workspace's
+// committer thread. Each time it wakes up, the thread takes all the queued transactions and commits
+// them in a single patching pass, then reports each of them through its callback.
+//--------------------------------------------------------------------------
+
+/// Queued transaction
+typedef struct __gnx_async_commit_t
+{
+    gnx_handle_t trans;
+    gnx_commit_callback_t callback;
+    void *ctx;
+    gnx_err_t err;                  ///< The transaction result, once committed
+    struct __gnx_async_commit_t *next;
+} gnx_async_commit_t;
+
+struct __gnx_committer_t
+{
+    gnx_workspace_t *ws;
+    void *thread;
+    void *wake;                     ///< Signaled when transactions are queued or when stopping
+    void *done;                     ///< Signaled after each patching pass (\ref gnx_transaction_commit_event)
+    gnx_os_lock_t lock;             ///< Protects the queue
+    gnx_async_commit_t *head;       ///< Queued transactions, oldest first
+    gnx_async_commit_t **tail;
+    bool stop;
+};
+
+//--------------------------------------------------------------------------
+// Commit a batch of queued transactions and report them
+static void commit_batch(
+    gnx_workspace_t *ws,
+    gnx_async_commit_t *batch)
+{
+    size_t nb_commits = 0;
+    for (gnx_async_commit_t *commit = batch; commit != NULL; commit = commit->next)
+        ++nb_commits;
+
+    gnx_handle_t *transactions = (gnx_handle_t *)gnx_malloc(nb_commits * sizeof(gnx_handle_t));
+    gnx_err_t *errs = (gnx_err_t *)gnx_malloc(nb_commits * sizeof(gnx_err_t));
+    if (transactions != NULL && errs != NULL)
+    {
+        size_t i = 0;
+        for (gnx_async_commit_t *commit = batch; commit != NULL; commit = commit->next)
+            transactions[i++] = commit->trans;
+
+        gnx_transactions_apply(
+            ws,
+            transactions,
+            nb_commits,
+            errs);
+
+        i = 0;
+        for (gnx_async_commit_t *commit = batch; commit != NULL; commit = commit->next)
+            commit->err = errs[i++];
+    }
+    else
+    {
+        // Not enough memory to batch them: one at a time
+        for (gnx_async_commit_t *commit = batch; commit != NULL; commit = commit->next)
+        {
+            gnx_transactions_apply(
+                ws,
+                &commit->trans,
+                1,
+                &commit->err);
+        }
+    }
+
+    gnx_mfree(transactions);
+    gnx_mfree(errs);
+
+    while (batch != NULL)
+    {
+        gnx_async_commit_t *commit = batch;
+        batch = commit->next;
+
+        size_t nb_items = gnx_transaction_get_size(commit->trans);
+        gnx_commit_result_t *results = (gnx_commit_result_t *)gnx_malloc((nb_items + 1) * sizeof(gnx_commit_result_t));
+        gnx_transaction_release(
+            commit->trans,
+            results);
+
+        if (commit->callback != NULL)
+        {
+            commit->callback(
+                commit->ctx,
+                commit->err,
+                results,
+                results != NULL ? nb_items : 0);
+        }
+
+        gnx_mfree(results);
+        GNX_FREE(commit);
+    }
+}
+
+//--------------------------------------------------------------------------
+static void committer_thread(void *ctx)
+{
+    gnx_committer_t *committer = (gnx_committer_t *)ctx;
+
+    for (;;)
+    {
+        gnx_os_event_wait(committer->wake);
+
+        // Take all the queued transactions
+        gnx_os_lock_acquire(&committer->lock);
+        gnx_async_commit_t *batch = committer->head;
+        committer->head = NULL;
+        committer->tail = &committer->head;
+        bool stop = committer->stop;
+        gnx_os_lock_release(&committer->lock);
+
+        if (batch != NULL)
+        {
+            commit_batch(
+                committer->ws,
+                batch);
+
+            gnx_os_event_set(committer->done);
+        }
+
+        // Stopping: the queue was drained
+        if (stop)
+            break;
+    }
+}
+
+//--------------------------------------------------------------------------
+// Start the committer thread of a workspace, unless already started
+static gnx_committer_t *get_committer(gnx_workspace_t *ws)
+{
+    gnx_os_lock_acquire(&ws->lock);
+
+    gnx_committer_t *committer = ws->committer;
+    do
+    {
+        if (committer != NULL)
+            break;
+
+        committer = GNX_ALLOC(gnx_committer_t);
+        if (committer == NULL)
+            break;
+
+        committer->ws = ws;
+        committer->head = NULL;
+        committer->tail = &committer->head;
+        committer->stop = false;
+        gnx_os_lock_init(&committer->lock);
+
+        committer->wake = gnx_os_event_create();
+        committer->done = gnx_os_event_create();
+        committer->thread = NULL;
+        if (committer->wake != NULL && committer->done != NULL)
+        {
+            committer->thread = gnx_os_thread_create(
+                committer_thread,
+                committer);
+        }
+
+        if (committer->thread == NULL)
+        {
+            if (committer->wake != NULL)
+                gnx_os_event_free(committer->wake);
+
+            if (committer->done != NULL)
+                gnx_os_event_free(committer->done);
+
+            GNX_FREE(committer);
+            committer = NULL;
+            break;
+        }
+
+        ws->committer = committer;
+    } while (false);
+
+    gnx_os_lock_release(&ws->lock);
+
+    return committer;
+}
+
+//--------------------------------------------------------------------------
+gnx_err_t gnx_committer_push(
+    gnx_workspace_t *ws,
+    gnx_handle_t trans,
+    gnx_commit_callback_t callback,
+    void *ctx)
+{
+    gnx_committer_t *committer = get_committer(ws);
+    if (committer == NULL)
+        return GNX_ERR_FAILED;
+
+    gnx_async_commit_t *commit = GNX_ALLOC(gnx_async_commit_t);
+    if (commit == NULL)
+        return GNX_ERR_NO_MEM;
+
+    commit->trans = trans;
+    commit->callback = callback;
+    commit->ctx = ctx;
+    commit->err = GNX_ERR_OK;
+    commit->next = NULL;
+
+    gnx_os_lock_acquire(&committer->lock);
+    *committer->tail = commit;
+    committer->tail = &commit->next;
+    gnx_os_lock_release(&committer->lock);
+
+    gnx_os_event_set(committer->wake);
+
+    return GNX_ERR_OK;
+}
+
+//--------------------------------------------------------------------------
+void gnx_committer_free(gnx_workspace_t *ws)
+{
+    gnx_committer_t *committer = ws->committer;
+
+    gnx_os_lock_acquire(&committer->lock);
+    committer->stop = true;
+    gnx_os_lock_release(&committer->lock);
+
+    gnx_os_event_set(committer->wake);
+    gnx_os_thread_join(committer->thread);
+
+    gnx_os_event_free(committer->wake);
+    gnx_os_event_free(committer->done);
+    GNX_FREE(committer);
+
+    ws->committer = NULL;
+}
+
+//--------------------------------------------------------------------------
+void *GANXO_API gnx_transaction_commit_event(gnx_handle_t handle)
+{
+    GET_WORKSPACE;
+
+    gnx_committer_t *committer = get_committer(ws);
+
+    return committer != NULL ? committer->done : NULL;
+}
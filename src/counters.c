@@ -0,0 +1,1084 @@
+#include "private.h"
+
+//--------------------------------------------------------------------------
+// Instrumentation counters.
+//
+// A counter hook jumps to a generated stub that counts the call, then jumps to the springboard:
+// no C code runs. The registered threads (\ref gnx_thread_register) count in their own block,
+// found through a thread local slot (fs:[ofs]) with plain additions. The other threads count in
+// shared counters with locked additions.
+//
+// With \ref GNX_COUNT_CYCLES, the stub also reads the time stamp counter and replaces the return
+// address by the exit thunk, remembering the caller in the thread's shadow stack. The exit thunk
+// adds the elapsed cycles and returns to the caller.
+//
+// A counter hook's stub first jumps through its control slot (\ref gnx_stub_control_t), which is always
+// writable: pointing it to the springboard disables the hook, and the sample mask times only 1 in N
+// calls, without rewriting the stub nor committing anything (\ref gnx_hook_set_sampling).
+//
+// A thread-scoped hook's stub only tests the calling thread's enable bit, held in a thread local
+// slot of 32 bits (fs:[ofs]), and jumps to the hook or to the springboard: it touches no register.
+//
+// A trace hook's stub appends a record to the thread's ring instead (it is the single producer,
+// see trace.c), and its returns go through the trace exit thunk. The frames of the deeper calls left through
+// an exception are still on the shadow stack: the exit thunks drop them, recognizing their own frame as
+// the outermost one whose return address slot is at or below the returning stack pointer.
+//--------------------------------------------------------------------------
+
+#if defined(GANXO_ARCH_X86)
+
+// STATIC ASSERT: the stubs address the shadow frames as 32 bytes entries after the depth
+typedef char __ASSERT_SHADOW_FRAME_SIZE[
+    sizeof(gnx_shadow_frame_t) == 32 && offsetof(gnx_counters_block_t, shadow) == 8 ? 1 : -1];
+
+// STATIC ASSERT: 32 bits cycles fill the last histogram bucket at most
+typedef char __ASSERT_HISTOGRAM_SIZE[GNX_HOOK_HISTOGRAM_SIZE == 8 ? 1 : -1];
+
+//--------------------------------------------------------------------------
+// Pop the frame of the returning call into ebx: ecx is the thread's block, esi where the return address was.
+// A ret N leaves esi N bytes above the frame's slot, but the caller's frames are above these arguments:
+// while the next outer frame's slot is also at or below esi, the popped frame is a deeper call left by an exception.
+static void emit_pop_shadow_frame(gnx_emitter_t *e)
+{
+    uint8_t *pop_frame = e->p;              // pop_frame:
+    gnx_emit(e, "\xFF\x09", 2);             // dec dword [ecx]
+    gnx_emit(e, "\x8B\x19", 2);             // mov ebx, [ecx]
+    gnx_emit(e, "\xC1\xE3\x05", 3);         // shl ebx, 5
+    gnx_emit(e, "\x8D\x5C\x19\x08", 4);     // lea ebx, [ecx + ebx + 8]
+    gnx_emit(e, "\x83\x39\x00", 3);         // cmp dword [ecx], 0      ; the outermost frame
+    uint8_t *to_owner = gnx_emit_jcc8(e, 0x74); // jz owner
+    gnx_emit(e, "\x39\x73\xF0", 3);         // cmp [ebx - 32 + 16], esi ; the next outer frame's slot
+    gnx_emit(e, "\x76", 1);                 // jbe pop_frame
+    *e->p = (uint8_t)(pop_frame - (e->p + 1));
+    e->p++;
+    gnx_bind_jcc8(e, to_owner);             // owner:
+}
+
+//--------------------------------------------------------------------------
+// Exit thunk: the timed functions return here
+static void gen_exit_thunk(
+    gnx_counters_t *counters,
+    uint8_t *code)
+{
+    gnx_emitter_t e = { code, code };
+
+    gnx_emit(&e, "\x83\xEC\x04", 3);        // sub esp, 4              ; room for the caller's address (where it was)
+    gnx_emit(&e, "\x50\x52\x51\x53\x56", 5);    // push eax/edx/ecx/ebx/esi; the return value is in edx:eax (or st0)
+    gnx_emit(&e, "\x0F\x31", 2);            // rdtsc
+    gnx_emit(&e, "\x64\x8B\x0D", 3);        // mov ecx, fs:[ofs]       ; the thread's counters block
+    gnx_emit32(&e, counters->tls_ofs);
+    gnx_emit(&e, "\x8D\x74\x24\x14", 4);    // lea esi, [esp + 20]     ; the return address slot
+    emit_pop_shadow_frame(&e);
+    gnx_emit(&e, "\x2B\x43\x08", 3);        // sub eax, [ebx + 8]      ; elapsed cycles
+    gnx_emit(&e, "\x1B\x53\x0C", 3);        // sbb edx, [ebx + 12]
+    gnx_emit(&e, "\x03\x4B\x04", 3);        // add ecx, [ebx + 4]      ; the counter's cycles
+    gnx_emit(&e, "\x8B\x33", 2);            // mov esi, [ebx]          ; the caller's address
+    gnx_emit(&e, "\x89\x74\x24\x14", 4);    // mov [esp + 20], esi
+    gnx_emit(&e, "\x01\x01", 2);            // add [ecx], eax
+    gnx_emit(&e, "\x11\x51\x04", 3);        // adc [ecx + 4], edx
+    gnx_emit(&e, "\xBB", 1);                // mov ebx, last bucket
+    gnx_emit32(&e, GNX_HOOK_HISTOGRAM_SIZE - 1);
+    gnx_emit(&e, "\x85\xD2", 2);            // test edx, edx
+    uint8_t *to_bucket = gnx_emit_jcc8(&e, 0x75); // jnz bucket
+    gnx_emit(&e, "\x83\xC8\x01", 3);        // or eax, 1
+    gnx_emit(&e, "\x0F\xBD\xC0", 3);        // bsr eax, eax
+    gnx_emit(&e, "\xC1\xE8\x02", 3);        // shr eax, 2              ; 16x buckets
+    gnx_emit(&e, "\x8B\xD8", 2);            // mov ebx, eax
+    gnx_bind_jcc8(&e, to_bucket);           // bucket:
+    gnx_emit(&e, "\xFF\x44\x99", 3);        // inc dword [ecx + ebx * 4 + histogram]
+    *e.p++ = (uint8_t)(offsetof(gnx_counter_t, histogram) - offsetof(gnx_counter_t, cycles));
+    gnx_emit(&e, "\x5E\x5B\x59\x5A\x58", 5);    // pop esi/ebx/ecx/edx/eax
+    gnx_emit(&e, "\xC3", 1);                // ret
+}
+
+//--------------------------------------------------------------------------
+void gnx_counters_gen_stub(
+    gnx_counters_t *counters,
+    uint8_t *stub,
+    uint32_t index,
+    uint32_t flags,
+    const void *springboard)
+{
+    gnx_emitter_t e = { stub, stub };
+
+    uint32_t calls_ofs = (uint32_t)(offsetof(gnx_counters_block_t, counters) + index * sizeof(gnx_counter_t));
+    uint32_t cycles_ofs = calls_ofs + (uint32_t)offsetof(gnx_counter_t, cycles);
+    gnx_stub_control_t *control = &counters->control[index];
+
+    gnx_emit(&e, "\xFF\x25", 2);            // jmp [dispatch]          ; the body, or the springboard once disabled
+    gnx_emit32(&e, (uint32_t)(uintptr_t)&control->dispatch);
+
+    control->body = e.p;
+    control->springboard = springboard;
+    control->flags = flags;
+    control->sample_mask = 0;
+    control->dispatch = control->body;
+
+    gnx_emit(&e, "\x51", 1);                // push ecx
+    gnx_emit(&e, "\x64\x8B\x0D", 3);        // mov ecx, fs:[ofs]       ; the thread's counters block
+    gnx_emit32(&e, counters->tls_ofs);
+    gnx_emit(&e, "\x85\xC9", 2);            // test ecx, ecx
+    uint8_t *to_shared = gnx_emit_jcc8(&e, 0x74); // jz shared
+
+    gnx_emit(&e, "\x83\x81", 2);            // add dword [ecx + calls], 1
+    gnx_emit32(&e, calls_ofs);
+    gnx_emit(&e, "\x01", 1);
+    gnx_emit(&e, "\x83\x91", 2);            // adc dword [ecx + calls + 4], 0
+    gnx_emit32(&e, calls_ofs + 4);
+    gnx_emit(&e, "\x00", 1);
+
+    if (GNX_HAS_FLAG(flags, GNX_COUNT_CYCLES))
+    {
+        gnx_emit(&e, "\x50\x52", 2);        // push eax/edx
+        gnx_emit(&e, "\x8B\x15", 2);        // mov edx, [sample_mask]
+        gnx_emit32(&e, (uint32_t)(uintptr_t)&control->sample_mask);
+        gnx_emit(&e, "\x85\x91", 2);        // test [ecx + calls], edx ; not sampled: not timed
+        gnx_emit32(&e, calls_ofs);
+        uint8_t *to_unsampled = gnx_emit_jcc8(&e, 0x75); // jnz untimed
+        gnx_emit(&e, "\x8B\x11", 2);        // mov edx, [ecx]          ; shadow stack depth
+        gnx_emit(&e, "\x83\xFA", 2);        // cmp edx, depth          ; too deep: not timed
+        *e.p++ = GNX_COUNTERS_SHADOW_DEPTH;
+        uint8_t *to_untimed = gnx_emit_jcc8(&e, 0x73); // jae untimed
+        gnx_emit(&e, "\xFF\x01", 2);        // inc dword [ecx]         ; push a shadow frame
+        gnx_emit(&e, "\xC1\xE2\x05", 3);    // shl edx, 5
+        gnx_emit(&e, "\x8D\x4C\x11\x08", 4);    // lea ecx, [ecx + edx + 8]
+        gnx_emit(&e, "\x8D\x44\x24\x0C", 4);    // lea eax, [esp + 12]     ; the return address slot
+        gnx_emit(&e, "\x89\x41\x10", 3);    // mov [ecx + 16], eax
+        gnx_emit(&e, "\x8B\x00", 2);        // mov eax, [eax]          ; the caller's address
+        gnx_emit(&e, "\x89\x01", 2);        // mov [ecx], eax
+        gnx_emit(&e, "\xC7\x41\x04", 3);    // mov dword [ecx + 4], cycles
+        gnx_emit32(&e, cycles_ofs);
+        gnx_emit(&e, "\xC7\x44\x24\x0C", 4);    // mov dword [esp + 12], exit_thunk
+        gnx_emit32(&e, (uint32_t)(uintptr_t)counters->exit_thunk);
+        gnx_emit(&e, "\x0F\x31", 2);        // rdtsc
+        gnx_emit(&e, "\x89\x41\x08", 3);    // mov [ecx + 8], eax
+        gnx_emit(&e, "\x89\x51\x0C", 3);    // mov [ecx + 12], edx
+        gnx_bind_jcc8(&e, to_unsampled);    // untimed:
+        gnx_bind_jcc8(&e, to_untimed);
+        gnx_emit(&e, "\x5A\x58", 2);        // pop edx/eax
+    }
+
+    gnx_emit(&e, "\x59", 1);                // pop ecx
+    gnx_emit_jmp(&e, springboard);          // jmp springboard
+
+    // Untracked thread: count only
+    uint32_t shared_calls = (uint32_t)(uintptr_t)&counters->shared[index].calls;
+
+    gnx_bind_jcc8(&e, to_shared);           // shared:
+    gnx_emit(&e, "\xF0\x83\x05", 3);        // lock add dword [calls], 1
+    gnx_emit32(&e, shared_calls);
+    gnx_emit(&e, "\x01", 1);
+    uint8_t *to_done = gnx_emit_jcc8(&e, 0x73); // jnc done
+    gnx_emit(&e, "\xF0\xFF\x05", 3);        // lock inc dword [calls + 4]
+    gnx_emit32(&e, shared_calls + 4);
+    gnx_bind_jcc8(&e, to_done);             // done:
+    gnx_emit(&e, "\x59", 1);                // pop ecx
+    gnx_emit_jmp(&e, springboard);          // jmp springboard
+}
+
+//--------------------------------------------------------------------------
+// Append a record to the thread's ring: ecx is the thread's block, the record is left in ebx.
+// Branches to the returned label (to bind with gnx_bind_jcc32: the record filling is too long for a rel8) if the ring is full.
+static uint8_t *emit_trace_record_alloc(gnx_emitter_t *e)
+{
+    gnx_emit(e, "\x8B\x99", 2);             // mov ebx, [ecx + head]
+    gnx_emit32(e, offsetof(gnx_counters_block_t, trace_head));
+    gnx_emit(e, "\x8B\xD3", 2);             // mov edx, ebx
+    gnx_emit(e, "\x2B\x91", 2);             // sub edx, [ecx + tail]
+    gnx_emit32(e, offsetof(gnx_counters_block_t, trace_tail));
+    gnx_emit(e, "\x81\xFA", 2);             // cmp edx, GNX_TRACE_RING_RECORDS
+    gnx_emit32(e, GNX_TRACE_RING_RECORDS);
+    uint8_t *to_full = gnx_emit_jcc32(e, 0x73); // jae full
+    gnx_emit(e, "\x81\xE3", 2);             // and ebx, GNX_TRACE_RING_RECORDS - 1
+    gnx_emit32(e, GNX_TRACE_RING_RECORDS - 1);
+    gnx_emit(e, "\xC1\xE3\x05", 3);         // shl ebx, 5
+    gnx_emit(e, "\x03\x99", 2);             // add ebx, [ecx + ring]
+    gnx_emit32(e, offsetof(gnx_counters_block_t, trace_ring));
+    return to_full;
+}
+
+//--------------------------------------------------------------------------
+// Complete the record in ebx (the hook identifier and the arguments are set) and publish it
+static void emit_trace_record_publish(gnx_emitter_t *e)
+{
+    gnx_emit(e, "\x64\xA1\x24\x00\x00\x00", 6); // mov eax, fs:[0x24]      ; thread id
+    gnx_emit(e, "\x89\x43\x04", 3);         // mov [ebx + 4], eax
+    gnx_emit(e, "\x0F\x31", 2);             // rdtsc
+    gnx_emit(e, "\x89\x43\x08", 3);         // mov [ebx + 8], eax
+    gnx_emit(e, "\x89\x53\x0C", 3);         // mov [ebx + 12], edx
+    gnx_emit(e, "\xFF\x81", 2);             // inc dword [ecx + head]  ; the drain reads up to head
+    gnx_emit32(e, offsetof(gnx_counters_block_t, trace_head));
+}
+
+//--------------------------------------------------------------------------
+// Exit thunk of the traced functions: records the return
+static void gen_trace_exit_thunk(
+    gnx_counters_t *counters,
+    uint8_t *code)
+{
+    gnx_emitter_t e = { code, code };
+
+    gnx_emit(&e, "\x83\xEC\x04", 3);        // sub esp, 4              ; room for the caller's address (where it was)
+    gnx_emit(&e, "\x50\x52\x51\x53\x56", 5);    // push eax/edx/ecx/ebx/esi
+    gnx_emit(&e, "\x64\x8B\x0D", 3);        // mov ecx, fs:[ofs]       ; the thread's block
+    gnx_emit32(&e, counters->tls_ofs);
+    gnx_emit(&e, "\x8D\x74\x24\x14", 4);    // lea esi, [esp + 20]     ; the return address slot
+    emit_pop_shadow_frame(&e);
+    gnx_emit(&e, "\x8B\x03", 2);            // mov eax, [ebx]          ; the caller's address
+    gnx_emit(&e, "\x89\x44\x24\x14", 4);    // mov [esp + 20], eax
+    gnx_emit(&e, "\x8B\x73\x04", 3);        // mov esi, [ebx + 4]      ; hook id
+
+    uint8_t *to_full = emit_trace_record_alloc(&e);
+    gnx_emit(&e, "\x81\xCE", 2);            // or esi, GNX_TRACE_RETURN_RECORD
+    gnx_emit32(&e, GNX_TRACE_RETURN_RECORD);
+    gnx_emit(&e, "\x89\x33", 2);            // mov [ebx], esi
+    gnx_emit(&e, "\x8B\x44\x24\x14", 4);    // mov eax, [esp + 20]     ; the caller
+    gnx_emit(&e, "\x89\x43\x10", 3);        // mov [ebx + 16], eax
+    gnx_emit(&e, "\x8B\x44\x24\x10", 4);    // mov eax, [esp + 16]     ; the returned eax
+    gnx_emit(&e, "\x89\x43\x14", 3);        // mov [ebx + 20], eax
+    gnx_emit(&e, "\x8B\x44\x24\x0C", 4);    // mov eax, [esp + 12]     ; the returned edx
+    gnx_emit(&e, "\x89\x43\x18", 3);        // mov [ebx + 24], eax
+    emit_trace_record_publish(&e);
+    uint8_t *to_done = gnx_emit_jcc8(&e, 0xEB); // jmp done
+
+    gnx_bind_jcc32(&e, to_full);            // full:
+    gnx_emit(&e, "\xFF\x81", 2);            // inc dword [ecx + dropped]
+    gnx_emit32(&e, offsetof(gnx_counters_block_t, trace_dropped));
+
+    gnx_bind_jcc8(&e, to_done);             // done:
+    gnx_emit(&e, "\x5E\x5B\x59\x5A\x58", 5);    // pop esi/ebx/ecx/edx/eax
+    gnx_emit(&e, "\xC3", 1);                // ret
+}
+
+//--------------------------------------------------------------------------
+void gnx_counters_gen_trace_stub(
+    gnx_counters_t *counters,
+    uint8_t *stub,
+    uint32_t hook_id,
+    uint32_t flags,
+    const void *springboard)
+{
+    gnx_emitter_t e = { stub, stub };
+
+    gnx_emit(&e, "\x51", 1);                // push ecx
+    gnx_emit(&e, "\x64\x8B\x0D", 3);        // mov ecx, fs:[ofs]       ; the thread's block
+    gnx_emit32(&e, counters->tls_ofs);
+    gnx_emit(&e, "\x85\xC9", 2);            // test ecx, ecx
+    uint8_t *to_tracked = gnx_emit_jcc8(&e, 0x75); // jnz tracked
+
+    // Untracked thread: count only
+    gnx_emit(&e, "\xF0\xFF\x05", 3);        // lock inc dword [untracked]
+    gnx_emit32(&e, (uint32_t)(uintptr_t)&counters->trace_untracked);
+    gnx_emit(&e, "\x59", 1);                // pop ecx
+    gnx_emit_jmp(&e, springboard);          // jmp springboard
+
+    gnx_bind_jcc8(&e, to_tracked);          // tracked:
+    gnx_emit(&e, "\x50\x52\x53", 3);        // push eax/edx/ebx
+    uint8_t *to_full = emit_trace_record_alloc(&e);
+    gnx_emit(&e, "\xC7\x03", 2);            // mov dword [ebx], hook_id
+    gnx_emit32(&e, hook_id);
+    gnx_emit(&e, "\x8B\x44\x24\x10", 4);    // mov eax, [esp + 16]     ; the caller
+    gnx_emit(&e, "\x89\x43\x10", 3);        // mov [ebx + 16], eax
+
+    uint32_t nb_args = (flags >> 8) & 0xFF;
+    for (uint32_t i = 0; i < nb_args && i < 3; i++)
+    {
+        gnx_emit(&e, "\x8B\x44\x24", 3);    // mov eax, [esp + 20 + 4 * i]
+        *e.p++ = (uint8_t)(20 + 4 * i);
+        gnx_emit(&e, "\x89\x43", 2);        // mov [ebx + 20 + 4 * i], eax
+        *e.p++ = (uint8_t)(20 + 4 * i);
+    }
+    emit_trace_record_publish(&e);
+
+    if (GNX_HAS_FLAG(flags, GNX_TRACE_RETURNS))
+    {
+        gnx_emit(&e, "\x8B\x11", 2);        // mov edx, [ecx]          ; shadow stack depth
+        gnx_emit(&e, "\x83\xFA", 2);        // cmp edx, depth          ; too deep: the return is not recorded
+        *e.p++ = GNX_COUNTERS_SHADOW_DEPTH;
+        uint8_t *to_done = gnx_emit_jcc8(&e, 0x73); // jae done
+        gnx_emit(&e, "\xFF\x01", 2);        // inc dword [ecx]         ; push a shadow frame
+        gnx_emit(&e, "\xC1\xE2\x05", 3);    // shl edx, 5
+        gnx_emit(&e, "\x8D\x54\x11\x08", 4);    // lea edx, [ecx + edx + 8]
+        gnx_emit(&e, "\x8D\x44\x24\x10", 4);    // lea eax, [esp + 16]     ; the return address slot
+        gnx_emit(&e, "\x89\x42\x10", 3);    // mov [edx + 16], eax
+        gnx_emit(&e, "\x8B\x00", 2);        // mov eax, [eax]
+        gnx_emit(&e, "\x89\x02", 2);        // mov [edx], eax
+        gnx_emit(&e, "\xC7\x42\x04", 3);    // mov dword [edx + 4], hook_id
+        gnx_emit32(&e, hook_id);
+        gnx_emit(&e, "\xC7\x44\x24\x10", 4);    // mov dword [esp + 16], trace_exit_thunk
+        gnx_emit32(&e, (uint32_t)(uintptr_t)counters->trace_exit_thunk);
+        gnx_bind_jcc8(&e, to_done);         // done:
+    }
+
+    gnx_emit(&e, "\x5B\x5A\x58\x59", 4);    // pop ebx/edx/eax/ecx
+    gnx_emit_jmp(&e, springboard);          // jmp springboard
+
+    gnx_bind_jcc32(&e, to_full);            // full:
+    gnx_emit(&e, "\xFF\x81", 2);            // inc dword [ecx + dropped]
+    gnx_emit32(&e, offsetof(gnx_counters_block_t, trace_dropped));
+    gnx_emit(&e, "\x5B\x5A\x58\x59", 4);    // pop ebx/edx/eax/ecx
+    gnx_emit_jmp(&e, springboard);          // jmp springboard
+}
+
+//--------------------------------------------------------------------------
+void gnx_counters_gen_thread_stub(
+    uint8_t *stub,
+    uint32_t ofs,
+    uint32_t bit,
+    const void *hook,
+    const void *springboard)
+{
+    gnx_emitter_t e = { stub, stub };
+
+    gnx_emit(&e, "\x64\xF7\x05", 3);        // test dword fs:[ofs], 1 << bit
+    gnx_emit32(&e, ofs);
+    gnx_emit32(&e, 1u << bit);
+    gnx_emit(&e, "\x0F\x85", 2);            // jnz hook
+    gnx_emit32(&e, (uint32_t)((const uint8_t *)hook - (e.p + sizeof(uint32_t))));
+    gnx_emit_jmp(&e, springboard);          // jmp springboard
+}
+
+//--------------------------------------------------------------------------
+// The guarded call's return: restore the caller's return address and release the group.
+// Neither the registers nor the flags are touched: the hook's result passes through.
+static void gen_guard_exit_thunk(gnx_guard_group_t *guard)
+{
+    gnx_emitter_t e = { guard->exit_thunk, guard->exit_thunk };
+
+    gnx_emit(&e, "\x64\xFF\x35", 3);        // push dword fs:[ret_ofs]
+    gnx_emit32(&e, guard->ret_ofs);
+    gnx_emit(&e, "\x64\xC7\x05", 3);        // mov dword fs:[slot_ofs], 0
+    gnx_emit32(&e, guard->slot_ofs);
+    gnx_emit32(&e, 0);
+    gnx_emit(&e, "\xC3", 1);                // ret
+}
+
+//--------------------------------------------------------------------------
+void gnx_counters_gen_guard_stub(
+    const gnx_guard_group_t *guard,
+    uint8_t *stub,
+    const void *hook,
+    const void *springboard)
+{
+    gnx_emitter_t e = { stub, stub };
+    uint8_t *to_reentrant;
+
+    // A guarded call in progress returns above the stack pointer. One left by an exception (or a
+    // longjmp) returns below it once the thread is back in an outer frame: it no longer counts.
+    gnx_emit(&e, "\x64\x39\x25", 3);        // cmp fs:[slot_ofs], esp
+    gnx_emit32(&e, guard->slot_ofs);
+    to_reentrant = gnx_emit_jcc8(&e, 0x77); // ja reentrant
+
+    gnx_emit(&e, "\x50", 1);                // push eax
+    gnx_emit(&e, "\x8B\x44\x24\x04", 4);    // mov eax, [esp + 4]
+    gnx_emit(&e, "\x64\xA3", 2);            // mov fs:[ret_ofs], eax
+    gnx_emit32(&e, guard->ret_ofs);
+    gnx_emit(&e, "\x8D\x44\x24\x04", 4);    // lea eax, [esp + 4]
+    gnx_emit(&e, "\x64\xA3", 2);            // mov fs:[slot_ofs], eax
+    gnx_emit32(&e, guard->slot_ofs);
+    gnx_emit(&e, "\xC7\x44\x24\x04", 4);    // mov dword [esp + 4], exit_thunk
+    gnx_emit32(&e, (uint32_t)(uintptr_t)guard->exit_thunk);
+    gnx_emit(&e, "\x58", 1);                // pop eax
+    gnx_emit_jmp(&e, hook);                 // jmp hook
+
+    gnx_bind_jcc8(&e, to_reentrant);        // reentrant:
+    gnx_emit_jmp(&e, springboard);          // jmp springboard
+}
+
+#else
+
+//--------------------------------------------------------------------------
+void gnx_counters_gen_thread_stub(
+    uint8_t *stub,
+    uint32_t ofs,
+    uint32_t bit,
+    const void *hook,
+    const void *springboard)
+{
+}
+
+//--------------------------------------------------------------------------
+static void gen_guard_exit_thunk(gnx_guard_group_t *guard)
+{
+}
+
+//--------------------------------------------------------------------------
+void gnx_counters_gen_guard_stub(
+    const gnx_guard_group_t *guard,
+    uint8_t *stub,
+    const void *hook,
+    const void *springboard)
+{
+}
+
+//--------------------------------------------------------------------------
+void gnx_counters_gen_stub(
+    gnx_counters_t *counters,
+    uint8_t *stub,
+    uint32_t index,
+    uint32_t flags,
+    const void *springboard)
+{
+    // Never called: no counters without the stubs (\ref gnx_counters_get)
+}
+
+//--------------------------------------------------------------------------
+void gnx_counters_gen_trace_stub(
+    gnx_counters_t *counters,
+    uint8_t *stub,
+    uint32_t hook_id,
+    uint32_t flags,
+    const void *springboard)
+{
+}
+
+#endif
+
+//--------------------------------------------------------------------------
+// Size of a threads block slot in the shared memory
+static inline size_t shm_slot_size(void)
+{
+    return GNX_ALIGN_UP(sizeof(gnx_counters_block_t), gnx_os_page_size());
+}
+
+//--------------------------------------------------------------------------
+// Threads block slot of the shared memory. The first two slots hold the shared and the retired counters.
+static inline gnx_counters_block_t *shm_slot(
+    gnx_counters_t *counters,
+    uint32_t slot)
+{
+    gnx_shared_counters_t *header = counters->shm_header;
+    uint8_t *first = (uint8_t *)header + header->arrays_ofs - offsetof(gnx_counters_block_t, counters);
+
+    return (gnx_counters_block_t *)(first + slot * header->arrays_stride);
+}
+
+//--------------------------------------------------------------------------
+// Map the shared memory of the counters and lay it out
+static void create_shm(
+    gnx_counters_t *counters,
+    const char *name,
+    uint32_t max_threads)
+{
+    uint32_t nb_slots = max_threads + 2;
+    size_t hooks_ofs = GNX_ALIGN_UP(sizeof(gnx_shared_counters_t), 64);
+    size_t slots_ofs = GNX_ALIGN_UP(hooks_ofs + GNX_MAX_COUNTERS * sizeof(gnx_shared_hook_t), gnx_os_page_size());
+
+    counters->shm_used = (uint8_t *)gnx_malloc(nb_slots);
+    if (counters->shm_used == NULL)
+        return;
+
+    counters->shm = gnx_os_shm_create(
+        name,
+        slots_ofs + nb_slots * shm_slot_size(),
+        (void **)&counters->shm_header);
+
+    if (counters->shm == NULL)
+    {
+        gnx_mfree(counters->shm_used);
+        return;
+    }
+
+    memset(counters->shm_used, 0, nb_slots);
+    counters->shm_used[0] = counters->shm_used[1] = true;
+    counters->shm_nb_slots = nb_slots;
+
+    // The magic comes last: a reader mapping it meanwhile does not trust the rest
+    gnx_shared_counters_t *header = counters->shm_header;
+    header->header_size = sizeof(gnx_shared_counters_t);
+    header->hook_size = sizeof(gnx_shared_hook_t);
+    header->counter_size = sizeof(gnx_hook_counters_t);
+    header->max_hooks = GNX_MAX_COUNTERS;
+    header->nb_hooks = 0;
+    header->nb_arrays = nb_slots;
+    header->hooks_ofs = hooks_ofs;
+    header->arrays_ofs = slots_ofs + offsetof(gnx_counters_block_t, counters);
+    header->arrays_stride = shm_slot_size();
+    header->version = GNX_SHARED_COUNTERS_VERSION;
+    header->magic = GNX_SHARED_COUNTERS_MAGIC;
+
+    counters->shared = shm_slot(counters, 0)->counters;
+    counters->retired = shm_slot(counters, 1)->counters;
+}
+
+//--------------------------------------------------------------------------
+// Create the workspace's counters, in a shared memory when it is named
+static gnx_counters_t *create_counters(
+    gnx_workspace_t *ws,
+    const char *shm_name,
+    uint32_t max_threads)
+{
+#if defined(GANXO_ARCH_X86)
+    gnx_os_lock_acquire(&ws->lock);
+
+    gnx_counters_t *counters = NULL;
+    do
+    {
+        if (ws->counters != NULL)
+            break;
+
+        counters = GNX_ALLOC(gnx_counters_t);
+        if (counters == NULL)
+            break;
+
+        memset(counters, 0, sizeof(*counters));
+        gnx_os_lock_init(&counters->governor_lock);
+
+        gnx_block_options_t bo;
+        bo.block_size = 4096;
+        bo.chunk_size = GNX_STUB_SIZE;
+        bo.chunk_align = 0x10;
+        bo.vmflags = GNX_MEM_RWX;
+        counters->stubs = gnx_block_create(&bo);
+
+        if (shm_name != NULL)
+        {
+            create_shm(
+                counters,
+                shm_name,
+                max_threads);
+        }
+        else
+        {
+            counters->shared = (gnx_counter_t *)gnx_vmalloc(GNX_MAX_COUNTERS * sizeof(gnx_counter_t), GNX_MEM_READ | GNX_MEM_WRITE);
+            counters->retired = (gnx_counter_t *)gnx_vmalloc(GNX_MAX_COUNTERS * sizeof(gnx_counter_t), GNX_MEM_READ | GNX_MEM_WRITE);
+        }
+
+        counters->control = (gnx_stub_control_t *)gnx_vmalloc(GNX_MAX_COUNTERS * sizeof(gnx_stub_control_t), GNX_MEM_READ | GNX_MEM_WRITE);
+
+        bool ok = counters->stubs != GNX_INVALID_HANDLE && counters->shared != NULL && counters->retired != NULL && counters->control != NULL;
+        if (ok)
+        {
+            counters->exit_thunk = (uint8_t *)gnx_block_chunk_alloc(counters->stubs);
+            counters->trace_exit_thunk = (uint8_t *)gnx_block_chunk_alloc(counters->stubs);
+            ok = counters->exit_thunk != NULL && counters->trace_exit_thunk != NULL;
+        }
+
+        if (ok)
+            ok = gnx_os_tls_alloc(&counters->tls_index, &counters->tls_ofs) == GNX_ERR_OK;
+
+        if (!ok)
+        {
+            if (counters->stubs != GNX_INVALID_HANDLE)
+                gnx_block_free(counters->stubs);
+
+            if (counters->shm != NULL)
+            {
+                gnx_os_shm_free(counters->shm, counters->shm_header);
+                gnx_mfree(counters->shm_used);
+            }
+            else
+            {
+                if (counters->shared != NULL)
+                    gnx_vmfree(counters->shared);
+
+                if (counters->retired != NULL)
+                    gnx_vmfree(counters->retired);
+            }
+
+            if (counters->control != NULL)
+                gnx_vmfree(counters->control);
+
+            GNX_FREE(counters);
+            counters = NULL;
+            break;
+        }
+
+        gen_exit_thunk(
+            counters,
+            counters->exit_thunk);
+
+        gen_trace_exit_thunk(
+            counters,
+            counters->trace_exit_thunk);
+
+        // Executable like the springboards, unless a transaction is in progress
+        if (ws->nb_open_transactions == 0)
+            gnx_block_protect(counters->stubs, GNX_MEM_EXEC);
+
+        ws->counters = counters;
+    } while (false);
+
+    gnx_os_lock_release(&ws->lock);
+
+    if (counters != NULL)
+    {
+        gnx_code_map_add(ws, counters->exit_thunk, GNX_STUB_SIZE, "gnx_exit_thunk", NULL);
+        gnx_code_map_add(ws, counters->trace_exit_thunk, GNX_STUB_SIZE, "gnx_trace_exit_thunk", NULL);
+    }
+
+    return counters;
+#else
+    return NULL;
+#endif
+}
+
+//--------------------------------------------------------------------------
+// Create the workspace's counters on first use
+gnx_counters_t *gnx_counters_get(gnx_workspace_t *ws)
+{
+    if (ws->counters == NULL)
+        create_counters(ws, NULL, 0);
+
+    // Another thread may have created them meanwhile
+    return ws->counters;
+}
+
+//--------------------------------------------------------------------------
+gnx_err_t GANXO_API gnx_counters_share(
+    gnx_handle_t handle,
+    const char *name,
+    uint32_t max_threads)
+{
+    GET_WORKSPACE;
+
+    if (name == NULL || ws->counters != NULL)
+        return GNX_ERR_INVALID_ARGS;
+
+#if defined(GANXO_ARCH_X86)
+    if (create_counters(ws, name, max_threads) == NULL)
+        return ws->counters != NULL ? GNX_ERR_INVALID_ARGS : GNX_ERR_FAILED;
+
+    return GNX_ERR_OK;
+#else
+    return GNX_ERR_NOT_SUPPORTED;
+#endif
+}
+
+//--------------------------------------------------------------------------
+void gnx_counters_describe(
+    gnx_workspace_t *ws,
+    uint32_t index,
+    const void *func,
+    uint32_t flags)
+{
+    gnx_counters_t *counters = ws->counters;
+    if (counters->shm == NULL)
+        return;
+
+    gnx_shared_counters_t *header = counters->shm_header;
+    gnx_shared_hook_t *hook = (gnx_shared_hook_t *)((uint8_t *)header + header->hooks_ofs) + index;
+
+    hook->address = (uint64_t)(uintptr_t)func;
+    hook->flags = flags;
+
+    gnx_os_module_t mod;
+    if (gnx_os_module_from_address(func, &mod))
+    {
+        hook->rva = (uint32_t)((const uint8_t *)func - mod.base);
+        strncpy_s(hook->module, sizeof(hook->module), mod.name, _TRUNCATE);
+    }
+
+    // The hooks are described in any order: count all the allocated ones
+    gnx_os_lock_acquire(&ws->lock);
+    header->nb_hooks = counters->nb_counters;
+    gnx_os_lock_release(&ws->lock);
+}
+
+//--------------------------------------------------------------------------
+void gnx_counters_publish_stats(gnx_workspace_t *ws)
+{
+    gnx_counters_t *counters = ws->counters;
+    if (counters == NULL || counters->shm == NULL)
+        return;
+
+    gnx_shared_counters_t *header = counters->shm_header;
+
+    gnx_os_lock_acquire(&ws->lock);
+    gnx_atomic_fetch_add(&header->stats_seq, 1);
+    header->stats = ws->stats;
+    gnx_atomic_fetch_add(&header->stats_seq, 1);
+    gnx_os_lock_release(&ws->lock);
+}
+
+//--------------------------------------------------------------------------
+gnx_err_t gnx_counters_alloc_stub(
+    gnx_workspace_t *ws,
+    uint8_t **stub,
+    uint32_t *index)
+{
+    gnx_counters_t *counters = gnx_counters_get(ws);
+    if (counters == NULL)
+        return GNX_ERR_NOT_SUPPORTED;
+
+    gnx_err_t err = GNX_ERR_OK;
+
+    gnx_os_lock_acquire(&ws->lock);
+    if (index != NULL && counters->nb_counters == GNX_MAX_COUNTERS)
+    {
+        err = GNX_ERR_NO_MEM;
+    }
+    else
+    {
+        *stub = (uint8_t *)gnx_block_chunk_alloc(counters->stubs);
+        if (*stub == NULL)
+            err = GNX_ERR_NO_MEM;
+        else if (index != NULL)
+            *index = counters->nb_counters++;
+    }
+    gnx_os_lock_release(&ws->lock);
+
+    return err;
+}
+
+//--------------------------------------------------------------------------
+gnx_err_t gnx_counters_alloc_thread_bit(
+    gnx_workspace_t *ws,
+    gnx_handle_t *thread_hook,
+    uint32_t *ofs,
+    uint32_t *bit)
+{
+    gnx_counters_t *counters = gnx_counters_get(ws);
+    if (counters == NULL)
+        return GNX_ERR_NOT_SUPPORTED;
+
+    gnx_err_t err = GNX_ERR_OK;
+
+    gnx_os_lock_acquire(&ws->lock);
+    do
+    {
+        uint32_t slot = counters->nb_thread_hooks / 32;
+        if (slot == GNX_THREAD_HOOKS_SLOTS)
+        {
+            err = GNX_ERR_NO_MEM;
+            break;
+        }
+
+        // A new slot every 32 hooks
+        if (counters->nb_thread_hooks % 32 == 0)
+        {
+            err = gnx_os_tls_alloc(
+                &counters->thread_tls_index[slot],
+                &counters->thread_tls_ofs[slot]);
+
+            if (err != GNX_ERR_OK)
+                break;
+        }
+
+        *bit = counters->nb_thread_hooks++ % 32;
+        *ofs = counters->thread_tls_ofs[slot];
+
+        // The handle holds all gnx_hook_thread_enable needs
+        *thread_hook = (gnx_handle_t)(uintptr_t)(((counters->thread_tls_index[slot] << 5) | *bit) + 1);
+    } while (false);
+    gnx_os_lock_release(&ws->lock);
+
+    return err;
+}
+
+//--------------------------------------------------------------------------
+gnx_err_t gnx_counters_get_guard(
+    gnx_workspace_t *ws,
+    uint32_t group,
+    gnx_guard_group_t **guard)
+{
+    gnx_counters_t *counters = gnx_counters_get(ws);
+    if (counters == NULL)
+        return GNX_ERR_NOT_SUPPORTED;
+
+    gnx_guard_group_t *g = &counters->guards[group];
+    gnx_err_t err = GNX_ERR_OK;
+    bool created = false;
+
+    gnx_os_lock_acquire(&ws->lock);
+    do
+    {
+        if (g->exit_thunk != NULL)
+            break;
+
+        err = gnx_os_tls_alloc(&g->ret_index, &g->ret_ofs);
+        if (err != GNX_ERR_OK)
+            break;
+
+        err = gnx_os_tls_alloc(&g->slot_index, &g->slot_ofs);
+        if (err != GNX_ERR_OK)
+        {
+            gnx_os_tls_free(g->ret_index);
+            break;
+        }
+
+        g->exit_thunk = (uint8_t *)gnx_block_chunk_alloc(counters->stubs);
+        if (g->exit_thunk == NULL)
+        {
+            gnx_os_tls_free(g->ret_index);
+            gnx_os_tls_free(g->slot_index);
+            err = GNX_ERR_NO_MEM;
+            break;
+        }
+
+        gen_guard_exit_thunk(g);
+        created = true;
+    } while (false);
+    gnx_os_lock_release(&ws->lock);
+
+    if (created)
+        gnx_code_map_add(ws, g->exit_thunk, GNX_STUB_SIZE, "gnx_guard_exit_thunk", NULL);
+
+    *guard = g;
+
+    return err;
+}
+
+//--------------------------------------------------------------------------
+gnx_err_t GANXO_API gnx_hook_thread_enable(
+    gnx_handle_t thread_hook,
+    bool enable)
+{
+    if (thread_hook == NULL)
+        return GNX_ERR_INVALID_ARGS;
+
+    uint32_t value = (uint32_t)(uintptr_t)thread_hook - 1;
+    uint32_t index = value >> 5;
+    uint32_t mask = 1u << (value & 31);
+
+    // Only the calling thread writes its bits
+    uintptr_t bits = (uintptr_t)gnx_os_tls_get(index);
+    bits = enable ? (bits | mask) : (bits & ~(uintptr_t)mask);
+    gnx_os_tls_set(index, (void *)bits);
+
+    return GNX_ERR_OK;
+}
+
+//--------------------------------------------------------------------------
+// Free a thread's block (or its slot, zeroing its counters for the next thread)
+static void free_block(
+    gnx_counters_t *counters,
+    gnx_counters_block_t *block)
+{
+    if (counters->shm == NULL)
+    {
+        gnx_vmfree(block);
+        return;
+    }
+
+    memset(block->counters, 0, counters->nb_counters * sizeof(gnx_counter_t));
+
+    uint32_t slot = (uint32_t)(((uint8_t *)block - (uint8_t *)shm_slot(counters, 0)) / counters->shm_header->arrays_stride);
+    counters->shm_used[slot] = false;
+}
+
+//--------------------------------------------------------------------------
+void gnx_counters_attach(gnx_thread_rec_t *rec)
+{
+    gnx_counters_t *counters = rec->ws->counters;
+
+    if (counters->shm != NULL)
+    {
+        // A free slot of the shared memory (its counters are zero), or the thread is not tracked
+        rec->counters = NULL;
+        for (uint32_t i = 2; i < counters->shm_nb_slots; i++)
+        {
+            if (!counters->shm_used[i])
+            {
+                counters->shm_used[i] = true;
+                rec->counters = shm_slot(counters, i);
+                break;
+            }
+        }
+    }
+    else
+    {
+        rec->counters = (gnx_counters_block_t *)gnx_vmalloc(sizeof(gnx_counters_block_t), GNX_MEM_READ | GNX_MEM_WRITE);
+    }
+
+    if (rec->counters == NULL)
+        return;
+
+    memset(rec->counters, 0, offsetof(gnx_counters_block_t, counters));
+
+    // A thread without a ring is not tracked at all
+    rec->counters->trace_ring = (gnx_trace_record_t *)gnx_vmalloc(
+        GNX_TRACE_RING_RECORDS * sizeof(gnx_trace_record_t),
+        GNX_MEM_READ | GNX_MEM_WRITE);
+
+    if (rec->counters->trace_ring == NULL)
+    {
+        free_block(counters, rec->counters);
+        rec->counters = NULL;
+        return;
+    }
+
+    gnx_os_tls_set(counters->tls_index, rec->counters);
+}
+
+//--------------------------------------------------------------------------
+void gnx_counters_detach(gnx_thread_rec_t *rec)
+{
+    gnx_counters_t *counters = rec->ws->counters;
+    gnx_counters_block_t *block = rec->counters;
+
+    // The thread may be unregistered (or the workspace closed) from another thread: only its own slot points to the block
+    if (gnx_os_tls_get(counters->tls_index) == block)
+        gnx_os_tls_set(counters->tls_index, NULL);
+
+    // Keep the counts of the thread (the caller holds the workspace lock)
+    for (uint32_t i = 0; i < counters->nb_counters; i++)
+    {
+        gnx_counter_t *retired = &counters->retired[i];
+        gnx_counter_t *counter = &block->counters[i];
+
+        retired->calls += counter->calls;
+        retired->cycles += counter->cycles;
+        for (int j = 0; j < GNX_HOOK_HISTOGRAM_SIZE; j++)
+            retired->histogram[j] += counter->histogram[j];
+    }
+
+    // And its records
+    if (counters->trace != NULL)
+        gnx_trace_drain_ring(counters, block, true);
+
+    rec->counters = NULL;
+    gnx_vmfree(block->trace_ring);
+    free_block(counters, block);
+}
+
+//--------------------------------------------------------------------------
+void gnx_counters_free(gnx_workspace_t *ws)
+{
+    gnx_counters_t *counters = ws->counters;
+    if (counters == NULL)
+        return;
+
+    gnx_os_tls_free(counters->tls_index);
+    for (uint32_t i = 0; i < (counters->nb_thread_hooks + 31) / 32; i++)
+        gnx_os_tls_free(counters->thread_tls_index[i]);
+
+    for (uint32_t i = 0; i < GNX_GUARD_GROUPS; i++)
+    {
+        if (counters->guards[i].exit_thunk != NULL)
+        {
+            gnx_os_tls_free(counters->guards[i].ret_index);
+            gnx_os_tls_free(counters->guards[i].slot_index);
+        }
+    }
+
+    gnx_block_free(counters->stubs);
+
+    if (counters->shm != NULL)
+    {
+        gnx_os_shm_free(counters->shm, counters->shm_header);
+        gnx_mfree(counters->shm_used);
+    }
+    else
+    {
+        gnx_vmfree(counters->shared);
+        gnx_vmfree(counters->retired);
+    }
+
+    gnx_vmfree(counters->control);
+    GNX_FREE(counters);
+
+    ws->counters = NULL;
+}
+
+//--------------------------------------------------------------------------
+static void add_counter(
+    gnx_hook_counters_t *result,
+    const gnx_counter_t *counter)
+{
+    result->calls += counter->calls;
+    result->cycles += counter->cycles;
+    for (int i = 0; i < GNX_HOOK_HISTOGRAM_SIZE; i++)
+        result->histogram[i] += counter->histogram[i];
+}
+
+//--------------------------------------------------------------------------
+void gnx_counters_sum(
+    gnx_workspace_t *ws,
+    uint32_t index,
+    gnx_hook_counters_t *result)
+{
+    gnx_counters_t *counters = ws->counters;
+
+    memset(result, 0, sizeof(*result));
+    add_counter(result, &counters->shared[index]);
+    add_counter(result, &counters->retired[index]);
+
+    // The counts of the running threads may be a few calls behind
+    for (gnx_singly_list_item_t *cur = ws->threads.next; cur != NULL; cur = cur->next)
+    {
+        gnx_thread_rec_t *rec = GNX_SINGLY_LIST_RECORD(
+            cur,
+            gnx_thread_rec_t);
+
+        if (rec->counters != NULL)
+            add_counter(result, &rec->counters->counters[index]);
+    }
+}
+
+//--------------------------------------------------------------------------
+gnx_err_t GANXO_API gnx_hook_get_counters(
+    gnx_handle_t handle,
+    gnx_handle_t counter,
+    gnx_hook_counters_t *result)
+{
+    GET_WORKSPACE;
+
+    gnx_counters_t *counters = ws->counters;
+    uint32_t index = (uint32_t)(uintptr_t)counter - 1;
+    if (counters == NULL || result == NULL || index >= counters->nb_counters)
+        return GNX_ERR_INVALID_ARGS;
+
+    gnx_os_lock_acquire(&ws->lock);
+    gnx_counters_sum(ws, index, result);
+    gnx_os_lock_release(&ws->lock);
+
+    return GNX_ERR_OK;
+}
+
+//--------------------------------------------------------------------------
+uint32_t gnx_counters_get_sampling(
+    gnx_counters_t *counters,
+    uint32_t index)
+{
+    gnx_stub_control_t *control = &counters->control[index];
+
+    return control->dispatch == control->body ? control->sample_mask + 1 : GNX_SAMPLING_DISABLED;
+}
+
+//--------------------------------------------------------------------------
+uint32_t gnx_counters_set_sampling(
+    gnx_counters_t *counters,
+    uint32_t index,
+    uint32_t sampling)
+{
+    gnx_stub_control_t *control = &counters->control[index];
+    uint32_t old_sampling = gnx_counters_get_sampling(counters, index);
+
+    // The threads in the stub meanwhile see either value: both are consistent
+    if (sampling == GNX_SAMPLING_DISABLED)
+    {
+        control->dispatch = control->springboard;
+    }
+    else
+    {
+        control->sample_mask = sampling - 1;
+        control->dispatch = control->body;
+    }
+
+    return old_sampling;
+}
+
+//--------------------------------------------------------------------------
+gnx_err_t GANXO_API gnx_hook_set_sampling(
+    gnx_handle_t handle,
+    gnx_handle_t counter,
+    uint32_t sampling)
+{
+    GET_WORKSPACE;
+
+    gnx_counters_t *counters = ws->counters;
+    uint32_t index = (uint32_t)(uintptr_t)counter - 1;
+    if (counters == NULL || index >= counters->nb_counters || (sampling & (sampling - 1)) != 0)
+        return GNX_ERR_INVALID_ARGS;
+
+    // Only the timed calls are sampled
+    if (sampling > GNX_SAMPLING_ALL && !GNX_HAS_FLAG(counters->control[index].flags, GNX_COUNT_CYCLES))
+        return GNX_ERR_INVALID_ARGS;
+
+    gnx_os_lock_acquire(&ws->lock);
+    gnx_counters_set_sampling(counters, index, sampling);
+    gnx_os_lock_release(&ws->lock);
+
+    return GNX_ERR_OK;
+}
@@ -1 +1 @@
-#include "private.h"
+#include "private.h"
@@ -1,22 +1,295 @@
-#include <ganxo.h>
-
-//--------------------------------------------------------------------------
-bool GANXO_API gnx_singly_list_remove(
-    gnx_singly_list_item_t *head,
-    gnx_singly_list_item_t *entry)
-{
-    gnx_singly_list_item_t *last = head;
-    // Find the node
-    for (gnx_singly_list_item_t *cur = head->next; cur != NULL; cur = cur->next)
-    {
-        if (cur == entry)
-        {
-            // Link previous node with next node (unlink current node)
-            last->next = cur->next;
-            return true;
-        }
-        last = cur;
-    }
-
-    return false;
-}
+#include "private.h"
+#include <stdlib.h>
+
+//--------------------------------------------------------------------------
+bool GANXO_API gnx_singly_list_remove(
+    gnx_singly_list_item_t *head,
+    gnx_singly_list_item_t *entry)
+{
+    gnx_singly_list_item_t *last = head;
+    // Find the node
+    for (gnx_singly_list_item_t *cur = head->next; cur != NULL; cur = cur->next)
+    {
+        if (cur == entry)
+        {
+            // Link previous node with next node (unlink current node)
+            last->next = cur->next;
+            return true;
+        }
+        last = cur;
+    }
+
+    return false;
+}
+
+//--------------------------------------------------------------------------
+// Range map: a sorted array of ranges published RCU style.
+// The updates build a new array and swap it in, the readers only count themselves in
+// around the binary search, in the counter of the current epoch parity. Each update moves
+// to the next epoch once the readers of the previous one drained: the new readers use the
+// other counter, so a counter drains even under a constant lookup traffic. An array
+// replaced during epoch E is only used by the readers of epochs E-1 and E, so it is freed
+// once the epoch reached E+2.
+//--------------------------------------------------------------------------
+
+/// Sorted ranges snapshot
+typedef struct __gnx_range_array_t
+{
+    struct __gnx_range_array_t *retired_next;   ///< Next replaced array waiting to be freed
+    long retired_epoch;                         ///< Epoch the array was replaced in
+    size_t nb_ranges;
+    gnx_range_t ranges[1];
+} gnx_range_array_t;
+
+/// Range map
+typedef struct __gnx_range_map_t
+{
+    gnx_range_array_t * volatile ranges;        ///< Current snapshot (NULL when empty)
+    volatile long epoch;                        ///< Only moved by the updates
+    volatile long nb_readers[2];                ///< Count of lookups in progress, by epoch parity
+    gnx_range_array_t *retired;                 ///< Replaced arrays not freed yet (most recent first)
+} gnx_range_map_t;
+
+//--------------------------------------------------------------------------
+static int __cdecl compare_ranges(
+    const void *a,
+    const void *b)
+{
+    const uint8_t *pa = (const uint8_t *)((const gnx_range_t *)a)->start;
+    const uint8_t *pb = (const uint8_t *)((const gnx_range_t *)b)->start;
+
+    return pa < pb ? -1 : (pa > pb ? 1 : 0);
+}
+
+//--------------------------------------------------------------------------
+static int __cdecl compare_addresses(
+    const void *a,
+    const void *b)
+{
+    const uint8_t *pa = *(const uint8_t * const *)a;
+    const uint8_t *pb = *(const uint8_t * const *)b;
+
+    return pa < pb ? -1 : (pa > pb ? 1 : 0);
+}
+
+//--------------------------------------------------------------------------
+// Free the replaced arrays when no lookup may still be using them
+static void reclaim_range_arrays(gnx_range_map_t *map)
+{
+    // The readers of the previous epoch are gone: its counter can be reused by the next one
+    long epoch = map->epoch;
+    if (map->nb_readers[(epoch + 1) & 1] == 0)
+        epoch = gnx_atomic_fetch_add(&map->epoch, 1) + 1;
+
+    gnx_range_array_t **link = &map->retired;
+    while (*link != NULL && (*link)->retired_epoch > epoch - 2)
+        link = &(*link)->retired_next;
+
+    while (*link != NULL)
+    {
+        gnx_range_array_t *array = *link;
+        *link = array->retired_next;
+        gnx_mfree(array);
+    }
+}
+
+//--------------------------------------------------------------------------
+gnx_handle_t GANXO_API gnx_range_map_create(void)
+{
+    gnx_range_map_t *map = GNX_ALLOC(gnx_range_map_t);
+    if (map == NULL)
+        return GNX_INVALID_HANDLE;
+
+    map->ranges = NULL;
+    map->epoch = 0;
+    map->nb_readers[0] = 0;
+    map->nb_readers[1] = 0;
+    map->retired = NULL;
+
+    return (gnx_handle_t)map;
+}
+
+//--------------------------------------------------------------------------
+void GANXO_API gnx_range_map_free(gnx_handle_t handle)
+{
+    gnx_range_map_t *map = (gnx_range_map_t *)handle;
+
+    gnx_mfree(map->ranges);
+    while (map->retired != NULL)
+    {
+        gnx_range_array_t *array = map->retired;
+        map->retired = array->retired_next;
+        gnx_mfree(array);
+    }
+
+    gnx_mfree(map);
+}
+
+//--------------------------------------------------------------------------
+gnx_err_t GANXO_API gnx_range_map_update(
+    gnx_handle_t handle,
+    const gnx_range_t *added,
+    size_t nb_added,
+    const void * const *removed,
+    size_t nb_removed)
+{
+    gnx_range_map_t *map = (gnx_range_map_t *)handle;
+    gnx_range_array_t *old_array = map->ranges;
+    size_t nb_old = old_array != NULL ? old_array->nb_ranges : 0;
+
+    gnx_err_t err = GNX_ERR_OK;
+    gnx_range_t *sorted_added = NULL;
+    const void **sorted_removed = NULL;
+    gnx_range_array_t *new_array = NULL;
+    do
+    {
+        // Sort the changes so that they are merged in a single pass
+        sorted_added = (gnx_range_t *)gnx_malloc((nb_added + 1) * sizeof(gnx_range_t));
+        sorted_removed = (const void **)gnx_malloc((nb_removed + 1) * sizeof(void *));
+        new_array = (gnx_range_array_t *)gnx_malloc(
+            sizeof(gnx_range_array_t) + (nb_old + nb_added) * sizeof(gnx_range_t));
+
+        if (sorted_added == NULL || sorted_removed == NULL || new_array == NULL)
+        {
+            err = GNX_ERR_NO_MEM;
+            break;
+        }
+
+        memcpy(sorted_added, added, nb_added * sizeof(gnx_range_t));
+        qsort(sorted_added, nb_added, sizeof(gnx_range_t), compare_ranges);
+
+        memcpy(sorted_removed, removed, nb_removed * sizeof(void *));
+        qsort(sorted_removed, nb_removed, sizeof(void *), compare_addresses);
+
+        // Merge the kept ranges with the added ones
+        size_t i_old = 0, i_add = 0, i_del = 0, n = 0;
+        for (;;)
+        {
+            const gnx_range_t *range;
+            if (i_old < nb_old && (i_add == nb_added || compare_ranges(&old_array->ranges[i_old], &sorted_added[i_add]) <= 0))
+            {
+                range = &old_array->ranges[i_old++];
+
+                // Skip the removed ranges
+                while (i_del < nb_removed && (const uint8_t *)sorted_removed[i_del] < (const uint8_t *)range->start)
+                    ++i_del;
+                if (i_del < nb_removed && sorted_removed[i_del] == range->start)
+                    continue;
+            }
+            else if (i_add < nb_added)
+            {
+                range = &sorted_added[i_add++];
+            }
+            else
+            {
+                break;
+            }
+
+            // The ranges never overlap
+            if (n != 0)
+            {
+                const gnx_range_t *last = &new_array->ranges[n - 1];
+                if ((const uint8_t *)last->start + last->size > (const uint8_t *)range->start)
+                {
+                    err = GNX_ERR_INVALID_ARGS;
+                    break;
+                }
+            }
+            new_array->ranges[n++] = *range;
+        }
+
+        if (err != GNX_ERR_OK)
+            break;
+
+        new_array->nb_ranges = n;
+        new_array->retired_next = NULL;
+
+        // Publish the new snapshot (full barrier) then retire the old one
+        gnx_atomic_xchg_ptr(&map->ranges, n != 0 ? new_array : NULL);
+        if (n == 0)
+            gnx_mfree(new_array);
+
+        if (old_array != NULL)
+        {
+            old_array->retired_epoch = map->epoch;
+            old_array->retired_next = map->retired;
+            map->retired = old_array;
+        }
+        new_array = NULL;
+
+        reclaim_range_arrays(map);
+    } while (false);
+
+    gnx_mfree(sorted_added);
+    gnx_mfree((void *)sorted_removed);
+    if (new_array != NULL)
+        gnx_mfree(new_array);
+
+    return err;
+}
+
+//--------------------------------------------------------------------------
+bool GANXO_API gnx_range_map_find(
+    gnx_handle_t handle,
+    const void *addr,
+    gnx_range_t *range)
+{
+    gnx_range_map_t *map = (gnx_range_map_t *)handle;
+    const uint8_t *p = (const uint8_t *)addr;
+    bool found = false;
+
+    // Counted in before reading the snapshot: it cannot be freed until counted out
+    volatile long *nb_readers = &map->nb_readers[map->epoch & 1];
+    gnx_atomic_fetch_add(nb_readers, 1);
+
+    gnx_range_array_t *array = map->ranges;
+    if (array != NULL)
+    {
+        // Find the last range starting at or before the address
+        size_t lo = 0, hi = array->nb_ranges;
+        while (lo < hi)
+        {
+            size_t mid = (lo + hi) / 2;
+            if ((const uint8_t *)array->ranges[mid].start <= p)
+                lo = mid + 1;
+            else
+                hi = mid;
+        }
+
+        if (lo != 0)
+        {
+            const gnx_range_t *candidate = &array->ranges[lo - 1];
+            if (p < (const uint8_t *)candidate->start + candidate->size)
+            {
+                *range = *candidate;
+                found = true;
+            }
+        }
+    }
+
+    gnx_atomic_fetch_add(nb_readers, -1);
+
+    return found;
+}
+
+//--------------------------------------------------------------------------
+size_t GANXO_API gnx_range_map_copy(
+    gnx_handle_t handle,
+    gnx_range_t *ranges,
+    size_t max_ranges)
+{
+    gnx_range_map_t *map = (gnx_range_map_t *)handle;
+
+    // A single snapshot, like the lookups
+    volatile long *nb_readers = &map->nb_readers[map->epoch & 1];
+    gnx_atomic_fetch_add(nb_readers, 1);
+
+    gnx_range_array_t *array = map->ranges;
+    size_t nb_ranges = array != NULL ? array->nb_ranges : 0;
+    if (ranges != NULL && nb_ranges != 0)
+        memcpy(ranges, array->ranges, (nb_ranges < max_ranges ? nb_ranges : max_ranges) * sizeof(gnx_range_t));
+
+    gnx_atomic_fetch_add(nb_readers, -1);
+
+    return nb_ranges;
+}
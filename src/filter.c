@@ -0,0 +1,426 @@
+#include "private.h"
+#include <errno.h>
+#include <stdlib.h>
+
+//--------------------------------------------------------------------------
+// Hook filters.
+//
+// A filter expression is parsed once, then compiled in a stub placed before the hook function:
+//
+//      expr     := and_expr ('||' and_expr)*
+//      and_expr := primary ('&&' primary)*
+//      primary  := '(' expr ')' | compare
+//      compare  := value ('==' | '!=' | '<' | '<=' | '>' | '>=') number
+//      value    := operand ['&' number] | '(' operand '&' number ')'
+//      operand  := 'arg'N | 'ecx' | 'edx'
+//
+// Each comparison compiles to a load, an optional and, a cmp and a single conditional branch: the
+// and/or operators only choose where the branches go (short circuit), so no value is ever pushed.
+//--------------------------------------------------------------------------
+
+#define MAX_STACK_ARGS 16
+
+/// Parser state
+typedef struct __gnx_filter_parser_t
+{
+    const char *p;
+    gnx_filter_t *filter;
+} gnx_filter_parser_t;
+
+//--------------------------------------------------------------------------
+static void skip_spaces(gnx_filter_parser_t *ps)
+{
+    while (*ps->p == ' ' || *ps->p == '\t')
+        ps->p++;
+}
+
+//--------------------------------------------------------------------------
+// Consume a token, if it comes next
+static bool accept(
+    gnx_filter_parser_t *ps,
+    const char *token)
+{
+    skip_spaces(ps);
+
+    size_t len = strlen(token);
+    if (strncmp(ps->p, token, len) != 0)
+        return false;
+
+    // The mask is not the start of '&&'
+    if (len == 1 && token[0] == '&' && ps->p[1] == '&')
+        return false;
+
+    ps->p += len;
+    return true;
+}
+
+//--------------------------------------------------------------------------
+static bool is_ident_char(char c)
+{
+    return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') || c == '_';
+}
+
+//--------------------------------------------------------------------------
+static bool is_hex_digit(char c)
+{
+    return (c >= '0' && c <= '9') || (c >= 'a' && c <= 'f') || (c >= 'A' && c <= 'F');
+}
+
+//--------------------------------------------------------------------------
+// Decimal, or hexadecimal after an explicit '0x' (a leading zero is not octal)
+static bool parse_number(
+    gnx_filter_parser_t *ps,
+    uint32_t *value)
+{
+    skip_spaces(ps);
+
+    if (*ps->p < '0' || *ps->p > '9')
+        return false;
+
+    int base = 10;
+    const char *digits = ps->p;
+    if (digits[0] == '0' && (digits[1] == 'x' || digits[1] == 'X'))
+    {
+        // strtoull would accept spaces or a sign after the prefix
+        base = 16;
+        digits += 2;
+        if (!is_hex_digit(*digits))
+            return false;
+    }
+
+    char *end;
+    errno = 0;
+    unsigned long long number = strtoull(digits, &end, base);
+    if (errno == ERANGE || number > UINT32_MAX)
+        return false;
+
+    *value = (uint32_t)number;
+    ps->p = end;
+
+    return !is_ident_char(*ps->p);
+}
+
+//--------------------------------------------------------------------------
+static bool parse_operand(
+    gnx_filter_parser_t *ps,
+    uint8_t *operand)
+{
+    skip_spaces(ps);
+
+    const char *start = ps->p;
+    while (is_ident_char(*ps->p))
+        ps->p++;
+
+    size_t len = ps->p - start;
+    if (len == 3 && strncmp(start, "ecx", 3) == 0)
+    {
+        *operand = GNX_FILTER_ECX;
+        return true;
+    }
+
+    if (len == 3 && strncmp(start, "edx", 3) == 0)
+    {
+        *operand = GNX_FILTER_EDX;
+        return true;
+    }
+
+    if (len < 4 || len > 5 || strncmp(start, "arg", 3) != 0)
+        return false;
+
+    uint32_t index = 0;
+    for (const char *c = start + 3; c < ps->p; c++)
+    {
+        if (*c < '0' || *c > '9')
+            return false;
+
+        index = index * 10 + (*c - '0');
+    }
+
+    *operand = (uint8_t)index;
+    return index < MAX_STACK_ARGS;
+}
+
+//--------------------------------------------------------------------------
+static int new_node(
+    gnx_filter_parser_t *ps,
+    uint8_t type)
+{
+    gnx_filter_t *filter = ps->filter;
+    if (filter->nb_nodes == sizeof(filter->nodes) / sizeof(filter->nodes[0]))
+        return -1;
+
+    gnx_filter_node_t *node = &filter->nodes[filter->nb_nodes];
+    memset(node, 0, sizeof(*node));
+    node->type = type;
+
+    return (int)filter->nb_nodes++;
+}
+
+//--------------------------------------------------------------------------
+// The comparison operator and its number, once the compared value is parsed
+static int parse_compare_rest(
+    gnx_filter_parser_t *ps,
+    uint8_t operand,
+    uint32_t mask)
+{
+    // The longer operators first
+    static const struct
+    {
+        const char *token;
+        uint8_t cond;
+    } ops[] =
+    {
+        { "==", 0x4 },  // e
+        { "!=", 0x5 },  // ne
+        { "<=", 0x6 },  // be
+        { ">=", 0x3 },  // ae
+        { "<",  0x2 },  // b
+        { ">",  0x7 },  // a
+    };
+
+    size_t i;
+    for (i = 0; i < sizeof(ops) / sizeof(ops[0]); i++)
+    {
+        if (accept(ps, ops[i].token))
+            break;
+    }
+
+    uint32_t value;
+    if (i == sizeof(ops) / sizeof(ops[0]) || !parse_number(ps, &value))
+        return -1;
+
+    if (++ps->filter->nb_terms > GNX_FILTER_MAX_TERMS)
+        return -1;
+
+    int index = new_node(ps, GNX_FILTER_COMPARE);
+    if (index < 0)
+        return -1;
+
+    gnx_filter_node_t *node = &ps->filter->nodes[index];
+    node->operand = operand;
+    node->mask = mask;
+    node->cond = ops[i].cond;
+    node->value = value;
+
+    return index;
+}
+
+static int parse_or(gnx_filter_parser_t *ps);
+
+//--------------------------------------------------------------------------
+static int parse_primary(gnx_filter_parser_t *ps)
+{
+    uint8_t operand;
+    uint32_t mask = 0xFFFFFFFF;
+
+    if (accept(ps, "("))
+    {
+        // A masked operand...
+        const char *save = ps->p;
+        if (    parse_operand(ps, &operand)
+            &&  (!accept(ps, "&") || parse_number(ps, &mask))
+            &&  accept(ps, ")"))
+        {
+            return parse_compare_rest(ps, operand, mask);
+        }
+
+        // ...or a sub-expression
+        ps->p = save;
+        int index = parse_or(ps);
+        if (index < 0 || !accept(ps, ")"))
+            return -1;
+
+        return index;
+    }
+
+    if (!parse_operand(ps, &operand))
+        return -1;
+
+    if (accept(ps, "&") && !parse_number(ps, &mask))
+        return -1;
+
+    return parse_compare_rest(ps, operand, mask);
+}
+
+//--------------------------------------------------------------------------
+// Parse a chain of operands of the same and/or operator
+static int parse_binary(
+    gnx_filter_parser_t *ps,
+    const char *token,
+    uint8_t type,
+    int (*parse_operand_expr)(gnx_filter_parser_t *))
+{
+    int left = parse_operand_expr(ps);
+    while (left >= 0 && accept(ps, token))
+    {
+        int right = parse_operand_expr(ps);
+        if (right < 0)
+            return -1;
+
+        int index = new_node(ps, type);
+        if (index < 0)
+            return -1;
+
+        ps->filter->nodes[index].left = (uint8_t)left;
+        ps->filter->nodes[index].right = (uint8_t)right;
+        left = index;
+    }
+
+    return left;
+}
+
+//--------------------------------------------------------------------------
+static int parse_and(gnx_filter_parser_t *ps)
+{
+    return parse_binary(ps, "&&", GNX_FILTER_AND, parse_primary);
+}
+
+//--------------------------------------------------------------------------
+static int parse_or(gnx_filter_parser_t *ps)
+{
+    return parse_binary(ps, "||", GNX_FILTER_OR, parse_and);
+}
+
+//--------------------------------------------------------------------------
+gnx_err_t gnx_filter_parse(
+    const char *text,
+    gnx_filter_t *filter)
+{
+    filter->nb_nodes = 0;
+    filter->nb_terms = 0;
+
+    gnx_filter_parser_t ps = { text, filter };
+    int root = parse_or(&ps);
+
+    skip_spaces(&ps);
+    if (root < 0 || *ps.p != '\0')
+        return GNX_ERR_INVALID_ARGS;
+
+    filter->root = (uint32_t)root;
+
+    return GNX_ERR_OK;
+}
+
+#if defined(GANXO_ARCH_X86)
+
+//--------------------------------------------------------------------------
+// Forward branch target: each comparison branches once at most
+typedef struct __gnx_filter_label_t
+{
+    uint8_t *sites[GNX_FILTER_MAX_TERMS]; ///< rel32 of the branches to this label
+    uint32_t nb_sites;
+} gnx_filter_label_t;
+
+static void emit_jcc_to(
+    gnx_emitter_t *e,
+    uint8_t cond,
+    gnx_filter_label_t *label)
+{
+    *e->p++ = 0x0F;
+    *e->p++ = (uint8_t)(0x80 | cond);
+    label->sites[label->nb_sites++] = e->p;
+    gnx_emit32(e, 0);
+}
+
+static void bind_label(
+    gnx_emitter_t *e,
+    gnx_filter_label_t *label)
+{
+    for (uint32_t i = 0; i < label->nb_sites; i++)
+    {
+        uint32_t rel = (uint32_t)(e->p - (label->sites[i] + sizeof(uint32_t)));
+        memcpy(label->sites[i], &rel, sizeof(rel));
+    }
+}
+
+//--------------------------------------------------------------------------
+// Branch to the label if the node evaluates to 'when', fall through otherwise
+static void gen_branch(
+    gnx_emitter_t *e,
+    const gnx_filter_t *filter,
+    uint32_t index,
+    bool when,
+    gnx_filter_label_t *target)
+{
+    const gnx_filter_node_t *node = &filter->nodes[index];
+
+    if (node->type == GNX_FILTER_COMPARE)
+    {
+        if (node->operand == GNX_FILTER_ECX)
+        {
+            gnx_emit(e, "\x8B\xC1", 2);                 // mov eax, ecx
+        }
+        else if (node->operand == GNX_FILTER_EDX)
+        {
+            gnx_emit(e, "\x8B\xC2", 2);                 // mov eax, edx
+        }
+        else
+        {
+            gnx_emit(e, "\x8B\x44\x24", 3);             // mov eax, [esp + 8 + 4 * arg] ; past the saved eax and the return address
+            *e->p++ = (uint8_t)(8 + 4 * node->operand);
+        }
+
+        if (node->mask != 0xFFFFFFFF)
+        {
+            gnx_emit(e, "\x25", 1);                     // and eax, mask
+            gnx_emit32(e, node->mask);
+        }
+
+        gnx_emit(e, "\x3D", 1);                         // cmp eax, value
+        gnx_emit32(e, node->value);
+
+        // The opposite condition code only differs by its low bit
+        emit_jcc_to(e, when ? node->cond : (uint8_t)(node->cond ^ 1), target);
+        return;
+    }
+
+    // Short circuit: the left operand alone decides when it is true for 'or' (false for 'and')
+    bool decisive = node->type == GNX_FILTER_OR;
+    if (decisive == when)
+    {
+        gen_branch(e, filter, node->left, when, target);
+        gen_branch(e, filter, node->right, when, target);
+    }
+    else
+    {
+        gnx_filter_label_t skip = { { NULL }, 0 };
+        gen_branch(e, filter, node->left, decisive, &skip);
+        gen_branch(e, filter, node->right, when, target);
+        bind_label(e, &skip);
+    }
+}
+
+//--------------------------------------------------------------------------
+void gnx_filter_gen_stub(
+    const gnx_filter_t *filter,
+    uint8_t *stub,
+    const void *hook,
+    const void *springboard)
+{
+    gnx_emitter_t e = { stub, stub };
+    gnx_filter_label_t miss = { { NULL }, 0 };
+
+    // Up to 20 bytes per comparison and 13 more: GNX_FILTER_MAX_TERMS fit in a stub
+    gnx_emit(&e, "\x50", 1);                            // push eax
+    gen_branch(&e, filter, filter->root, false, &miss);
+    gnx_emit(&e, "\x58", 1);                            // pop eax
+    gnx_emit_jmp(&e, hook);                             // jmp hook
+
+    bind_label(&e, &miss);                              // miss:
+    gnx_emit(&e, "\x58", 1);                            // pop eax
+    gnx_emit_jmp(&e, springboard);                      // jmp springboard
+}
+
+#else
+
+//--------------------------------------------------------------------------
+void gnx_filter_gen_stub(
+    const gnx_filter_t *filter,
+    uint8_t *stub,
+    const void *hook,
+    const void *springboard)
+{
+    // Never called: no stubs without the counters (\ref gnx_counters_get)
+}
+
+#endif
@@ -1,176 +1,361 @@
-#include "private.h"
-
-//--------------------------------------------------------------------------
-// Platform APIs
-//--------------------------------------------------------------------------
-
-static gnx_platform_apis_t papis = { 0 };
-
-#if defined(GANXO_PLATFORM_WINDOWS)
-	#include "win-papi-impl.c"
-#endif
-
-// malloc()
-void *GANXO_API gnx_malloc(size_t size)
-{
-	return papis.malloc(size);
-}
-
-// free()
-void GANXO_API gnx_mfree(void *block)
-{
-	papis.mfree(block);
-}
-
-// vmalloc()
-void *GANXO_API gnx_vmalloc(
-	size_t size,
-	gnx_mem_flags_t flags)
-{
-	return papis.vmalloc(size, flags);
-}
-
-// vmprotect()
-gnx_err_t GANXO_API gnx_vmprotect(
-    const void *block,
-    size_t size,
-    gnx_mem_flags_t flags,
-    gnx_mem_flags_t *old_flags)
-{
-    return papis.vmprotect(
-        block, 
-        size, 
-        flags, 
-        old_flags);
-}
-
-// vmfree()
-gnx_err_t GANXO_API gnx_vmfree(void *block)
-{
-	return papis.vmfree(block);
-}
-
-gnx_err_t GANXO_API gnx_flush_instruction_cache(
-    void *proc,
-    const void *address,
-    size_t size)
-{
-    return papis.flush_instruction_cache(proc, address, size);
-}
-
-//--------------------------------------------------------------------------
-gnx_err_t GANXO_API gnx_set_platform_apis(gnx_platform_apis_t *apis)
-{
-	if (apis == NULL || apis->cb != sizeof(gnx_platform_apis_t))
-		return GNX_ERR_INVALID_ARGS;
-
-	// Overwrite assigned callbacks
-	if (apis->malloc != NULL)
-		papis.malloc = apis->malloc;
-
-	if (apis->mfree != NULL)
-		papis.mfree = apis->mfree;
-
-	if (apis->vmalloc != NULL)
-		papis.vmalloc = apis->vmalloc;
-
-	if (apis->vmfree != NULL)
-		papis.vmfree = apis->vmfree;
-
-    if (apis->vmprotect != NULL)
-        papis.vmprotect = apis->vmprotect;
-
-    if (apis->flush_instruction_cache != NULL)
-        papis.flush_instruction_cache = apis->flush_instruction_cache;
-
-	// TODO: pass and update CS_OPT_MEM accordingly
-	return GNX_ERR_OK;
-}
-
-//--------------------------------------------------------------------------
-// Initialize Ganxo
-gnx_err_t GANXO_API gnx_init(void)
-{
-    // Set the default helper APIs for the current platform
-	set_default_platform_apis();
-
-    // Check if Capstone is compiled with support for the same architecture as Ganxo
-	return cs_support(GNX_CS_ARCH) ? GNX_ERR_OK : GNX_ERR_NOT_SUPPORTED;
-}
-
-//--------------------------------------------------------------------------
-gnx_err_t GANXO_API gnx_open(gnx_handle_t *handle)
-{
-    gnx_err_t err;
-    gnx_workspace_t *ws;
-    do
-    {
-        // Create a new workspace
-        ws = GNX_ALLOC(gnx_workspace_t);
-        if (ws == NULL)
-        {
-            err = GNX_ERR_NO_MEM;
-            break;
-        }
-
-        // Create disassembler for the workspace
-        ws->dis = gnx_disasm_create();
-        if (ws->dis == GNX_INVALID_HANDLE)
-        {
-            err = GNX_ERR_DISASM;
-            break;
-        }
-
-        //
-        // Create user hooks blocks
-        // (it will be used for springboard allocations)
-        //
-        gnx_block_options_t bo;
-        bo.block_size           = 4096 * 10; // 10 pages block size
-        bo.chunk_align          = 0x10; // Align the first chunk (springboards in this case) to 16 bytes
-        
-        // User hooks require a plain springboard with no special dispatcher
-        bo.chunk_size = sizeof(userhook_springboard_t);
-        // Default block allocation
-        bo.vmflags = GNX_MEM_RWX;
-
-        // Attempt to create the block
-        ws->user_hooks = gnx_block_create(&bo);
-        if (ws->user_hooks == GNX_INVALID_HANDLE)
-        {
-            err = GNX_ERR_NO_MEM;
-            break;
-        }
-
-        // Return the workspace handle
-        *handle = (gnx_handle_t)ws;
-
-        // Success
-        return GNX_ERR_OK;
-    } while (false);
-
-    //
-    // Failure cleanup from here on
-    //
-    if (ws->dis != GNX_INVALID_HANDLE)
-        gnx_disasm_free(ws->dis);
-
-    if (ws->user_hooks != GNX_INVALID_HANDLE)
-        gnx_block_free(ws->user_hooks);
-
-    if (ws != NULL)
-        gnx_mfree(ws);
-
-    *handle = GNX_INVALID_HANDLE;
-	return err;
-}
-
-//--------------------------------------------------------------------------
-void GANXO_API gnx_close(gnx_handle_t handle)
-{
-	GET_WORKSPACE;
-
-    gnx_disasm_free(ws->dis);
-    gnx_block_free(ws->user_hooks);
-	gnx_mfree(ws);
-}
\ No newline at end of file
+#include "private.h"
+
+//--------------------------------------------------------------------------
+// Platform APIs
+//--------------------------------------------------------------------------
+
+static gnx_platform_apis_t papis = { 0 };
+
+#if defined(GANXO_PLATFORM_WINDOWS)
+	#include "win-papi-impl.c"
+#endif
+
+// malloc()
+void *GANXO_API gnx_malloc(size_t size)
+{
+	return papis.malloc(size);
+}
+
+// free()
+void GANXO_API gnx_mfree(void *block)
+{
+	papis.mfree(block);
+}
+
+// vmalloc()
+void *GANXO_API gnx_vmalloc(
+	size_t size,
+	gnx_mem_flags_t flags)
+{
+	return papis.vmalloc(size, flags);
+}
+
+// vmprotect()
+gnx_err_t GANXO_API gnx_vmprotect(
+    const void *block,
+    size_t size,
+    gnx_mem_flags_t flags,
+    gnx_mem_flags_t *old_flags)
+{
+    return papis.vmprotect(
+        block, 
+        size, 
+        flags, 
+        old_flags);
+}
+
+// vmfree()
+gnx_err_t GANXO_API gnx_vmfree(void *block)
+{
+	return papis.vmfree(block);
+}
+
+gnx_err_t GANXO_API gnx_flush_instruction_cache(
+    void *proc,
+    const void *address,
+    size_t size)
+{
+    return papis.flush_instruction_cache(proc, address, size);
+}
+
+//--------------------------------------------------------------------------
+gnx_err_t GANXO_API gnx_set_platform_apis(gnx_platform_apis_t *apis)
+{
+	if (apis == NULL || apis->cb != sizeof(gnx_platform_apis_t))
+		return GNX_ERR_INVALID_ARGS;
+
+	// Overwrite assigned callbacks
+	if (apis->malloc != NULL)
+		papis.malloc = apis->malloc;
+
+	if (apis->mfree != NULL)
+		papis.mfree = apis->mfree;
+
+	if (apis->vmalloc != NULL)
+		papis.vmalloc = apis->vmalloc;
+
+	if (apis->vmfree != NULL)
+		papis.vmfree = apis->vmfree;
+
+    if (apis->vmprotect != NULL)
+        papis.vmprotect = apis->vmprotect;
+
+    if (apis->flush_instruction_cache != NULL)
+        papis.flush_instruction_cache = apis->flush_instruction_cache;
+
+	// TODO: pass and update CS_OPT_MEM accordingly
+	return GNX_ERR_OK;
+}
+
+//--------------------------------------------------------------------------
+// Initialize Ganxo
+gnx_err_t GANXO_API gnx_init(void)
+{
+    // Set the default helper APIs for the current platform
+	set_default_platform_apis();
+
+    gnx_live_patch_init();
+
+    // Check if Capstone is compiled with support for the same architecture as Ganxo
+	return cs_support(GNX_CS_ARCH) ? GNX_ERR_OK : GNX_ERR_NOT_SUPPORTED;
+}
+
+//--------------------------------------------------------------------------
+gnx_err_t GANXO_API gnx_open(gnx_handle_t *handle)
+{
+    gnx_err_t err;
+    gnx_workspace_t *ws;
+    do
+    {
+        // Create a new workspace
+        ws = GNX_ALLOC(gnx_workspace_t);
+        if (ws == NULL)
+        {
+            err = GNX_ERR_NO_MEM;
+            break;
+        }
+        memset(ws, 0, sizeof(*ws));
+        gnx_os_lock_init(&ws->lock);
+        gnx_os_lock_init(&ws->commit_lock);
+        gnx_os_lock_init(&ws->pending_lock);
+        gnx_os_lock_init(&ws->code_map.lock);
+        ws->epoch = 1;
+
+        // Create disassembler for the workspace
+        ws->dis = gnx_disasm_create();
+        if (ws->dis == GNX_INVALID_HANDLE)
+        {
+            err = GNX_ERR_DISASM;
+            break;
+        }
+
+        //
+        // Create user hooks blocks
+        // (it will be used for springboard allocations)
+        //
+        gnx_block_options_t bo;
+        bo.block_size           = 4096 * 10; // 10 pages block size
+        bo.chunk_align          = 0x10; // Align the first chunk (springboards in this case) to 16 bytes
+        
+        // User hooks require a plain springboard with no special dispatcher
+        bo.chunk_size = sizeof(userhook_springboard_t);
+        // Default block allocation
+        bo.vmflags = GNX_MEM_RWX;
+
+        // Attempt to create the block
+        ws->user_hooks = gnx_block_create(&bo);
+        if (ws->user_hooks == GNX_INVALID_HANDLE)
+        {
+            err = GNX_ERR_NO_MEM;
+            break;
+        }
+
+        // Whole leaf functions springboards use bigger chunks
+        bo.chunk_size = sizeof(userhook_leaf_springboard_t);
+        ws->leaf_hooks = gnx_block_create(&bo);
+        if (ws->leaf_hooks == GNX_INVALID_HANDLE)
+        {
+            err = GNX_ERR_NO_MEM;
+            break;
+        }
+
+        // The slot hooks dispatch slots are plain data: they are written without any protection change
+        bo.block_size = 4096;
+        bo.chunk_size = sizeof(gnx_hook_slot_t);
+        bo.vmflags = GNX_MEM_READ | GNX_MEM_WRITE;
+        ws->hook_slots = gnx_block_create(&bo);
+        if (ws->hook_slots == GNX_INVALID_HANDLE)
+        {
+            err = GNX_ERR_NO_MEM;
+            break;
+        }
+
+        // Installed hooks index
+        ws->hook_index = gnx_range_map_create();
+        if (ws->hook_index == GNX_INVALID_HANDLE)
+        {
+            err = GNX_ERR_NO_MEM;
+            break;
+        }
+
+        // Springboard templates cache
+        ws->sb_cache = gnx_sb_cache_create();
+        if (ws->sb_cache == NULL)
+        {
+            err = GNX_ERR_NO_MEM;
+            break;
+        }
+        ws->sb_cache_enabled = true;
+
+        // Return the workspace handle
+        *handle = (gnx_handle_t)ws;
+
+        // Success
+        return GNX_ERR_OK;
+    } while (false);
+
+    //
+    // Failure cleanup from here on
+    //
+    if (ws->dis != GNX_INVALID_HANDLE)
+        gnx_disasm_free(ws->dis);
+
+    if (ws->user_hooks != GNX_INVALID_HANDLE)
+        gnx_block_free(ws->user_hooks);
+
+    if (ws->leaf_hooks != GNX_INVALID_HANDLE)
+        gnx_block_free(ws->leaf_hooks);
+
+    if (ws->hook_slots != GNX_INVALID_HANDLE)
+        gnx_block_free(ws->hook_slots);
+
+    if (ws->hook_index != GNX_INVALID_HANDLE)
+        gnx_range_map_free(ws->hook_index);
+
+    if (ws->sb_cache != NULL)
+        gnx_sb_cache_free(ws->sb_cache);
+
+    if (ws != NULL)
+        gnx_mfree(ws);
+
+    *handle = GNX_INVALID_HANDLE;
+	return err;
+}
+
+//--------------------------------------------------------------------------
+void GANXO_API gnx_close(gnx_handle_t handle)
+{
+	GET_WORKSPACE;
+
+    // No more modules notifications
+    gnx_pending_hooks_free(ws);
+
+    // Complete the pending asynchronous commits first
+    if (ws->committer != NULL)
+        gnx_committer_free(ws);
+
+    // The last records of the threads
+    gnx_trace_free(ws);
+    gnx_governor_free(ws);
+    gnx_code_map_free(ws);
+
+    gnx_disasm_free(ws->dis);
+    gnx_block_free(ws->user_hooks);
+    gnx_block_free(ws->leaf_hooks);
+    gnx_block_free(ws->hook_slots);
+    gnx_range_map_free(ws->hook_index);
+
+    if (ws->sb_cache != NULL)
+        gnx_sb_cache_free(ws->sb_cache);
+
+    if (ws->plan != NULL)
+        gnx_plan_free(ws->plan);
+
+    gnx_dis_pool_free(ws);
+    gnx_threads_free(ws);
+    gnx_counters_free(ws);
+
+	gnx_mfree(ws);
+}
+
+//--------------------------------------------------------------------------
+gnx_err_t GANXO_API gnx_close_ex(
+    gnx_handle_t handle,
+    uint32_t flags)
+{
+    GET_WORKSPACE;
+
+    // The hooks of the pending asynchronous commits are unhooked too
+    if (ws->committer != NULL)
+        gnx_committer_free(ws);
+
+    gnx_err_t err = GNX_ERR_OK;
+    if (GNX_HAS_FLAG(flags, GNX_CLOSE_UNHOOK))
+        err = gnx_unhook_all(handle);
+
+    gnx_close(handle);
+
+    return err;
+}
+
+//--------------------------------------------------------------------------
+gnx_err_t GANXO_API gnx_set_option(
+    gnx_handle_t handle,
+    gnx_option_t option,
+    size_t value)
+{
+    GET_WORKSPACE;
+
+    switch (option)
+    {
+        case GNX_OPT_LEAF_RELOC_MAX_SIZE:
+            if (value > GANXO_MAX_LEAF_FUNCTION_SIZE)
+                return GNX_ERR_INVALID_ARGS;
+
+            ws->leaf_max_size = value;
+            break;
+
+        case GNX_OPT_SPRINGBOARD_CACHE:
+            // The hooking threads read the cache without locking: it is only switched off, and freed by gnx_close
+            gnx_os_lock_acquire(&ws->lock);
+            ws->sb_cache_enabled = value != 0;
+            gnx_os_lock_release(&ws->lock);
+            break;
+
+        case GNX_OPT_WORKER_THREADS:
+            ws->nb_workers = value;
+            break;
+
+        case GNX_OPT_COMMIT_MODE:
+            if (value > GNX_COMMIT_STOP_THREADS)
+                return GNX_ERR_INVALID_ARGS;
+
+            ws->commit_mode = (gnx_commit_mode_t)value;
+            break;
+
+        case GNX_OPT_REGISTERED_THREADS_ONLY:
+            gnx_os_lock_acquire(&ws->lock);
+            ws->registered_threads_only = value != 0;
+            gnx_os_lock_release(&ws->lock);
+            break;
+
+        default:
+            return GNX_ERR_INVALID_ARGS;
+    }
+    return GNX_ERR_OK;
+}
+
+//--------------------------------------------------------------------------
+gnx_err_t GANXO_API gnx_get_stats(
+    gnx_handle_t handle,
+    gnx_stats_t *stats)
+{
+    GET_WORKSPACE;
+
+    if (stats == NULL || stats->cb != sizeof(gnx_stats_t))
+        return GNX_ERR_INVALID_ARGS;
+
+    *stats = ws->stats;
+    stats->cb = sizeof(gnx_stats_t);
+
+    return GNX_ERR_OK;
+}
+
+//--------------------------------------------------------------------------
+gnx_err_t GANXO_API gnx_resolve_symbols(
+    const char *module,
+    const char **names,
+    size_t nb_names,
+    void **addrs,
+    size_t *sizes)
+{
+    if (module == NULL || (nb_names != 0 && (names == NULL || addrs == NULL)))
+        return GNX_ERR_INVALID_ARGS;
+
+    return gnx_os_resolve_exports(
+        module,
+        names,
+        nb_names,
+        addrs,
+        sizes);
+}
@@ -0,0 +1,371 @@
+#include "private.h"
+
+//--------------------------------------------------------------------------
+// Overhead governor.
+//
+// At each check, the cost of each counter hook since the last check is estimated from its calls and
+// its timed calls (the sum of its histogram): count_cost cycles per call, plus timed_cost cycles per
+// timed call. The budget is a share of the time stamp counter cycles elapsed meanwhile. The hooks are
+// only switched through their control slots (\ref gnx_counters_set_sampling): nothing is committed.
+//--------------------------------------------------------------------------
+
+/// Counter hook as seen by the governor
+typedef struct __gnx_governed_hook_t
+{
+    uint64_t calls;             ///< Counts at the last check
+    uint64_t timed;
+    uint64_t count_cost;        ///< Estimated cycles of the counted calls since the last check
+    uint64_t timed_cost;        ///< Estimated cycles of the timed calls since the last check
+    uint32_t sampling;
+    uint32_t old_sampling;      ///< Sampling before the check, to report the switches
+} gnx_governed_hook_t;
+
+/// Hook sorted by cost
+typedef struct __gnx_governed_order_t
+{
+    uint64_t cost;
+    uint32_t index;
+} gnx_governed_order_t;
+
+/// Overhead governor of a workspace
+typedef struct __gnx_governor_t
+{
+    gnx_workspace_t *ws;
+    gnx_governor_options_t options;
+    gnx_governed_hook_t *hooks; ///< Indexed like the counters
+    gnx_governed_order_t *order;
+    uint64_t last_tsc;          ///< Time stamp counter at the last check
+    gnx_os_lock_t check_lock;   ///< Serializes the periodic checks with the explicit ones
+    void *check_thread;         ///< NULL without a periodic check
+    void *wake;                 ///< Wakes up the check thread to stop it
+    volatile bool stop;
+} gnx_governor_t;
+
+//--------------------------------------------------------------------------
+static int compare_cost(const void *a, const void *b)
+{
+    uint64_t ca = ((const gnx_governed_order_t *)a)->cost, cb = ((const gnx_governed_order_t *)b)->cost;
+    return ca > cb ? -1 : (ca < cb ? 1 : 0);
+}
+
+//--------------------------------------------------------------------------
+// Read the counts of the hooks and estimate their costs since the last check
+static uint64_t measure(
+    gnx_workspace_t *ws,
+    gnx_governor_t *gov,
+    uint32_t nb_hooks)
+{
+    uint64_t total = 0;
+    for (uint32_t i = 0; i < nb_hooks; i++)
+    {
+        gnx_governed_hook_t *hook = &gov->hooks[i];
+
+        gnx_hook_counters_t counts;
+        gnx_counters_sum(ws, i, &counts);
+
+        uint64_t timed = 0;
+        for (int j = 0; j < GNX_HOOK_HISTOGRAM_SIZE; j++)
+            timed += counts.histogram[j];
+
+        // The hooks added since the last check are measured from zero
+        hook->count_cost = (counts.calls - hook->calls) * gov->options.count_cost;
+        hook->timed_cost = (timed - hook->timed) * gov->options.timed_cost;
+        hook->calls = counts.calls;
+        hook->timed = timed;
+        hook->sampling = hook->old_sampling = gnx_counters_get_sampling(ws->counters, i);
+
+        total += hook->count_cost + hook->timed_cost;
+    }
+
+    return total;
+}
+
+//--------------------------------------------------------------------------
+// Sort the hooks by decreasing cost
+static void sort_hooks(
+    gnx_governor_t *gov,
+    uint32_t nb_hooks)
+{
+    for (uint32_t i = 0; i < nb_hooks; i++)
+    {
+        gov->order[i].cost = gov->hooks[i].count_cost + gov->hooks[i].timed_cost;
+        gov->order[i].index = i;
+    }
+
+    qsort(gov->order, nb_hooks, sizeof(gnx_governed_order_t), compare_cost);
+}
+
+//--------------------------------------------------------------------------
+// Choose the sampling of the hooks that fits their costs in the budget
+static void adjust(
+    gnx_workspace_t *ws,
+    gnx_governor_t *gov,
+    uint32_t nb_hooks,
+    uint64_t total,
+    uint64_t budget)
+{
+    gnx_stub_control_t *control = ws->counters->control;
+    sort_hooks(gov, nb_hooks);
+
+    // Over budget: time fewer calls of the costliest hooks first...
+    for (uint32_t i = 0; i < nb_hooks && total > budget; i++)
+    {
+        gnx_governed_hook_t *hook = &gov->hooks[gov->order[i].index];
+        if (!GNX_HAS_FLAG(control[gov->order[i].index].flags, GNX_COUNT_CYCLES) || hook->sampling == GNX_SAMPLING_DISABLED)
+            continue;
+
+        while (hook->sampling < gov->options.max_sampling && hook->timed_cost != 0 && total > budget)
+        {
+            hook->sampling *= 2;
+            total -= hook->timed_cost / 2;
+            hook->timed_cost -= hook->timed_cost / 2;
+        }
+    }
+
+    // ...then disable them
+    for (uint32_t i = 0; i < nb_hooks && total > budget; i++)
+    {
+        gnx_governed_hook_t *hook = &gov->hooks[gov->order[i].index];
+        if (hook->sampling == GNX_SAMPLING_DISABLED || hook->count_cost + hook->timed_cost == 0)
+            continue;
+
+        total -= hook->count_cost + hook->timed_cost;
+        hook->sampling = GNX_SAMPLING_DISABLED;
+    }
+
+    // Well below the budget: time more calls of the cheapest sampled hooks again
+    for (uint32_t i = nb_hooks; i-- > 0 && total < budget / 2;)
+    {
+        gnx_governed_hook_t *hook = &gov->hooks[gov->order[i].index];
+        while (hook->sampling > GNX_SAMPLING_ALL && total + hook->timed_cost <= budget / 2)
+        {
+            hook->sampling /= 2;
+            total += hook->timed_cost;
+            hook->timed_cost *= 2;
+        }
+    }
+
+    for (uint32_t i = 0; i < nb_hooks; i++)
+    {
+        if (gov->hooks[i].sampling != gov->hooks[i].old_sampling)
+            gnx_counters_set_sampling(ws->counters, i, gov->hooks[i].sampling);
+    }
+}
+
+//--------------------------------------------------------------------------
+static void check(
+    gnx_workspace_t *ws,
+    gnx_governor_t *gov)
+{
+    gnx_os_lock_acquire(&gov->check_lock);
+
+    gnx_os_lock_acquire(&ws->lock);
+
+    uint64_t tsc = gnx_rdtsc();
+    uint64_t budget = (tsc - gov->last_tsc) / 1000 * gov->options.budget_permille;
+    gov->last_tsc = tsc;
+
+    uint32_t nb_hooks = ws->counters->nb_counters;
+    uint64_t total = measure(ws, gov, nb_hooks);
+    adjust(ws, gov, nb_hooks, total, budget);
+
+    gnx_os_lock_release(&ws->lock);
+
+    // Report the switches without any lock held: the callback may read the counters
+    if (gov->options.callback != NULL)
+    {
+        for (uint32_t i = 0; i < nb_hooks; i++)
+        {
+            gnx_governed_hook_t *hook = &gov->hooks[i];
+            if (hook->sampling != hook->old_sampling)
+            {
+                gov->options.callback(
+                    gov->options.ctx,
+                    (gnx_handle_t)(uintptr_t)(i + 1),
+                    hook->old_sampling,
+                    hook->sampling);
+            }
+        }
+    }
+
+    gnx_os_lock_release(&gov->check_lock);
+}
+
+//--------------------------------------------------------------------------
+// The governor may already be detached from the counters: it is only freed once this thread exited
+static void check_thread_proc(void *ctx)
+{
+    gnx_governor_t *gov = (gnx_governor_t *)ctx;
+
+    while (!gov->stop)
+    {
+        if (!gnx_os_event_wait_timeout(gov->wake, gov->options.period_ms))
+            check(gov->ws, gov);
+    }
+}
+
+//--------------------------------------------------------------------------
+static void free_governor(gnx_governor_t *gov)
+{
+    if (gov->wake != NULL)
+        gnx_os_event_free(gov->wake);
+
+    if (gov->hooks != NULL)
+        gnx_mfree(gov->hooks);
+
+    if (gov->order != NULL)
+        gnx_mfree(gov->order);
+
+    GNX_FREE(gov);
+}
+
+//--------------------------------------------------------------------------
+gnx_err_t GANXO_API gnx_governor_start(
+    gnx_handle_t handle,
+    const gnx_governor_options_t *options)
+{
+    GET_WORKSPACE;
+
+    if (options == NULL || (options->max_sampling & (options->max_sampling - 1)) != 0)
+        return GNX_ERR_INVALID_ARGS;
+
+    gnx_counters_t *counters = gnx_counters_get(ws);
+    if (counters == NULL)
+        return GNX_ERR_NOT_SUPPORTED;
+
+    if (counters->governor != NULL)
+        return GNX_ERR_INVALID_ARGS;
+
+    gnx_governor_t *gov = GNX_ALLOC(gnx_governor_t);
+    if (gov == NULL)
+        return GNX_ERR_NO_MEM;
+
+    memset(gov, 0, sizeof(*gov));
+
+    gov->ws = ws;
+    gov->options = *options;
+    if (gov->options.count_cost == 0)
+        gov->options.count_cost = GNX_GOVERNOR_COUNT_COST;
+
+    if (gov->options.timed_cost == 0)
+        gov->options.timed_cost = GNX_GOVERNOR_TIMED_COST;
+
+    if (gov->options.max_sampling == 0)
+        gov->options.max_sampling = GNX_GOVERNOR_MAX_SAMPLING;
+
+    gnx_os_lock_init(&gov->check_lock);
+
+    gnx_err_t err = GNX_ERR_OK;
+    do
+    {
+        gov->hooks = (gnx_governed_hook_t *)gnx_malloc(GNX_MAX_COUNTERS * sizeof(gnx_governed_hook_t));
+        gov->order = (gnx_governed_order_t *)gnx_malloc(GNX_MAX_COUNTERS * sizeof(gnx_governed_order_t));
+        if (gov->hooks == NULL || gov->order == NULL)
+        {
+            err = GNX_ERR_NO_MEM;
+            break;
+        }
+
+        memset(gov->hooks, 0, GNX_MAX_COUNTERS * sizeof(gnx_governed_hook_t));
+
+        if (options->period_ms != 0)
+        {
+            gov->wake = gnx_os_event_create();
+            if (gov->wake == NULL)
+            {
+                err = GNX_ERR_FAILED;
+                break;
+            }
+        }
+
+        gnx_os_lock_acquire(&counters->governor_lock);
+        if (counters->governor != NULL)
+        {
+            err = GNX_ERR_INVALID_ARGS;
+        }
+        else
+        {
+            // The calls made before are not accounted for
+            gnx_os_lock_acquire(&ws->lock);
+            measure(ws, gov, counters->nb_counters);
+            gov->last_tsc = gnx_rdtsc();
+            gnx_os_lock_release(&ws->lock);
+
+            if (options->period_ms != 0)
+            {
+                gov->check_thread = gnx_os_thread_create(check_thread_proc, gov);
+                if (gov->check_thread == NULL)
+                    err = GNX_ERR_FAILED;
+            }
+
+            if (err == GNX_ERR_OK)
+                counters->governor = gov;
+        }
+        gnx_os_lock_release(&counters->governor_lock);
+    } while (false);
+
+    if (err != GNX_ERR_OK)
+        free_governor(gov);
+
+    return err;
+}
+
+//--------------------------------------------------------------------------
+gnx_err_t GANXO_API gnx_governor_check(gnx_handle_t handle)
+{
+    GET_WORKSPACE;
+
+    gnx_counters_t *counters = ws->counters;
+    if (counters == NULL)
+        return GNX_ERR_INVALID_ARGS;
+
+    // The governor cannot be stopped meanwhile
+    gnx_err_t err = GNX_ERR_INVALID_ARGS;
+    gnx_os_lock_acquire(&counters->governor_lock);
+    if (counters->governor != NULL)
+    {
+        check(ws, counters->governor);
+        err = GNX_ERR_OK;
+    }
+    gnx_os_lock_release(&counters->governor_lock);
+
+    return err;
+}
+
+//--------------------------------------------------------------------------
+gnx_err_t GANXO_API gnx_governor_stop(gnx_handle_t handle)
+{
+    GET_WORKSPACE;
+
+    gnx_counters_t *counters = ws->counters;
+    if (counters == NULL)
+        return GNX_ERR_INVALID_ARGS;
+
+    // Detach the governor: no explicit check is running nor can start
+    gnx_os_lock_acquire(&counters->governor_lock);
+    gnx_governor_t *gov = counters->governor;
+    counters->governor = NULL;
+    gnx_os_lock_release(&counters->governor_lock);
+
+    if (gov == NULL)
+        return GNX_ERR_INVALID_ARGS;
+
+    // The check thread still uses it until it exits
+    if (gov->check_thread != NULL)
+    {
+        gov->stop = true;
+        gnx_os_event_set(gov->wake);
+        gnx_os_thread_join(gov->check_thread);
+    }
+
+    free_governor(gov);
+
+    return GNX_ERR_OK;
+}
+
+//--------------------------------------------------------------------------
+void gnx_governor_free(gnx_workspace_t *ws)
+{
+    if (ws->counters != NULL && ws->counters->governor != NULL)
+        gnx_governor_stop((gnx_handle_t)ws);
+}
@@ -1,466 +1,3533 @@
-#include "private.h"
-
-/// Transaction item
-typedef struct __gnx_transaction_item_t
-{
-    uint32_t op_flags; // (add or remove)
-        #define GNX_TSXF_ADD 1
-        #define GNX_TSXF_DEL 2
-    union
-    {
-        struct
-        {
-            // Function address to hook (with all jumps skipped)
-            void *func_addr;
-            // The hook replacement function
-            void *hook_addr;
-            // Original func_addr without jumps skipped
-            userhook_springboard_t *uh;
-
-            void **psrc;
-        } add;
-        struct
-        {
-            userhook_springboard_t *uh;
-            void **psrc;
-        } remove;
-    } op;
-    GNX_SINGLY_LIST_ITEM_DEFINE;
-} gnx_transaction_item_t;
-
-
-/// Transaction header
-typedef struct __gnx_transaction_t
-{
-    gnx_handle_t gnx;
-    gnx_singly_list_item_t items;
-} gnx_transaction_t;
-
-//--------------------------------------------------------------------------
-#define GET_TRANS \
-    gnx_transaction_t *trans = (gnx_transaction_t *)handle
-
-#define GET_VARS \
-    GET_TRANS; \
-    gnx_workspace_t *ws = (gnx_workspace_t *)trans->gnx;
-
-
-//--------------------------------------------------------------------------
-static gnx_err_t create_function_springboard(
-    gnx_workspace_t *ws,
-    const void *src_func,
-    userhook_springboard_t *uh)
-{
-    // How big is the destination copy
-    ptrdiff_t dest_left = sizeof(uh->springboard);
-
-    // We need to copy just enough bytes to fit the springboard
-    ptrdiff_t src_left = GANXO_JUMP_TO_SPRINGBOARD_SIZE;
-
-    uint8_t *reloc_dest = (uint8_t *)uh->springboard;
-    const uint8_t *src = src_func;
-
-    gnx_err_t err = GNX_ERR_OK;
-    bool small_func = false;
-    while (src_left > 0)
-    {
-        // Make sure we have enough room to copy the biggest possible instruction
-        dest_left -= (reloc_dest - (uint8_t *)uh->springboard);
-        if (dest_left < GANXO_MAX_INSTR_SIZE)
-            return GNX_ERR_BUFFER_TOO_SMALL;
-
-        const uint8_t *psrc = src;
-
-        // Copy and relocate the source instruction
-        err = gnx_disasm_copy_instruction(
-            ws->dis, 
-            (const void **)&src, 
-            (void **)&reloc_dest);
-
-        // Bail out on failure
-        if (err != GNX_ERR_OK)
-            return err;
-
-        // Update the source bytes count to copy
-        src_left -= src - psrc;
-
-        // Just copied a return instruction prematurely:
-        // - The source function is too short and does not have enough space
-        //   so we can write a springboard
-        if (src_left > 0 && gnx_disasm_is_ret(ws->dis))
-        {
-            // Let us see if we have enough alignment bytes we can leverage
-            do 
-            {
-                // Disassemble the function
-                size_t aln_size;
-                err = gnx_disasm_instruction(
-                    ws->dis, 
-                    src,
-                    &aln_size);
-                if (err != GNX_ERR_OK)
-                    return err;
-
-                // Check if this is an alignment byte
-                if (!gnx_disasm_is_align(ws->dis, &aln_size))
-                    return GNX_ERR_FUNCTION_TOO_SMALL;
-
-                // If these are alignment bytes, we can use them freely to make room for the rest of the springboard
-
-                // Copy alignment instruction as-is
-                memcpy(reloc_dest, src, aln_size);
-
-                src_left -= aln_size;
-                src += aln_size;
-                reloc_dest += aln_size;
-            } while (src_left > 0);
-            // This is a small function:
-            // - there is no real springboard because the copied bytes contain the complete function. 
-            small_func = true;
-        }
-    }
-
-    // Last step, if needed, generate the jump to go past our
-    // springboard jump in the original function
-    if (!small_func)
-    {
-        if (dest_left < GANXO_JUMP_TO_SPRINGBOARD_SIZE)
-            return GNX_ERR_BUFFER_TOO_SMALL;
-        
-        gnx_asm_gen_relbranch(
-            ws->dis,
-            false,
-            src,
-            (void **)&reloc_dest);
-    }
-
-    uh->backup_sz = (uint16_t)(src - (uint8_t *)src_func);
-
-    // Let's backup the original bytes
-    memcpy(
-        uh->backup,
-        src_func,
-        uh->backup_sz);
-
-    return GNX_ERR_OK;
-}
-
-//--------------------------------------------------------------------------
-// Create a springboard
-static inline gnx_err_t free_user_springboard(
-    gnx_workspace_t *ws,
-    userhook_springboard_t *uh)
-{
-    return gnx_block_chunk_free(ws->user_hooks, uh);
-}
-
-//--------------------------------------------------------------------------
-// Create a springboard
-static gnx_err_t make_user_springboard(
-    gnx_workspace_t *ws,
-    gnx_transaction_item_t *item,
-    userhook_springboard_t **uh)
-{
-    gnx_err_t err;
-    userhook_springboard_t *user_hook = NULL;
-    do 
-    {
-        // Allocate memory for the springboard
-        user_hook = GNX_ALLOC_CHUNK(
-            ws->user_hooks, 
-            userhook_springboard_t);
-        if (user_hook == NULL)
-        {
-            err = GNX_ERR_NO_MEM;
-            break;
-        }
-
-        //
-        // Create a springboard
-        //
-        err = create_function_springboard(
-            ws, 
-            item->op.add.func_addr,
-            user_hook);
-
-        if (err != GNX_ERR_OK)
-            break;
-
-        *uh = user_hook;
-
-        return GNX_ERR_OK;
-    } while (false);
-
-    // Clean up
-    if (user_hook != NULL)
-    {
-        gnx_block_chunk_free(
-            ws->user_hooks, 
-            user_hook);
-    }
-    return err;
-}
-
-//--------------------------------------------------------------------------
-gnx_err_t GANXO_API gnx_transaction_begin(
-    gnx_handle_t gnx,
-    gnx_handle_t *handle)
-{
-    gnx_workspace_t *ws = (gnx_workspace_t *)gnx;
-
-    // Create new transaction
-    gnx_transaction_t *trans = GNX_ALLOC(gnx_transaction_t);
-    if (trans == NULL)
-        return GNX_ERR_NO_MEM;
-
-    // Unlock the blocks when the transaction begins
-    if (gnx_block_protect(ws->user_hooks, GNX_MEM_RWX) != GNX_ERR_OK)
-    {
-        gnx_mfree(trans);
-        return GNX_ERR_FAILED;
-    }
-
-    // Remember the workspace
-    trans->gnx = gnx;
-
-    // Initialize the transaction items linked list
-    gnx_singly_list_init(&trans->items);
-
-    *handle = (gnx_handle_t)trans;
-
-    return GNX_ERR_OK;
-}
-
-//--------------------------------------------------------------------------
-gnx_err_t GANXO_API gnx_transaction_add_hook(
-    gnx_handle_t handle,
-    void **psrc,
-    void *hook)
-{
-    GET_VARS;
-
-    // Create a transaction item
-    gnx_transaction_item_t *item = GNX_ALLOC(gnx_transaction_item_t);
-    if (item == NULL)
-        return GNX_ERR_NO_MEM;
-
-    item->op_flags = GNX_TSXF_ADD;
-    item->op.add.hook_addr = hook;
-    item->op.add.psrc = psrc;
-
-    // Get the real function address
-    item->op.add.func_addr = (void *)gnx_disasm_skip_jumps(
-        ws->dis,
-        *psrc);
-
-    userhook_springboard_t *uh;
-    gnx_err_t err = make_user_springboard(
-        ws, 
-        item, 
-        &uh);
-
-    if (err != GNX_ERR_OK)
-    {
-        GNX_FREE(item);
-        return err;
-    }
-
-    // Remember the original function address for restoration
-    uh->func_addr_final = item->op.add.func_addr;
-    uh->func_addr = *psrc;
-
-    // Replace the original function address with the springboard address
-    *psrc = uh->springboard;
-
-    item->op.add.uh = uh;
-    GNX_SINGLY_LIST_ITEM_PUSH(
-        &trans->items,
-        item);
-
-    return GNX_ERR_OK;
-}
-
-//--------------------------------------------------------------------------
-gnx_err_t GANXO_API gnx_transaction_remove_hook(
-    gnx_handle_t handle,
-    void **psrc)
-{
-    GET_TRANS;
-
-    // Create a transaction item
-    gnx_transaction_item_t *item = GNX_ALLOC(gnx_transaction_item_t);
-    if (item == NULL)
-        return GNX_ERR_NO_MEM;
-
-    item->op_flags = GNX_TSXF_DEL;
-
-    item->op.remove.psrc = psrc;
-    // After a successful hook, psrc points to a user springboard structure
-    item->op.remove.uh = GNX_CONTAINING_RECORD(
-        *psrc, 
-        userhook_springboard_t, 
-        springboard);
-
-    GNX_SINGLY_LIST_ITEM_PUSH(
-        &trans->items,
-        item);
-
-    return GNX_ERR_OK;
-}
-
-//--------------------------------------------------------------------------
-gnx_err_t GANXO_API gnx_transaction_abort(gnx_handle_t handle)
-{
-    GET_VARS;
-    gnx_singly_list_item_t *cur = trans->items.next;
-    while (cur != NULL)
-    {
-        // Get the current item
-        gnx_transaction_item_t *item = GNX_SINGLY_LIST_RECORD(
-            cur,
-            gnx_transaction_item_t);
-
-        if (item->op_flags == GNX_TSXF_ADD)
-        {
-            // Restore the original function address
-            *item->op.add.psrc = item->op.add.uh->func_addr;
-
-            // Free the springboard
-            free_user_springboard(ws, item->op.add.uh);
-        }
-        else if (item->op_flags == GNX_TSXF_DEL)
-        {
-            // Restore the original function address
-            *item->op.remove.psrc = item->op.remove.uh->func_addr;
-
-            // Free the springboard
-            free_user_springboard(ws, item->op.remove.uh);
-        }
-        cur = cur->next;
-
-        GNX_FREE(item);
-    }
-
-    // Lock back the blocks
-    gnx_block_protect(ws->user_hooks, GNX_MEM_EXEC);
-
-    // The transaction is now empty, free it
-    GNX_FREE(trans);
-
-    return GNX_ERR_OK;
-}
-
-//--------------------------------------------------------------------------
-// Commit the hooks
-gnx_err_t GANXO_API gnx_transaction_commit(gnx_handle_t handle)
-{
-    GET_VARS;
-
-    size_t nb_success = 0;
-    gnx_err_t err = GNX_ERR_OK;
-
-    void *func_addr = NULL, *hook_addr = NULL;
-    size_t prot_sz;
-    gnx_mem_flags_t old_flags;
-
-    gnx_singly_list_item_t *cur = trans->items.next;
-    while (cur != NULL)
-    {
-        // Get the current item
-        gnx_transaction_item_t *item = GNX_SINGLY_LIST_RECORD(
-            cur,
-            gnx_transaction_item_t);
-
-        // Commit / add
-        if (item->op_flags == GNX_TSXF_ADD)
-        {
-            func_addr = item->op.add.func_addr;
-            hook_addr = item->op.add.hook_addr;
-            prot_sz = item->op.add.uh->backup_sz;
-        }
-        // Commit / remove
-        else if (item->op_flags == GNX_TSXF_DEL)
-        {
-            func_addr = item->op.remove.uh->func_addr_final;
-            prot_sz = item->op.remove.uh->backup_sz;
-        }
-        else
-        {
-            // Invalid operation
-            prot_sz = 0;
-        }
-
-        if (prot_sz != 0) do 
-        {
-            // Change protection so that we can patch the original function
-            err = gnx_vmprotect(
-                func_addr,
-                prot_sz,
-                GNX_MEM_RWX,
-                &old_flags);
-
-            // Failed to change the protection?
-            if (err != GNX_ERR_OK)
-                break;
-
-            if (item->op_flags == GNX_TSXF_ADD)
-            {
-                // Replace the instruction with a jump to the hook
-                gnx_asm_gen_relbranch(
-                    ws->dis,
-                    false,
-                    hook_addr,
-                    &func_addr);
-            }
-            else if (item->op_flags == GNX_TSXF_DEL)
-            {
-                // Restore the original bytes
-                memcpy(
-                    func_addr,
-                    item->op.remove.uh->backup,
-                    prot_sz);
-
-                // Restore the original function address
-                *item->op.remove.psrc = item->op.remove.uh->func_addr;
-
-                free_user_springboard(ws, item->op.remove.uh);
-            }
-
-            // Restore the protection
-            err = gnx_vmprotect(
-                func_addr,
-                prot_sz,
-                old_flags,
-                NULL);
-
-            if (err != GNX_ERR_OK)
-                break;
-
-            // Flush instruction cache after the patch
-            err = gnx_flush_instruction_cache(
-                NULL,
-                func_addr,
-                prot_sz);
-            if (err != GNX_ERR_OK)
-                break;
-
-            ++nb_success;
-
-        } while (false);
-
-        cur = cur->next;
-
-        GNX_FREE(item);
-    }
-
-    // The transaction is now empty, free it
-    GNX_FREE(trans);
-
-    if (err != GNX_ERR_OK)
-        err = nb_success == 0 ? GNX_ERR_FAILED : GNX_ERR_PARTIAL;
-
-    // Lock back the blocks
-    gnx_block_protect(ws->user_hooks, GNX_MEM_EXEC);
-
-    return err;
-}
+#include "private.h"
+#include <limits.h>
+#include <stdlib.h>
+
+/// Transaction item
+typedef struct __gnx_transaction_item_t
+{
+    uint32_t op_flags; // (add or remove)
+        #define GNX_TSXF_ADD 1
+        #define GNX_TSXF_DEL 2
+        #define GNX_TSXF_IAT 3
+        #define GNX_TSXF_REJECTED 4 // An add overlapping another hook when committed (op.add is kept)
+        #define GNX_TSXF_JOIN 5     // An add on a hooked function, joining its hooks chain (op.join)
+        #define GNX_TSXF_LEAVE 6    // The removal of a joined hook (op.join)
+        #define GNX_TSXF_HANDOVER 7 // The removal of a hook with joined hooks: the first one takes over the patch (op.remove)
+    bool committed;  // The function is patched (or restored)
+    bool unindexed;  // Committed but the hook index could not be updated (\ref update_hook_index)
+    union
+    {
+        struct
+        {
+            // Function address to hook (with all jumps skipped)
+            void *func_addr;
+            // The hook replacement function
+            void *hook_addr;
+            // Original func_addr without jumps skipped
+            userhook_springboard_t *uh;
+
+            void **psrc;
+        } add;
+        struct
+        {
+            userhook_springboard_t *uh;
+            void **psrc;
+            // The joined hook taking the patch over, and its hook (GNX_TSXF_HANDOVER)
+            gnx_hook_join_t *join;
+            void *hook_addr;
+        } remove;
+        struct
+        {
+            // The hook installed on the function, checked against the index when committed
+            userhook_springboard_t *uh;
+            void *func_addr;
+            // NULL once a failed join is dropped
+            gnx_hook_join_t *join;
+            void **psrc;
+        } join;
+        struct
+        {
+            // Import address table slot
+            void **slot;
+            void *hook_addr;
+            // Where the original import was returned
+            void **porig;
+        } iat;
+    } op;
+    GNX_SINGLY_LIST_ITEM_DEFINE;
+} gnx_transaction_item_t;
+
+
+/// Transaction header
+typedef struct __gnx_transaction_t
+{
+    gnx_handle_t gnx;
+    gnx_singly_list_item_t items; ///< Most recent item first (lock-free stack, see push_transaction_item)
+} gnx_transaction_t;
+
+/// Hook prepared by \ref prepare_hook
+typedef struct __gnx_hook_prep_t
+{
+    gnx_err_t err;              ///< Springboard template error
+    void *func_addr;            ///< Function address with all jumps skipped
+    size_t patch_size;          ///< Size of the patch written at the function address
+    size_t leaf_size;           ///< Size of the relocatable leaf function (0 if not a leaf)
+    bool cached;                ///< The template comes from the cache or the plan
+    gnx_sb_template_t tpl;      ///< Springboard template
+} gnx_hook_prep_t;
+
+/// Descriptors are handed out to the bulk hooks workers by batches
+#define GNX_BULK_BATCH_SIZE 256
+
+/// Maximum count of bulk hooks workers
+#define GNX_BULK_MAX_WORKERS 64
+
+/// Bulk hooks preparation state shared by the workers
+typedef struct __gnx_bulk_ctx_t
+{
+    gnx_workspace_t *ws;
+    const gnx_hook_desc_t *descs;
+    gnx_hook_prep_t *preps;     ///< One prepared hook per descriptor
+    size_t n;
+    volatile long next;         ///< First descriptor of the next batch
+} gnx_bulk_ctx_t;
+
+/// Bulk hooks preparation worker
+typedef struct __gnx_bulk_worker_t
+{
+    gnx_bulk_ctx_t *ctx;
+    gnx_handle_t dis;           ///< Each worker has its own disassembler
+    void *thread;
+} gnx_bulk_worker_t;
+
+//--------------------------------------------------------------------------
+#define GET_TRANS \
+    gnx_transaction_t *trans = (gnx_transaction_t *)handle
+
+#define GET_VARS \
+    GET_TRANS; \
+    gnx_workspace_t *ws = (gnx_workspace_t *)trans->gnx;
+
+
+//--------------------------------------------------------------------------
+// Disassemble and relocate the first instructions of a function into a springboard template
+static gnx_err_t build_springboard_template(
+    gnx_handle_t dis,
+    const void *src_func,
+    size_t patch_size,
+    gnx_sb_template_t *tpl)
+{
+    // We need to copy just enough bytes to fit the patch
+    ptrdiff_t src_left = (ptrdiff_t)patch_size;
+
+    uint8_t *reloc_dest = tpl->code;
+    const uint8_t *src = src_func;
+
+    tpl->nb_fixups = 0;
+
+    gnx_err_t err = GNX_ERR_OK;
+    bool small_func = false;
+    while (src_left > 0)
+    {
+        // Make sure we have enough room to copy the biggest possible instruction
+        ptrdiff_t dest_left = sizeof(tpl->code) - (reloc_dest - tpl->code);
+        if (dest_left < GANXO_MAX_INSTR_SIZE)
+            return GNX_ERR_BUFFER_TOO_SMALL;
+
+        const uint8_t *psrc = src;
+
+        // Copy and relocate the source instruction
+        err = gnx_disasm_copy_instruction(
+            dis, 
+            (const void **)&src, 
+            (void **)&reloc_dest);
+
+        // Bail out on failure
+        if (err != GNX_ERR_OK)
+            return err;
+
+        // Relative branches are relocated with their rel32 operand last:
+        // remember it so the template can be instantiated for any function
+        const uint8_t *target;
+        if (gnx_disasm_get_branch_target(dis, (const void **)&target))
+        {
+            gnx_sb_fixup_t *fixup = &tpl->fixups[tpl->nb_fixups++];
+            fixup->rel_ofs = (uint8_t)(reloc_dest - tpl->code - sizeof(int32_t));
+            fixup->target_delta = (int32_t)(target - (const uint8_t *)src_func);
+        }
+
+        // Update the source bytes count to copy
+        src_left -= src - psrc;
+
+        // Just copied a return instruction prematurely:
+        // - The source function is too short and does not have enough space
+        //   so we can write a springboard
+        if (src_left > 0 && gnx_disasm_is_ret(dis))
+        {
+            // Let us see if we have enough alignment bytes we can leverage
+            do 
+            {
+                // Disassemble the function
+                size_t aln_size;
+                err = gnx_disasm_instruction(
+                    dis, 
+                    src,
+                    &aln_size);
+                if (err != GNX_ERR_OK)
+                    return err;
+
+                // Check if this is an alignment byte
+                if (!gnx_disasm_is_align(dis, &aln_size))
+                    return GNX_ERR_FUNCTION_TOO_SMALL;
+
+                // If these are alignment bytes, we can use them freely to make room for the rest of the springboard
+
+                // Copy alignment instruction as-is
+                memcpy(reloc_dest, src, aln_size);
+
+                src_left -= aln_size;
+                src += aln_size;
+                reloc_dest += aln_size;
+            } while (src_left > 0);
+            // This is a small function:
+            // - there is no real springboard because the copied bytes contain the complete function. 
+            small_func = true;
+        }
+    }
+
+    tpl->backup_sz = (uint8_t)(src - (uint8_t *)src_func);
+
+    // Last step, if needed, generate the jump to go past our
+    // springboard jump in the original function
+    if (!small_func)
+    {
+        if (sizeof(tpl->code) - (reloc_dest - tpl->code) < GANXO_JUMP_TO_SPRINGBOARD_SIZE)
+            return GNX_ERR_BUFFER_TOO_SMALL;
+        
+        gnx_asm_gen_relbranch(
+            dis,
+            false,
+            src,
+            (void **)&reloc_dest);
+
+        gnx_sb_fixup_t *fixup = &tpl->fixups[tpl->nb_fixups++];
+        fixup->rel_ofs = (uint8_t)(reloc_dest - tpl->code - sizeof(int32_t));
+        fixup->target_delta = tpl->backup_sz;
+    }
+
+    tpl->code_sz = (uint8_t)(reloc_dest - tpl->code);
+
+    return GNX_ERR_OK;
+}
+
+//--------------------------------------------------------------------------
+// Instantiate a springboard template for a given function: 
+// copy the code then patch the relative operands
+static void instantiate_springboard_template(
+    const gnx_sb_template_t *tpl,
+    const void *src_func,
+    userhook_springboard_t *uh)
+{
+    memcpy(
+        uh->springboard,
+        tpl->code,
+        tpl->code_sz);
+
+    for (uint8_t i = 0; i < tpl->nb_fixups; i++)
+    {
+        const gnx_sb_fixup_t *fixup = &tpl->fixups[i];
+        uint8_t *rel = uh->springboard + fixup->rel_ofs;
+
+        // rel32 = target - next instruction address
+        *(int32_t *)rel = (int32_t)(
+              ((uintptr_t)src_func + fixup->target_delta) 
+            - (uintptr_t)(rel + sizeof(int32_t)));
+    }
+
+    uh->backup_sz = tpl->backup_sz;
+
+    // Let's backup the original bytes
+    memcpy(
+        uh->backup,
+        src_func,
+        uh->backup_sz);
+}
+
+//--------------------------------------------------------------------------
+gnx_err_t gnx_sb_template_get(
+    gnx_workspace_t *ws,
+    const void *src_func,
+    size_t patch_size,
+    gnx_sb_template_t *tpl)
+{
+    // Functions starting with the same bytes share the same template
+    if (ws->sb_cache_enabled)
+    {
+        const gnx_sb_template_t *cached = gnx_sb_cache_lookup(
+            ws->sb_cache, 
+            src_func,
+            patch_size);
+        if (cached != NULL)
+        {
+            gnx_atomic_fetch_add(&ws->stats.nb_sb_cache_hits, 1);
+            *tpl = *cached;
+            return GNX_ERR_OK;
+        }
+    }
+
+    gnx_err_t err = build_springboard_template(
+        ws->dis,
+        src_func,
+        patch_size,
+        tpl);
+    if (err != GNX_ERR_OK)
+        return err;
+
+    if (ws->sb_cache_enabled)
+    {
+        gnx_os_lock_acquire(&ws->lock);
+        gnx_sb_cache_insert(ws->sb_cache, src_func, tpl);
+        gnx_os_lock_release(&ws->lock);
+    }
+
+    return GNX_ERR_OK;
+}
+
+//--------------------------------------------------------------------------
+// Linear sweep of a short leaf function.
+// The function is a leaf if, within max_size bytes, it has no calls, no indirect branches,
+// no branches outside of itself and it ends with a RET (or a tail JMP) that is not jumped over.
+// \return The function size or 0 if it is not a relocatable leaf function
+static size_t sweep_leaf_function(
+    gnx_handle_t dis,
+    const uint8_t *func,
+    size_t max_size)
+{
+    const uint8_t *end = func + max_size;
+
+    // The internal branches targets, and the furthest ones
+    uint8_t targets[GNX_ROUND_UP_DIV(GANXO_MAX_LEAF_FUNCTION_SIZE, 8)];
+    memset(targets, 0, sizeof(targets));
+    const uint8_t *reach = func, *cond_reach = func;
+
+    for (const uint8_t *ip = func; ip < end; )
+    {
+        size_t inst_sz;
+        if (gnx_disasm_instruction(dis, ip, &inst_sz) != GNX_ERR_OK || ip + inst_sz > end)
+            return 0;
+
+        // Not a leaf function
+        if (gnx_disasm_is_call(dis))
+            return 0;
+
+        bool conditional = false, is_end = gnx_disasm_is_ret(dis);
+        if (gnx_disasm_is_jump(dis, &conditional))
+        {
+            // Indirect jumps (ex: jump tables) cannot be followed
+            const uint8_t *target;
+            if (!gnx_disasm_get_branch_target(dis, (const void **)&target))
+                return 0;
+
+            if (target >= func && target < end)
+            {
+                size_t ofs = target - func;
+                targets[ofs / 8] |= (uint8_t)(1 << (ofs % 8));
+
+                if (target > reach)
+                    reach = target;
+                if (conditional && target > cond_reach)
+                    cond_reach = target;
+            }
+            // Only a tail jump may leave the function
+            else if (conditional)
+            {
+                return 0;
+            }
+            is_end = !conditional;
+        }
+
+        ip += inst_sz;
+        if (!is_end)
+            continue;
+
+        // Nothing branches past this point: this is the end of the function
+        if (ip > reach)
+            return ip - func;
+
+        // The function goes on past its last RET (or jump) only where a branch lands right after it.
+        // Otherwise the targets further are not internal (ex: a conditional tail jump to the next function).
+        size_t next_ofs = ip - func;
+        if ((targets[next_ofs / 8] & (1 << (next_ofs % 8))) == 0)
+            return cond_reach >= ip ? 0 : next_ofs;
+    }
+    return 0;
+}
+
+//--------------------------------------------------------------------------
+// Relocate a whole leaf function into the springboard.
+// Internal branches are retargeted into the springboard so that the original
+// function is never executed again.
+static gnx_err_t create_leaf_springboard(
+    gnx_handle_t dis,
+    const void *src_func,
+    size_t func_size,
+    size_t patch_size,
+    userhook_leaf_springboard_t *luh)
+{
+    userhook_springboard_t *uh = &luh->uh;
+
+    // Springboard offset of each source instruction (+1, zero for no instruction boundary)
+    uint16_t ofs_map[GANXO_MAX_LEAF_FUNCTION_SIZE + 1];
+    memset(ofs_map, 0, sizeof(ofs_map));
+
+    // Internal branches to retarget
+    struct
+    {
+        uint16_t rel_ofs;   ///< rel32 operand offset in the springboard
+        uint8_t src_target; ///< Target offset in the source function
+    } fixups[GANXO_MAX_LEAF_FUNCTION_SIZE / 2];
+    size_t nb_fixups = 0;
+
+    uint8_t *sb_start = uh->springboard;
+    uint8_t *sb_end = sb_start + (sizeof(*luh) - offsetof(userhook_leaf_springboard_t, uh.springboard));
+    uint8_t *reloc_dest = sb_start;
+
+    const uint8_t *func = (const uint8_t *)src_func;
+    const uint8_t *src = func;
+    size_t backup_sz = 0;
+    while (src < func + func_size)
+    {
+        if (sb_end - reloc_dest < GANXO_MAX_INSTR_SIZE)
+            return GNX_ERR_BUFFER_TOO_SMALL;
+
+        ofs_map[src - func] = (uint16_t)(reloc_dest - sb_start + 1);
+
+        gnx_err_t err = gnx_disasm_copy_instruction(
+            dis,
+            (const void **)&src,
+            (void **)&reloc_dest);
+        if (err != GNX_ERR_OK)
+            return err;
+
+        // The patch covers the first whole instructions that fit the jump to the hook
+        if (backup_sz == 0 && (size_t)(src - func) >= patch_size)
+            backup_sz = src - func;
+
+        // Remember the internal branches: their relocated rel32 operand is always last
+        const uint8_t *target;
+        if (    gnx_disasm_get_branch_target(dis, (const void **)&target)
+            &&  target >= func && target < func + func_size)
+        {
+            fixups[nb_fixups].rel_ofs = (uint16_t)(reloc_dest - sb_start - sizeof(int32_t));
+            fixups[nb_fixups].src_target = (uint8_t)(target - func);
+            ++nb_fixups;
+        }
+    }
+
+    if (backup_sz == 0)
+        return GNX_ERR_FUNCTION_TOO_SMALL;
+
+    // Point the internal branches to their relocated targets
+    for (size_t i = 0; i < nb_fixups; i++)
+    {
+        uint16_t target_ofs = ofs_map[fixups[i].src_target];
+
+        // Branching in the middle of an instruction
+        if (target_ofs == 0)
+            return GNX_ERR_INST_COPY;
+
+        *(int32_t *)(sb_start + fixups[i].rel_ofs) =
+            (int32_t)(target_ofs - 1) - (int32_t)(fixups[i].rel_ofs + sizeof(int32_t));
+    }
+
+    uh->flags = GNX_UHF_LEAF;
+    uh->leaf_size = (uint32_t)func_size;
+    uh->backup_sz = (uint32_t)backup_sz;
+
+    // Let's backup the original bytes
+    memcpy(
+        uh->backup,
+        src_func,
+        uh->backup_sz);
+
+    return GNX_ERR_OK;
+}
+
+//--------------------------------------------------------------------------
+// Drop the hooks chain of a dispatch slot
+static void release_hook_chain(gnx_hook_slot_t *slot)
+{
+    while (slot->chain != NULL)
+    {
+        gnx_hook_chain_entry_t *entry = slot->chain;
+        slot->chain = entry->next;
+
+        // As the slot hook's own function pointer, the chained hooks get back the original function
+        if (slot->uh != NULL)
+            *entry->porig = slot->uh->func_addr;
+
+        GNX_FREE(entry);
+    }
+}
+
+//--------------------------------------------------------------------------
+// Drop the hooks joined behind a hook whose function is unhooked
+// \param unloaded The module is unloaded: their function pointers get NULL back instead of
+//        their original function
+static void release_hook_joins(
+    userhook_springboard_t *uh,
+    bool unloaded)
+{
+    while (uh->joins != NULL)
+    {
+        gnx_hook_join_t *join = uh->joins;
+        uh->joins = join->next;
+
+        *join->psrc = unloaded ? NULL : join->func_addr;
+        GNX_FREE(join);
+    }
+}
+
+//--------------------------------------------------------------------------
+// Free a dispatch slot and its hooks chain
+static void free_hook_slot(
+    gnx_workspace_t *ws,
+    gnx_hook_slot_t *slot)
+{
+    release_hook_chain(slot);
+
+    gnx_os_lock_acquire(&ws->lock);
+    gnx_block_chunk_free(ws->hook_slots, slot);
+    gnx_os_lock_release(&ws->lock);
+}
+
+//--------------------------------------------------------------------------
+// Size of the springboard code area
+static inline size_t springboard_size(const userhook_springboard_t *uh)
+{
+    return GNX_HAS_FLAG(uh->flags, GNX_UHF_LEAF)
+        ? sizeof(userhook_leaf_springboard_t) - offsetof(userhook_leaf_springboard_t, uh.springboard)
+        : sizeof(uh->springboard);
+}
+
+//--------------------------------------------------------------------------
+// Free a springboard (and its dispatch slot)
+gnx_err_t gnx_sb_free(
+    gnx_workspace_t *ws,
+    userhook_springboard_t *uh)
+{
+    if (uh->slot != NULL)
+        free_hook_slot(ws, uh->slot);
+
+    gnx_code_map_remove(
+        ws,
+        uh->springboard,
+        springboard_size(uh),
+        "gnx_springboard",
+        uh->func_addr_final);
+
+    gnx_os_lock_acquire(&ws->lock);
+    gnx_err_t err = gnx_block_chunk_free(
+        GNX_HAS_FLAG(uh->flags, GNX_UHF_LEAF) ? ws->leaf_hooks : ws->user_hooks,
+        uh);
+    gnx_os_lock_release(&ws->lock);
+
+    return err;
+}
+
+//--------------------------------------------------------------------------
+// Change the protection of all the springboards blocks
+static gnx_err_t protect_springboards(
+    gnx_workspace_t *ws,
+    gnx_mem_flags_t mem_prot)
+{
+    gnx_err_t err = gnx_block_protect(ws->user_hooks, mem_prot);
+    if (err == GNX_ERR_OK)
+        err = gnx_block_protect(ws->leaf_hooks, mem_prot);
+
+    // The counters stubs too
+    if (err == GNX_ERR_OK && ws->counters != NULL)
+        err = gnx_block_protect(ws->counters->stubs, mem_prot);
+
+    return err;
+}
+
+//--------------------------------------------------------------------------
+// Unlock the springboards blocks for a transaction (the first one makes them writable)
+static gnx_err_t open_springboards(gnx_workspace_t *ws)
+{
+    gnx_err_t err = GNX_ERR_OK;
+
+    gnx_os_lock_acquire(&ws->lock);
+    if (ws->nb_open_transactions == 0)
+        err = protect_springboards(ws, GNX_MEM_RWX);
+
+    if (err == GNX_ERR_OK)
+        ++ws->nb_open_transactions;
+    gnx_os_lock_release(&ws->lock);
+
+    return err;
+}
+
+//--------------------------------------------------------------------------
+// Lock back the springboards blocks when the last transaction ends
+static void close_springboards(
+    gnx_workspace_t *ws,
+    size_t nb_transactions)
+{
+    gnx_os_lock_acquire(&ws->lock);
+    ws->nb_open_transactions -= nb_transactions;
+    if (ws->nb_open_transactions == 0)
+        protect_springboards(ws, GNX_MEM_EXEC);
+    gnx_os_lock_release(&ws->lock);
+}
+
+//--------------------------------------------------------------------------
+// Prepare a hook: everything that does not modify the workspace, so that the
+// bulk hooks workers may run it concurrently with their own disassembler
+static void prepare_hook(
+    gnx_workspace_t *ws,
+    gnx_handle_t dis,
+    const void *src,
+    size_t func_size,
+    size_t patch_size,
+    gnx_hook_prep_t *prep)
+{
+    prep->patch_size = patch_size;
+    prep->leaf_size = 0;
+    prep->cached = true;
+
+    // The plan remembers both the real function address and its springboard
+    const gnx_sb_template_t *tpl = NULL;
+    if (ws->plan != NULL)
+    {
+        tpl = gnx_plan_lookup(
+            ws->plan,
+            dis,
+            src,
+            &prep->func_addr);
+
+        // The planned springboard may have been made for a shorter patch
+        if (tpl != NULL && tpl->backup_sz < patch_size)
+            tpl = NULL;
+    }
+
+    if (tpl == NULL)
+    {
+        // Get the real function address
+        prep->func_addr = (void *)gnx_disasm_skip_jumps(
+            dis,
+            src);
+
+        // The function size only describes the function if no jump was skipped
+        size_t leaf_max = ws->leaf_max_size;
+        if (func_size != 0 && prep->func_addr == src)
+            leaf_max = func_size <= leaf_max ? func_size : 0;
+
+        // Short leaf functions are relocated as a whole when possible
+        if (leaf_max != 0)
+        {
+            prep->leaf_size = sweep_leaf_function(
+                dis,
+                prep->func_addr,
+                leaf_max);
+
+            // Too small functions are handled by the regular springboard (it may use the alignment bytes)
+            if (prep->leaf_size < patch_size)
+                prep->leaf_size = 0;
+        }
+
+        // Functions starting with the same bytes share the same template
+        if (ws->sb_cache_enabled)
+        {
+            tpl = gnx_sb_cache_lookup(
+                ws->sb_cache,
+                prep->func_addr,
+                patch_size);
+
+            // The bulk hooks workers look up concurrently
+            if (tpl != NULL)
+                gnx_atomic_fetch_add(&ws->stats.nb_sb_cache_hits, 1);
+        }
+    }
+
+    if (tpl != NULL)
+    {
+        prep->tpl = *tpl;
+        prep->err = GNX_ERR_OK;
+    }
+    else
+    {
+        prep->cached = false;
+        prep->err = build_springboard_template(
+            dis,
+            prep->func_addr,
+            patch_size,
+            &prep->tpl);
+    }
+}
+
+//--------------------------------------------------------------------------
+// Relocate a whole leaf function (\ref GNX_OPT_LEAF_RELOC_MAX_SIZE)
+static userhook_springboard_t *make_leaf_springboard(
+    gnx_workspace_t *ws,
+    gnx_handle_t dis,
+    const void *func_addr,
+    size_t func_size,
+    size_t patch_size)
+{
+    gnx_os_lock_acquire(&ws->lock);
+    userhook_leaf_springboard_t *luh = GNX_ALLOC_CHUNK(
+        ws->leaf_hooks,
+        userhook_leaf_springboard_t);
+    gnx_os_lock_release(&ws->lock);
+
+    if (luh == NULL)
+        return NULL;
+
+    luh->uh.slot = NULL;
+    if (create_leaf_springboard(dis, func_addr, func_size, patch_size, luh) != GNX_ERR_OK)
+    {
+        // Never used, nor described to the code map
+        gnx_os_lock_acquire(&ws->lock);
+        gnx_block_chunk_free(ws->leaf_hooks, luh);
+        gnx_os_lock_release(&ws->lock);
+        return NULL;
+    }
+    return &luh->uh;
+}
+
+//--------------------------------------------------------------------------
+// Create the springboard of a prepared hook
+static gnx_err_t make_user_springboard(
+    gnx_workspace_t *ws,
+    gnx_handle_t dis,
+    gnx_hook_prep_t *prep,
+    userhook_springboard_t **uh)
+{
+    // Short leaf functions are relocated as a whole when possible
+    if (prep->leaf_size != 0)
+    {
+        userhook_springboard_t *leaf_hook = make_leaf_springboard(
+            ws,
+            dis,
+            prep->func_addr,
+            prep->leaf_size,
+            prep->patch_size);
+        if (leaf_hook != NULL)
+        {
+            gnx_code_map_add(
+                ws,
+                leaf_hook->springboard,
+                springboard_size(leaf_hook),
+                "gnx_springboard",
+                prep->func_addr);
+
+            *uh = leaf_hook;
+            return GNX_ERR_OK;
+        }
+    }
+
+    if (prep->err != GNX_ERR_OK)
+        return prep->err;
+
+    gnx_os_lock_acquire(&ws->lock);
+
+    // Allocate memory for the springboard
+    userhook_springboard_t *user_hook = GNX_ALLOC_CHUNK(
+        ws->user_hooks, 
+        userhook_springboard_t);
+
+    // Newly built templates are cached here, never by the bulk hooks workers
+    if (user_hook != NULL && !prep->cached && ws->sb_cache_enabled)
+    {
+        gnx_sb_cache_insert(
+            ws->sb_cache, 
+            prep->func_addr, 
+            &prep->tpl);
+        prep->cached = true;
+    }
+
+    gnx_os_lock_release(&ws->lock);
+
+    if (user_hook == NULL)
+        return GNX_ERR_NO_MEM;
+
+    user_hook->flags = 0;
+    user_hook->slot = NULL;
+
+    instantiate_springboard_template(
+        &prep->tpl,
+        prep->func_addr,
+        user_hook);
+
+    gnx_code_map_add(
+        ws,
+        user_hook->springboard,
+        springboard_size(user_hook),
+        "gnx_springboard",
+        prep->func_addr);
+
+    *uh = user_hook;
+
+    return GNX_ERR_OK;
+}
+
+//--------------------------------------------------------------------------
+// Push an item to the transaction. Only pushes may race (lock-free stack):
+// the items are popped by the commit or the abort, once all the threads are done.
+static void push_transaction_item(
+    gnx_transaction_t *trans,
+    gnx_transaction_item_t *item)
+{
+    gnx_singly_list_item_t *head;
+    do
+    {
+        head = trans->items.next;
+        item->slist_entry.next = head;
+    } while (gnx_atomic_cas_ptr(&trans->items.next, &item->slist_entry, head) != head);
+}
+
+//--------------------------------------------------------------------------
+// Tell whether the bytes a hook overwrites are already patched or relocated by an installed hook
+static bool hook_overlaps_index(
+    gnx_workspace_t *ws,
+    const userhook_springboard_t *uh)
+{
+    const uint8_t *start = (const uint8_t *)uh->func_addr_final;
+    const uint8_t *end = start + uh->backup_sz;
+
+    // Any indexed range overlapping the patch contains one of its bytes
+    gnx_range_t range;
+    for (const uint8_t *p = start; p < end; p++)
+    {
+        if (gnx_range_map_find(ws->hook_index, p, &range))
+            return true;
+    }
+    return false;
+}
+
+//--------------------------------------------------------------------------
+// Tell whether the bytes a hook overwrites are already patched or relocated by another hook:
+// an installed one (or its springboard) or one added to the same transaction
+static bool hook_overlaps(
+    gnx_transaction_t *trans,
+    const userhook_springboard_t *uh)
+{
+    gnx_workspace_t *ws = (gnx_workspace_t *)trans->gnx;
+    const uint8_t *start = (const uint8_t *)uh->func_addr_final;
+    const uint8_t *end = start + uh->backup_sz;
+
+    if (hook_overlaps_index(ws, uh))
+        return true;
+
+    // The items pushed meanwhile by other threads, or committed meanwhile by other transactions,
+    // are rejected by the commit (\ref reject_overlapping_items)
+    for (gnx_singly_list_item_t *cur = trans->items.next; cur != NULL; cur = cur->next)
+    {
+        const gnx_transaction_item_t *item = GNX_SINGLY_LIST_RECORD(
+            cur,
+            gnx_transaction_item_t);
+
+        if (item->op_flags != GNX_TSXF_ADD)
+            continue;
+
+        const uint8_t *other = (const uint8_t *)item->op.add.uh->func_addr_final;
+        if (other < end && start < other + item->op.add.uh->backup_sz)
+            return true;
+    }
+
+    return false;
+}
+
+//--------------------------------------------------------------------------
+// Add a prepared hook to the transaction
+// \param slot The dispatch slot of a slot hook, NULL for a regular hook
+static gnx_err_t add_prepared_hook(
+    gnx_transaction_t *trans,
+    gnx_handle_t dis,
+    void **psrc,
+    void *hook,
+    gnx_hook_prep_t *prep,
+    gnx_hook_slot_t *slot)
+{
+    gnx_workspace_t *ws = (gnx_workspace_t *)trans->gnx;
+
+    // Create a transaction item
+    gnx_transaction_item_t *item = GNX_ALLOC(gnx_transaction_item_t);
+    if (item == NULL)
+        return GNX_ERR_NO_MEM;
+
+    item->op_flags = GNX_TSXF_ADD;
+    item->committed = false;
+    item->unindexed = false;
+    item->op.add.hook_addr = hook;
+    item->op.add.psrc = psrc;
+    item->op.add.func_addr = prep->func_addr;
+
+    userhook_springboard_t *uh;
+    gnx_err_t err = make_user_springboard(
+        ws, 
+        dis,
+        prep, 
+        &uh);
+
+    if (err != GNX_ERR_OK)
+    {
+        GNX_FREE(item);
+        return err;
+    }
+
+    // Remember the original function address for restoration
+    uh->func_addr_final = item->op.add.func_addr;
+    uh->func_addr = *psrc;
+    uh->psrc = psrc;
+    uh->joins = NULL;
+
+    // The index (and the unhooking) needs each byte to be patched by one hook at most
+    if (hook_overlaps(trans, uh))
+    {
+        gnx_sb_free(ws, uh);
+        GNX_FREE(item);
+        return GNX_ERR_INVALID_ARGS;
+    }
+
+    if (slot != NULL)
+    {
+        slot->uh = uh;
+        uh->slot = slot;
+    }
+
+    // Replace the original function address with the springboard address
+    *psrc = uh->springboard;
+
+    item->op.add.uh = uh;
+    push_transaction_item(
+        trans,
+        item);
+
+    return GNX_ERR_OK;
+}
+
+//--------------------------------------------------------------------------
+// Find the hook installed on a function: the jumps leading to the function are followed
+// up to its patch, never through the patch into the hook
+static userhook_springboard_t *find_installed_hook(
+    gnx_workspace_t *ws,
+    gnx_handle_t dis,
+    const void *src)
+{
+    const void *addr = src;
+    do
+    {
+        gnx_range_t range;
+        if (gnx_range_map_find(ws->hook_index, addr, &range))
+        {
+            // Not the start of a patch (nor a springboard): the add overlaps the hook
+            userhook_springboard_t *uh = (userhook_springboard_t *)range.value;
+            return range.start == addr && addr == uh->func_addr_final ? uh : NULL;
+        }
+    } while (gnx_disasm_follow_jump(dis, addr, &addr));
+
+    return NULL;
+}
+
+//--------------------------------------------------------------------------
+// Join a hook behind the hook installed on the function: the function keeps its single patch
+// and springboard, the hook is linked to the chain when committed (\ref link_joined_hook)
+static gnx_err_t add_joined_hook(
+    gnx_transaction_t *trans,
+    userhook_springboard_t *uh,
+    void **psrc,
+    void *hook)
+{
+    // The hooks of a slot hook are chained through its dispatch slot (\ref gnx_hook_chain_insert)
+    if (uh->slot != NULL)
+        return GNX_ERR_INVALID_ARGS;
+
+    gnx_transaction_item_t *item = GNX_ALLOC(gnx_transaction_item_t);
+    if (item == NULL)
+        return GNX_ERR_NO_MEM;
+
+    gnx_hook_join_t *join = GNX_ALLOC(gnx_hook_join_t);
+    if (join == NULL)
+    {
+        GNX_FREE(item);
+        return GNX_ERR_NO_MEM;
+    }
+
+    join->next = NULL;
+    join->hook = hook;
+    join->psrc = psrc;
+    join->func_addr = *psrc;
+
+    item->op_flags = GNX_TSXF_JOIN;
+    item->committed = false;
+    item->unindexed = false;
+    item->op.join.uh = uh;
+    item->op.join.func_addr = uh->func_addr_final;
+    item->op.join.join = join;
+    item->op.join.psrc = psrc;
+
+    // Like a new hook's, the function pointer runs the original function until the commit
+    *psrc = uh->springboard;
+
+    push_transaction_item(
+        trans,
+        item);
+
+    return GNX_ERR_OK;
+}
+
+//--------------------------------------------------------------------------
+// Take a disassembler from the workspace pool (or create one)
+static gnx_handle_t acquire_disasm(gnx_workspace_t *ws)
+{
+    gnx_disasm_t *dis = NULL;
+
+    gnx_os_lock_acquire(&ws->lock);
+    if (ws->dis_pool.next != NULL)
+    {
+        dis = GNX_SINGLY_LIST_ITEM_POP(
+            &ws->dis_pool, 
+            gnx_disasm_t);
+    }
+    gnx_os_lock_release(&ws->lock);
+
+    if (dis == NULL)
+        return gnx_disasm_create();
+
+    return (gnx_handle_t)dis;
+}
+
+//--------------------------------------------------------------------------
+// Give back a disassembler to the workspace pool (linked through its own list entry, nothing to allocate)
+static void release_disasm(
+    gnx_workspace_t *ws,
+    gnx_handle_t handle)
+{
+    if (handle == GNX_INVALID_HANDLE)
+        return;
+
+    GET_DISASM;
+
+    gnx_os_lock_acquire(&ws->lock);
+    GNX_SINGLY_LIST_ITEM_PUSH(
+        &ws->dis_pool,
+        dis);
+    gnx_os_lock_release(&ws->lock);
+}
+
+//--------------------------------------------------------------------------
+void gnx_dis_pool_free(gnx_workspace_t *ws)
+{
+    while (ws->dis_pool.next != NULL)
+    {
+        gnx_disasm_t *dis = GNX_SINGLY_LIST_ITEM_POP(
+            &ws->dis_pool, 
+            gnx_disasm_t);
+
+        gnx_disasm_free((gnx_handle_t)dis);
+    }
+}
+
+//--------------------------------------------------------------------------
+gnx_err_t GANXO_API gnx_transaction_begin(
+    gnx_handle_t gnx,
+    gnx_handle_t *handle)
+{
+    gnx_workspace_t *ws = (gnx_workspace_t *)gnx;
+
+    // Create new transaction
+    gnx_transaction_t *trans = GNX_ALLOC(gnx_transaction_t);
+    if (trans == NULL)
+        return GNX_ERR_NO_MEM;
+
+    // Unlock the blocks when the transaction begins
+    if (open_springboards(ws) != GNX_ERR_OK)
+    {
+        gnx_mfree(trans);
+        return GNX_ERR_FAILED;
+    }
+
+    // Make room with the retired springboards
+    gnx_sb_reclaim(ws);
+
+    // Remember the workspace
+    trans->gnx = gnx;
+
+    // Initialize the transaction items linked list
+    gnx_singly_list_init(&trans->items);
+
+    *handle = (gnx_handle_t)trans;
+
+    return GNX_ERR_OK;
+}
+
+//--------------------------------------------------------------------------
+gnx_err_t GANXO_API gnx_transaction_add_hook(
+    gnx_handle_t handle,
+    void **psrc,
+    void *hook)
+{
+    GET_VARS;
+
+    // Other threads may be adding hooks to the same transaction
+    gnx_handle_t dis = acquire_disasm(ws);
+    if (dis == GNX_INVALID_HANDLE)
+        return GNX_ERR_DISASM;
+
+    // An already hooked function keeps its patch: the hook joins the installed one
+    gnx_err_t err;
+    userhook_springboard_t *installed = find_installed_hook(
+        ws,
+        dis,
+        *psrc);
+
+    if (installed != NULL)
+    {
+        err = add_joined_hook(
+            trans,
+            installed,
+            psrc,
+            hook);
+    }
+    else
+    {
+        gnx_hook_prep_t prep;
+        prepare_hook(
+            ws, 
+            dis, 
+            *psrc, 
+            0, 
+            GANXO_JUMP_TO_SPRINGBOARD_SIZE,
+            &prep);
+
+        err = add_prepared_hook(
+            trans,
+            dis,
+            psrc,
+            hook,
+            &prep,
+            NULL);
+    }
+
+    release_disasm(ws, dis);
+
+    return err;
+}
+
+//--------------------------------------------------------------------------
+gnx_err_t GANXO_API gnx_transaction_add_slot_hook(
+    gnx_handle_t handle,
+    void **psrc,
+    void *hook,
+    bool enabled,
+    gnx_handle_t *hook_handle)
+{
+    GET_VARS;
+
+    if (psrc == NULL || hook_handle == NULL)
+        return GNX_ERR_INVALID_ARGS;
+
+    // The dispatch slot lives in a data block: it is never executable nor write protected
+    gnx_os_lock_acquire(&ws->lock);
+    gnx_hook_slot_t *slot = GNX_ALLOC_CHUNK(
+        ws->hook_slots,
+        gnx_hook_slot_t);
+    gnx_os_lock_release(&ws->lock);
+
+    if (slot == NULL)
+        return GNX_ERR_NO_MEM;
+
+    slot->hook = hook;
+    slot->base_hook = hook;
+    slot->chain = NULL;
+    slot->uh = NULL;
+    gnx_os_lock_init(&slot->chain_lock);
+
+    gnx_handle_t dis = acquire_disasm(ws);
+    if (dis == GNX_INVALID_HANDLE)
+    {
+        free_hook_slot(ws, slot);
+        return GNX_ERR_DISASM;
+    }
+
+    gnx_hook_prep_t prep;
+    prepare_hook(
+        ws, 
+        dis, 
+        *psrc, 
+        0, 
+        GANXO_JUMP_TO_SLOT_SIZE,
+        &prep);
+
+    gnx_err_t err = add_prepared_hook(
+        trans,
+        dis,
+        psrc,
+        hook,
+        &prep,
+        slot);
+
+    release_disasm(ws, dis);
+
+    if (err != GNX_ERR_OK)
+    {
+        free_hook_slot(ws, slot);
+        return err;
+    }
+
+    // Nothing jumps through the slot until the transaction is committed
+    slot->target = enabled ? hook : slot->uh->springboard;
+    *hook_handle = (gnx_handle_t)slot;
+
+    return GNX_ERR_OK;
+}
+
+//--------------------------------------------------------------------------
+gnx_err_t GANXO_API gnx_hook_enable(gnx_handle_t hook_handle)
+{
+    gnx_hook_slot_t *slot = (gnx_hook_slot_t *)hook_handle;
+    if (slot == NULL)
+        return GNX_ERR_INVALID_ARGS;
+
+    // Jump to the first hook of the chain, even if it is being replaced meanwhile (\ref gnx_hook_chain_insert)
+    void *hook;
+    do
+    {
+        hook = slot->hook;
+        gnx_atomic_xchg_ptr(&slot->target, hook);
+    } while (slot->hook != hook);
+
+    return GNX_ERR_OK;
+}
+
+//--------------------------------------------------------------------------
+gnx_err_t GANXO_API gnx_hook_disable(gnx_handle_t hook_handle)
+{
+    gnx_hook_slot_t *slot = (gnx_hook_slot_t *)hook_handle;
+    if (slot == NULL)
+        return GNX_ERR_INVALID_ARGS;
+
+    // The springboard runs the original function
+    gnx_atomic_xchg_ptr(&slot->target, slot->uh->springboard);
+
+    return GNX_ERR_OK;
+}
+
+//--------------------------------------------------------------------------
+// Make a hook the first of the chain (the chain lock is held)
+static void set_chain_head(
+    gnx_hook_slot_t *slot,
+    void *hook)
+{
+    void *old_hook = slot->hook;
+    gnx_atomic_xchg_ptr(&slot->hook, hook);
+
+    // Only an enabled hook jumps to the chain
+    gnx_atomic_cas_ptr(&slot->target, hook, old_hook);
+}
+
+//--------------------------------------------------------------------------
+gnx_err_t GANXO_API gnx_hook_chain_insert(
+    gnx_handle_t hook_handle,
+    gnx_handle_t after,
+    void **porig,
+    void *hook,
+    gnx_handle_t *entry_handle)
+{
+    gnx_hook_slot_t *slot = (gnx_hook_slot_t *)hook_handle;
+    gnx_hook_chain_entry_t *prev = (gnx_hook_chain_entry_t *)after;
+
+    if (slot == NULL || porig == NULL || hook == NULL || entry_handle == NULL)
+        return GNX_ERR_INVALID_ARGS;
+
+    gnx_hook_chain_entry_t *entry = GNX_ALLOC(gnx_hook_chain_entry_t);
+    if (entry == NULL)
+        return GNX_ERR_NO_MEM;
+
+    entry->hook = hook;
+    entry->porig = porig;
+
+    gnx_os_lock_acquire(&slot->chain_lock);
+
+    gnx_hook_chain_entry_t *cur = slot->chain;
+    while (cur != NULL && cur != prev)
+        cur = cur->next;
+
+    gnx_err_t err = GNX_ERR_OK;
+    if (prev == NULL)
+    {
+        // The new hook continues to the previous first hook
+        entry->next = slot->chain;
+        *porig = slot->hook;
+        slot->chain = entry;
+
+        set_chain_head(slot, hook);
+    }
+    else if (cur != NULL)
+    {
+        // The previous hook now continues to the new hook, which continues where the previous one did
+        entry->next = prev->next;
+        *porig = *prev->porig;
+        prev->next = entry;
+
+        gnx_atomic_xchg_ptr(prev->porig, hook);
+    }
+    else
+    {
+        // Not an entry of this chain
+        err = GNX_ERR_INVALID_ARGS;
+    }
+
+    gnx_os_lock_release(&slot->chain_lock);
+
+    if (err != GNX_ERR_OK)
+    {
+        GNX_FREE(entry);
+        return err;
+    }
+
+    *entry_handle = (gnx_handle_t)entry;
+
+    return GNX_ERR_OK;
+}
+
+//--------------------------------------------------------------------------
+gnx_err_t GANXO_API gnx_hook_chain_remove(
+    gnx_handle_t hook_handle,
+    gnx_handle_t entry_handle)
+{
+    gnx_hook_slot_t *slot = (gnx_hook_slot_t *)hook_handle;
+    gnx_hook_chain_entry_t *entry = (gnx_hook_chain_entry_t *)entry_handle;
+
+    if (slot == NULL || entry == NULL)
+        return GNX_ERR_INVALID_ARGS;
+
+    gnx_os_lock_acquire(&slot->chain_lock);
+
+    gnx_hook_chain_entry_t *prev = NULL, *cur = slot->chain;
+    while (cur != NULL && cur != entry)
+    {
+        prev = cur;
+        cur = cur->next;
+    }
+
+    if (cur != NULL)
+    {
+        // Skip the hook: the calls already in it still continue through its own function pointer
+        if (prev == NULL)
+        {
+            slot->chain = entry->next;
+            set_chain_head(slot, *entry->porig);
+        }
+        else
+        {
+            prev->next = entry->next;
+            gnx_atomic_xchg_ptr(prev->porig, *entry->porig);
+        }
+    }
+
+    gnx_os_lock_release(&slot->chain_lock);
+
+    if (cur == NULL)
+        return GNX_ERR_INVALID_ARGS;
+
+    GNX_FREE(entry);
+
+    return GNX_ERR_OK;
+}
+
+//--------------------------------------------------------------------------
+// Bulk hooks preparation worker: prepares batches of descriptors until none is left
+static void bulk_prepare_worker(void *param)
+{
+    gnx_bulk_worker_t *worker = (gnx_bulk_worker_t *)param;
+    gnx_bulk_ctx_t *ctx = worker->ctx;
+
+    for (;;)
+    {
+        size_t first = (size_t)gnx_atomic_fetch_add(&ctx->next, GNX_BULK_BATCH_SIZE);
+        if (first >= ctx->n)
+            break;
+
+        size_t last = first + GNX_BULK_BATCH_SIZE;
+        if (last > ctx->n)
+            last = ctx->n;
+
+        for (size_t i = first; i < last; i++)
+        {
+            const gnx_hook_desc_t *desc = &ctx->descs[i];
+            prepare_hook(
+                ctx->ws,
+                worker->dis,
+                *desc->psrc,
+                desc->func_size,
+                GANXO_JUMP_TO_SPRINGBOARD_SIZE,
+                &ctx->preps[i]);
+        }
+    }
+}
+
+//--------------------------------------------------------------------------
+gnx_err_t GANXO_API gnx_transaction_add_hooks(
+    gnx_handle_t handle,
+    const gnx_hook_desc_t *descs,
+    size_t n,
+    gnx_err_t *results)
+{
+    GET_VARS;
+
+    if (descs == NULL || n == 0 || n > LONG_MAX - GNX_BULK_BATCH_SIZE)
+        return GNX_ERR_INVALID_ARGS;
+
+    for (size_t i = 0; i < n; i++)
+    {
+        if (descs[i].psrc == NULL)
+            return GNX_ERR_INVALID_ARGS;
+    }
+
+    gnx_bulk_ctx_t ctx;
+    ctx.ws = ws;
+    ctx.descs = descs;
+    ctx.n = n;
+    ctx.next = 0;
+    ctx.preps = (gnx_hook_prep_t *)gnx_malloc(n * sizeof(gnx_hook_prep_t));
+    if (ctx.preps == NULL)
+        return GNX_ERR_NO_MEM;
+
+    // No need for more workers than batches
+    size_t nb_workers = ws->nb_workers != 0 ? ws->nb_workers : gnx_os_cpu_count();
+    size_t nb_batches = GNX_ROUND_UP_DIV(n, GNX_BULK_BATCH_SIZE);
+    if (nb_workers > nb_batches)
+        nb_workers = nb_batches;
+    if (nb_workers > GNX_BULK_MAX_WORKERS)
+        nb_workers = GNX_BULK_MAX_WORKERS;
+
+    //
+    // Fan out: the calling thread is the first worker.
+    // The other workers are best effort: when they cannot start, the remaining ones take over their batches.
+    //
+    gnx_bulk_worker_t workers[GNX_BULK_MAX_WORKERS];
+    workers[0].ctx = &ctx;
+    workers[0].thread = NULL;
+    workers[0].dis = acquire_disasm(ws);
+    if (workers[0].dis == GNX_INVALID_HANDLE)
+    {
+        gnx_mfree(ctx.preps);
+        return GNX_ERR_DISASM;
+    }
+
+    for (size_t i = 1; i < nb_workers; i++)
+    {
+        gnx_bulk_worker_t *worker = &workers[i];
+        worker->ctx = &ctx;
+        worker->thread = NULL;
+        worker->dis = acquire_disasm(ws);
+        if (worker->dis == GNX_INVALID_HANDLE)
+            continue;
+
+        worker->thread = gnx_os_thread_create(
+            bulk_prepare_worker, 
+            worker);
+    }
+
+    bulk_prepare_worker(&workers[0]);
+
+    for (size_t i = 1; i < nb_workers; i++)
+    {
+        gnx_bulk_worker_t *worker = &workers[i];
+        if (worker->thread != NULL)
+            gnx_os_thread_join(worker->thread);
+
+        if (worker->dis != GNX_INVALID_HANDLE)
+            release_disasm(ws, worker->dis);
+    }
+
+    //
+    // Merge in the descriptors order so that the transaction does not depend on the threads scheduling
+    //
+    size_t nb_success = 0;
+    for (size_t i = 0; i < n; i++)
+    {
+        gnx_err_t err = add_prepared_hook(
+            trans,
+            workers[0].dis,
+            descs[i].psrc,
+            descs[i].hook,
+            &ctx.preps[i],
+            NULL);
+
+        if (err == GNX_ERR_OK)
+            ++nb_success;
+
+        if (results != NULL)
+            results[i] = err;
+    }
+
+    release_disasm(ws, workers[0].dis);
+    gnx_mfree(ctx.preps);
+
+    if (nb_success == n)
+        return GNX_ERR_OK;
+
+    return nb_success == 0 ? GNX_ERR_FAILED : GNX_ERR_PARTIAL;
+}
+
+//--------------------------------------------------------------------------
+// Find the hook a function pointer belongs to among the hooks with joined hooks
+// (their function pointers lead to the next hook of the chain, not to the springboard).
+// The commit lock is held: the chains and the index only change under it.
+// \param join Returns the joined hook, NULL if the function pointer is the installed hook's own
+static bool find_chained_hook(
+    gnx_workspace_t *ws,
+    void **psrc,
+    userhook_springboard_t **puh,
+    gnx_hook_join_t **pjoin)
+{
+    bool found = false;
+
+    size_t nb_ranges = gnx_range_map_copy(ws->hook_index, NULL, 0);
+    gnx_range_t *ranges = (gnx_range_t *)gnx_malloc((nb_ranges + 1) * sizeof(gnx_range_t));
+    if (ranges != NULL)
+        nb_ranges = gnx_range_map_copy(ws->hook_index, ranges, nb_ranges);
+
+    for (size_t i = 0; ranges != NULL && i < nb_ranges && !found; i++)
+    {
+        // Each hook once: its patch range
+        userhook_springboard_t *uh = (userhook_springboard_t *)ranges[i].value;
+        if (ranges[i].start != uh->func_addr_final || uh->joins == NULL)
+            continue;
+
+        *puh = uh;
+        *pjoin = NULL;
+        found = uh->psrc == psrc;
+        for (gnx_hook_join_t *join = uh->joins; join != NULL && !found; join = join->next)
+        {
+            *pjoin = join;
+            found = join->psrc == psrc;
+        }
+    }
+
+    gnx_mfree(ranges);
+    return found;
+}
+
+//--------------------------------------------------------------------------
+bool gnx_hook_is_chained(
+    gnx_workspace_t *ws,
+    void **psrc)
+{
+    userhook_springboard_t *uh;
+    gnx_hook_join_t *join;
+
+    gnx_os_lock_acquire(&ws->commit_lock);
+    bool found = find_chained_hook(ws, psrc, &uh, &join);
+    gnx_os_lock_release(&ws->commit_lock);
+
+    return found;
+}
+
+//--------------------------------------------------------------------------
+gnx_err_t GANXO_API gnx_transaction_remove_hook(
+    gnx_handle_t handle,
+    void **psrc)
+{
+    GET_VARS;
+
+    if (psrc == NULL)
+        return GNX_ERR_INVALID_ARGS;
+
+    // After a successful hook, psrc points to an installed springboard (a user springboard structure)
+    // unless other hooks were joined behind it
+    userhook_springboard_t *uh = NULL;
+    gnx_hook_join_t *join = NULL;
+    gnx_range_t range;
+    if (    gnx_range_map_find(ws->hook_index, *psrc, &range) 
+        &&  range.start == *psrc)
+    {
+        uh = GNX_CONTAINING_RECORD(
+            *psrc, 
+            userhook_springboard_t, 
+            springboard);
+    }
+
+    if (uh == NULL || (uh->psrc != psrc && uh->joins != NULL))
+    {
+        gnx_os_lock_acquire(&ws->commit_lock);
+        bool found = find_chained_hook(ws, psrc, &uh, &join);
+        gnx_os_lock_release(&ws->commit_lock);
+
+        if (!found)
+            return GNX_ERR_INVALID_ARGS;
+    }
+
+    // Create a transaction item
+    gnx_transaction_item_t *item = GNX_ALLOC(gnx_transaction_item_t);
+    if (item == NULL)
+        return GNX_ERR_NO_MEM;
+
+    item->committed = false;
+    item->unindexed = false;
+
+    if (join != NULL)
+    {
+        // Only unlinked from the chain when committed
+        item->op_flags = GNX_TSXF_LEAVE;
+        item->op.join.uh = uh;
+        item->op.join.func_addr = uh->func_addr_final;
+        item->op.join.join = join;
+        item->op.join.psrc = psrc;
+    }
+    else
+    {
+        // Handed over to the joined hooks if there are some when committed (\ref update_hook_chains)
+        item->op_flags = GNX_TSXF_DEL;
+        item->op.remove.psrc = psrc;
+        item->op.remove.uh = uh;
+        item->op.remove.join = NULL;
+        item->op.remove.hook_addr = NULL;
+    }
+
+    push_transaction_item(
+        trans,
+        item);
+
+    return GNX_ERR_OK;
+}
+
+//--------------------------------------------------------------------------
+/// Import slots hook request (\ref gnx_transaction_add_iat_hook)
+typedef struct __gnx_iat_hook_ctx_t
+{
+    gnx_transaction_t *trans;
+    void *hook;
+    void **porig;
+    size_t nb_slots;
+    gnx_err_t err;
+} gnx_iat_hook_ctx_t;
+
+//--------------------------------------------------------------------------
+// Add an import slot to redirect to the transaction
+static void add_import_slot(
+    void *ctx,
+    void **slot)
+{
+    gnx_iat_hook_ctx_t *iat = (gnx_iat_hook_ctx_t *)ctx;
+    if (iat->err != GNX_ERR_OK)
+        return;
+
+    gnx_transaction_item_t *item = GNX_ALLOC(gnx_transaction_item_t);
+    if (item == NULL)
+    {
+        iat->err = GNX_ERR_NO_MEM;
+        return;
+    }
+
+    // The first slot found tells where the original function is
+    if (iat->nb_slots++ == 0)
+        *iat->porig = *slot;
+
+    item->op_flags = GNX_TSXF_IAT;
+    item->committed = false;
+    item->unindexed = false;
+    item->op.iat.slot = slot;
+    item->op.iat.hook_addr = iat->hook;
+    item->op.iat.porig = iat->porig;
+
+    push_transaction_item(
+        iat->trans,
+        item);
+}
+
+//--------------------------------------------------------------------------
+gnx_err_t GANXO_API gnx_transaction_add_iat_hook(
+    gnx_handle_t handle,
+    const char *module,
+    const char *symbol,
+    void *hook,
+    void **orig)
+{
+    GET_TRANS;
+
+    if (symbol == NULL || hook == NULL || orig == NULL)
+        return GNX_ERR_INVALID_ARGS;
+
+    // "dll!function" restricts the function to the imports of that module
+    char dll[GNX_OS_MODULE_NAME_SIZE];
+    const char *sep = strchr(symbol, '!');
+    if (sep != NULL)
+    {
+        size_t len = sep - symbol;
+        if (len == 0 || len >= sizeof(dll))
+            return GNX_ERR_INVALID_ARGS;
+
+        memcpy(dll, symbol, len);
+        dll[len] = '\0';
+        symbol = sep + 1;
+    }
+
+    gnx_iat_hook_ctx_t ctx;
+    ctx.trans = trans;
+    ctx.hook = hook;
+    ctx.porig = orig;
+    ctx.nb_slots = 0;
+    ctx.err = GNX_ERR_OK;
+
+    gnx_os_find_import_slots(
+        module,
+        sep != NULL ? dll : NULL,
+        symbol,
+        add_import_slot,
+        &ctx);
+
+    if (ctx.err == GNX_ERR_OK && ctx.nb_slots == 0)
+        ctx.err = GNX_ERR_NOT_FOUND;
+
+    return ctx.err;
+}
+
+//--------------------------------------------------------------------------
+// Hook a function with a generated stub (a counter or trace hook). The stub is generated
+// once the function pointer is the springboard.
+static gnx_err_t add_stub_hook(
+    gnx_handle_t handle,
+    void **psrc,
+    uint32_t *counter_index,
+    uint8_t **stub)
+{
+    GET_VARS;
+
+    // The stubs block is writable while the transaction is open
+    gnx_err_t err = gnx_counters_alloc_stub(
+        ws,
+        stub,
+        counter_index);
+
+    if (err != GNX_ERR_OK)
+        return err;
+
+    const void *func = *psrc;
+    err = gnx_transaction_add_hook(
+        handle,
+        psrc,
+        *stub);
+
+    if (err != GNX_ERR_OK)
+    {
+        // The counter index is not reused
+        gnx_os_lock_acquire(&ws->lock);
+        gnx_block_chunk_free(ws->counters->stubs, *stub);
+        gnx_os_lock_release(&ws->lock);
+        return err;
+    }
+
+    // The stubs are kept until the workspace is closed: never removed from the code map
+    gnx_code_map_add(
+        ws,
+        *stub,
+        GNX_STUB_SIZE,
+        "gnx_stub",
+        func);
+
+    return GNX_ERR_OK;
+}
+
+//--------------------------------------------------------------------------
+gnx_err_t GANXO_API gnx_transaction_add_counter_hook(
+    gnx_handle_t handle,
+    void **psrc,
+    uint32_t flags,
+    gnx_handle_t *counter)
+{
+    GET_VARS;
+
+    if (psrc == NULL || counter == NULL)
+        return GNX_ERR_INVALID_ARGS;
+
+    const void *func = *psrc;
+    uint8_t *stub;
+    uint32_t index;
+    gnx_err_t err = add_stub_hook(
+        handle,
+        psrc,
+        &index,
+        &stub);
+
+    if (err != GNX_ERR_OK)
+        return err;
+
+    // The stub ends in the springboard
+    gnx_counters_gen_stub(
+        ws->counters,
+        stub,
+        index,
+        flags,
+        *psrc);
+
+    gnx_counters_describe(
+        ws,
+        index,
+        func,
+        flags);
+
+    *counter = (gnx_handle_t)(uintptr_t)(index + 1);
+
+    return GNX_ERR_OK;
+}
+
+//--------------------------------------------------------------------------
+gnx_err_t GANXO_API gnx_transaction_add_trace_hook(
+    gnx_handle_t handle,
+    void **psrc,
+    uint32_t hook_id,
+    uint32_t flags)
+{
+    GET_VARS;
+
+    if (psrc == NULL || GNX_HAS_FLAG(hook_id, GNX_TRACE_RETURN_RECORD) || ((flags >> 8) & 0xFF) > 3)
+        return GNX_ERR_INVALID_ARGS;
+
+    uint8_t *stub;
+    gnx_err_t err = add_stub_hook(
+        handle,
+        psrc,
+        NULL,
+        &stub);
+
+    if (err != GNX_ERR_OK)
+        return err;
+
+    gnx_counters_gen_trace_stub(
+        ws->counters,
+        stub,
+        hook_id,
+        flags,
+        *psrc);
+
+    return GNX_ERR_OK;
+}
+
+//--------------------------------------------------------------------------
+gnx_err_t GANXO_API gnx_transaction_add_filtered_hook(
+    gnx_handle_t handle,
+    void **psrc,
+    void *hook,
+    const char *filter)
+{
+    if (psrc == NULL || hook == NULL || filter == NULL)
+        return GNX_ERR_INVALID_ARGS;
+
+    gnx_filter_t parsed;
+    gnx_err_t err = gnx_filter_parse(
+        filter,
+        &parsed);
+
+    if (err != GNX_ERR_OK)
+        return err;
+
+    uint8_t *stub;
+    err = add_stub_hook(
+        handle,
+        psrc,
+        NULL,
+        &stub);
+
+    if (err != GNX_ERR_OK)
+        return err;
+
+    // The calls that do not match jump to the springboard
+    gnx_filter_gen_stub(
+        &parsed,
+        stub,
+        hook,
+        *psrc);
+
+    return GNX_ERR_OK;
+}
+
+//--------------------------------------------------------------------------
+gnx_err_t GANXO_API gnx_transaction_add_thread_hook(
+    gnx_handle_t handle,
+    void **psrc,
+    void *hook,
+    gnx_handle_t *thread_hook)
+{
+    GET_VARS;
+
+    if (psrc == NULL || hook == NULL || thread_hook == NULL)
+        return GNX_ERR_INVALID_ARGS;
+
+    uint32_t ofs, bit;
+    gnx_err_t err = gnx_counters_alloc_thread_bit(
+        ws,
+        thread_hook,
+        &ofs,
+        &bit);
+
+    if (err != GNX_ERR_OK)
+        return err;
+
+    // The bit is not reused if the hook fails
+    uint8_t *stub;
+    err = add_stub_hook(
+        handle,
+        psrc,
+        NULL,
+        &stub);
+
+    if (err != GNX_ERR_OK)
+        return err;
+
+    gnx_counters_gen_thread_stub(
+        stub,
+        ofs,
+        bit,
+        hook,
+        *psrc);
+
+    return GNX_ERR_OK;
+}
+
+//--------------------------------------------------------------------------
+gnx_err_t GANXO_API gnx_transaction_add_guarded_hook(
+    gnx_handle_t handle,
+    void **psrc,
+    void *hook,
+    uint32_t group)
+{
+    GET_VARS;
+
+    if (psrc == NULL || hook == NULL || group >= GNX_GUARD_GROUPS)
+        return GNX_ERR_INVALID_ARGS;
+
+    // The stubs block is writable while the transaction is open
+    gnx_guard_group_t *guard;
+    gnx_err_t err = gnx_counters_get_guard(
+        ws,
+        group,
+        &guard);
+
+    if (err != GNX_ERR_OK)
+        return err;
+
+    uint8_t *stub;
+    err = add_stub_hook(
+        handle,
+        psrc,
+        NULL,
+        &stub);
+
+    if (err != GNX_ERR_OK)
+        return err;
+
+    gnx_counters_gen_guard_stub(
+        guard,
+        stub,
+        hook,
+        *psrc);
+
+    return GNX_ERR_OK;
+}
+
+//--------------------------------------------------------------------------
+gnx_err_t GANXO_API gnx_transaction_abort(gnx_handle_t handle)
+{
+    GET_VARS;
+    gnx_singly_list_item_t *cur = trans->items.next;
+    while (cur != NULL)
+    {
+        // Get the current item
+        gnx_transaction_item_t *item = GNX_SINGLY_LIST_RECORD(
+            cur,
+            gnx_transaction_item_t);
+
+        if (item->op_flags == GNX_TSXF_ADD)
+        {
+            // Restore the original function address
+            *item->op.add.psrc = item->op.add.uh->func_addr;
+
+            // Free the springboard
+            gnx_sb_free(ws, item->op.add.uh);
+        }
+        else if (item->op_flags == GNX_TSXF_JOIN)
+        {
+            // Never linked to the chain
+            *item->op.join.psrc = item->op.join.join->func_addr;
+            GNX_FREE(item->op.join.join);
+        }
+        // A removal only drops its item: the hook is still installed, with its springboard
+        cur = cur->next;
+
+        GNX_FREE(item);
+    }
+
+    // Lock back the blocks
+    close_springboards(ws, 1);
+
+    // The transaction is now empty, free it
+    GNX_FREE(trans);
+
+    return GNX_ERR_OK;
+}
+
+//--------------------------------------------------------------------------
+// Generate the jump to the hook in a buffer, as it has to be written at the function address
+static size_t gen_hook_jump(
+    gnx_handle_t dis,
+    const void *func_addr,
+    const void *hook_addr,
+    uint8_t *code)
+{
+    // The relative branch is generated for the buffer address: shift the target accordingly
+    void *dest = code;
+    gnx_asm_gen_relbranch(
+        dis,
+        false,
+        (const void *)((uintptr_t)hook_addr + ((uintptr_t)code - (uintptr_t)func_addr)),
+        &dest);
+
+    return (uint8_t *)dest - code;
+}
+
+//--------------------------------------------------------------------------
+// Generate the patch of a hooked function: a jump to the hook, or through the dispatch slot of a slot hook
+static size_t gen_hook_patch(
+    gnx_handle_t dis,
+    const gnx_transaction_item_t *item,
+    uint8_t *code)
+{
+    const gnx_hook_slot_t *slot = item->op.add.uh->slot;
+    if (slot == NULL)
+    {
+        return gen_hook_jump(
+            dis,
+            item->op.add.func_addr,
+            item->op.add.hook_addr,
+            code);
+    }
+
+    void *dest = code;
+    gnx_asm_gen_indirect_jump(
+        dis,
+        (const void *)&slot->target,
+        &dest);
+
+    return (uint8_t *)dest - code;
+}
+
+//--------------------------------------------------------------------------
+// Once the patch jumps to the first joined hook, that hook takes the removed one's place
+static void hand_over_patch(gnx_transaction_item_t *item)
+{
+    userhook_springboard_t *uh = item->op.remove.uh;
+
+    // The same hook removed twice in the batch hands the patch over once
+    gnx_hook_join_t *join = item->op.remove.join;
+    if (uh->joins != join)
+        return;
+
+    // Restore the original function address
+    *item->op.remove.psrc = uh->func_addr;
+
+    uh->psrc = join->psrc;
+    uh->func_addr = join->func_addr;
+    uh->joins = join->next;
+
+    GNX_FREE(join);
+}
+
+//--------------------------------------------------------------------------
+// Map an offset in the original function to the springboard (or the reverse) by relocating
+// the copied instructions again
+// \return False if the offset is not an instruction boundary of the relocated code
+static bool map_springboard_offset(
+    gnx_handle_t dis,
+    const userhook_springboard_t *uh,
+    bool to_springboard,
+    size_t ofs,
+    size_t *mapped)
+{
+    bool leaf = GNX_HAS_FLAG(uh->flags, GNX_UHF_LEAF);
+
+    // The original code: the backup then, for leaf functions, the rest of the function (never patched)
+    uint8_t src_code[GANXO_MAX_LEAF_FUNCTION_SIZE];
+    size_t src_sz = leaf ? uh->leaf_size : uh->backup_sz;
+    memcpy(src_code, uh->backup, uh->backup_sz);
+    memcpy(
+        src_code + uh->backup_sz, 
+        (const uint8_t *)uh->func_addr_final + uh->backup_sz, 
+        src_sz - uh->backup_sz);
+
+    const uint8_t *src = src_code;
+    size_t sb_ofs = 0;
+    while (src < src_code + src_sz)
+    {
+        size_t src_ofs = src - src_code;
+        if (to_springboard ? src_ofs == ofs : sb_ofs == ofs)
+        {
+            *mapped = to_springboard ? sb_ofs : src_ofs;
+            return true;
+        }
+
+        uint8_t reloc[GANXO_MAX_INSTR_SIZE];
+        void *dest = reloc;
+        if (gnx_disasm_copy_instruction(dis, (const void **)&src, &dest) != GNX_ERR_OK)
+            return false;
+
+        sb_ofs += (uint8_t *)dest - reloc;
+    }
+
+    // The jump back to the function
+    if (!to_springboard && !leaf && ofs == sb_ofs)
+    {
+        *mapped = uh->backup_sz;
+        return true;
+    }
+    return false;
+}
+
+/// Code range where a stopped thread must be moved (\ref GNX_COMMIT_STOP_THREADS)
+typedef struct __gnx_stw_window_t
+{
+    const uint8_t *start;
+    const uint8_t *end;
+    const userhook_springboard_t *uh;
+    bool springboard;       ///< The range is in the springboard (unhooking), otherwise in the function (hooking)
+} gnx_stw_window_t;
+
+/// Stop-the-world patching
+typedef struct __gnx_stw_ctx_t
+{
+    gnx_workspace_t *ws;
+    gnx_handle_t dis;           ///< Disassembler of the fixups, not shared with any suspended thread
+    gnx_live_patch_t *patches;
+    size_t nb_patches;
+    gnx_stw_window_t *windows;  ///< Sorted windows
+    size_t nb_windows;
+    uint32_t nb_fixups;
+} gnx_stw_ctx_t;
+
+//--------------------------------------------------------------------------
+static int __cdecl compare_stw_windows(
+    const void *a,
+    const void *b)
+{
+    const uint8_t *pa = ((const gnx_stw_window_t *)a)->start;
+    const uint8_t *pb = ((const gnx_stw_window_t *)b)->start;
+
+    return pa < pb ? -1 : (pa > pb ? 1 : 0);
+}
+
+//--------------------------------------------------------------------------
+// The other threads are suspended: plain writes
+static void stw_patch(void *param)
+{
+    gnx_stw_ctx_t *ctx = (gnx_stw_ctx_t *)param;
+    for (size_t i = 0; i < ctx->nb_patches; i++)
+    {
+        gnx_live_patch_t *patch = &ctx->patches[i];
+        memcpy(patch->addr, patch->code, patch->size);
+    }
+}
+
+//--------------------------------------------------------------------------
+// Move a thread stopped in the middle of a patched prologue to the equivalent instruction
+static bool stw_fixup_ip(
+    void *param,
+    const void **ip)
+{
+    gnx_stw_ctx_t *ctx = (gnx_stw_ctx_t *)param;
+    const uint8_t *pc = (const uint8_t *)*ip;
+
+    // Find the last window starting at or before the instruction pointer
+    size_t lo = 0, hi = ctx->nb_windows;
+    while (lo < hi)
+    {
+        size_t mid = (lo + hi) / 2;
+        if (ctx->windows[mid].start <= pc)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    if (lo == 0 || pc >= ctx->windows[lo - 1].end)
+        return false;
+
+    const gnx_stw_window_t *window = &ctx->windows[lo - 1];
+    const userhook_springboard_t *uh = window->uh;
+    size_t mapped;
+    if (window->springboard)
+    {
+        if (!map_springboard_offset(ctx->dis, uh, false, pc - uh->springboard, &mapped))
+            return false;
+
+        *ip = (const uint8_t *)uh->func_addr_final + mapped;
+    }
+    else
+    {
+        if (!map_springboard_offset(ctx->dis, uh, true, pc - (const uint8_t *)uh->func_addr_final, &mapped))
+            return false;
+
+        *ip = uh->springboard + mapped;
+    }
+
+    ++ctx->nb_fixups;
+    return true;
+}
+
+//--------------------------------------------------------------------------
+// Apply the patches with all the other threads suspended (\ref GNX_COMMIT_STOP_THREADS)
+static gnx_err_t stop_threads_and_patch(
+    gnx_workspace_t *ws,
+    gnx_live_patch_t *patches,
+    gnx_stw_window_t *windows,
+    size_t nb_patches)
+{
+    gnx_stw_ctx_t ctx;
+    ctx.ws = ws;
+    ctx.patches = patches;
+    ctx.nb_patches = nb_patches;
+    ctx.windows = windows;
+    ctx.nb_windows = 0;
+    ctx.nb_fixups = 0;
+
+    // Everything is ready before the threads are stopped
+    for (size_t i = 0; i < nb_patches; i++)
+    {
+        if (patches[i].size != 0)
+            windows[ctx.nb_windows++] = windows[i];
+    }
+
+    qsort(
+        windows,
+        ctx.nb_windows,
+        sizeof(gnx_stw_window_t),
+        compare_stw_windows);
+
+    // A suspended thread may be using the workspace disassembler, or hold the heap lock its creation needs
+    ctx.dis = acquire_disasm(ws);
+    if (ctx.dis == GNX_INVALID_HANDLE)
+        return GNX_ERR_DISASM;
+
+    uint64_t pause_ns;
+    gnx_err_t err = gnx_os_stop_threads(
+        stw_patch,
+        stw_fixup_ip,
+        &ctx,
+        &pause_ns);
+
+    release_disasm(ws, ctx.dis);
+
+    if (err == GNX_ERR_OK)
+    {
+        ws->stats.nb_ip_fixups += ctx.nb_fixups;
+        ws->stats.last_pause_us = pause_ns / 1000;
+        if (ws->stats.last_pause_us > ws->stats.max_pause_us)
+            ws->stats.max_pause_us = ws->stats.last_pause_us;
+    }
+    return err;
+}
+
+//--------------------------------------------------------------------------
+// Commit all the items at once while the other threads keep running (\ref GNX_COMMIT_LIVE)
+// or are suspended (\ref GNX_COMMIT_STOP_THREADS)
+// \return The count of committed items
+static size_t commit_items_batched(
+    gnx_workspace_t *ws,
+    gnx_transaction_t *trans,
+    gnx_err_t *err)
+{
+    size_t nb_items = 0;
+    for (gnx_singly_list_item_t *cur = trans->items.next; cur != NULL; cur = cur->next)
+        ++nb_items;
+
+    if (nb_items == 0)
+        return 0;
+
+    bool stop_threads = ws->commit_mode == GNX_COMMIT_STOP_THREADS;
+
+    gnx_live_patch_t *patches = (gnx_live_patch_t *)gnx_malloc(nb_items * sizeof(gnx_live_patch_t));
+    gnx_mem_flags_t *old_flags = (gnx_mem_flags_t *)gnx_malloc(nb_items * sizeof(gnx_mem_flags_t));
+    gnx_stw_window_t *windows = stop_threads ? (gnx_stw_window_t *)gnx_malloc(nb_items * sizeof(gnx_stw_window_t)) : NULL;
+    if (patches == NULL || old_flags == NULL || (stop_threads && windows == NULL))
+    {
+        gnx_mfree(patches);
+        gnx_mfree(old_flags);
+        gnx_mfree(windows);
+        *err = GNX_ERR_NO_MEM;
+        return 0;
+    }
+
+    // Describe the patches and make them writable
+    size_t i = 0;
+    for (gnx_singly_list_item_t *cur = trans->items.next; cur != NULL; cur = cur->next, i++)
+    {
+        gnx_transaction_item_t *item = GNX_SINGLY_LIST_RECORD(
+            cur,
+            gnx_transaction_item_t);
+
+        gnx_live_patch_t *patch = &patches[i];
+        patch->size = 0;
+
+        size_t size;
+        userhook_springboard_t *uh;
+        if (item->op_flags == GNX_TSXF_ADD)
+        {
+            // A jump to the hook
+            uh = item->op.add.uh;
+            patch->addr = item->op.add.func_addr;
+            patch->redirect = uh->slot != NULL ? uh->slot->target : item->op.add.hook_addr;
+            size = gen_hook_patch(
+                ws->dis,
+                item,
+                patch->code);
+        }
+        else if (item->op_flags == GNX_TSXF_DEL)
+        {
+            // The original bytes: meanwhile, the springboard still runs the original function
+            uh = item->op.remove.uh;
+            patch->addr = uh->func_addr_final;
+            patch->redirect = uh->springboard;
+            size = uh->backup_sz;
+            memcpy(
+                patch->code,
+                uh->backup,
+                size);
+        }
+        else if (item->op_flags == GNX_TSXF_HANDOVER)
+        {
+            // A jump to the first joined hook: a thread is never in the middle of the replaced jump
+            uh = item->op.remove.uh;
+            patch->addr = uh->func_addr_final;
+            patch->redirect = item->op.remove.hook_addr;
+            size = gen_hook_jump(
+                ws->dis,
+                patch->addr,
+                item->op.remove.hook_addr,
+                patch->code);
+
+            if (stop_threads)
+                windows[i].start = windows[i].end = NULL;
+        }
+        else
+        {
+            // Not a code patch (the import slots are written apart): an empty window
+            if (stop_threads)
+                windows[i].start = windows[i].end = NULL;
+            continue;
+        }
+
+        if (stop_threads && item->op_flags != GNX_TSXF_HANDOVER)
+        {
+            // Hooking: the threads past the first instruction of the prologue move to the springboard.
+            // Unhooking: the threads in the springboard move back to the function.
+            gnx_stw_window_t *window = &windows[i];
+            window->uh = uh;
+            window->springboard = item->op_flags == GNX_TSXF_DEL;
+            if (window->springboard)
+            {
+                window->start = uh->springboard;
+                window->end = uh->springboard + springboard_size(uh);
+            }
+            else
+            {
+                window->start = patch->addr + 1;
+                window->end = patch->addr + uh->backup_sz;
+            }
+        }
+
+        if (gnx_vmprotect(patch->addr, size, GNX_MEM_RWX, &old_flags[i]) == GNX_ERR_OK)
+            patch->size = size;
+    }
+
+    gnx_err_t patch_err = stop_threads
+        ? stop_threads_and_patch(ws, patches, windows, nb_items)
+        : gnx_live_patch_apply(patches, nb_items);
+
+    size_t nb_success = 0;
+    i = 0;
+    for (gnx_singly_list_item_t *cur = trans->items.next; cur != NULL; cur = cur->next, i++)
+    {
+        gnx_transaction_item_t *item = GNX_SINGLY_LIST_RECORD(
+            cur,
+            gnx_transaction_item_t);
+
+        if (    item->op_flags != GNX_TSXF_ADD 
+            &&  item->op_flags != GNX_TSXF_DEL 
+            &&  item->op_flags != GNX_TSXF_HANDOVER)
+        {
+            continue;
+        }
+
+        gnx_live_patch_t *patch = &patches[i];
+        if (patch->size == 0)
+        {
+            *err = GNX_ERR_FAILED;
+            continue;
+        }
+
+        // Restore the protection
+        gnx_vmprotect(
+            patch->addr,
+            patch->size,
+            old_flags[i],
+            NULL);
+
+        if (patch_err != GNX_ERR_OK)
+        {
+            *err = patch_err;
+            continue;
+        }
+
+        gnx_flush_instruction_cache(
+            NULL,
+            patch->addr,
+            patch->size);
+
+        if (item->op_flags == GNX_TSXF_DEL)
+        {
+            // Restore the original function address
+            *item->op.remove.psrc = item->op.remove.uh->func_addr;
+        }
+        else if (item->op_flags == GNX_TSXF_HANDOVER)
+        {
+            hand_over_patch(item);
+        }
+
+        item->committed = true;
+        ++nb_success;
+    }
+
+    gnx_mfree(patches);
+    gnx_mfree(old_flags);
+    gnx_mfree(windows);
+
+    return nb_success;
+}
+
+//--------------------------------------------------------------------------
+// Commit the items one at a time with plain writes
+// \return The count of committed items
+static size_t commit_items(
+    gnx_workspace_t *ws,
+    gnx_transaction_t *trans,
+    gnx_err_t *perr)
+{
+    size_t nb_success = 0;
+    gnx_err_t err = GNX_ERR_OK;
+
+    void *func_addr = NULL;
+    size_t prot_sz;
+    gnx_mem_flags_t old_flags;
+
+    gnx_singly_list_item_t *cur = trans->items.next;
+    while (cur != NULL)
+    {
+        // Get the current item
+        gnx_transaction_item_t *item = GNX_SINGLY_LIST_RECORD(
+            cur,
+            gnx_transaction_item_t);
+
+        // Commit / add
+        if (item->op_flags == GNX_TSXF_ADD)
+        {
+            func_addr = item->op.add.func_addr;
+            prot_sz = item->op.add.uh->backup_sz;
+        }
+        // Commit / remove
+        else if (item->op_flags == GNX_TSXF_DEL || item->op_flags == GNX_TSXF_HANDOVER)
+        {
+            func_addr = item->op.remove.uh->func_addr_final;
+            prot_sz = item->op.remove.uh->backup_sz;
+        }
+        else
+        {
+            // Invalid operation
+            prot_sz = 0;
+        }
+
+        if (prot_sz != 0) do 
+        {
+            // Change protection so that we can patch the original function
+            err = gnx_vmprotect(
+                func_addr,
+                prot_sz,
+                GNX_MEM_RWX,
+                &old_flags);
+
+            // Failed to change the protection?
+            if (err != GNX_ERR_OK)
+                break;
+
+            if (item->op_flags == GNX_TSXF_ADD)
+            {
+                // Replace the instruction with a jump to the hook
+                uint8_t code[GANXO_MAX_SPRINGBOARD_SIZE];
+                size_t code_sz = gen_hook_patch(
+                    ws->dis,
+                    item,
+                    code);
+
+                memcpy(
+                    func_addr,
+                    code,
+                    code_sz);
+            }
+            else if (item->op_flags == GNX_TSXF_DEL)
+            {
+                // Restore the original bytes
+                memcpy(
+                    func_addr,
+                    item->op.remove.uh->backup,
+                    prot_sz);
+
+                // Restore the original function address
+                *item->op.remove.psrc = item->op.remove.uh->func_addr;
+            }
+            else
+            {
+                // Replace the jump to the removed hook with a jump to the first joined hook
+                uint8_t code[GANXO_MAX_SPRINGBOARD_SIZE];
+                size_t code_sz = gen_hook_jump(
+                    ws->dis,
+                    func_addr,
+                    item->op.remove.hook_addr,
+                    code);
+
+                memcpy(
+                    func_addr,
+                    code,
+                    code_sz);
+
+                hand_over_patch(item);
+            }
+
+            // Restore the protection
+            err = gnx_vmprotect(
+                func_addr,
+                prot_sz,
+                old_flags,
+                NULL);
+
+            if (err != GNX_ERR_OK)
+                break;
+
+            // Flush instruction cache after the patch
+            err = gnx_flush_instruction_cache(
+                NULL,
+                func_addr,
+                prot_sz);
+            if (err != GNX_ERR_OK)
+                break;
+
+            item->committed = true;
+            ++nb_success;
+
+        } while (false);
+
+        if (err != GNX_ERR_OK)
+            *perr = err;
+
+        cur = cur->next;
+    }
+
+    return nb_success;
+}
+
+//--------------------------------------------------------------------------
+// Describe the index ranges of a committed item
+// \return The count of ranges (two per hook: the patched bytes and the springboard)
+static size_t get_item_ranges(
+    const gnx_transaction_item_t *item,
+    gnx_range_t *added,
+    const void **removed)
+{
+    if (!item->committed)
+        return 0;
+
+    if (item->op_flags == GNX_TSXF_ADD)
+    {
+        userhook_springboard_t *uh = item->op.add.uh;
+
+        added[0].start = uh->func_addr_final;
+        added[0].size = uh->backup_sz;
+        added[0].value = uh;
+
+        added[1].start = uh->springboard;
+        added[1].size = springboard_size(uh);
+        added[1].value = uh;
+        return 2;
+    }
+    
+    if (item->op_flags == GNX_TSXF_DEL)
+    {
+        removed[0] = item->op.remove.uh->func_addr_final;
+        removed[1] = item->op.remove.uh->springboard;
+        return 2;
+    }
+
+    return 0;
+}
+
+//--------------------------------------------------------------------------
+// Index the patches and springboards of the committed hooks, forget the removed ones.
+// All at once, or item by item when that fails (overlapping hooks added concurrently, or no memory)
+// so that only the faulty items are left out (\ref gnx_transaction_item_t::unindexed).
+static gnx_err_t update_hook_index(
+    gnx_workspace_t *ws,
+    gnx_transaction_t *trans)
+{
+    size_t nb_items = 0;
+    for (gnx_singly_list_item_t *cur = trans->items.next; cur != NULL; cur = cur->next)
+        ++nb_items;
+
+    if (nb_items == 0)
+        return GNX_ERR_OK;
+
+    gnx_err_t err = GNX_ERR_NO_MEM;
+    gnx_range_t *added = (gnx_range_t *)gnx_malloc(2 * nb_items * sizeof(gnx_range_t));
+    const void **removed = (const void **)gnx_malloc(2 * nb_items * sizeof(void *));
+    if (added != NULL && removed != NULL)
+    {
+        size_t nb_added = 0, nb_removed = 0;
+        for (gnx_singly_list_item_t *cur = trans->items.next; cur != NULL; cur = cur->next)
+        {
+            gnx_transaction_item_t *item = GNX_SINGLY_LIST_RECORD(
+                cur,
+                gnx_transaction_item_t);
+
+            if (item->op_flags == GNX_TSXF_ADD)
+                nb_added += get_item_ranges(item, &added[nb_added], NULL);
+            else
+                nb_removed += get_item_ranges(item, NULL, &removed[nb_removed]);
+        }
+
+        gnx_os_lock_acquire(&ws->lock);
+        err = gnx_range_map_update(
+            ws->hook_index,
+            added,
+            nb_added,
+            removed,
+            nb_removed);
+        gnx_os_lock_release(&ws->lock);
+    }
+
+    gnx_mfree(added);
+    gnx_mfree((void *)removed);
+
+    if (err == GNX_ERR_OK)
+        return GNX_ERR_OK;
+
+    // One item at a time: the removals first, so that they never depend on the additions
+    gnx_err_t first_err = err;
+    for (int pass = 0; pass < 2; pass++)
+    {
+        for (gnx_singly_list_item_t *cur = trans->items.next; cur != NULL; cur = cur->next)
+        {
+            gnx_transaction_item_t *item = GNX_SINGLY_LIST_RECORD(
+                cur,
+                gnx_transaction_item_t);
+
+            if ((item->op_flags == GNX_TSXF_DEL) != (pass == 0))
+                continue;
+
+            gnx_range_t item_added[2];
+            const void *item_removed[2];
+            size_t nb_ranges = get_item_ranges(item, item_added, item_removed);
+            if (nb_ranges == 0)
+                continue;
+
+            gnx_os_lock_acquire(&ws->lock);
+            err = gnx_range_map_update(
+                ws->hook_index,
+                item_added,
+                pass == 0 ? 0 : nb_ranges,
+                item_removed,
+                pass == 0 ? nb_ranges : 0);
+            gnx_os_lock_release(&ws->lock);
+
+            item->unindexed = err != GNX_ERR_OK;
+        }
+    }
+
+    return first_err;
+}
+
+//--------------------------------------------------------------------------
+// Fill the information of an indexed hook
+static void get_hook_info(
+    const gnx_range_t *range,
+    gnx_hook_info_t *info)
+{
+    const userhook_springboard_t *uh = (const userhook_springboard_t *)range->value;
+
+    info->in_springboard = range->start == uh->springboard;
+    info->func_addr = uh->func_addr_final;
+    info->patch_size = uh->backup_sz;
+    info->springboard = (void *)uh->springboard;
+    info->springboard_size = springboard_size(uh);
+    info->slot_hook = (gnx_handle_t)uh->slot;
+}
+
+//--------------------------------------------------------------------------
+bool GANXO_API gnx_hook_find_by_target(
+    gnx_handle_t handle,
+    const void *target,
+    gnx_hook_info_t *info)
+{
+    GET_WORKSPACE;
+
+    if (info == NULL || info->cb != sizeof(gnx_hook_info_t))
+        return false;
+
+    gnx_range_t range;
+    if (!gnx_range_map_find(ws->hook_index, target, &range))
+        return false;
+
+    get_hook_info(&range, info);
+
+    // Only the patched bytes
+    return !info->in_springboard;
+}
+
+//--------------------------------------------------------------------------
+bool GANXO_API gnx_hook_find_by_pc(
+    gnx_handle_t handle,
+    const void *pc,
+    gnx_hook_info_t *info)
+{
+    GET_WORKSPACE;
+
+    if (info == NULL || info->cb != sizeof(gnx_hook_info_t))
+        return false;
+
+    gnx_range_t range;
+    if (!gnx_range_map_find(ws->hook_index, pc, &range))
+        return false;
+
+    get_hook_info(&range, info);
+
+    return true;
+}
+
+//--------------------------------------------------------------------------
+static int __cdecl compare_import_slots(
+    const void *a,
+    const void *b)
+{
+    void **pa = (*(gnx_transaction_item_t * const *)a)->op.iat.slot;
+    void **pb = (*(gnx_transaction_item_t * const *)b)->op.iat.slot;
+
+    return pa < pb ? -1 : (pa > pb ? 1 : 0);
+}
+
+//--------------------------------------------------------------------------
+// Redirect the import slots of the transaction: data writes, one protection change per page
+// and no instruction cache flush
+static void commit_import_slots(
+    gnx_transaction_t *trans,
+    gnx_err_t *err)
+{
+    size_t nb_slots = 0;
+    for (gnx_singly_list_item_t *cur = trans->items.next; cur != NULL; cur = cur->next)
+    {
+        gnx_transaction_item_t *item = GNX_SINGLY_LIST_RECORD(
+            cur,
+            gnx_transaction_item_t);
+
+        if (item->op_flags == GNX_TSXF_IAT)
+            ++nb_slots;
+    }
+
+    if (nb_slots == 0)
+        return;
+
+    gnx_transaction_item_t **items = (gnx_transaction_item_t **)gnx_malloc(nb_slots * sizeof(gnx_transaction_item_t *));
+    if (items == NULL)
+    {
+        *err = GNX_ERR_NO_MEM;
+        return;
+    }
+
+    size_t i = 0;
+    for (gnx_singly_list_item_t *cur = trans->items.next; cur != NULL; cur = cur->next)
+    {
+        gnx_transaction_item_t *item = GNX_SINGLY_LIST_RECORD(
+            cur,
+            gnx_transaction_item_t);
+
+        if (item->op_flags == GNX_TSXF_IAT)
+            items[i++] = item;
+    }
+
+    qsort(
+        items,
+        nb_slots,
+        sizeof(gnx_transaction_item_t *),
+        compare_import_slots);
+
+    uintptr_t page_mask = ~((uintptr_t)gnx_os_page_size() - 1);
+    for (i = 0; i < nb_slots; )
+    {
+        uintptr_t page = (uintptr_t)items[i]->op.iat.slot & page_mask;
+
+        size_t i_end = i + 1;
+        while (i_end < nb_slots && ((uintptr_t)items[i_end]->op.iat.slot & page_mask) == page)
+            ++i_end;
+
+        // Still executable: the import table may share its page with code
+        gnx_mem_flags_t old_flags;
+        if (gnx_vmprotect((void *)page, ~page_mask + 1, GNX_MEM_RWX, &old_flags) == GNX_ERR_OK)
+        {
+            // The slots are aligned pointers: the calls see either the old or the new one
+            for (size_t k = i; k < i_end; k++)
+            {
+                gnx_atomic_xchg_ptr(
+                    items[k]->op.iat.slot,
+                    items[k]->op.iat.hook_addr);
+
+                items[k]->committed = true;
+            }
+
+            gnx_vmprotect(
+                (void *)page,
+                ~page_mask + 1,
+                old_flags,
+                NULL);
+        }
+        else
+        {
+            *err = GNX_ERR_FAILED;
+        }
+
+        i = i_end;
+    }
+
+    gnx_mfree(items);
+}
+
+//--------------------------------------------------------------------------
+// Outcome of a transaction from its items
+static gnx_err_t get_transaction_result(gnx_transaction_t *trans)
+{
+    size_t nb_items = 0, nb_committed = 0, nb_unindexed = 0;
+    for (gnx_singly_list_item_t *cur = trans->items.next; cur != NULL; cur = cur->next)
+    {
+        gnx_transaction_item_t *item = GNX_SINGLY_LIST_RECORD(
+            cur,
+            gnx_transaction_item_t);
+
+        ++nb_items;
+        if (item->committed)
+            ++nb_committed;
+        if (item->unindexed)
+            ++nb_unindexed;
+    }
+
+    // The unindexed hooks are installed, but cannot be found (nor removed)
+    if (nb_committed == nb_items && nb_unindexed == 0)
+        return GNX_ERR_OK;
+
+    return nb_committed == 0 ? GNX_ERR_FAILED : GNX_ERR_PARTIAL;
+}
+
+//--------------------------------------------------------------------------
+/// ADD item of a commit batch, with its position in the batch
+typedef struct __gnx_batch_add_t
+{
+    gnx_transaction_item_t *item;
+    size_t pos;
+} gnx_batch_add_t;
+
+//--------------------------------------------------------------------------
+static int __cdecl compare_batch_adds(
+    const void *a,
+    const void *b)
+{
+    const gnx_batch_add_t *pa = (const gnx_batch_add_t *)a;
+    const gnx_batch_add_t *pb = (const gnx_batch_add_t *)b;
+    const uint8_t *fa = (const uint8_t *)pa->item->op.add.uh->func_addr_final;
+    const uint8_t *fb = (const uint8_t *)pb->item->op.add.uh->func_addr_final;
+
+    if (fa != fb)
+        return fa < fb ? -1 : 1;
+
+    return pa->pos < pb->pos ? -1 : (pa->pos > pb->pos ? 1 : 0);
+}
+
+//--------------------------------------------------------------------------
+// Reject an ADD item before it is patched: the function pointer gets the original function back
+// and the springboard, never indexed, is retired (the callers may have called it since the add)
+static void reject_item(
+    gnx_workspace_t *ws,
+    gnx_transaction_item_t *item)
+{
+    userhook_springboard_t *uh = item->op.add.uh;
+
+    item->op_flags = GNX_TSXF_REJECTED;
+    if (*item->op.add.psrc == uh->springboard)
+        *item->op.add.psrc = uh->func_addr;
+
+    gnx_sb_retire(ws, uh);
+}
+
+//--------------------------------------------------------------------------
+// Under the commit lock, before patching: the hooks added to different transactions (or concurrently
+// to the same one) may patch the same bytes. The items overlapping an installed hook or an earlier
+// item of the batch are rejected, never patched.
+static void reject_overlapping_items(
+    gnx_workspace_t *ws,
+    gnx_transaction_t *trans,
+    gnx_err_t *err)
+{
+    size_t nb_adds = 0;
+    for (gnx_singly_list_item_t *cur = trans->items.next; cur != NULL; cur = cur->next)
+    {
+        gnx_transaction_item_t *item = GNX_SINGLY_LIST_RECORD(
+            cur,
+            gnx_transaction_item_t);
+
+        if (item->op_flags == GNX_TSXF_ADD)
+            ++nb_adds;
+    }
+
+    if (nb_adds == 0)
+        return;
+
+    // Without memory, nothing can be checked: no hook is added
+    gnx_batch_add_t *adds = (gnx_batch_add_t *)gnx_malloc(nb_adds * sizeof(gnx_batch_add_t));
+    size_t pos = 0, nb_sorted = 0;
+    for (gnx_singly_list_item_t *cur = trans->items.next; cur != NULL; cur = cur->next, pos++)
+    {
+        gnx_transaction_item_t *item = GNX_SINGLY_LIST_RECORD(
+            cur,
+            gnx_transaction_item_t);
+
+        if (item->op_flags != GNX_TSXF_ADD)
+            continue;
+
+        if (adds == NULL || hook_overlaps_index(ws, item->op.add.uh))
+        {
+            reject_item(ws, item);
+            *err = adds == NULL ? GNX_ERR_NO_MEM : GNX_ERR_INVALID_ARGS;
+            continue;
+        }
+
+        adds[nb_sorted].item = item;
+        adds[nb_sorted++].pos = pos;
+    }
+
+    if (adds == NULL)
+        return;
+
+    qsort(
+        adds,
+        nb_sorted,
+        sizeof(gnx_batch_add_t),
+        compare_batch_adds);
+
+    // Of two overlapping items, the later one in the batch is rejected
+    for (size_t i = 0; i < nb_sorted; i++)
+    {
+        const userhook_springboard_t *uh = adds[i].item->op.add.uh;
+        const uint8_t *end = (const uint8_t *)uh->func_addr_final + uh->backup_sz;
+
+        for (size_t j = i + 1; j < nb_sorted && (const uint8_t *)adds[j].item->op.add.uh->func_addr_final < end; j++)
+        {
+            gnx_transaction_item_t *later = adds[j].pos > adds[i].pos ? adds[j].item : adds[i].item;
+            if (later->op_flags == GNX_TSXF_ADD)
+            {
+                reject_item(ws, later);
+                *err = GNX_ERR_INVALID_ARGS;
+            }
+        }
+    }
+
+    gnx_mfree(adds);
+}
+
+//--------------------------------------------------------------------------
+// Tell whether a hook is still installed on a function (it may have been removed by a transaction
+// committed after the item was added)
+static bool is_hook_installed(
+    gnx_workspace_t *ws,
+    const userhook_springboard_t *uh,
+    const void *func_addr)
+{
+    gnx_range_t range;
+    return  gnx_range_map_find(ws->hook_index, func_addr, &range)
+        &&  range.start == func_addr
+        &&  range.value == uh;
+}
+
+//--------------------------------------------------------------------------
+// Link a joined hook at the end of the chain: the last hook now continues to it, and it continues
+// to the springboard. No code is touched.
+static void link_joined_hook(
+    gnx_workspace_t *ws,
+    gnx_transaction_item_t *item,
+    gnx_err_t *err)
+{
+    userhook_springboard_t *uh = item->op.join.uh;
+    gnx_hook_join_t *join = item->op.join.join;
+
+    if (!is_hook_installed(ws, uh, item->op.join.func_addr))
+    {
+        // The function pointer gets the original function back
+        *join->psrc = join->func_addr;
+        GNX_FREE(join);
+        item->op.join.join = NULL;
+        *err = GNX_ERR_FAILED;
+        return;
+    }
+
+    void **prev_psrc = uh->psrc;
+    gnx_hook_join_t **link = &uh->joins;
+    while (*link != NULL)
+    {
+        prev_psrc = (*link)->psrc;
+        link = &(*link)->next;
+    }
+
+    *join->psrc = uh->springboard;
+    *link = join;
+    gnx_atomic_xchg_ptr(prev_psrc, join->hook);
+
+    item->committed = true;
+}
+
+//--------------------------------------------------------------------------
+// Unlink a joined hook from its chain: the previous hook now continues where it did
+static void unlink_joined_hook(
+    gnx_workspace_t *ws,
+    gnx_transaction_item_t *item,
+    gnx_err_t *err)
+{
+    userhook_springboard_t *uh = item->op.join.uh;
+
+    // The joined hook may have been removed, or its function unhooked, by another transaction
+    void **prev_psrc = NULL;
+    gnx_hook_join_t **link = NULL;
+    if (is_hook_installed(ws, uh, item->op.join.func_addr))
+    {
+        prev_psrc = uh->psrc;
+        link = &uh->joins;
+        while (*link != NULL && *link != item->op.join.join)
+        {
+            prev_psrc = (*link)->psrc;
+            link = &(*link)->next;
+        }
+    }
+
+    if (link == NULL || *link == NULL)
+    {
+        *err = GNX_ERR_FAILED;
+        return;
+    }
+
+    gnx_hook_join_t *join = *link;
+    gnx_atomic_xchg_ptr(prev_psrc, *join->psrc);
+    *link = join->next;
+
+    // Restore the original function address
+    *join->psrc = join->func_addr;
+    GNX_FREE(join);
+
+    item->committed = true;
+}
+
+//--------------------------------------------------------------------------
+// Under the commit lock, before patching: the joined hooks are linked to their chain, then the
+// leaving ones are unlinked (no code is touched). Last, the removal of a hook that still has joined
+// hooks becomes a hand over: its patch is replaced by a jump to the first joined hook.
+static void update_hook_chains(
+    gnx_workspace_t *ws,
+    gnx_transaction_t *trans,
+    gnx_err_t *err)
+{
+    static const uint32_t passes[] = { GNX_TSXF_JOIN, GNX_TSXF_LEAVE, GNX_TSXF_DEL };
+
+    for (size_t pass = 0; pass < _countof(passes); pass++)
+    {
+        for (gnx_singly_list_item_t *cur = trans->items.next; cur != NULL; cur = cur->next)
+        {
+            gnx_transaction_item_t *item = GNX_SINGLY_LIST_RECORD(
+                cur,
+                gnx_transaction_item_t);
+
+            if (item->op_flags != passes[pass])
+                continue;
+
+            if (item->op_flags == GNX_TSXF_JOIN)
+            {
+                link_joined_hook(ws, item, err);
+            }
+            else if (item->op_flags == GNX_TSXF_LEAVE)
+            {
+                unlink_joined_hook(ws, item, err);
+            }
+            else if (item->op.remove.uh->joins != NULL)
+            {
+                item->op_flags = GNX_TSXF_HANDOVER;
+                item->op.remove.join = item->op.remove.uh->joins;
+                item->op.remove.hook_addr = item->op.remove.join->hook;
+            }
+        }
+    }
+}
+
+//--------------------------------------------------------------------------
+gnx_err_t gnx_transactions_apply(
+    gnx_workspace_t *ws,
+    const gnx_handle_t *transactions,
+    size_t nb_transactions,
+    gnx_err_t *errs)
+{
+    if (nb_transactions == 0)
+        return GNX_ERR_OK;
+
+    // Splice all the items in a single transaction, in the transactions order
+    gnx_transaction_t batch;
+    batch.gnx = (gnx_handle_t)ws;
+    gnx_singly_list_init(&batch.items);
+
+    gnx_singly_list_item_t **link = &batch.items.next;
+    for (size_t i = 0; i < nb_transactions; i++)
+    {
+        gnx_transaction_t *trans = (gnx_transaction_t *)transactions[i];
+        *link = trans->items.next;
+        while (*link != NULL)
+            link = &(*link)->next;
+    }
+
+    gnx_os_lock_acquire(&ws->commit_lock);
+
+    gnx_err_t err = GNX_ERR_OK;
+    reject_overlapping_items(ws, &batch, &err);
+    update_hook_chains(ws, &batch, &err);
+
+    if (ws->commit_mode == GNX_COMMIT_PLAIN)
+        commit_items(ws, &batch, &err);
+    else
+        commit_items_batched(ws, &batch, &err);
+
+    commit_import_slots(&batch, &err);
+
+    gnx_err_t index_err = update_hook_index(ws, &batch);
+    if (index_err != GNX_ERR_OK && err == GNX_ERR_OK)
+        err = index_err;
+
+    for (gnx_singly_list_item_t *cur = batch.items.next; cur != NULL; cur = cur->next)
+    {
+        gnx_transaction_item_t *item = GNX_SINGLY_LIST_RECORD(
+            cur,
+            gnx_transaction_item_t);
+
+        // The removed hooks springboards are not indexed anymore but other threads may still
+        // run them: they are freed once all the threads passed a quiescent point
+        // (a hook removed twice in the transaction is retired once, a springboard still indexed never is)
+        if (    item->committed 
+            &&  !item->unindexed
+            &&  item->op_flags == GNX_TSXF_DEL 
+            &&  !GNX_HAS_FLAG(item->op.remove.uh->flags, GNX_UHF_RETIRED))
+        {
+            userhook_springboard_t *uh = item->op.remove.uh;
+            if (uh->slot != NULL)
+                release_hook_chain(uh->slot);
+
+            gnx_sb_retire(ws, uh);
+        }
+    }
+
+    gnx_os_lock_release(&ws->commit_lock);
+
+    // Split the items back: each transaction's last item leads to the next non empty transaction
+    gnx_singly_list_item_t *next_head = NULL;
+    for (size_t i = nb_transactions; i-- > 0; )
+    {
+        gnx_transaction_t *trans = (gnx_transaction_t *)transactions[i];
+        if (trans->items.next == NULL)
+            continue;
+
+        if (next_head != NULL)
+        {
+            gnx_singly_list_item_t *cur = trans->items.next;
+            while (cur->next != next_head)
+                cur = cur->next;
+
+            cur->next = NULL;
+        }
+        next_head = trans->items.next;
+    }
+
+    for (size_t i = 0; i < nb_transactions; i++)
+        errs[i] = get_transaction_result((gnx_transaction_t *)transactions[i]);
+
+    // Free the retired springboards no thread may still run
+    gnx_sb_reclaim(ws);
+
+    // Lock back the blocks
+    close_springboards(ws, nb_transactions);
+
+    // For the monitors of the shared counters
+    gnx_counters_publish_stats(ws);
+
+    return err;
+}
+
+//--------------------------------------------------------------------------
+size_t gnx_transaction_release(
+    gnx_handle_t handle,
+    gnx_commit_result_t *results)
+{
+    GET_TRANS;
+
+    size_t nb_results = 0;
+    gnx_singly_list_item_t *cur = trans->items.next;
+    while (cur != NULL)
+    {
+        gnx_transaction_item_t *item = GNX_SINGLY_LIST_RECORD(
+            cur,
+            gnx_transaction_item_t);
+
+        cur = cur->next;
+
+        if (results != NULL)
+        {
+            gnx_commit_result_t *result = &results[nb_results];
+            result->remove =    item->op_flags == GNX_TSXF_DEL 
+                            ||  item->op_flags == GNX_TSXF_HANDOVER 
+                            ||  item->op_flags == GNX_TSXF_LEAVE;
+            if (item->op_flags == GNX_TSXF_IAT)
+                result->psrc = item->op.iat.porig;
+            else if (item->op_flags == GNX_TSXF_JOIN || item->op_flags == GNX_TSXF_LEAVE)
+                result->psrc = item->op.join.psrc;
+            else
+                result->psrc = result->remove ? item->op.remove.psrc : item->op.add.psrc;
+            if (item->committed)
+                result->err = GNX_ERR_OK;
+            else
+                result->err = item->op_flags == GNX_TSXF_REJECTED ? GNX_ERR_INVALID_ARGS : GNX_ERR_FAILED;
+        }
+        ++nb_results;
+
+        GNX_FREE(item);
+    }
+
+    // The transaction is now empty, free it
+    GNX_FREE(trans);
+
+    return nb_results;
+}
+
+//--------------------------------------------------------------------------
+size_t gnx_transaction_get_size(gnx_handle_t handle)
+{
+    GET_TRANS;
+
+    size_t nb_items = 0;
+    for (gnx_singly_list_item_t *cur = trans->items.next; cur != NULL; cur = cur->next)
+        ++nb_items;
+
+    return nb_items;
+}
+
+//--------------------------------------------------------------------------
+// Commit the hooks
+gnx_err_t GANXO_API gnx_transaction_commit(gnx_handle_t handle)
+{
+    GET_VARS;
+
+    gnx_err_t err;
+    gnx_transactions_apply(
+        ws,
+        &handle,
+        1,
+        &err);
+
+    gnx_transaction_release(
+        handle,
+        NULL);
+
+    return err;
+}
+
+//--------------------------------------------------------------------------
+gnx_err_t GANXO_API gnx_transaction_commit_async(
+    gnx_handle_t handle,
+    gnx_commit_callback_t callback,
+    void *ctx)
+{
+    GET_VARS;
+
+    // The transaction stays open (its springboards writable) until the committer thread is done with it
+    return gnx_committer_push(
+        ws,
+        handle,
+        callback,
+        ctx);
+}
+
+//--------------------------------------------------------------------------
+static int __cdecl compare_patched_addresses(
+    const void *a,
+    const void *b)
+{
+    const uint8_t *pa = (*(userhook_springboard_t * const *)a)->func_addr_final;
+    const uint8_t *pb = (*(userhook_springboard_t * const *)b)->func_addr_final;
+
+    return pa < pb ? -1 : (pa > pb ? 1 : 0);
+}
+
+//--------------------------------------------------------------------------
+// Collect the installed hooks of a springboards block: the indexed springboards
+// (not the retired ones nor the ones of an uncommitted transaction)
+// \param hooks NULL to count all the springboards (the most hooks there can be)
+// \return The count of hooks
+static size_t collect_installed_hooks(
+    gnx_workspace_t *ws,
+    gnx_handle_t block,
+    userhook_springboard_t **hooks)
+{
+    size_t nb_hooks = 0;
+
+    gnx_block_chunk_iterator_t iter;
+    void *chunk;
+    gnx_block_chunk_iter_begin(block, &iter);
+    while (gnx_block_chunk_iter_next(&iter, &chunk))
+    {
+        userhook_springboard_t *uh = (userhook_springboard_t *)chunk;
+        if (hooks == NULL)
+        {
+            ++nb_hooks;
+            continue;
+        }
+
+        gnx_range_t range;
+        if (    gnx_range_map_find(ws->hook_index, uh->springboard, &range)
+            &&  range.value == uh)
+        {
+            hooks[nb_hooks++] = uh;
+        }
+    }
+
+    return nb_hooks;
+}
+
+//--------------------------------------------------------------------------
+void gnx_drop_hooks(
+    gnx_workspace_t *ws,
+    void ** const *psrcs,
+    size_t nb_psrcs)
+{
+    if (nb_psrcs == 0 || open_springboards(ws) != GNX_ERR_OK)
+        return;
+
+    gnx_os_lock_acquire(&ws->commit_lock);
+
+    const void **removed = (const void **)gnx_malloc(2 * nb_psrcs * sizeof(void *));
+    if (removed != NULL)
+    {
+        size_t nb_removed = 0;
+        for (size_t i = 0; i < nb_psrcs; i++)
+        {
+            // A function pointer leading to an installed springboard, or to the next hook of a chain
+            gnx_range_t range;
+            void *springboard = *psrcs[i];
+            userhook_springboard_t *uh = NULL;
+            gnx_hook_join_t *join;
+            if (    gnx_range_map_find(ws->hook_index, springboard, &range) 
+                &&  range.start == springboard)
+            {
+                uh = (userhook_springboard_t *)range.value;
+            }
+
+            if (uh == NULL && !find_chained_hook(ws, psrcs[i], &uh, &join))
+                continue;
+
+            // All the hooks of the function are dropped with it, whichever function pointer comes first
+            *psrcs[i] = NULL;
+            if (GNX_HAS_FLAG(uh->flags, GNX_UHF_RETIRED))
+                continue;
+
+            removed[nb_removed++] = uh->func_addr_final;
+            removed[nb_removed++] = uh->springboard;
+
+            if (uh->slot != NULL)
+                release_hook_chain(uh->slot);
+
+            *uh->psrc = NULL;
+            release_hook_joins(uh, true);
+            gnx_sb_retire(ws, uh);
+        }
+
+        gnx_os_lock_acquire(&ws->lock);
+        gnx_range_map_update(
+            ws->hook_index,
+            NULL,
+            0,
+            removed,
+            nb_removed);
+        gnx_os_lock_release(&ws->lock);
+
+        gnx_mfree((void *)removed);
+    }
+
+    gnx_os_lock_release(&ws->commit_lock);
+
+    gnx_sb_reclaim(ws);
+    close_springboards(ws, 1);
+}
+
+//--------------------------------------------------------------------------
+gnx_err_t GANXO_API gnx_unhook_all(gnx_handle_t handle)
+{
+    GET_WORKSPACE;
+
+    if (open_springboards(ws) != GNX_ERR_OK)
+        return GNX_ERR_FAILED;
+
+    gnx_os_lock_acquire(&ws->commit_lock);
+
+    size_t nb_chunks = collect_installed_hooks(ws, ws->user_hooks, NULL) 
+                     + collect_installed_hooks(ws, ws->leaf_hooks, NULL);
+
+    userhook_springboard_t **hooks = (userhook_springboard_t **)gnx_malloc((nb_chunks + 1) * sizeof(userhook_springboard_t *));
+    bool *restored = (bool *)gnx_malloc((nb_chunks + 1) * sizeof(bool));
+    const void **removed = (const void **)gnx_malloc((2 * nb_chunks + 1) * sizeof(void *));
+
+    gnx_err_t err = GNX_ERR_OK;
+    size_t nb_hooks = 0, nb_restored = 0;
+    do
+    {
+        if (hooks == NULL || restored == NULL || removed == NULL)
+        {
+            err = GNX_ERR_NO_MEM;
+            break;
+        }
+
+        nb_hooks = collect_installed_hooks(ws, ws->user_hooks, hooks);
+        nb_hooks += collect_installed_hooks(ws, ws->leaf_hooks, hooks + nb_hooks);
+
+        qsort(
+            hooks,
+            nb_hooks,
+            sizeof(userhook_springboard_t *),
+            compare_patched_addresses);
+
+        // Restore the patches page by page: each group spans the pages of consecutive patches
+        // (a patch crossing a page boundary joins both pages)
+        uintptr_t page_mask = ~((uintptr_t)gnx_os_page_size() - 1);
+        for (size_t i = 0; i < nb_hooks; )
+        {
+            uint8_t *start = hooks[i]->func_addr_final;
+            uintptr_t first_page = (uintptr_t)start & page_mask;
+            uintptr_t end_page = ((uintptr_t)start + hooks[i]->backup_sz - 1 + ~page_mask) & page_mask;
+
+            size_t i_end = i + 1;
+            for (; i_end < nb_hooks && (uintptr_t)hooks[i_end]->func_addr_final < end_page; ++i_end)
+            {
+                uintptr_t patch_end = (uintptr_t)hooks[i_end]->func_addr_final + hooks[i_end]->backup_sz;
+                if (patch_end > end_page)
+                    end_page = (patch_end - 1 + ~page_mask) & page_mask;
+            }
+
+            gnx_mem_flags_t old_flags;
+            bool ok = gnx_vmprotect(
+                (void *)first_page,
+                end_page - first_page,
+                GNX_MEM_RWX,
+                &old_flags) == GNX_ERR_OK;
+
+            for (size_t k = i; k < i_end; ++k)
+            {
+                userhook_springboard_t *uh = hooks[k];
+                restored[k] = ok;
+                if (!ok)
+                    continue;
+
+                // Restore the original bytes
+                memcpy(
+                    uh->func_addr_final,
+                    uh->backup,
+                    uh->backup_sz);
+
+                ++nb_restored;
+            }
+
+            if (ok)
+            {
+                gnx_vmprotect(
+                    (void *)first_page,
+                    end_page - first_page,
+                    old_flags,
+                    NULL);
+
+                // Only the restored pages: a single range would span all the code between the groups
+                gnx_flush_instruction_cache(
+                    NULL,
+                    (void *)first_page,
+                    end_page - first_page);
+            }
+            else
+            {
+                err = GNX_ERR_FAILED;
+            }
+
+            i = i_end;
+        }
+
+        // Forget the unhooked functions
+        size_t nb_removed = 0;
+        for (size_t i = 0; i < nb_hooks; i++)
+        {
+            userhook_springboard_t *uh = hooks[i];
+            if (!restored[i])
+                continue;
+
+            removed[nb_removed++] = uh->func_addr_final;
+            removed[nb_removed++] = uh->springboard;
+
+            // Give the original function back to the caller, unless its pointer was changed meanwhile
+            void *next = uh->joins != NULL ? uh->joins->hook : uh->springboard;
+            if (*uh->psrc == next)
+                *uh->psrc = uh->func_addr;
+
+            if (uh->slot != NULL)
+                release_hook_chain(uh->slot);
+
+            release_hook_joins(uh, false);
+        }
+
+        gnx_os_lock_acquire(&ws->lock);
+        gnx_range_map_update(
+            ws->hook_index,
+            NULL,
+            0,
+            removed,
+            nb_removed);
+        gnx_os_lock_release(&ws->lock);
+
+        // The springboards may still be running: retire them like the unhooked ones of a transaction
+        for (size_t i = 0; i < nb_hooks; i++)
+        {
+            if (restored[i])
+                gnx_sb_retire(ws, hooks[i]);
+        }
+    } while (false);
+
+    gnx_mfree(hooks);
+    gnx_mfree(restored);
+    gnx_mfree((void *)removed);
+
+    gnx_os_lock_release(&ws->commit_lock);
+
+    if (err != GNX_ERR_OK && err != GNX_ERR_NO_MEM)
+        err = nb_restored == 0 ? GNX_ERR_FAILED : GNX_ERR_PARTIAL;
+
+    gnx_sb_reclaim(ws);
+    close_springboards(ws, 1);
+
+    return err;
+}
@@ -0,0 +1,192 @@
+#include "private.h"
+#include <stdlib.h>
+
+//--------------------------------------------------------------------------
+// Live patching: modify code that other threads may be executing.
+//
+// A patch that fits in an aligned qword is written with a single atomic 8 bytes store.
+// The other patches are staged with breakpoints (ala Linux's text_poke_bp):
+//   1. write an INT3 on the first byte of every patch, then serialize all the processors
+//   2. write the patches tails, then serialize
+//   3. write the patches first bytes, then serialize
+// Meanwhile, a thread hitting one of the breakpoints is redirected where the
+// complete patch would have sent it.
+//
+// \note Like any function entry patching, a thread that was already past the first instruction
+//       of a patched function is not accounted for (see \ref GNX_COMMIT_STOP_THREADS).
+//--------------------------------------------------------------------------
+
+#define GNX_INT3 0xCC
+
+/// Patches being staged (sorted by address)
+typedef struct __gnx_live_batch_t
+{
+    gnx_live_patch_t **patches;
+    size_t nb_patches;
+} gnx_live_batch_t;
+
+/// The staged batch, NULL when no patching is in progress
+static gnx_live_batch_t * volatile s_staged = NULL;
+
+/// Count of threads in the breakpoint handler: the staged batch is kept alive while it is not zero
+static volatile long s_nb_handlers = 0;
+
+/// Serializes the live patching of all the workspaces (the breakpoints handler is process wide)
+static gnx_os_lock_t s_lock;
+
+//--------------------------------------------------------------------------
+static int __cdecl compare_patches(
+    const void *a,
+    const void *b)
+{
+    const uint8_t *pa = (*(gnx_live_patch_t * const *)a)->addr;
+    const uint8_t *pb = (*(gnx_live_patch_t * const *)b)->addr;
+
+    return pa < pb ? -1 : (pa > pb ? 1 : 0);
+}
+
+//--------------------------------------------------------------------------
+static bool live_patch_bp_handler(
+    const void *addr,
+    const void **resume)
+{
+    bool handled = false;
+
+    gnx_atomic_fetch_add(&s_nb_handlers, 1);
+
+    gnx_live_batch_t *batch = s_staged;
+    if (batch != NULL)
+    {
+        gnx_live_patch_t key, *pkey = &key;
+        key.addr = (uint8_t *)addr;
+
+        gnx_live_patch_t **found = (gnx_live_patch_t **)bsearch(
+            &pkey,
+            batch->patches,
+            batch->nb_patches,
+            sizeof(gnx_live_patch_t *),
+            compare_patches);
+
+        if (found != NULL)
+        {
+            *resume = (*found)->redirect;
+            handled = true;
+        }
+    }
+
+    // Late breakpoint: the patching completed before this thread reached the handler
+    // (possibly while another batch is staged). The breakpoint is gone, simply execute
+    // the patched instruction.
+    if (!handled && *(const volatile uint8_t *)addr != GNX_INT3)
+    {
+        *resume = addr;
+        handled = true;
+    }
+
+    gnx_atomic_fetch_add(&s_nb_handlers, -1);
+
+    return handled;
+}
+
+//--------------------------------------------------------------------------
+static inline bool fits_atomic_store(const gnx_live_patch_t *patch)
+{
+    return ((uintptr_t)patch->addr & 7) + patch->size <= sizeof(int64_t);
+}
+
+//--------------------------------------------------------------------------
+// Write a patch that fits in an aligned qword with a single atomic store
+static void write_atomic_patch(gnx_live_patch_t *patch)
+{
+    volatile int64_t *qword = (volatile int64_t *)((uintptr_t)patch->addr & ~(uintptr_t)7);
+    size_t ofs = patch->addr - (uint8_t *)qword;
+
+    int64_t old_val, new_val;
+    do
+    {
+        old_val = *qword;
+        new_val = old_val;
+        memcpy((uint8_t *)&new_val + ofs, patch->code, patch->size);
+    } while (gnx_atomic_cas64(qword, new_val, old_val) != old_val);
+}
+
+//--------------------------------------------------------------------------
+void gnx_live_patch_init(void)
+{
+    gnx_os_lock_init(&s_lock);
+}
+
+//--------------------------------------------------------------------------
+gnx_err_t gnx_live_patch_apply(
+    gnx_live_patch_t *patches,
+    size_t nb_patches)
+{
+    // The patches that cannot be written atomically are staged
+    gnx_live_patch_t **staged = (gnx_live_patch_t **)gnx_malloc(nb_patches * sizeof(gnx_live_patch_t *));
+    if (staged == NULL)
+        return GNX_ERR_NO_MEM;
+
+    size_t nb_staged = 0;
+    for (size_t i = 0; i < nb_patches; i++)
+    {
+        gnx_live_patch_t *patch = &patches[i];
+        if (patch->size != 0 && !fits_atomic_store(patch))
+            staged[nb_staged++] = patch;
+    }
+
+    // Nothing is written unless all the patches can be
+    gnx_err_t err = GNX_ERR_OK;
+    if (nb_staged != 0)
+        err = gnx_os_bp_handler_install(live_patch_bp_handler);
+
+    if (err == GNX_ERR_OK)
+    {
+        for (size_t i = 0; i < nb_patches; i++)
+        {
+            gnx_live_patch_t *patch = &patches[i];
+            if (patch->size != 0 && fits_atomic_store(patch))
+                write_atomic_patch(patch);
+        }
+    }
+
+    if (err == GNX_ERR_OK && nb_staged != 0)
+    {
+        qsort(
+            staged,
+            nb_staged,
+            sizeof(gnx_live_patch_t *),
+            compare_patches);
+
+        gnx_live_batch_t batch;
+        batch.patches = staged;
+        batch.nb_patches = nb_staged;
+
+        gnx_os_lock_acquire(&s_lock);
+        gnx_atomic_xchg_ptr(&s_staged, &batch);
+
+        // 1. Breakpoints first
+        for (size_t i = 0; i < nb_staged; i++)
+            *(volatile uint8_t *)staged[i]->addr = GNX_INT3;
+        gnx_os_serialize_cpus();
+
+        // 2. The tails are never executed while the breakpoints are there
+        for (size_t i = 0; i < nb_staged; i++)
+            memcpy(staged[i]->addr + 1, staged[i]->code + 1, staged[i]->size - 1);
+        gnx_os_serialize_cpus();
+
+        // 3. Replace the breakpoints
+        for (size_t i = 0; i < nb_staged; i++)
+            *(volatile uint8_t *)staged[i]->addr = staged[i]->code[0];
+        gnx_os_serialize_cpus();
+
+        // Wait for the handlers still looking at the batch
+        gnx_atomic_xchg_ptr(&s_staged, NULL);
+        while (s_nb_handlers != 0)
+            gnx_os_yield();
+
+        gnx_os_lock_release(&s_lock);
+    }
+
+    gnx_mfree(staged);
+    return err;
+}
@@ -0,0 +1,11 @@
+#include "private.h"
+#include <stdlib.h>
+#include <stdio.h>
+
+//--------------------------------------------------------------------------
+// Operating system services
+//--------------------------------------------------------------------------
+
+#if defined(GANXO_PLATFORM_WINDOWS)
+    #include "win-os-impl.c"
+#endif
@@ -0,0 +1,333 @@
+#include "private.h"
+
+//--------------------------------------------------------------------------
+// Pending hooks: hooks of functions exported by modules that are not loaded yet.
+//
+// The workspace is notified of the modules loading and unloading. When a module with pending
+// hooks is loaded, all its hooks are resolved at once (\ref gnx_resolve_symbols) and installed in a
+// single transaction. When it is unloaded, its hooks are dropped: the code is gone, so their
+// springboards are simply retired and the hooks go back to pending.
+//
+// \note The notifications are received under the loader lock: the hooks are prepared on the
+//       notified thread (no bulk hooks workers) and the pending lock is never held while hooking.
+//--------------------------------------------------------------------------
+
+/// Pending hook (\ref gnx_add_pending_hooks)
+typedef struct __gnx_pending_hook_t
+{
+    char module[GNX_OS_MODULE_NAME_SIZE];
+    void **psrc;
+    void *hook;
+    bool applied;               ///< Installed, or being installed
+    GNX_SINGLY_LIST_ITEM_DEFINE;
+    char symbol[1];             ///< Exported function name (allocated with the structure)
+} gnx_pending_hook_t;
+
+//--------------------------------------------------------------------------
+// Name a module as the loader does: ".dll" is appended to a name without extension
+// (a trailing dot means no extension at all). The loaded modules are reported with their full base name.
+static bool normalize_module_name(
+    const char *name,
+    char *normalized,
+    size_t size)
+{
+    size_t len = strlen(name);
+    const char *ext = strrchr(name, '.');
+
+    if (ext != NULL && ext[1] == '\0')
+        --len;
+
+    const char *suffix = ext == NULL ? ".dll" : "";
+    if (len == 0 || len + strlen(suffix) >= size)
+        return false;
+
+    memcpy(normalized, name, len);
+    strcpy_s(normalized + len, size - len, suffix);
+    return true;
+}
+
+//--------------------------------------------------------------------------
+// Claim the hooks of a module that are (or are not) installed
+// \return The count of hooks, 'hooks' is allocated by the caller for all the pending hooks
+static size_t claim_module_hooks(
+    gnx_workspace_t *ws,
+    const char *module,
+    bool applied,
+    gnx_pending_hook_t **hooks)
+{
+    size_t nb_hooks = 0;
+    for (gnx_singly_list_item_t *cur = ws->pending.next; cur != NULL; cur = cur->next)
+    {
+        gnx_pending_hook_t *ph = GNX_SINGLY_LIST_RECORD(
+            cur,
+            gnx_pending_hook_t);
+
+        if (ph->applied != applied || _stricmp(ph->module, module) != 0)
+            continue;
+
+        ph->applied = !applied;
+        hooks[nb_hooks++] = ph;
+    }
+
+    return nb_hooks;
+}
+
+//--------------------------------------------------------------------------
+// Is a pending hook installed? (its function pointer leads to its springboard, or to the next
+// hook of the chain it joined when the function was already hooked)
+static bool is_installed(
+    gnx_workspace_t *ws,
+    const gnx_pending_hook_t *ph)
+{
+    gnx_hook_info_t info;
+    info.cb = sizeof(info);
+
+    if (    gnx_hook_find_by_pc((gnx_handle_t)ws, *ph->psrc, &info)
+        &&  info.in_springboard 
+        &&  info.springboard == *ph->psrc)
+    {
+        return true;
+    }
+
+    return gnx_hook_is_chained(ws, ph->psrc);
+}
+
+//--------------------------------------------------------------------------
+// Install the pending hooks of a loaded module in one transaction
+static gnx_err_t apply_module_hooks(
+    gnx_workspace_t *ws,
+    const char *module)
+{
+    gnx_os_lock_acquire(&ws->pending_lock);
+
+    size_t nb_pending = ws->nb_pending;
+    gnx_pending_hook_t **hooks = (gnx_pending_hook_t **)gnx_malloc((nb_pending + 1) * sizeof(gnx_pending_hook_t *));
+    const char **names = (const char **)gnx_malloc((nb_pending + 1) * sizeof(const char *));
+    void **addrs = (void **)gnx_malloc((nb_pending + 1) * sizeof(void *));
+
+    size_t nb_hooks = 0;
+    if (hooks != NULL && names != NULL && addrs != NULL)
+        nb_hooks = claim_module_hooks(ws, module, false, hooks);
+
+    gnx_os_lock_release(&ws->pending_lock);
+
+    gnx_err_t err = GNX_ERR_OK;
+    do
+    {
+        if (hooks == NULL || names == NULL || addrs == NULL)
+        {
+            err = GNX_ERR_NO_MEM;
+            break;
+        }
+
+        if (nb_hooks == 0)
+            break;
+
+        for (size_t i = 0; i < nb_hooks; i++)
+            names[i] = hooks[i]->symbol;
+
+        gnx_resolve_symbols(
+            module,
+            names,
+            nb_hooks,
+            addrs,
+            NULL);
+
+        gnx_handle_t transaction;
+        err = gnx_transaction_begin(
+            (gnx_handle_t)ws,
+            &transaction);
+        if (err != GNX_ERR_OK)
+            break;
+
+        for (size_t i = 0; i < nb_hooks; i++)
+        {
+            gnx_pending_hook_t *ph = hooks[i];
+            if (addrs[i] == NULL)
+                continue;
+
+            // A hook that cannot be added stays pending: its pointer must not hold the unhooked address
+            void *prev = *ph->psrc;
+            *ph->psrc = addrs[i];
+            if (gnx_transaction_add_hook(transaction, ph->psrc, ph->hook) != GNX_ERR_OK)
+            {
+                *ph->psrc = prev;
+                addrs[i] = NULL;
+            }
+        }
+
+        err = gnx_transaction_commit(transaction);
+    } while (false);
+
+    // The hooks that could not be installed stay pending
+    gnx_os_lock_acquire(&ws->pending_lock);
+    for (size_t i = 0; i < nb_hooks; i++)
+    {
+        if (addrs[i] == NULL || !is_installed(ws, hooks[i]))
+            hooks[i]->applied = false;
+    }
+    gnx_os_lock_release(&ws->pending_lock);
+
+    gnx_mfree(hooks);
+    gnx_mfree((void *)names);
+    gnx_mfree(addrs);
+
+    return err;
+}
+
+//--------------------------------------------------------------------------
+// Drop the hooks of an unloaded module
+static void drop_module_hooks(
+    gnx_workspace_t *ws,
+    const char *module)
+{
+    gnx_os_lock_acquire(&ws->pending_lock);
+
+    gnx_pending_hook_t **hooks = (gnx_pending_hook_t **)gnx_malloc((ws->nb_pending + 1) * sizeof(gnx_pending_hook_t *));
+    void ***psrcs = (void ***)gnx_malloc((ws->nb_pending + 1) * sizeof(void **));
+
+    size_t nb_hooks = 0;
+    if (hooks != NULL && psrcs != NULL)
+        nb_hooks = claim_module_hooks(ws, module, true, hooks);
+
+    gnx_os_lock_release(&ws->pending_lock);
+
+    for (size_t i = 0; i < nb_hooks; i++)
+        psrcs[i] = hooks[i]->psrc;
+
+    gnx_drop_hooks(
+        ws,
+        psrcs,
+        nb_hooks);
+
+    gnx_mfree(hooks);
+    gnx_mfree(psrcs);
+}
+
+//--------------------------------------------------------------------------
+static void on_module_event(
+    void *ctx,
+    bool loaded,
+    const gnx_os_module_t *mod)
+{
+    gnx_workspace_t *ws = (gnx_workspace_t *)ctx;
+
+    if (loaded)
+        apply_module_hooks(ws, mod->name);
+    else
+        drop_module_hooks(ws, mod->name);
+}
+
+//--------------------------------------------------------------------------
+void gnx_pending_hooks_free(gnx_workspace_t *ws)
+{
+    if (ws->module_events != NULL)
+    {
+        gnx_os_module_events_unregister(ws->module_events);
+        ws->module_events = NULL;
+    }
+
+    while (ws->pending.next != NULL)
+    {
+        gnx_pending_hook_t *ph = GNX_SINGLY_LIST_ITEM_POP(
+            &ws->pending,
+            gnx_pending_hook_t);
+
+        gnx_mfree(ph);
+    }
+    ws->nb_pending = 0;
+}
+
+//--------------------------------------------------------------------------
+gnx_err_t GANXO_API gnx_add_pending_hooks(
+    gnx_handle_t handle,
+    const gnx_pending_hook_desc_t *descs,
+    size_t nb_descs)
+{
+    GET_WORKSPACE;
+
+    char module[GNX_OS_MODULE_NAME_SIZE];
+    for (size_t i = 0; i < nb_descs; i++)
+    {
+        const gnx_pending_hook_desc_t *desc = &descs[i];
+        if (    desc->module == NULL 
+            ||  !normalize_module_name(desc->module, module, sizeof(module))
+            ||  desc->symbol == NULL 
+            ||  desc->psrc == NULL 
+            ||  desc->hook == NULL)
+        {
+            return GNX_ERR_INVALID_ARGS;
+        }
+    }
+
+    // Registering may take the loader lock: never while holding the pending lock
+    if (ws->module_events == NULL)
+    {
+        void *events = gnx_os_module_events_register(
+            on_module_event, 
+            ws);
+        if (events == NULL)
+            return GNX_ERR_FAILED;
+
+        if (gnx_atomic_cas_ptr(&ws->module_events, events, NULL) != NULL)
+            gnx_os_module_events_unregister(events);
+    }
+
+    gnx_os_lock_acquire(&ws->pending_lock);
+
+    gnx_err_t err = GNX_ERR_OK;
+    size_t nb_added = 0;
+    for (; err == GNX_ERR_OK && nb_added < nb_descs; nb_added++)
+    {
+        const gnx_pending_hook_desc_t *desc = &descs[nb_added];
+
+        size_t symbol_len = strlen(desc->symbol);
+        gnx_pending_hook_t *ph = (gnx_pending_hook_t *)gnx_malloc(sizeof(gnx_pending_hook_t) + symbol_len);
+        if (ph == NULL)
+        {
+            err = GNX_ERR_NO_MEM;
+            break;
+        }
+
+        normalize_module_name(desc->module, ph->module, sizeof(ph->module));
+        memcpy(ph->symbol, desc->symbol, symbol_len + 1);
+        ph->psrc = desc->psrc;
+        ph->hook = desc->hook;
+        ph->applied = false;
+
+        GNX_SINGLY_LIST_ITEM_PUSH(
+            &ws->pending,
+            ph);
+        ++ws->nb_pending;
+    }
+
+    gnx_os_lock_release(&ws->pending_lock);
+
+    if (err != GNX_ERR_OK)
+        return nb_added == 0 ? err : GNX_ERR_PARTIAL;
+
+    // The modules already loaded are hooked right away, one transaction per module
+    char prev_module[GNX_OS_MODULE_NAME_SIZE] = "";
+    for (size_t i = 0; i < nb_descs; i++)
+    {
+        // Usually grouped by module
+        normalize_module_name(descs[i].module, module, sizeof(module));
+        if (_stricmp(module, prev_module) == 0)
+            continue;
+
+        strcpy_s(prev_module, sizeof(prev_module), module);
+
+        gnx_os_module_t mod;
+        if (gnx_os_module_from_name(module, &mod))
+        {
+            gnx_err_t module_err = apply_module_hooks(
+                ws, 
+                module);
+
+            if (module_err != GNX_ERR_OK)
+                err = module_err;
+        }
+    }
+
+    return err;
+}
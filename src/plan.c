@@ -0,0 +1,453 @@
+#include "private.h"
+
+#include <stdlib.h>
+
+//--------------------------------------------------------------------------
+// Hook plan file format
+//
+//  gnx_plan_header_t
+//  gnx_plan_module_t   modules[nb_modules]
+//  gnx_plan_template_t templates[nb_templates]
+//  gnx_plan_entry_t    entries[nb_entries]   (sorted by source module and offset)
+//
+// The file is only meant to be read back by the same Ganxo build on the same architecture.
+//--------------------------------------------------------------------------
+
+#define GNX_PLAN_MAGIC      0x504E5847 // 'GXNP'
+#define GNX_PLAN_VERSION    1
+
+/// Maximum number of modules in a plan
+#define GNX_PLAN_MAX_MODULES 1024
+
+/// Plan file header
+typedef struct __gnx_plan_header_t
+{
+    uint32_t magic;
+    uint32_t version;
+    uint32_t ptr_size;          ///< sizeof(void *) of the writer
+    uint32_t module_sz;         ///< sizeof(gnx_plan_module_t)
+    uint32_t template_sz;       ///< sizeof(gnx_plan_template_t)
+    uint32_t entry_sz;          ///< sizeof(gnx_plan_entry_t)
+    uint32_t nb_modules;
+    uint32_t nb_templates;
+    uint32_t nb_entries;
+} gnx_plan_header_t;
+
+/// Planned module
+typedef struct __gnx_plan_module_t
+{
+    uint8_t id[GNX_OS_MODULE_ID_SIZE];
+    char name[GNX_OS_MODULE_NAME_SIZE];
+} gnx_plan_module_t;
+
+/// Planned springboard template (shared by all the functions starting with the same bytes)
+typedef struct __gnx_plan_template_t
+{
+    uint8_t prologue[GANXO_MAX_SPRINGBOARD_SIZE]; ///< The first tpl.backup_sz bytes of the function
+    gnx_sb_template_t tpl;
+} gnx_plan_template_t;
+
+/// Planned hook
+typedef struct __gnx_plan_entry_t
+{
+    uint16_t src_module;        ///< Module of the function address as passed to gnx_transaction_add_hook
+    uint16_t final_module;      ///< Module of the function once all the jumps are skipped
+    uint32_t src_rva;
+    uint32_t final_rva;
+    uint32_t tpl_index;
+} gnx_plan_entry_t;
+
+/// Mapped plan
+struct __gnx_plan_t
+{
+    const void *view;
+    const gnx_plan_header_t *hdr;
+    const gnx_plan_module_t *modules;
+    const gnx_plan_template_t *templates;
+    const gnx_plan_entry_t *entries;
+    gnx_os_module_t *loaded;    ///< The plan modules currently loaded with a matching build id (NULL base otherwise)
+};
+
+//--------------------------------------------------------------------------
+static int compare_entries(
+    const void *a,
+    const void *b)
+{
+    const gnx_plan_entry_t *e1 = (const gnx_plan_entry_t *)a, *e2 = (const gnx_plan_entry_t *)b;
+    if (e1->src_module != e2->src_module)
+        return e1->src_module < e2->src_module ? -1 : 1;
+
+    if (e1->src_rva != e2->src_rva)
+        return e1->src_rva < e2->src_rva ? -1 : 1;
+
+    return 0;
+}
+
+//--------------------------------------------------------------------------
+static int compare_template_ptrs(
+    const void *a,
+    const void *b)
+{
+    return memcmp(
+        *(const gnx_plan_template_t **)a,
+        *(const gnx_plan_template_t **)b,
+        sizeof(gnx_plan_template_t));
+}
+
+//--------------------------------------------------------------------------
+// Find or add a module to the plan being exported
+static bool add_export_module(
+    const void *addr,
+    gnx_os_module_t *modules,
+    uint32_t *nb_modules,
+    uint16_t *index,
+    uint32_t *rva)
+{
+    for (uint32_t i = 0; i < *nb_modules; i++)
+    {
+        if ((const uint8_t *)addr >= modules[i].base && (const uint8_t *)addr < modules[i].base + modules[i].size)
+        {
+            *index = (uint16_t)i;
+            *rva = (uint32_t)((const uint8_t *)addr - modules[i].base);
+            return true;
+        }
+    }
+
+    if (*nb_modules >= GNX_PLAN_MAX_MODULES || !gnx_os_module_from_address(addr, &modules[*nb_modules]))
+        return false;
+
+    *index = (uint16_t)*nb_modules;
+    *rva = (uint32_t)((const uint8_t *)addr - modules[*nb_modules].base);
+    ++*nb_modules;
+    return true;
+}
+
+//--------------------------------------------------------------------------
+// Plan record from a template (padding zeroed so that identical templates compare equal)
+static void make_plan_template(
+    const gnx_sb_template_t *tpl,
+    const void *prologue,
+    gnx_plan_template_t *ptpl)
+{
+    memset(ptpl, 0, sizeof(*ptpl));
+    memcpy(ptpl->prologue, prologue, tpl->backup_sz);
+    memcpy(ptpl->tpl.code, tpl->code, tpl->code_sz);
+    ptpl->tpl.code_sz = tpl->code_sz;
+    ptpl->tpl.backup_sz = tpl->backup_sz;
+    ptpl->tpl.nb_fixups = tpl->nb_fixups;
+    for (uint8_t i = 0; i < tpl->nb_fixups; i++)
+    {
+        ptpl->tpl.fixups[i].rel_ofs = tpl->fixups[i].rel_ofs;
+        ptpl->tpl.fixups[i].target_delta = tpl->fixups[i].target_delta;
+    }
+}
+
+//--------------------------------------------------------------------------
+gnx_err_t GANXO_API gnx_plan_export(
+    gnx_handle_t handle,
+    const char *path)
+{
+    GET_WORKSPACE;
+
+    // The installed hooks are the indexed ones, not the retired nor the uncommitted springboards
+    gnx_os_lock_acquire(&ws->lock);
+    size_t nb_ranges = gnx_range_map_copy(ws->hook_index, NULL, 0);
+    gnx_range_t *ranges = gnx_malloc(sizeof(gnx_range_t) * (nb_ranges + 1));
+    if (ranges != NULL)
+        gnx_range_map_copy(ws->hook_index, ranges, nb_ranges);
+    gnx_os_lock_release(&ws->lock);
+
+    // Two ranges per hook: the patched bytes and the springboard
+    size_t nb_hooks = nb_ranges / 2;
+
+    gnx_os_module_t *modules = gnx_malloc(sizeof(gnx_os_module_t) * GNX_PLAN_MAX_MODULES);
+    gnx_plan_template_t *templates = gnx_malloc(sizeof(gnx_plan_template_t) * (nb_hooks + 1));
+    const gnx_plan_template_t **sorted = gnx_malloc(sizeof(gnx_plan_template_t *) * (nb_hooks + 1));
+    uint32_t *remap = gnx_malloc(sizeof(uint32_t) * (nb_hooks + 1));
+    gnx_plan_entry_t *entries = gnx_malloc(sizeof(gnx_plan_entry_t) * (nb_hooks + 1));
+    void *file = NULL;
+
+    gnx_err_t err = GNX_ERR_NO_MEM;
+    do
+    {
+        if (ranges == NULL || modules == NULL || templates == NULL || sorted == NULL || remap == NULL || entries == NULL)
+            break;
+
+        //
+        // Describe every regular springboard (leaf springboards depend on the whole function and are not planned)
+        //
+        uint32_t nb_modules = 0, nb_entries = 0;
+        for (size_t i = 0; i < nb_ranges; i++)
+        {
+            // Each hook once, from its springboard range
+            const userhook_springboard_t *uh = (const userhook_springboard_t *)ranges[i].value;
+            if (ranges[i].start != uh->springboard || GNX_HAS_FLAG(uh->flags, GNX_UHF_LEAF))
+                continue;
+
+            gnx_plan_entry_t *entry = &entries[nb_entries];
+
+            if (    !add_export_module(uh->func_addr, modules, &nb_modules, &entry->src_module, &entry->src_rva)
+                ||  !add_export_module(uh->func_addr_final, modules, &nb_modules, &entry->final_module, &entry->final_rva))
+            {
+                continue;
+            }
+
+            // The template only depends on the backed up bytes
+            gnx_sb_template_t tpl;
+            size_t patch_size = uh->slot != NULL ? GANXO_JUMP_TO_SLOT_SIZE : GANXO_JUMP_TO_SPRINGBOARD_SIZE;
+            if (gnx_sb_template_get(ws, uh->backup, patch_size, &tpl) != GNX_ERR_OK || tpl.backup_sz != uh->backup_sz)
+                continue;
+
+            make_plan_template(&tpl, uh->backup, &templates[nb_entries]);
+            sorted[nb_entries] = &templates[nb_entries];
+            entry->tpl_index = nb_entries;
+            ++nb_entries;
+        }
+
+        //
+        // Share identical templates
+        //
+        qsort((void *)sorted, nb_entries, sizeof(*sorted), compare_template_ptrs);
+
+        uint32_t nb_templates = 0;
+        for (uint32_t i = 0; i < nb_entries; i++)
+        {
+            if (i == 0 || compare_template_ptrs(&sorted[i - 1], &sorted[i]) != 0)
+                ++nb_templates;
+
+            remap[sorted[i] - templates] = nb_templates - 1;
+        }
+
+        for (uint32_t i = 0; i < nb_entries; i++)
+            entries[i].tpl_index = remap[entries[i].tpl_index];
+
+        qsort(entries, nb_entries, sizeof(*entries), compare_entries);
+
+        //
+        // Write the plan
+        //
+        file = gnx_os_file_create(path);
+        if (file == NULL)
+        {
+            err = GNX_ERR_FAILED;
+            break;
+        }
+
+        gnx_plan_header_t hdr;
+        hdr.magic = GNX_PLAN_MAGIC;
+        hdr.version = GNX_PLAN_VERSION;
+        hdr.ptr_size = sizeof(void *);
+        hdr.module_sz = sizeof(gnx_plan_module_t);
+        hdr.template_sz = sizeof(gnx_plan_template_t);
+        hdr.entry_sz = sizeof(gnx_plan_entry_t);
+        hdr.nb_modules = nb_modules;
+        hdr.nb_templates = nb_templates;
+        hdr.nb_entries = nb_entries;
+
+        err = gnx_os_file_write(file, &hdr, sizeof(hdr));
+
+        for (uint32_t i = 0; i < nb_modules && err == GNX_ERR_OK; i++)
+        {
+            gnx_plan_module_t pmod;
+            memset(&pmod, 0, sizeof(pmod));
+            memcpy(pmod.id, modules[i].id, sizeof(pmod.id));
+            memcpy(pmod.name, modules[i].name, sizeof(pmod.name));
+
+            err = gnx_os_file_write(file, &pmod, sizeof(pmod));
+        }
+
+        for (uint32_t i = 0; i < nb_entries && err == GNX_ERR_OK; i++)
+        {
+            if (i == 0 || compare_template_ptrs(&sorted[i - 1], &sorted[i]) != 0)
+                err = gnx_os_file_write(file, sorted[i], sizeof(gnx_plan_template_t));
+        }
+
+        if (err == GNX_ERR_OK)
+            err = gnx_os_file_write(file, entries, sizeof(gnx_plan_entry_t) * nb_entries);
+    } while (false);
+
+    if (file != NULL)
+        gnx_os_file_close(file);
+
+    gnx_mfree(ranges);
+    gnx_mfree(modules);
+    gnx_mfree(templates);
+    gnx_mfree((void *)sorted);
+    gnx_mfree(remap);
+    gnx_mfree(entries);
+
+    return err;
+}
+
+//--------------------------------------------------------------------------
+void gnx_plan_free(gnx_plan_t *plan)
+{
+    gnx_os_unmap_file(plan->view);
+    gnx_mfree(plan->loaded);
+    GNX_FREE(plan);
+}
+
+//--------------------------------------------------------------------------
+void GANXO_API gnx_plan_unload(gnx_handle_t handle)
+{
+    GET_WORKSPACE;
+    if (ws->plan != NULL)
+    {
+        gnx_plan_free(ws->plan);
+        ws->plan = NULL;
+    }
+}
+
+//--------------------------------------------------------------------------
+gnx_err_t GANXO_API gnx_plan_load(
+    gnx_handle_t handle,
+    const char *path)
+{
+    GET_WORKSPACE;
+
+    const void *view;
+    size_t size;
+    gnx_err_t err = gnx_os_map_file(path, &view, &size);
+    if (err != GNX_ERR_OK)
+        return err;
+
+    gnx_plan_t *plan = NULL;
+    do
+    {
+        //
+        // Validate the plan
+        //
+        err = GNX_ERR_INVALID_ARGS;
+
+        const gnx_plan_header_t *hdr = (const gnx_plan_header_t *)view;
+        if (    size < sizeof(*hdr)
+            ||  hdr->magic != GNX_PLAN_MAGIC
+            ||  hdr->version != GNX_PLAN_VERSION
+            ||  hdr->ptr_size != sizeof(void *)
+            ||  hdr->module_sz != sizeof(gnx_plan_module_t)
+            ||  hdr->template_sz != sizeof(gnx_plan_template_t)
+            ||  hdr->entry_sz != sizeof(gnx_plan_entry_t)
+            ||  hdr->nb_modules > GNX_PLAN_MAX_MODULES)
+        {
+            break;
+        }
+
+        uint64_t expected_sz = sizeof(*hdr) 
+            + (uint64_t)hdr->nb_modules * sizeof(gnx_plan_module_t)
+            + (uint64_t)hdr->nb_templates * sizeof(gnx_plan_template_t)
+            + (uint64_t)hdr->nb_entries * sizeof(gnx_plan_entry_t);
+        if (expected_sz != size)
+            break;
+
+        const gnx_plan_entry_t *entries = (const gnx_plan_entry_t *)((const uint8_t *)view + size) - hdr->nb_entries;
+        uint32_t i_entry;
+        for (i_entry = 0; i_entry < hdr->nb_entries; i_entry++)
+        {
+            if (    entries[i_entry].src_module >= hdr->nb_modules 
+                ||  entries[i_entry].final_module >= hdr->nb_modules 
+                ||  entries[i_entry].tpl_index >= hdr->nb_templates)
+            {
+                break;
+            }
+        }
+        if (i_entry != hdr->nb_entries)
+            break;
+
+        err = GNX_ERR_NO_MEM;
+        plan = GNX_ALLOC(gnx_plan_t);
+        if (plan == NULL)
+            break;
+
+        plan->view = view;
+        plan->hdr = hdr;
+        plan->modules = (const gnx_plan_module_t *)(hdr + 1);
+        plan->templates = (const gnx_plan_template_t *)(plan->modules + hdr->nb_modules);
+        plan->entries = entries;
+        plan->loaded = gnx_malloc(sizeof(gnx_os_module_t) * (hdr->nb_modules + 1));
+        if (plan->loaded == NULL)
+            break;
+
+        // Only trust the modules that are loaded and were not rebuilt
+        for (uint32_t i = 0; i < hdr->nb_modules; i++)
+        {
+            gnx_os_module_t *mod = &plan->loaded[i];
+            char name[GNX_OS_MODULE_NAME_SIZE];
+            memcpy(name, plan->modules[i].name, sizeof(name));
+            name[sizeof(name) - 1] = '\0';
+
+            if (    !gnx_os_module_from_name(name, mod)
+                ||  memcmp(mod->id, plan->modules[i].id, sizeof(mod->id)) != 0)
+            {
+                mod->base = NULL;
+                mod->size = 0;
+            }
+        }
+
+        // Replace the previous plan
+        if (ws->plan != NULL)
+            gnx_plan_free(ws->plan);
+
+        ws->plan = plan;
+
+        return GNX_ERR_OK;
+    } while (false);
+
+    if (plan != NULL)
+    {
+        gnx_mfree(plan->loaded);
+        GNX_FREE(plan);
+    }
+
+    gnx_os_unmap_file(view);
+    return err;
+}
+
+//--------------------------------------------------------------------------
+const gnx_sb_template_t *gnx_plan_lookup(
+    gnx_plan_t *plan,
+    gnx_handle_t dis,
+    const void *src,
+    void **final)
+{
+    const gnx_plan_header_t *hdr = plan->hdr;
+
+    // Find the module
+    gnx_plan_entry_t key;
+    for (key.src_module = 0; key.src_module < hdr->nb_modules; key.src_module++)
+    {
+        const gnx_os_module_t *mod = &plan->loaded[key.src_module];
+        if (mod->base != NULL && (const uint8_t *)src >= mod->base && (const uint8_t *)src < mod->base + mod->size)
+            break;
+    }
+    if (key.src_module == hdr->nb_modules)
+        return NULL;
+
+    key.src_rva = (uint32_t)((const uint8_t *)src - plan->loaded[key.src_module].base);
+
+    // Find the entry
+    const gnx_plan_entry_t *entry = bsearch(
+        &key, 
+        plan->entries, 
+        hdr->nb_entries, 
+        sizeof(gnx_plan_entry_t), 
+        compare_entries);
+    if (entry == NULL)
+        return NULL;
+
+    const gnx_os_module_t *final_mod = &plan->loaded[entry->final_module];
+    if (final_mod->base == NULL || entry->final_rva >= final_mod->size)
+        return NULL;
+
+    // The function bytes must not have changed (ex: already hooked)
+    const gnx_plan_template_t *ptpl = &plan->templates[entry->tpl_index];
+    const uint8_t *func = final_mod->base + entry->final_rva;
+    if (memcmp(func, ptpl->prologue, ptpl->tpl.backup_sz) != 0)
+        return NULL;
+
+    // The jumps from src must still lead to the planned function (ex: a retargeted import thunk)
+    if ((const void *)func != src && gnx_disasm_skip_jumps(dis, src) != (const void *)func)
+        return NULL;
+
+    *final = (void *)func;
+    return &ptpl->tpl;
+}
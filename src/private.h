@@ -1,122 +1,1094 @@
-#ifndef __GANXO_PRIVATE_INC__
-#define __GANXO_PRIVATE_INC__
-
-#include <string.h>
-
-#ifdef _MSC_VER
-    #pragma warning(push)
-    #pragma warning(disable: 4820)
-    #include <capstone.h>
-    #pragma warning(pop)
-#endif
-
-#include <ganxo.h>
-
-//--------------------------------------------------------------------------
-// Disasm structures and macros
-//--------------------------------------------------------------------------
-#if defined(GANXO_ARCH_X86)
-	#define GNX_CS_ARCH CS_ARCH_X86
-	#define GNX_CS_MODE CS_MODE_32
-
-	// E9 xx xx xx xx ; jmp rel32
-	#define GANXO_JUMP_TO_SPRINGBOARD_SIZE 5
-
-#elif defined(GANXO_ARCH_X64)
-	#define GNX_CS_ARCH CS_ARCH_X86
-	#define GNX_CS_MODE CS_MODE_64
-
-	// FF 25 00 00 00 00       jmp cs:LongAddress
-	// 00 00 00 00 00 00 00 00 LongAddress dq ?
-	#define GANXO_JUMP_TO_SPRINGBOARD_SIZE 14
-#endif
-
-// The reasoning is that in the least we need GANXO_JUMP_TO_SPRINGBOARD_SIZE. If instructions are shorter, then
-// then we need to also copy the next instruction which could be as big as the maximum instruction size.
-#define GANXO_MAX_SPRINGBOARD_SIZE (GANXO_JUMP_TO_SPRINGBOARD_SIZE + GANXO_MAX_INSTR_SIZE)
-
-// Return the Ganxo disasm structure from the handle
-#define GET_DISASM gnx_disasm_t *dis = (gnx_disasm_t *)handle
-
-/// Work structure for the disassembler utilities
-typedef struct __gnx_disasm_t
-{
-	csh cs; ///< Capstone handle
-	cs_insn *insn; ///< preallocated instruction
-} gnx_disasm_t;
-
-
-/// User hook springboard format
-typedef struct __userhook_springboard_t
-{
-    uint8_t springboard[GANXO_MAX_SPRINGBOARD_SIZE];
-    uint8_t backup[GANXO_MAX_SPRINGBOARD_SIZE];
-    uint32_t backup_sz;
-    void    *func_addr;
-    void    *func_addr_final;
-} userhook_springboard_t;
-
-//--------------------------------------------------------------------------
-// Block/chunks macros and structures
-//--------------------------------------------------------------------------
-
-/// Return the Ganxo block header structure from the handle
-#define GET_BLOCK_HEADER \
-    gnx_block_header_t *bh = (gnx_block_header_t *)handle
-
-/// Return the chunk size
-#define gnx_block_chunk_get_size(handle) \
-    ((gnx_block_header_t *)handle)->chunk_size
-
-/// Block definition
-typedef struct __gnx_block_t
-{
-#ifdef GNX_DEBUG_BLOCK
-    int id;
-#endif
-	struct __gnx_block_t *next; ///< Next linked block
-    uint8_t *chunk_base;        ///< First chunk base address
-    uint8_t free_bitmap[1];     ///< Variable size bitmap denoting the free chunks in the block
-    uint8_t padding[3];
-} gnx_block_t;
-
-/// Block header, it describes everything about a block header.
-typedef struct __gnx_block_header_t
-{
-	gnx_block_t *first_block;	///< Location of the first block
-    gnx_block_t *active_block;  ///< Active block
-    gnx_block_t *last_block;    ///< Last block in the chain
-	gnx_mem_flags_t vmflags;	///< Memory flags used with the vmalloc() when allocating future blocks
-	size_t block_size;			///< Size of each block.
-	size_t chunk_size;			///< Size of each chunk in the block
-	size_t nb_chunks;			///< Number of chunks in a block
-    size_t freebitmap_sz;       ///< Size of the free chunks bitmap
-} gnx_block_header_t;
-
-/// Helper iterator structure to walk all the allocated chunks
-typedef struct __gnx_block_chunk_iterator_internal_t
-{
-    gnx_block_header_t *bh;
-    size_t chunk_no;
-    gnx_block_t *block;
-} gnx_block_chunk_iterator_internal_t;
-
-// STATIC ASSERT: Verify that the opaque iterator matches the size of the internal iterator
-typedef char __ASSERT_BLOCK_CHUNK_ITERATOR_SIZE[
-        sizeof(gnx_block_chunk_iterator_t) == sizeof(gnx_block_chunk_iterator_internal_t) 
-        ? 1 : -1];
-
-//--------------------------------------------------------------------------
-// Ganxo workspace structures
-//--------------------------------------------------------------------------
-
-#define GET_WORKSPACE gnx_workspace_t *ws = (gnx_workspace_t *)handle
-
-/// This is the main workspace structure for the whole library
-typedef struct __gnx_workspace_t
-{
-	gnx_handle_t dis;               ///< Disassembler
-	gnx_handle_t user_hooks;        ///< The block handle for user-hooks springboards
-} gnx_workspace_t;
-
+#ifndef __GANXO_PRIVATE_INC__
+#define __GANXO_PRIVATE_INC__
+
+#include <string.h>
+
+#ifdef _MSC_VER
+    #pragma warning(push)
+    #pragma warning(disable: 4820)
+    #include <capstone.h>
+    #pragma warning(pop)
+#endif
+
+#include <ganxo.h>
+
+//--------------------------------------------------------------------------
+// Atomic operations
+//--------------------------------------------------------------------------
+#ifdef _MSC_VER
+    #include <intrin.h>
+
+    /// Atomically add a value and return the previous one
+    #define gnx_atomic_fetch_add(p, v) \
+        _InterlockedExchangeAdd((volatile long *)(p), (long)(v))
+
+    /// Atomically replace a pointer if it equals 'comparand' and return its previous value
+    #define gnx_atomic_cas_ptr(p, exchange, comparand) \
+        _InterlockedCompareExchangePointer((void * volatile *)(p), (void *)(exchange), (void *)(comparand))
+
+    /// Atomically replace a pointer and return its previous value
+    #define gnx_atomic_xchg_ptr(p, v) \
+        _InterlockedExchangePointer((void * volatile *)(p), (void *)(v))
+
+    /// Atomically replace a 64 bits value if it equals 'comparand' and return its previous value
+    #define gnx_atomic_cas64(p, exchange, comparand) \
+        _InterlockedCompareExchange64((volatile long long *)(p), (long long)(exchange), (long long)(comparand))
+
+    /// Read the time stamp counter
+    #define gnx_rdtsc() __rdtsc()
+#endif
+
+//--------------------------------------------------------------------------
+// Disasm structures and macros
+//--------------------------------------------------------------------------
+#if defined(GANXO_ARCH_X86)
+	#define GNX_CS_ARCH CS_ARCH_X86
+	#define GNX_CS_MODE CS_MODE_32
+
+	// E9 xx xx xx xx ; jmp rel32
+	#define GANXO_JUMP_TO_SPRINGBOARD_SIZE 5
+
+	// FF 25 xx xx xx xx ; jmp dword ptr [slot]
+	#define GANXO_JUMP_TO_SLOT_SIZE 6
+
+#elif defined(GANXO_ARCH_X64)
+	#define GNX_CS_ARCH CS_ARCH_X86
+	#define GNX_CS_MODE CS_MODE_64
+
+	// FF 25 00 00 00 00       jmp cs:LongAddress
+	// 00 00 00 00 00 00 00 00 LongAddress dq ?
+	#define GANXO_JUMP_TO_SPRINGBOARD_SIZE 14
+
+	// FF 25 xx xx xx xx ; jmp qword ptr [rip + rel32] (the slot must be within 2GB)
+	#define GANXO_JUMP_TO_SLOT_SIZE 6
+#endif
+
+// The reasoning is that in the least we need GANXO_JUMP_TO_SPRINGBOARD_SIZE. If instructions are shorter, then
+// then we need to also copy the next instruction which could be as big as the maximum instruction size.
+// The slot jump fits too: it is never more than one byte longer, so its last copied instruction
+// still starts within the first GANXO_JUMP_TO_SPRINGBOARD_SIZE bytes.
+#define GANXO_MAX_SPRINGBOARD_SIZE (GANXO_JUMP_TO_SPRINGBOARD_SIZE + GANXO_MAX_INSTR_SIZE)
+
+// A leaf function relocated as a whole may grow: short branches are widened to rel32 (at most 4 times
+// the size of a JECXZ) and we always keep room for one more maximum sized instruction
+#define GANXO_MAX_LEAF_SPRINGBOARD_SIZE ((GANXO_MAX_LEAF_FUNCTION_SIZE * 4) + GANXO_MAX_INSTR_SIZE)
+
+// Return the Ganxo disasm structure from the handle
+#define GET_DISASM gnx_disasm_t *dis = (gnx_disasm_t *)handle
+
+/// Work structure for the disassembler utilities
+typedef struct __gnx_disasm_t
+{
+	csh cs; ///< Capstone handle
+	cs_insn *insn; ///< preallocated instruction
+	GNX_SINGLY_LIST_ITEM_DEFINE; ///< Link in the workspace pool (\ref gnx_workspace_t::dis_pool)
+} gnx_disasm_t;
+
+
+/// Returns the target of a previously disassembled relative jump or call
+/// \return False if the instruction is not a relative branch
+bool gnx_disasm_get_branch_target(
+    gnx_handle_t handle,
+    const void **target);
+
+
+/// Follow the unconditional jump at an address (one step of \ref gnx_disasm_skip_jumps)
+/// \return False if the instruction is not a jump that can be followed
+bool gnx_disasm_follow_jump(
+    gnx_handle_t handle,
+    const void *src,
+    const void **target);
+
+
+// Relative branches are at least 2 bytes long: copying the instructions that cover the jump to the
+// springboard relocates at most that many of them, plus the jump back to the original function
+#define GANXO_MAX_SPRINGBOARD_FIXUPS (GNX_ROUND_UP_DIV(GANXO_JUMP_TO_SPRINGBOARD_SIZE, 2) + 1)
+
+/// Springboard template relative operand
+typedef struct __gnx_sb_fixup_t
+{
+    uint8_t rel_ofs;        ///< Offset of the rel32 operand in the springboard code
+    int32_t target_delta;   ///< The branch target relative to the source function
+} gnx_sb_fixup_t;
+
+/// Springboard template: the position independent form of a springboard.
+/// The springboard only depends on the first 'backup_sz' bytes of a function so all
+/// the functions starting with those same bytes share the same template.
+typedef struct __gnx_sb_template_t
+{
+    uint8_t code[GANXO_MAX_SPRINGBOARD_SIZE];   ///< Springboard code (rel32 operands are patched when instantiated)
+    uint8_t code_sz;                            ///< Springboard code size
+    uint8_t backup_sz;                          ///< Count of copied (and to be patched) function bytes
+    uint8_t nb_fixups;                          ///< Count of relative operands
+    gnx_sb_fixup_t fixups[GANXO_MAX_SPRINGBOARD_FIXUPS];
+} gnx_sb_template_t;
+
+/// Hook joined behind the hook installed on a function (\ref gnx_transaction_add_hook on a hooked function).
+/// Each hook of the chain continues through its own function pointer: the one the function's hook was
+/// added with leads to the first joined hook, the last joined hook's leads to the springboard.
+typedef struct __gnx_hook_join_t
+{
+    struct __gnx_hook_join_t *next;         ///< Next joined hook, toward the springboard
+    void *hook;                             ///< The hook function
+    void **psrc;                            ///< Where the hook continues: the next hook or the springboard
+    void *func_addr;                        ///< The function pointer value before the hook was added
+} gnx_hook_join_t;
+
+/// User hook springboard format
+/// \note The springboard is the last member so that leaf springboards can spill over
+///       into the extra room of \ref userhook_leaf_springboard_t
+typedef struct __userhook_springboard_t
+{
+    uint8_t backup[GANXO_MAX_SPRINGBOARD_SIZE];
+    uint32_t backup_sz;
+    uint32_t flags;
+        #define GNX_UHF_LEAF 0x00000001 ///< The whole function is relocated in the springboard
+        #define GNX_UHF_RETIRED 0x00000002 ///< Unhooked, waiting to be freed (\ref gnx_sb_retire)
+    uint32_t leaf_size;     ///< Size of the relocated leaf function (\ref GNX_UHF_LEAF)
+    long retire_epoch;      ///< Workspace epoch when retired (\ref GNX_UHF_RETIRED)
+    struct __userhook_springboard_t *limbo_next; ///< Next retired springboard
+    struct __gnx_hook_slot_t *slot; ///< Dispatch slot (NULL unless hooked with \ref gnx_transaction_add_slot_hook)
+    gnx_hook_join_t *joins; ///< Hooks joined behind it, in calling order
+    void    **psrc;         ///< Caller's function pointer, given back the original function by \ref gnx_unhook_all
+    void    *func_addr;
+    void    *func_addr_final;
+    uint8_t springboard[GANXO_MAX_SPRINGBOARD_SIZE];
+} userhook_springboard_t;
+
+/// Leaf function springboard: no jump back to the original function is needed
+typedef struct __userhook_leaf_springboard_t
+{
+    userhook_springboard_t uh;
+    uint8_t spill[GANXO_MAX_LEAF_SPRINGBOARD_SIZE - GANXO_MAX_SPRINGBOARD_SIZE];
+} userhook_leaf_springboard_t;
+
+//--------------------------------------------------------------------------
+// Block/chunks macros and structures
+//--------------------------------------------------------------------------
+
+/// Return the Ganxo block header structure from the handle
+#define GET_BLOCK_HEADER \
+    gnx_block_header_t *bh = (gnx_block_header_t *)handle
+
+/// Return the chunk size
+#define gnx_block_chunk_get_size(handle) \
+    ((gnx_block_header_t *)handle)->chunk_size
+
+/// Block definition
+typedef struct __gnx_block_t
+{
+#ifdef GNX_DEBUG_BLOCK
+    int id;
+#endif
+	struct __gnx_block_t *next; ///< Next linked block
+    uint8_t *chunk_base;        ///< First chunk base address
+    uint8_t free_bitmap[1];     ///< Variable size bitmap denoting the free chunks in the block
+    uint8_t padding[3];
+} gnx_block_t;
+
+/// Block header, it describes everything about a block header.
+typedef struct __gnx_block_header_t
+{
+	gnx_block_t *first_block;	///< Location of the first block
+    gnx_block_t *active_block;  ///< Active block
+    gnx_block_t *last_block;    ///< Last block in the chain
+	gnx_mem_flags_t vmflags;	///< Memory flags used with the vmalloc() when allocating future blocks
+	size_t block_size;			///< Size of each block.
+	size_t chunk_size;			///< Size of each chunk in the block
+	size_t nb_chunks;			///< Number of chunks in a block
+    size_t freebitmap_sz;       ///< Size of the free chunks bitmap
+} gnx_block_header_t;
+
+/// Helper iterator structure to walk all the allocated chunks
+typedef struct __gnx_block_chunk_iterator_internal_t
+{
+    gnx_block_header_t *bh;
+    size_t chunk_no;
+    gnx_block_t *block;
+} gnx_block_chunk_iterator_internal_t;
+
+// STATIC ASSERT: Verify that the opaque iterator matches the size of the internal iterator
+typedef char __ASSERT_BLOCK_CHUNK_ITERATOR_SIZE[
+        sizeof(gnx_block_chunk_iterator_t) == sizeof(gnx_block_chunk_iterator_internal_t) 
+        ? 1 : -1];
+
+//--------------------------------------------------------------------------
+// Springboard templates cache
+//--------------------------------------------------------------------------
+
+/// Number of hash buckets (power of 2)
+#define GNX_SB_CACHE_BUCKETS 1024
+
+/// Maximum number of cached templates
+#define GNX_SB_CACHE_MAX_ENTRIES 4096
+
+/// Cached springboard template
+typedef struct __gnx_sb_cache_entry_t
+{
+    struct __gnx_sb_cache_entry_t *next;        ///< Next entry in the same bucket
+    uint32_t hash;                              ///< Hash of the first tpl.backup_sz bytes
+    uint8_t prologue[GANXO_MAX_SPRINGBOARD_SIZE]; ///< The function bytes the template was built from
+    gnx_sb_template_t tpl;
+} gnx_sb_cache_entry_t;
+
+/// Springboard templates cache, keyed by the function bytes copied in the springboard
+typedef struct __gnx_sb_cache_t
+{
+    size_t nb_entries;
+    volatile size_t max_backup_sz;              ///< Longest cached prologue: the lookups never hash further
+    gnx_sb_cache_entry_t *buckets[GNX_SB_CACHE_BUCKETS];
+} gnx_sb_cache_t;
+
+/// Create an empty springboard templates cache
+gnx_sb_cache_t *gnx_sb_cache_create(void);
+
+/// Free the cache and all its entries
+void gnx_sb_cache_free(gnx_sb_cache_t *cache);
+
+/// Find the template matching the first bytes of a function
+/// \param min_size The minimum count of bytes the template must copy (the size of the patch)
+/// \return NULL if no template is cached for this function's prologue
+/// \note At most min_size + GANXO_MAX_INSTR_SIZE - 1 bytes are read: no more than building the template would decode
+const gnx_sb_template_t *gnx_sb_cache_lookup(
+    gnx_sb_cache_t *cache,
+    const void *func,
+    size_t min_size);
+
+/// Remember the template built for a function
+/// \note Insertions must be serialized (workspace lock) but lookups may run concurrently
+void gnx_sb_cache_insert(
+    gnx_sb_cache_t *cache,
+    const void *func,
+    const gnx_sb_template_t *tpl);
+
+//--------------------------------------------------------------------------
+// Operating system services (implemented by the platform's xxx-os-impl.c)
+//--------------------------------------------------------------------------
+
+/// Size of a module build identifier
+#define GNX_OS_MODULE_ID_SIZE 20
+
+/// Maximum module base name length (including the terminating zero)
+#define GNX_OS_MODULE_NAME_SIZE 64
+
+/// Loaded module information
+typedef struct __gnx_os_module_t
+{
+    const uint8_t *base;                        ///< Image base address
+    size_t size;                                ///< Image size
+    uint8_t id[GNX_OS_MODULE_ID_SIZE];          ///< Build identifier (changes whenever the module is rebuilt)
+    char name[GNX_OS_MODULE_NAME_SIZE];         ///< Module base name
+} gnx_os_module_t;
+
+/// Map a whole file in memory for reading
+gnx_err_t gnx_os_map_file(
+    const char *path,
+    const void **view,
+    size_t *size);
+
+/// Unmap a file mapped with \ref gnx_os_map_file
+void gnx_os_unmap_file(const void *view);
+
+/// Create (or truncate) a file and map it in memory for writing
+/// \param view Returns the mapped view of the whole file
+/// \return The mapping, NULL on failure
+void *gnx_os_map_new_file(
+    const char *path,
+    size_t size,
+    void **view);
+
+/// Unmap a file mapped with \ref gnx_os_map_new_file and truncate it
+void gnx_os_unmap_new_file(
+    void *mapping,
+    void *view,
+    uint64_t final_size);
+
+/// Create (or truncate) a file for writing
+/// \return NULL on failure
+void *gnx_os_file_create(const char *path);
+
+/// Write to a file created with \ref gnx_os_file_create
+gnx_err_t gnx_os_file_write(
+    void *file,
+    const void *buf,
+    size_t size);
+
+/// Close a file created with \ref gnx_os_file_create
+void gnx_os_file_close(void *file);
+
+/// Longest file path
+#define GNX_OS_MAX_PATH 260
+
+/// Path of the process's perf map file: perf-<pid>.map in the temporary directory
+bool gnx_os_perf_map_path(
+    char *path,
+    size_t size);
+
+/// Lightweight exclusive lock (no destruction needed)
+typedef struct __gnx_os_lock_t
+{
+    void *opaque;
+} gnx_os_lock_t;
+
+/// Initialize a lock
+void gnx_os_lock_init(gnx_os_lock_t *lock);
+
+/// Acquire a lock
+void gnx_os_lock_acquire(gnx_os_lock_t *lock);
+
+/// Release a lock
+void gnx_os_lock_release(gnx_os_lock_t *lock);
+
+/// Thread entry point
+typedef void (*gnx_os_thread_proc_t)(void *ctx);
+
+/// Start a thread
+/// \return NULL on failure
+void *gnx_os_thread_create(
+    gnx_os_thread_proc_t proc,
+    void *ctx);
+
+/// Wait for a thread to finish and free it
+void gnx_os_thread_join(void *thread);
+
+/// Count of logical processors
+size_t gnx_os_cpu_count(void);
+
+/// Size of a memory page (the protection granularity)
+size_t gnx_os_page_size(void);
+
+/// Create an auto-reset event: a signal wakes up a single wait
+/// \return NULL on failure
+void *gnx_os_event_create(void);
+
+/// Signal an event
+void gnx_os_event_set(void *event);
+
+/// Wait for an event to be signaled
+void gnx_os_event_wait(void *event);
+
+/// Free an event
+void gnx_os_event_free(void *event);
+
+/// Allocate a thread local slot
+/// \param ofs Returns the offset of the slot from the thread's environment block (the stubs address it directly)
+gnx_err_t gnx_os_tls_alloc(
+    uint32_t *index,
+    uint32_t *ofs);
+
+/// Set the calling thread's value of a thread local slot
+void gnx_os_tls_set(
+    uint32_t index,
+    void *value);
+
+/// Get the calling thread's value of a thread local slot
+void *gnx_os_tls_get(uint32_t index);
+
+/// Free a thread local slot
+void gnx_os_tls_free(uint32_t index);
+
+/// Wait for an event to be signaled, up to a timeout
+/// \return false if the timeout elapsed
+bool gnx_os_event_wait_timeout(
+    void *event,
+    uint32_t timeout_ms);
+
+/// Create a named shared memory region
+/// \param view Returns the mapped view of the whole region
+/// \return The region, NULL on failure or if the name is already used
+void *gnx_os_shm_create(
+    const char *name,
+    size_t size,
+    void **view);
+
+/// Unmap and free a shared memory region (the other processes mapping it keep it alive)
+void gnx_os_shm_free(
+    void *shm,
+    void *view);
+
+/// Give up the rest of the thread's time slice
+void gnx_os_yield(void);
+
+/// Serialize the instruction stream of all the processors running the process threads
+/// (after cross-modifying code)
+void gnx_os_serialize_cpus(void);
+
+/// Called while all the other threads of the process are suspended.
+/// \note It must not allocate memory nor take any lock: a suspended thread may own it.
+typedef void (*gnx_os_stw_proc_t)(void *ctx);
+
+/// Called for each suspended thread
+/// \param ip In/out instruction pointer of the thread
+/// \return True if the instruction pointer was changed
+typedef bool (*gnx_os_ip_fixup_t)(
+    void *ctx,
+    const void **ip);
+
+/// Suspend all the other threads, run 'proc', let 'fixup' move their instruction pointers, then resume them
+/// \param pause_ns Returns how long the threads were suspended
+gnx_err_t gnx_os_stop_threads(
+    gnx_os_stw_proc_t proc,
+    gnx_os_ip_fixup_t fixup,
+    void *ctx,
+    uint64_t *pause_ns);
+
+/// Called for each thread by \ref gnx_os_scan_threads
+/// \param regs The instruction pointer, then the general purpose registers (none for the calling thread)
+/// \param sp The stack pointer: the used part of the stack is [sp, base)
+typedef void (*gnx_os_thread_scan_t)(
+    void *ctx,
+    const uintptr_t *regs,
+    size_t nb_regs,
+    const uintptr_t *sp,
+    const uintptr_t *base);
+
+/// Let 'scan' read the registers and the stack of all the threads of the process: the calling one,
+/// then all the others while they are suspended.
+/// \note 'scan' must not allocate memory nor take any lock: a suspended thread may own it.
+/// \retval GNX_ERR_FAILED Some threads could not be scanned
+gnx_err_t gnx_os_scan_threads(
+    gnx_os_thread_scan_t scan,
+    void *ctx);
+
+/// Breakpoint handler
+/// \param addr The breakpoint address
+/// \param resume Returns where the thread resumes when handled
+/// \return False if the breakpoint is not handled (it is passed to the next handlers)
+typedef bool (*gnx_os_bp_handler_t)(
+    const void *addr,
+    const void **resume);
+
+/// Install the process wide breakpoint handler (once, for the process lifetime)
+gnx_err_t gnx_os_bp_handler_install(gnx_os_bp_handler_t handler);
+
+/// Called for each import address table slot found (\ref gnx_os_find_import_slots)
+typedef void (*gnx_os_import_slot_proc_t)(
+    void *ctx,
+    void **slot);
+
+/// Find the import address table slots of a function imported by name
+/// \param module Base name of the importing module, NULL for all the loaded modules
+/// \param dll Base name of the module exporting the function, NULL for any
+/// \return The count of slots found
+size_t gnx_os_find_import_slots(
+    const char *module,
+    const char *dll,
+    const char *symbol,
+    gnx_os_import_slot_proc_t proc,
+    void *ctx);
+
+/// Resolve functions exported by name by a loaded module (\ref gnx_resolve_symbols)
+gnx_err_t gnx_os_resolve_exports(
+    const char *module,
+    const char **names,
+    size_t nb_names,
+    void **addrs,
+    size_t *sizes);
+
+/// Called when a module is loaded or unloaded (\ref gnx_os_module_events_register)
+/// \note Called under the loader lock
+typedef void (*gnx_os_module_event_proc_t)(
+    void *ctx,
+    bool loaded,
+    const gnx_os_module_t *mod);
+
+/// Be notified of the modules loading and unloading. The build identifier of the notified modules is not set.
+/// \return The registration, NULL on failure
+void *gnx_os_module_events_register(
+    gnx_os_module_event_proc_t proc,
+    void *ctx);
+
+/// Stop the notifications: no notification is running anymore once it returns
+void gnx_os_module_events_unregister(void *registration);
+
+/// Get the information of the loaded module containing an address
+bool gnx_os_module_from_address(
+    const void *addr,
+    gnx_os_module_t *mod);
+
+/// Get the information of a loaded module given its base name
+bool gnx_os_module_from_name(
+    const char *name,
+    gnx_os_module_t *mod);
+
+//--------------------------------------------------------------------------
+// Live patching (see live-patch.c)
+//--------------------------------------------------------------------------
+
+/// Code patch
+typedef struct __gnx_live_patch_t
+{
+    uint8_t *addr;                              ///< Patched address (writable)
+    uint8_t code[GANXO_MAX_SPRINGBOARD_SIZE];   ///< New code
+    size_t size;                                ///< New code size (0 skips the patch)
+    const void *redirect;                       ///< Where a thread reaching 'addr' is sent while the patch is staged
+} gnx_live_patch_t;
+
+/// Initialize the live patching (\ref gnx_init)
+void gnx_live_patch_init(void);
+
+/// Patch code that may be running on other threads
+/// \note The instruction cache is not flushed. On failure, nothing is patched.
+gnx_err_t gnx_live_patch_apply(
+    gnx_live_patch_t *patches,
+    size_t nb_patches);
+
+//--------------------------------------------------------------------------
+// Slot hooks
+//--------------------------------------------------------------------------
+
+/// Hook inserted in the chain of a slot hook (\ref gnx_hook_chain_insert)
+typedef struct __gnx_hook_chain_entry_t
+{
+    struct __gnx_hook_chain_entry_t *next;  ///< Next entry, toward the slot hook's own hook
+    void *hook;                             ///< The hook function
+    void **porig;                           ///< Where the hook continues: the next hook of the chain
+} gnx_hook_chain_entry_t;
+
+/// Dispatch slot of a slot hook (\ref gnx_transaction_add_slot_hook).
+/// The patched function jumps through 'target': pointing it to the first hook of the chain or to the
+/// springboard enables or disables the hook.
+/// The chained hooks continue through their own function pointer ('porig') so the calls never go
+/// through more than one indirect jump per hook, and the chain is modified without touching any code.
+typedef struct __gnx_hook_slot_t
+{
+    void * volatile target;                 ///< Where the patched function jumps to (first member: jmp [slot])
+    void * volatile hook;                   ///< The first hook of the chain
+    void *base_hook;                        ///< The slot hook's own hook, last of the chain
+    gnx_hook_chain_entry_t *chain;          ///< The hooks inserted before the base hook
+    gnx_os_lock_t chain_lock;               ///< Serializes the chain modifications (the calls never take it)
+    userhook_springboard_t *uh;             ///< The hooked function springboard
+} gnx_hook_slot_t;
+
+//--------------------------------------------------------------------------
+// Hook plans
+//--------------------------------------------------------------------------
+
+/// Mapped hook plan (opaque, see plan.c)
+typedef struct __gnx_plan_t gnx_plan_t;
+
+/// Find the planned springboard of a function
+/// \param dis Disassembler used to check that the jumps from src still lead to the planned function
+/// \param src The function address (jumps not skipped yet)
+/// \param final Returns the function address after all the jumps are skipped
+/// \return NULL if the function is not in the plan, if its bytes changed or if src jumps elsewhere
+const gnx_sb_template_t *gnx_plan_lookup(
+    gnx_plan_t *plan,
+    gnx_handle_t dis,
+    const void *src,
+    void **final);
+
+/// Unmap and free a plan
+void gnx_plan_free(gnx_plan_t *plan);
+
+//--------------------------------------------------------------------------
+// Ganxo workspace structures
+//--------------------------------------------------------------------------
+
+#define GET_WORKSPACE gnx_workspace_t *ws = (gnx_workspace_t *)handle
+
+/// Code ranges description for the profilers (\ref gnx_code_map_start)
+typedef struct __gnx_code_map_t
+{
+    volatile bool active;           ///< Read without the lock: nothing is formatted until started
+    void *file;                     ///< perf map file, NULL for none
+    gnx_code_map_callback_t callback;
+    void *ctx;
+    gnx_os_lock_t lock;             ///< Serializes the lines and the callbacks
+} gnx_code_map_t;
+
+/// This is the main workspace structure for the whole library
+typedef struct __gnx_workspace_t
+{
+	gnx_handle_t dis;               ///< Disassembler
+	gnx_handle_t user_hooks;        ///< The block handle for user-hooks springboards
+	gnx_handle_t leaf_hooks;        ///< The block handle for whole leaf functions springboards
+	gnx_handle_t hook_slots;        ///< The block handle for the slot hooks dispatch slots (data, never executable)
+	gnx_handle_t hook_index;        ///< Installed patches and springboards ranges (value: the springboard, \ref gnx_hook_find_by_pc)
+	size_t leaf_max_size;           ///< Maximum leaf function size to relocate (0 disables, \ref GNX_OPT_LEAF_RELOC_MAX_SIZE)
+	gnx_sb_cache_t *sb_cache;       ///< Springboard templates cache (kept until \ref gnx_close, even when disabled)
+	bool sb_cache_enabled;          ///< The springboard templates cache is used (\ref GNX_OPT_SPRINGBOARD_CACHE)
+	gnx_plan_t *plan;               ///< Loaded hook plan (\ref gnx_plan_load)
+	size_t nb_workers;              ///< Bulk hooks preparation threads (0: one per processor, \ref GNX_OPT_WORKER_THREADS)
+	gnx_singly_list_item_t dis_pool; ///< Spare disassemblers for the hooking threads (\ref gnx_disasm_t, each worker thread needs its own)
+	gnx_commit_mode_t commit_mode;  ///< How the transactions are committed (\ref GNX_OPT_COMMIT_MODE)
+	gnx_stats_t stats;              ///< Statistics (\ref gnx_get_stats)
+	volatile long epoch;            ///< Springboards reclamation epoch, advanced by each retirement (\ref gnx_sb_retire)
+	bool track_threads;             ///< A thread was registered: the retired springboards wait for the registered threads' epochs
+	bool registered_threads_only;   ///< Only the registered threads run the hooks: no threads scan (\ref GNX_OPT_REGISTERED_THREADS_ONLY)
+	gnx_singly_list_item_t threads; ///< Registered threads (\ref gnx_thread_rec_t)
+	userhook_springboard_t *limbo;  ///< Retired springboards, most recent first
+	size_t nb_open_transactions;    ///< Transactions in progress: the springboards blocks are writable until the last one ends
+	gnx_os_lock_t commit_lock;      ///< Serializes the patching passes (the callers' commits and the committer thread's)
+	struct __gnx_committer_t *committer; ///< Asynchronous commits thread (NULL until the first \ref gnx_transaction_commit_async)
+	gnx_singly_list_item_t pending; ///< Hooks of the modules to come (\ref gnx_add_pending_hooks)
+	size_t nb_pending;              ///< Count of pending hooks
+	gnx_os_lock_t pending_lock;     ///< Protects the pending hooks (never held while hooking)
+	void * volatile module_events;  ///< Modules loading notifications registration (NULL until the first pending hook)
+	struct __gnx_counters_t *counters; ///< Instrumentation counters (NULL until the first \ref gnx_transaction_add_counter_hook)
+	gnx_code_map_t code_map;        ///< Code ranges description (\ref gnx_code_map_start)
+	gnx_os_lock_t lock;             ///< Protects the springboards and slots blocks, the hooks index updates, the registered threads, the templates cache insertions and the disassemblers pool
+} gnx_workspace_t;
+
+//--------------------------------------------------------------------------
+// Springboards
+//--------------------------------------------------------------------------
+
+/// Get the springboard template of a function (from the cache or by disassembling it)
+/// \param patch_size The size of the patch the springboard makes room for
+gnx_err_t gnx_sb_template_get(
+    gnx_workspace_t *ws,
+    const void *src_func,
+    size_t patch_size,
+    gnx_sb_template_t *tpl);
+
+/// Free the workspace's pooled disassemblers
+void gnx_dis_pool_free(gnx_workspace_t *ws);
+
+/// Commit several transactions of the workspace in a single patching pass, in order.
+/// The transactions are not freed (\ref gnx_transaction_release).
+/// \param errs Returns the result of each transaction
+/// \return The patching pass error, if any
+gnx_err_t gnx_transactions_apply(
+    gnx_workspace_t *ws,
+    const gnx_handle_t *transactions,
+    size_t nb_transactions,
+    gnx_err_t *errs);
+
+/// Tell whether a function pointer is the one of an installed hook chained with other hooks
+/// (\ref gnx_hook_join_t): it may lead to the next hook rather than to the springboard
+bool gnx_hook_is_chained(
+    gnx_workspace_t *ws,
+    void **psrc);
+
+/// Forget the installed hooks of an unloaded module: their springboards are retired without restoring
+/// any code and their function pointers are set to NULL
+/// \param psrcs The function pointers of the hooks, the ones that are not hooked are ignored
+void gnx_drop_hooks(
+    gnx_workspace_t *ws,
+    void ** const *psrcs,
+    size_t nb_psrcs);
+
+/// Count of items of a transaction
+size_t gnx_transaction_get_size(gnx_handle_t handle);
+
+/// Free an applied transaction (\ref gnx_transactions_apply)
+/// \param results Returns the result of each item (\ref gnx_transaction_get_size), may be NULL
+/// \return The count of items
+size_t gnx_transaction_release(
+    gnx_handle_t handle,
+    gnx_commit_result_t *results);
+
+/// Free a springboard (and its dispatch slot) right away
+gnx_err_t gnx_sb_free(
+    gnx_workspace_t *ws,
+    userhook_springboard_t *uh);
+
+//--------------------------------------------------------------------------
+// Generated code emission (counters.c, filter.c)
+//--------------------------------------------------------------------------
+
+/// Code being generated
+typedef struct __gnx_emitter_t
+{
+    uint8_t *start;
+    uint8_t *p;
+} gnx_emitter_t;
+
+static inline void gnx_emit(
+    gnx_emitter_t *e,
+    const char *bytes,
+    size_t size)
+{
+    memcpy(e->p, bytes, size);
+    e->p += size;
+}
+
+static inline void gnx_emit32(
+    gnx_emitter_t *e,
+    uint32_t value)
+{
+    memcpy(e->p, &value, sizeof(value));
+    e->p += sizeof(value);
+}
+
+/// Emit a short branch to be bound later
+static inline uint8_t *gnx_emit_jcc8(
+    gnx_emitter_t *e,
+    uint8_t opcode)
+{
+    *e->p++ = opcode;
+    *e->p++ = 0;
+    return e->p;
+}
+
+/// Bind a short branch to the current position (at most 127 bytes ahead: use \ref gnx_emit_jcc32 otherwise)
+static inline void gnx_bind_jcc8(
+    gnx_emitter_t *e,
+    uint8_t *after_branch)
+{
+    after_branch[-1] = (uint8_t)(e->p - after_branch);
+}
+
+/// Emit a near branch to be bound later
+/// \param opcode The short branch opcode (0x70 - 0x7F)
+static inline uint8_t *gnx_emit_jcc32(
+    gnx_emitter_t *e,
+    uint8_t opcode)
+{
+    *e->p++ = 0x0F;
+    *e->p++ = (uint8_t)(opcode + 0x10);
+    gnx_emit32(e, 0);
+    return e->p;
+}
+
+/// Bind a near branch to the current position
+static inline void gnx_bind_jcc32(
+    gnx_emitter_t *e,
+    uint8_t *after_branch)
+{
+    int32_t rel = (int32_t)(e->p - after_branch);
+    memcpy(after_branch - sizeof(rel), &rel, sizeof(rel));
+}
+
+static inline void gnx_emit_jmp(
+    gnx_emitter_t *e,
+    const void *target)
+{
+    *e->p++ = 0xE9;
+    gnx_emit32(e, (uint32_t)((const uint8_t *)target - (e->p + sizeof(uint32_t))));
+}
+
+//--------------------------------------------------------------------------
+// Instrumentation counters (see counters.c)
+//--------------------------------------------------------------------------
+
+#define GNX_MAX_COUNTERS            4096    ///< Counter hooks of a workspace
+#define GNX_COUNTERS_SHADOW_DEPTH   64      ///< Nested timed calls of a thread (the deeper ones are only counted)
+#define GNX_STUB_SIZE               256     ///< Generated stubs chunk size
+#define GNX_TRACE_RING_RECORDS      8192    ///< Trace records ring of a thread (a power of 2)
+#define GNX_TRACE_SEGMENT_RECORDS   256     ///< Trace records drained at once (\ref gnx_trace_drain)
+#define GNX_THREAD_HOOKS_SLOTS      4       ///< Thread local slots of the thread-scoped hooks enable bits (32 hooks each)
+
+/// Counter of a hook (laid out like \ref gnx_hook_counters_t)
+typedef struct __gnx_counter_t
+{
+    volatile uint64_t calls;
+    volatile uint64_t cycles;
+    volatile uint32_t histogram[GNX_HOOK_HISTOGRAM_SIZE];
+} gnx_counter_t;
+
+/// Timed or traced call in progress
+typedef struct __gnx_shadow_frame_t
+{
+    const void *ret;            ///< Caller's return address
+    uint32_t cycles_ofs;        ///< Offset of the counter's cycles in the thread's block, or the trace hook identifier
+    uint64_t tsc;               ///< Time stamp counter on entry
+    const void *slot;           ///< Stack address of the replaced return address
+    uint32_t reserved[3];
+} gnx_shadow_frame_t;
+
+/// Sampling control of a counter hook's stub, always writable
+typedef struct __gnx_stub_control_t
+{
+    const void *volatile dispatch; ///< Where the stub jumps first: its body, or the springboard once disabled
+    volatile uint32_t sample_mask; ///< The calls are timed when the thread's count has none of these bits
+    const void *body;
+    const void *springboard;
+    uint32_t flags;             ///< Counter hook flags (\ref GNX_COUNT_CYCLES)
+} gnx_stub_control_t;
+
+/// Counters and trace records of a registered thread, found by the stubs through a thread local slot
+typedef struct __gnx_counters_block_t
+{
+    uint32_t depth;             ///< Timed or traced calls in progress
+    uint32_t reserved;
+    gnx_shadow_frame_t shadow[GNX_COUNTERS_SHADOW_DEPTH];
+    volatile uint32_t trace_head;       ///< Records written by the thread (the stubs)
+    volatile uint32_t trace_tail;       ///< Records drained (\ref gnx_trace_drain)
+    volatile uint32_t trace_dropped;    ///< Records dropped because the ring was full
+    uint32_t trace_dropped_seen;        ///< Dropped records already accounted for in the trace file
+    gnx_trace_record_t *trace_ring;     ///< Single producer records ring (\ref GNX_TRACE_RING_RECORDS)
+    gnx_counter_t counters[GNX_MAX_COUNTERS];
+} gnx_counters_block_t;
+
+/// Recursion guard group: the thread local slots where each thread keeps its guarded call
+typedef struct __gnx_guard_group_t
+{
+    uint32_t ret_index;         ///< Caller's return address
+    uint32_t ret_ofs;
+    uint32_t slot_index;        ///< Stack address of the replaced return address, 0 outside the group's hooks
+    uint32_t slot_ofs;
+    uint8_t *exit_thunk;        ///< Where the group's hooks return, NULL until the group is used
+} gnx_guard_group_t;
+
+/// Counters of a workspace
+typedef struct __gnx_counters_t
+{
+    uint32_t tls_index;         ///< Thread local slot of the threads blocks (\ref gnx_os_tls_alloc)
+    uint32_t tls_ofs;           ///< Offset of the slot from the thread's environment block (fs)
+    gnx_handle_t stubs;         ///< Generated stubs block (protected like the springboards)
+    uint8_t *exit_thunk;        ///< Where the timed functions return
+    uint8_t *trace_exit_thunk;  ///< Where the traced functions return
+    volatile uint32_t trace_untracked; ///< Calls of the traced functions by unregistered threads (not recorded)
+    struct __gnx_trace_t *trace; ///< Trace file being written (\ref gnx_trace_start)
+    struct __gnx_governor_t *governor; ///< Overhead governor (\ref gnx_governor_start)
+    gnx_os_lock_t governor_lock; ///< Serializes the governor start, checks and stop
+    gnx_stub_control_t *control; ///< Sampling of the counter hooks
+    uint32_t thread_tls_index[GNX_THREAD_HOOKS_SLOTS]; ///< Thread local slots holding the threads enable bits
+    uint32_t thread_tls_ofs[GNX_THREAD_HOOKS_SLOTS];
+    uint32_t nb_thread_hooks;
+    gnx_guard_group_t guards[GNX_GUARD_GROUPS];
+    void *shm;                  ///< Shared memory of the counters (\ref gnx_counters_share), NULL if private
+    gnx_shared_counters_t *shm_header; ///< Mapped shared memory
+    uint8_t *shm_used;          ///< Threads blocks slots in use
+    uint32_t shm_nb_slots;
+    gnx_counter_t *shared;      ///< Counters of the unregistered threads (locked additions)
+    gnx_counter_t *retired;     ///< Counts left by the threads that unregistered
+    uint32_t nb_counters;
+} gnx_counters_t;
+
+/// Get the workspace's counters, created on first use
+/// \return NULL on failure or if the architecture is not supported
+gnx_counters_t *gnx_counters_get(gnx_workspace_t *ws);
+
+/// Allocate a stub and its counter
+/// \param index Returns the counter index, NULL for a stub without counter (trace hooks)
+/// \note The stubs block must be writable
+gnx_err_t gnx_counters_alloc_stub(
+    gnx_workspace_t *ws,
+    uint8_t **stub,
+    uint32_t *index);
+
+/// Generate a counter's stub, jumping to the springboard once the call is accounted for
+void gnx_counters_gen_stub(
+    gnx_counters_t *counters,
+    uint8_t *stub,
+    uint32_t index,
+    uint32_t flags,
+    const void *springboard);
+
+/// Allocate a thread-scoped hook's enable bit (and a thread local slot for every 32 hooks)
+/// \param thread_hook Returns the handle of the hook (\ref gnx_hook_thread_enable)
+/// \param ofs Returns the offset of the bit's slot from the thread's environment block
+gnx_err_t gnx_counters_alloc_thread_bit(
+    gnx_workspace_t *ws,
+    gnx_handle_t *thread_hook,
+    uint32_t *ofs,
+    uint32_t *bit);
+
+/// Generate a thread-scoped hook's stub: the enabled threads jump to the hook, the others to the springboard
+void gnx_counters_gen_thread_stub(
+    uint8_t *stub,
+    uint32_t ofs,
+    uint32_t bit,
+    const void *hook,
+    const void *springboard);
+
+/// Get a recursion guard group, allocating its slots and generating its exit thunk on first use
+/// \note The stubs block must be writable
+gnx_err_t gnx_counters_get_guard(
+    gnx_workspace_t *ws,
+    uint32_t group,
+    gnx_guard_group_t **guard);
+
+/// Generate a guarded hook's stub: the reentrant calls jump to the springboard, the others to the hook
+void gnx_counters_gen_guard_stub(
+    const gnx_guard_group_t *guard,
+    uint8_t *stub,
+    const void *hook,
+    const void *springboard);
+
+/// Describe a counter hook in the shared memory, if any
+void gnx_counters_describe(
+    gnx_workspace_t *ws,
+    uint32_t index,
+    const void *func,
+    uint32_t flags);
+
+/// Copy the workspace statistics to the shared memory, if any
+void gnx_counters_publish_stats(gnx_workspace_t *ws);
+
+/// Generate a trace hook's stub, jumping to the springboard once the call is recorded
+void gnx_counters_gen_trace_stub(
+    gnx_counters_t *counters,
+    uint8_t *stub,
+    uint32_t hook_id,
+    uint32_t flags,
+    const void *springboard);
+
+/// Sum the counts of a counter hook over all the threads
+/// \note The workspace lock must be held
+void gnx_counters_sum(
+    gnx_workspace_t *ws,
+    uint32_t index,
+    gnx_hook_counters_t *result);
+
+/// Current sampling of a counter hook (\ref gnx_hook_set_sampling)
+uint32_t gnx_counters_get_sampling(
+    gnx_counters_t *counters,
+    uint32_t index);
+
+/// Change the sampling of a counter hook (\ref gnx_hook_set_sampling)
+/// \return The previous sampling
+/// \note The workspace lock must be held
+uint32_t gnx_counters_set_sampling(
+    gnx_counters_t *counters,
+    uint32_t index,
+    uint32_t sampling);
+
+/// Free the counters and their stubs (\ref gnx_close)
+void gnx_counters_free(gnx_workspace_t *ws);
+
+//--------------------------------------------------------------------------
+// Trace files (see trace.c)
+//--------------------------------------------------------------------------
+
+/// Copy the records of a thread's ring to the trace file
+/// \param all Copy all the records, not only the full segments
+/// \note The workspace lock must be held
+void gnx_trace_drain_ring(
+    gnx_counters_t *counters,
+    gnx_counters_block_t *block,
+    bool all);
+
+/// Stop writing the trace file, if any (\ref gnx_close)
+void gnx_trace_free(gnx_workspace_t *ws);
+
+//--------------------------------------------------------------------------
+// Hook filters (see filter.c)
+//--------------------------------------------------------------------------
+
+#define GNX_FILTER_MAX_TERMS        8       ///< Comparisons of a filter expression (they fit in a stub)
+
+#define GNX_FILTER_COMPARE          0
+#define GNX_FILTER_AND              1
+#define GNX_FILTER_OR               2
+
+#define GNX_FILTER_ECX              0xFE    ///< Compared operand: the ecx register
+#define GNX_FILTER_EDX              0xFF    ///< Compared operand: the edx register
+
+/// Filter expression node
+typedef struct __gnx_filter_node_t
+{
+    uint8_t type;               ///< GNX_FILTER_COMPARE, GNX_FILTER_AND or GNX_FILTER_OR
+    uint8_t left;               ///< Operands of GNX_FILTER_AND and GNX_FILTER_OR
+    uint8_t right;
+    uint8_t operand;            ///< Stack argument index, GNX_FILTER_ECX or GNX_FILTER_EDX
+    uint8_t cond;               ///< x86 condition code of the unsigned comparison (jcc)
+    uint32_t mask;
+    uint32_t value;
+} gnx_filter_node_t;
+
+/// Parsed filter expression (\ref gnx_transaction_add_filtered_hook)
+typedef struct __gnx_filter_t
+{
+    gnx_filter_node_t nodes[2 * GNX_FILTER_MAX_TERMS];
+    uint32_t nb_nodes;
+    uint32_t nb_terms;
+    uint32_t root;
+} gnx_filter_t;
+
+/// Parse a filter expression
+/// \retval GNX_ERR_INVALID_ARGS Syntax error, or too many comparisons
+gnx_err_t gnx_filter_parse(
+    const char *text,
+    gnx_filter_t *filter);
+
+/// Generate a filtered hook's stub: the matching calls jump to the hook, the others to the springboard
+void gnx_filter_gen_stub(
+    const gnx_filter_t *filter,
+    uint8_t *stub,
+    const void *hook,
+    const void *springboard);
+
+//--------------------------------------------------------------------------
+// Code map (see code-map.c)
+//--------------------------------------------------------------------------
+
+/// Describe a code range placed by the workspace, if the code map is started
+/// \param kind Prefix of the name, ex: "gnx_springboard"
+/// \param func Function the code belongs to, named after its module; NULL for a shared thunk
+void gnx_code_map_add(
+    gnx_workspace_t *ws,
+    const void *start,
+    size_t size,
+    const char *kind,
+    const void *func);
+
+/// Note that a code range described by \ref gnx_code_map_add is freed
+void gnx_code_map_remove(
+    gnx_workspace_t *ws,
+    const void *start,
+    size_t size,
+    const char *kind,
+    const void *func);
+
+/// Stop the code map, if started (\ref gnx_close)
+void gnx_code_map_free(gnx_workspace_t *ws);
+
+//--------------------------------------------------------------------------
+// Overhead governor (see governor.c)
+//--------------------------------------------------------------------------
+
+/// Stop the overhead governor, if any (\ref gnx_close)
+void gnx_governor_free(gnx_workspace_t *ws);
+
+//--------------------------------------------------------------------------
+// Springboards reclamation (see reclaim.c)
+//--------------------------------------------------------------------------
+
+/// Thread taking part in the springboards reclamation (\ref gnx_thread_register)
+typedef struct __gnx_thread_rec_t
+{
+    gnx_workspace_t *ws;
+    volatile long epoch;        ///< Workspace epoch seen at the thread's last quiescent point
+    gnx_counters_block_t *counters; ///< Thread's counters (NULL until a counter hook is added)
+    GNX_SINGLY_LIST_ITEM_DEFINE;
+} gnx_thread_rec_t;
+
+/// Give the calling registered thread its own counters
+void gnx_counters_attach(gnx_thread_rec_t *rec);
+
+/// Fold the counts of a thread into the retired counts and free its counters
+/// \note The workspace lock must be held. The thread local slot is only cleared when called from the thread itself.
+void gnx_counters_detach(gnx_thread_rec_t *rec);
+
+/// Put an unhooked springboard in limbo until no thread may still run it
+/// \note The springboards blocks must be writable
+void gnx_sb_retire(
+    gnx_workspace_t *ws,
+    userhook_springboard_t *uh);
+
+/// Free the retired springboards all the threads are done with
+/// \note The springboards blocks must be writable
+void gnx_sb_reclaim(gnx_workspace_t *ws);
+
+/// Free the registered threads records (\ref gnx_close)
+void gnx_threads_free(gnx_workspace_t *ws);
+
+//--------------------------------------------------------------------------
+// Pending hooks (see pending.c)
+//--------------------------------------------------------------------------
+
+/// Stop the modules notifications and free the pending hooks (\ref gnx_close)
+void gnx_pending_hooks_free(gnx_workspace_t *ws);
+
+//--------------------------------------------------------------------------
+// Asynchronous commits (see commit-async.c)
+//--------------------------------------------------------------------------
+
+/// Asynchronous commits thread of a workspace (opaque)
+typedef struct __gnx_committer_t gnx_committer_t;
+
+/// Queue a transaction to the committer thread (started on the first call)
+gnx_err_t gnx_committer_push(
+    gnx_workspace_t *ws,
+    gnx_handle_t trans,
+    gnx_commit_callback_t callback,
+    void *ctx);
+
+/// Complete the pending asynchronous commits and stop the committer thread
+void gnx_committer_free(gnx_workspace_t *ws);
+
 #endif
\ No newline at end of file
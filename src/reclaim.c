@@ -0,0 +1,350 @@
+#include "private.h"
+#include <stdlib.h>
+
+//--------------------------------------------------------------------------
+// Deferred springboards reclamation (quiescent state based).
+//
+// Once a function is unhooked, other threads may still be running its springboard or be about
+// to return into it (a relocated call). So the springboard is retired to the workspace's limbo list,
+// tagged with the current epoch, and the epoch advances.
+// The threads running the hooks register themselves and report their quiescent points, where
+// they do not run any hooked code, by recording the current epoch (\ref gnx_thread_quiescent).
+// A retired springboard is done with the registered threads once every one of them recorded a later epoch.
+//
+// The other threads are not tracked: nothing proves that such a thread is done with a springboard, not
+// even a delay (it may be preempted in it, or blocked in the callee of a relocated call).
+// So the retired springboards, once past the registered threads' epochs, stay in limbo until a scan of all
+// the threads (their instruction pointer, their registers and their whole stack, while they are suspended)
+// finds no value pointing into them. The scan is conservative: a stale value only keeps a springboard one
+// more pass. Only when the caller promises that the registered threads are the only ones running the hooks
+// (\ref GNX_OPT_REGISTERED_THREADS_ONLY) are the springboards freed on the epochs alone.
+//--------------------------------------------------------------------------
+
+/// Retired springboard checked by a threads scan
+typedef struct __gnx_scanned_sb_t
+{
+    uintptr_t start;            ///< The whole chunk
+    uintptr_t end;
+    bool referenced;
+} gnx_scanned_sb_t;
+
+/// Threads scan of the retired springboards, sorted by address
+typedef struct __gnx_sb_scan_t
+{
+    gnx_scanned_sb_t *sbs;
+    size_t nb_sbs;
+    uintptr_t lo;               ///< Bounds of all the springboards: most values are rejected at once
+    uintptr_t hi;
+} gnx_sb_scan_t;
+
+#define GET_THREAD_REC \
+    gnx_thread_rec_t *rec = (gnx_thread_rec_t *)thread_handle
+
+//--------------------------------------------------------------------------
+void gnx_sb_retire(
+    gnx_workspace_t *ws,
+    userhook_springboard_t *uh)
+{
+    gnx_os_lock_acquire(&ws->lock);
+
+    uh->flags |= GNX_UHF_RETIRED;
+    uh->retire_epoch = ws->epoch;
+    uh->limbo_next = ws->limbo;
+    ws->limbo = uh;
+    ++ws->stats.nb_limbo;
+
+    // The threads reporting from now on are past this springboard
+    gnx_atomic_fetch_add(&ws->epoch, 1);
+
+    gnx_os_lock_release(&ws->lock);
+}
+
+//--------------------------------------------------------------------------
+static int compare_start(const void *a, const void *b)
+{
+    uintptr_t sa = ((const gnx_scanned_sb_t *)a)->start, sb = ((const gnx_scanned_sb_t *)b)->start;
+    return sa < sb ? -1 : (sa > sb ? 1 : 0);
+}
+
+//--------------------------------------------------------------------------
+// The springboard containing an address, if any
+static gnx_scanned_sb_t *find_scanned(
+    gnx_sb_scan_t *scan,
+    uintptr_t value)
+{
+    if (value < scan->lo || value >= scan->hi)
+        return NULL;
+
+    size_t lo = 0, hi = scan->nb_sbs;
+    while (lo < hi)
+    {
+        size_t mid = (lo + hi) / 2;
+        if (value < scan->sbs[mid].start)
+            hi = mid;
+        else if (value >= scan->sbs[mid].end)
+            lo = mid + 1;
+        else
+            return &scan->sbs[mid];
+    }
+    return NULL;
+}
+
+//--------------------------------------------------------------------------
+// Mark the springboards a thread may still run or return into (no allocation: the others are suspended)
+static void scan_thread(
+    void *ctx,
+    const uintptr_t *regs,
+    size_t nb_regs,
+    const uintptr_t *sp,
+    const uintptr_t *base)
+{
+    gnx_sb_scan_t *scan = (gnx_sb_scan_t *)ctx;
+
+    for (size_t i = 0; i < nb_regs; i++)
+    {
+        gnx_scanned_sb_t *sb = find_scanned(scan, regs[i]);
+        if (sb != NULL)
+            sb->referenced = true;
+    }
+
+    for (const uintptr_t *p = sp; p < base; p++)
+    {
+        gnx_scanned_sb_t *sb = find_scanned(scan, *p);
+        if (sb != NULL)
+            sb->referenced = true;
+    }
+}
+
+//--------------------------------------------------------------------------
+// Untracked threads: free the retired springboards of a list detached from the limbo that no thread
+// references anymore. The other ones go back to the limbo's tail (they are older than the ones left there).
+static void reclaim_scanned(
+    gnx_workspace_t *ws,
+    userhook_springboard_t *limbo)
+{
+    if (limbo == NULL)
+        return;
+
+    size_t nb_sbs = 0;
+    for (userhook_springboard_t *uh = limbo; uh != NULL; uh = uh->limbo_next)
+        ++nb_sbs;
+
+    gnx_sb_scan_t scan;
+    scan.nb_sbs = nb_sbs;
+    scan.sbs = (gnx_scanned_sb_t *)gnx_malloc(nb_sbs * sizeof(gnx_scanned_sb_t));
+    scan.lo = UINTPTR_MAX;
+    scan.hi = 0;
+
+    if (scan.sbs != NULL)
+    {
+        size_t i = 0;
+        for (userhook_springboard_t *uh = limbo; uh != NULL; uh = uh->limbo_next, i++)
+        {
+            scan.sbs[i].start = (uintptr_t)uh;
+            scan.sbs[i].end = scan.sbs[i].start + (GNX_HAS_FLAG(uh->flags, GNX_UHF_LEAF)
+                ? sizeof(userhook_leaf_springboard_t)
+                : sizeof(userhook_springboard_t));
+            scan.sbs[i].referenced = false;
+
+            if (scan.sbs[i].start < scan.lo)
+                scan.lo = scan.sbs[i].start;
+
+            if (scan.sbs[i].end > scan.hi)
+                scan.hi = scan.sbs[i].end;
+        }
+
+        qsort(scan.sbs, nb_sbs, sizeof(gnx_scanned_sb_t), compare_start);
+
+        // Some threads were not scanned: they may reference any springboard
+        if (gnx_os_scan_threads(scan_thread, &scan) != GNX_ERR_OK)
+        {
+            for (i = 0; i < nb_sbs; i++)
+                scan.sbs[i].referenced = true;
+        }
+    }
+
+    // Put back the referenced springboards after the ones retired meanwhile (more recent), in order
+    userhook_springboard_t *freed = NULL, **freed_tail = &freed;
+
+    gnx_os_lock_acquire(&ws->lock);
+
+    userhook_springboard_t **link = &ws->limbo;
+    while (*link != NULL)
+        link = &(*link)->limbo_next;
+
+    while (limbo != NULL)
+    {
+        userhook_springboard_t *uh = limbo;
+        limbo = uh->limbo_next;
+        uh->limbo_next = NULL;
+
+        gnx_scanned_sb_t *sb = scan.sbs != NULL ? find_scanned(&scan, (uintptr_t)uh) : NULL;
+        if (scan.sbs == NULL || sb->referenced)
+        {
+            *link = uh;
+            link = &uh->limbo_next;
+        }
+        else
+        {
+            --ws->stats.nb_limbo;
+            *freed_tail = uh;
+            freed_tail = &uh->limbo_next;
+        }
+    }
+
+    gnx_os_lock_release(&ws->lock);
+
+    if (scan.sbs != NULL)
+        gnx_mfree(scan.sbs);
+
+    while (freed != NULL)
+    {
+        userhook_springboard_t *next = freed->limbo_next;
+        gnx_sb_free(ws, freed);
+        freed = next;
+    }
+}
+
+//--------------------------------------------------------------------------
+void gnx_sb_reclaim(gnx_workspace_t *ws)
+{
+    gnx_os_lock_acquire(&ws->lock);
+
+    if (!ws->track_threads)
+    {
+        // Scan the whole limbo list: the springboards retired meanwhile wait for the next pass
+        userhook_springboard_t *limbo = ws->limbo;
+        ws->limbo = NULL;
+        gnx_os_lock_release(&ws->lock);
+
+        reclaim_scanned(ws, limbo);
+        return;
+    }
+
+    // The springboards retired before this epoch are not running anymore
+    long safe_epoch = ws->epoch;
+    for (gnx_singly_list_item_t *cur = ws->threads.next; cur != NULL; cur = cur->next)
+    {
+        gnx_thread_rec_t *rec = GNX_SINGLY_LIST_RECORD(
+            cur,
+            gnx_thread_rec_t);
+
+        if (rec->epoch < safe_epoch)
+            safe_epoch = rec->epoch;
+    }
+
+    // The limbo list is sorted by decreasing epoch: detach its safe tail
+    userhook_springboard_t **link = &ws->limbo;
+    while (*link != NULL && (*link)->retire_epoch >= safe_epoch)
+        link = &(*link)->limbo_next;
+
+    userhook_springboard_t *freed = *link;
+    *link = NULL;
+
+    // The unregistered threads (all of them once the last one unregistered) may still run the springboards
+    if (!ws->registered_threads_only)
+    {
+        gnx_os_lock_release(&ws->lock);
+
+        reclaim_scanned(ws, freed);
+        return;
+    }
+
+    for (userhook_springboard_t *uh = freed; uh != NULL; uh = uh->limbo_next)
+        --ws->stats.nb_limbo;
+
+    gnx_os_lock_release(&ws->lock);
+
+    while (freed != NULL)
+    {
+        userhook_springboard_t *next = freed->limbo_next;
+        gnx_sb_free(ws, freed);
+        freed = next;
+    }
+}
+
+//--------------------------------------------------------------------------
+void gnx_threads_free(gnx_workspace_t *ws)
+{
+    while (ws->threads.next != NULL)
+    {
+        gnx_thread_rec_t *rec = GNX_SINGLY_LIST_ITEM_POP(
+            &ws->threads,
+            gnx_thread_rec_t);
+
+        if (rec->counters != NULL)
+            gnx_counters_detach(rec);
+
+        GNX_FREE(rec);
+    }
+}
+
+//--------------------------------------------------------------------------
+gnx_err_t GANXO_API gnx_thread_register(
+    gnx_handle_t handle,
+    gnx_handle_t *thread_handle)
+{
+    GET_WORKSPACE;
+
+    if (thread_handle == NULL)
+        return GNX_ERR_INVALID_ARGS;
+
+    gnx_thread_rec_t *rec = GNX_ALLOC(gnx_thread_rec_t);
+    if (rec == NULL)
+        return GNX_ERR_NO_MEM;
+
+    rec->ws = ws;
+    rec->counters = NULL;
+
+    gnx_os_lock_acquire(&ws->lock);
+
+    // The counter hooks count in the thread's own block
+    if (ws->counters != NULL)
+        gnx_counters_attach(rec);
+
+    // Registering is a quiescent point
+    rec->epoch = ws->epoch;
+    ws->track_threads = true;
+    GNX_SINGLY_LIST_ITEM_PUSH(
+        &ws->threads,
+        rec);
+
+    gnx_os_lock_release(&ws->lock);
+
+    *thread_handle = (gnx_handle_t)rec;
+
+    return GNX_ERR_OK;
+}
+
+//--------------------------------------------------------------------------
+void GANXO_API gnx_thread_quiescent(gnx_handle_t thread_handle)
+{
+    GET_THREAD_REC;
+    rec->epoch = rec->ws->epoch;
+
+    // Counter hooks were added since the thread registered
+    if (rec->counters == NULL && rec->ws->counters != NULL)
+    {
+        gnx_os_lock_acquire(&rec->ws->lock);
+        gnx_counters_attach(rec);
+        gnx_os_lock_release(&rec->ws->lock);
+    }
+}
+
+//--------------------------------------------------------------------------
+void GANXO_API gnx_thread_unregister(gnx_handle_t thread_handle)
+{
+    GET_THREAD_REC;
+    gnx_workspace_t *ws = rec->ws;
+
+    gnx_os_lock_acquire(&ws->lock);
+    gnx_singly_list_remove(
+        &ws->threads,
+        &rec->slist_entry);
+
+    if (rec->counters != NULL)
+        gnx_counters_detach(rec);
+    gnx_os_lock_release(&ws->lock);
+
+    GNX_FREE(rec);
+}
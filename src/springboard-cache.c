@@ -0,0 +1,117 @@
+#include "private.h"
+
+//--------------------------------------------------------------------------
+// FNV-1a hashing
+#define GNX_FNV_OFFSET_BASIS 2166136261u
+#define GNX_FNV_PRIME        16777619u
+
+static inline uint32_t fnv1a_step(
+    uint32_t hash,
+    uint8_t b)
+{
+    return (hash ^ b) * GNX_FNV_PRIME;
+}
+
+//--------------------------------------------------------------------------
+gnx_sb_cache_t *gnx_sb_cache_create(void)
+{
+    gnx_sb_cache_t *cache = GNX_ALLOC(gnx_sb_cache_t);
+    if (cache != NULL)
+        memset(cache, 0, sizeof(*cache));
+
+    return cache;
+}
+
+//--------------------------------------------------------------------------
+void gnx_sb_cache_free(gnx_sb_cache_t *cache)
+{
+    for (size_t i = 0; i < GNX_SB_CACHE_BUCKETS; i++)
+    {
+        gnx_sb_cache_entry_t *entry = cache->buckets[i];
+        while (entry != NULL)
+        {
+            gnx_sb_cache_entry_t *next = entry->next;
+            GNX_FREE(entry);
+            entry = next;
+        }
+    }
+    GNX_FREE(cache);
+}
+
+//--------------------------------------------------------------------------
+// A template built from N bytes is valid for any function starting with the same N bytes:
+// decoding those bytes yields the same instructions. So we probe every possible copy length
+// while hashing the function bytes incrementally. The copy ends on the first instruction boundary
+// at or after min_size, so the probes stop before the end of the longest instruction crossing it.
+// Lookups may run concurrently with an insertion (see \ref gnx_sb_cache_insert).
+const gnx_sb_template_t *gnx_sb_cache_lookup(
+    gnx_sb_cache_t *cache,
+    const void *func,
+    size_t min_size)
+{
+    size_t max_size = min_size + GANXO_MAX_INSTR_SIZE - 1;
+    if (max_size > cache->max_backup_sz)
+        max_size = cache->max_backup_sz;
+
+    const uint8_t *p = (const uint8_t *)func;
+    uint32_t hash = GNX_FNV_OFFSET_BASIS;
+
+    for (size_t len = 0; len < max_size; len++)
+    {
+        hash = fnv1a_step(hash, p[len]);
+
+        // We copy at least the size of the patch
+        if (len + 1 < min_size)
+            continue;
+
+        for (gnx_sb_cache_entry_t *entry = cache->buckets[hash & (GNX_SB_CACHE_BUCKETS - 1)];
+             entry != NULL;
+             entry = entry->next)
+        {
+            if (    entry->hash == hash 
+                &&  entry->tpl.backup_sz == len + 1 
+                &&  memcmp(entry->prologue, p, len + 1) == 0)
+            {
+                return &entry->tpl;
+            }
+        }
+    }
+    return NULL;
+}
+
+//--------------------------------------------------------------------------
+void gnx_sb_cache_insert(
+    gnx_sb_cache_t *cache,
+    const void *func,
+    const gnx_sb_template_t *tpl)
+{
+    if (cache->nb_entries >= GNX_SB_CACHE_MAX_ENTRIES)
+        return;
+
+    gnx_sb_cache_entry_t *entry = GNX_ALLOC(gnx_sb_cache_entry_t);
+    if (entry == NULL)
+        return;
+
+    const uint8_t *p = (const uint8_t *)func;
+    uint32_t hash = GNX_FNV_OFFSET_BASIS;
+    for (size_t i = 0; i < tpl->backup_sz; i++)
+        hash = fnv1a_step(hash, p[i]);
+
+    entry->hash = hash;
+    entry->tpl = *tpl;
+    memcpy(
+        entry->prologue, 
+        func, 
+        tpl->backup_sz);
+
+    // A lookup that sees the entry but not the new size only misses it
+    if (tpl->backup_sz > cache->max_backup_sz)
+        cache->max_backup_sz = tpl->backup_sz;
+
+    // Publish the entry once it is complete: lookups do not take the workspace lock
+    gnx_sb_cache_entry_t **bucket = &cache->buckets[hash & (GNX_SB_CACHE_BUCKETS - 1)];
+    entry->next = *bucket;
+    gnx_atomic_xchg_ptr(bucket, entry);
+
+    ++cache->nb_entries;
+}
@@ -0,0 +1,252 @@
+#include "private.h"
+
+//--------------------------------------------------------------------------
+// Trace files.
+//
+// The trace hooks stubs append their records to the ring of the calling thread (see counters.c):
+// the thread is the only producer, it writes a record then advances the ring's head. The drain is
+// the only consumer: it copies the records between the tail and the head to the trace file, then
+// advances the tail. Neither side takes a lock against the other; the drains are serialized by the
+// workspace lock, which also keeps the registered threads (and their rings) alive meanwhile.
+//--------------------------------------------------------------------------
+
+/// Trace file being written
+typedef struct __gnx_trace_t
+{
+    void *mapping;                      ///< File mapping (\ref gnx_os_map_new_file)
+    gnx_trace_file_header_t *header;    ///< Mapped view: the header, then the records
+    uint64_t capacity;                  ///< Count of records the file can hold
+    uint32_t untracked_seen;            ///< Untracked calls already accounted for
+    uint32_t drain_period_ms;
+    void *drain_thread;                 ///< NULL without a periodic drain
+    void *wake;                         ///< Wakes up the drain thread to stop it
+    volatile bool stop;
+} gnx_trace_t;
+
+//--------------------------------------------------------------------------
+void gnx_trace_drain_ring(
+    gnx_counters_t *counters,
+    gnx_counters_block_t *block,
+    bool all)
+{
+    gnx_trace_t *trace = counters->trace;
+    gnx_trace_file_header_t *header = trace->header;
+
+    uint32_t dropped = block->trace_dropped;
+    header->nb_dropped += dropped - block->trace_dropped_seen;
+    block->trace_dropped_seen = dropped;
+
+    uint32_t tail = block->trace_tail;
+    uint32_t nb = block->trace_head - tail;
+    if (!all)
+        nb -= nb % GNX_TRACE_SEGMENT_RECORDS;
+
+    if (nb == 0)
+        return;
+
+    // The records that do not fit in the file are dropped
+    uint64_t room = trace->capacity - header->nb_records;
+    uint32_t nb_copied = nb > room ? (uint32_t)room : nb;
+    header->nb_dropped += nb - nb_copied;
+
+    gnx_trace_record_t *dst = (gnx_trace_record_t *)(header + 1) + header->nb_records;
+    uint32_t first = tail & (GNX_TRACE_RING_RECORDS - 1);
+    uint32_t nb_first = GNX_TRACE_RING_RECORDS - first;
+    if (nb_first > nb_copied)
+        nb_first = nb_copied;
+
+    // The ring wraps around
+    memcpy(dst, &block->trace_ring[first], nb_first * sizeof(gnx_trace_record_t));
+    memcpy(dst + nb_first, block->trace_ring, (nb_copied - nb_first) * sizeof(gnx_trace_record_t));
+    header->nb_records += nb_copied;
+
+    // Hand the slots back to the thread once copied
+    block->trace_tail = tail + nb;
+}
+
+//--------------------------------------------------------------------------
+// Drain the rings of all the registered threads
+static void drain_rings(
+    gnx_workspace_t *ws,
+    bool all)
+{
+    gnx_os_lock_acquire(&ws->lock);
+
+    gnx_counters_t *counters = ws->counters;
+    gnx_trace_t *trace = counters->trace;
+    if (trace != NULL)
+    {
+        for (gnx_singly_list_item_t *cur = ws->threads.next; cur != NULL; cur = cur->next)
+        {
+            gnx_thread_rec_t *rec = GNX_SINGLY_LIST_RECORD(
+                cur,
+                gnx_thread_rec_t);
+
+            if (rec->counters != NULL)
+                gnx_trace_drain_ring(counters, rec->counters, all);
+        }
+
+        uint32_t untracked = counters->trace_untracked;
+        trace->header->nb_dropped += untracked - trace->untracked_seen;
+        trace->untracked_seen = untracked;
+    }
+
+    gnx_os_lock_release(&ws->lock);
+}
+
+//--------------------------------------------------------------------------
+static void drain_thread_proc(void *ctx)
+{
+    gnx_workspace_t *ws = (gnx_workspace_t *)ctx;
+    gnx_trace_t *trace = ws->counters->trace;
+
+    while (!trace->stop)
+    {
+        gnx_os_event_wait_timeout(trace->wake, trace->drain_period_ms);
+        drain_rings(ws, false);
+    }
+}
+
+//--------------------------------------------------------------------------
+gnx_err_t GANXO_API gnx_trace_start(
+    gnx_handle_t handle,
+    const char *path,
+    size_t max_size,
+    uint32_t drain_period_ms)
+{
+    GET_WORKSPACE;
+
+    if (path == NULL || max_size < sizeof(gnx_trace_file_header_t) + GNX_TRACE_SEGMENT_RECORDS * sizeof(gnx_trace_record_t))
+        return GNX_ERR_INVALID_ARGS;
+
+    gnx_counters_t *counters = gnx_counters_get(ws);
+    if (counters == NULL)
+        return GNX_ERR_NOT_SUPPORTED;
+
+    if (counters->trace != NULL)
+        return GNX_ERR_INVALID_ARGS;
+
+    gnx_trace_t *trace = GNX_ALLOC(gnx_trace_t);
+    if (trace == NULL)
+        return GNX_ERR_NO_MEM;
+
+    memset(trace, 0, sizeof(*trace));
+
+    gnx_err_t err = GNX_ERR_OK;
+    do
+    {
+        trace->mapping = gnx_os_map_new_file(
+            path,
+            max_size,
+            (void **)&trace->header);
+
+        if (trace->mapping == NULL)
+        {
+            err = GNX_ERR_FAILED;
+            break;
+        }
+
+        trace->capacity = (max_size - sizeof(gnx_trace_file_header_t)) / sizeof(gnx_trace_record_t);
+        trace->header->magic = GNX_TRACE_FILE_MAGIC;
+        trace->header->record_size = sizeof(gnx_trace_record_t);
+        trace->header->nb_records = 0;
+        trace->header->nb_dropped = 0;
+
+        // The calls of the untracked threads made before are not accounted for
+        trace->untracked_seen = counters->trace_untracked;
+        trace->drain_period_ms = drain_period_ms;
+
+        gnx_os_lock_acquire(&ws->lock);
+        if (counters->trace != NULL)
+            err = GNX_ERR_INVALID_ARGS;
+        else
+            counters->trace = trace;
+        gnx_os_lock_release(&ws->lock);
+
+        if (err != GNX_ERR_OK || drain_period_ms == 0)
+            break;
+
+        trace->wake = gnx_os_event_create();
+        if (trace->wake != NULL)
+            trace->drain_thread = gnx_os_thread_create(drain_thread_proc, ws);
+
+        if (trace->drain_thread == NULL)
+            err = GNX_ERR_FAILED;
+    } while (false);
+
+    if (err != GNX_ERR_OK)
+    {
+        if (counters->trace == trace)
+        {
+            gnx_os_lock_acquire(&ws->lock);
+            counters->trace = NULL;
+            gnx_os_lock_release(&ws->lock);
+        }
+
+        if (trace->wake != NULL)
+            gnx_os_event_free(trace->wake);
+
+        if (trace->mapping != NULL)
+            gnx_os_unmap_new_file(trace->mapping, trace->header, 0);
+
+        GNX_FREE(trace);
+    }
+
+    return err;
+}
+
+//--------------------------------------------------------------------------
+gnx_err_t GANXO_API gnx_trace_drain(gnx_handle_t handle)
+{
+    GET_WORKSPACE;
+
+    if (ws->counters == NULL || ws->counters->trace == NULL)
+        return GNX_ERR_INVALID_ARGS;
+
+    drain_rings(ws, false);
+
+    return GNX_ERR_OK;
+}
+
+//--------------------------------------------------------------------------
+gnx_err_t GANXO_API gnx_trace_stop(gnx_handle_t handle)
+{
+    GET_WORKSPACE;
+
+    gnx_counters_t *counters = ws->counters;
+    if (counters == NULL || counters->trace == NULL)
+        return GNX_ERR_INVALID_ARGS;
+
+    gnx_trace_t *trace = counters->trace;
+    if (trace->drain_thread != NULL)
+    {
+        trace->stop = true;
+        gnx_os_event_set(trace->wake);
+        gnx_os_thread_join(trace->drain_thread);
+    }
+
+    if (trace->wake != NULL)
+        gnx_os_event_free(trace->wake);
+
+    drain_rings(ws, true);
+
+    gnx_os_lock_acquire(&ws->lock);
+    counters->trace = NULL;
+    gnx_os_lock_release(&ws->lock);
+
+    gnx_os_unmap_new_file(
+        trace->mapping,
+        trace->header,
+        sizeof(gnx_trace_file_header_t) + trace->header->nb_records * sizeof(gnx_trace_record_t));
+
+    GNX_FREE(trace);
+
+    return GNX_ERR_OK;
+}
+
+//--------------------------------------------------------------------------
+void gnx_trace_free(gnx_workspace_t *ws)
+{
+    if (ws->counters != NULL && ws->counters->trace != NULL)
+        gnx_trace_stop((gnx_handle_t)ws);
+}
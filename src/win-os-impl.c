@@ -0,0 +1,1255 @@
+//
+// This file is included by os.c and it contains the Windows operating system services
+//
+
+#pragma warning(push)
+#pragma warning(disable: 4820 4255)
+#include <windows.h>
+#include <tlhelp32.h>
+#pragma warning(pop)
+
+//--------------------------------------------------------------------------
+gnx_err_t gnx_os_map_file(
+    const char *path,
+    const void **view,
+    size_t *size)
+{
+    HANDLE hFile = CreateFileA(
+        path,
+        GENERIC_READ,
+        FILE_SHARE_READ,
+        NULL,
+        OPEN_EXISTING,
+        FILE_ATTRIBUTE_NORMAL,
+        NULL);
+    if (hFile == INVALID_HANDLE_VALUE)
+        return GNX_ERR_FAILED;
+
+    gnx_err_t err = GNX_ERR_FAILED;
+    do
+    {
+        LARGE_INTEGER file_size;
+        if (!GetFileSizeEx(hFile, &file_size) || file_size.QuadPart == 0 || file_size.QuadPart > (SIZE_T)-1)
+            break;
+
+        HANDLE hMap = CreateFileMappingA(
+            hFile,
+            NULL,
+            PAGE_READONLY,
+            0,
+            0,
+            NULL);
+        if (hMap == NULL)
+            break;
+
+        // The view keeps a reference to the mapping
+        *view = MapViewOfFile(
+            hMap,
+            FILE_MAP_READ,
+            0,
+            0,
+            0);
+        CloseHandle(hMap);
+
+        if (*view == NULL)
+            break;
+
+        *size = (size_t)file_size.QuadPart;
+        err = GNX_ERR_OK;
+    } while (false);
+
+    CloseHandle(hFile);
+    return err;
+}
+
+//--------------------------------------------------------------------------
+void gnx_os_unmap_file(const void *view)
+{
+    UnmapViewOfFile(view);
+}
+
+//--------------------------------------------------------------------------
+/// Writable file mapping (\ref gnx_os_map_new_file)
+typedef struct __win_new_file_map_t
+{
+    HANDLE hFile;
+    HANDLE hMap;
+} win_new_file_map_t;
+
+void *gnx_os_map_new_file(
+    const char *path,
+    size_t size,
+    void **view)
+{
+    win_new_file_map_t *fm = GNX_ALLOC(win_new_file_map_t);
+    if (fm == NULL)
+        return NULL;
+
+    fm->hMap = NULL;
+    fm->hFile = CreateFileA(
+        path,
+        GENERIC_READ | GENERIC_WRITE,
+        FILE_SHARE_READ,
+        NULL,
+        CREATE_ALWAYS,
+        FILE_ATTRIBUTE_NORMAL,
+        NULL);
+
+    do
+    {
+        if (fm->hFile == INVALID_HANDLE_VALUE)
+            break;
+
+        // The mapping extends the file to its size
+        fm->hMap = CreateFileMappingA(
+            fm->hFile,
+            NULL,
+            PAGE_READWRITE,
+            (DWORD)((uint64_t)size >> 32),
+            (DWORD)size,
+            NULL);
+        if (fm->hMap == NULL)
+            break;
+
+        *view = MapViewOfFile(
+            fm->hMap,
+            FILE_MAP_WRITE,
+            0,
+            0,
+            size);
+        if (*view == NULL)
+            break;
+
+        return fm;
+    } while (false);
+
+    if (fm->hMap != NULL)
+        CloseHandle(fm->hMap);
+
+    if (fm->hFile != INVALID_HANDLE_VALUE)
+        CloseHandle(fm->hFile);
+
+    GNX_FREE(fm);
+    return NULL;
+}
+
+//--------------------------------------------------------------------------
+void gnx_os_unmap_new_file(
+    void *mapping,
+    void *view,
+    uint64_t final_size)
+{
+    win_new_file_map_t *fm = (win_new_file_map_t *)mapping;
+
+    UnmapViewOfFile(view);
+    CloseHandle(fm->hMap);
+
+    // Drop the unused end of the file
+    LARGE_INTEGER pos;
+    pos.QuadPart = (LONGLONG)final_size;
+    if (SetFilePointerEx(fm->hFile, pos, NULL, FILE_BEGIN))
+        SetEndOfFile(fm->hFile);
+
+    CloseHandle(fm->hFile);
+    GNX_FREE(fm);
+}
+
+//--------------------------------------------------------------------------
+void *gnx_os_shm_create(
+    const char *name,
+    size_t size,
+    void **view)
+{
+    HANDLE hMap = CreateFileMappingA(
+        INVALID_HANDLE_VALUE,
+        NULL,
+        PAGE_READWRITE,
+        (DWORD)((uint64_t)size >> 32),
+        (DWORD)size,
+        name);
+    if (hMap == NULL)
+        return NULL;
+
+    // Another workspace (or process) already uses the name
+    if (GetLastError() == ERROR_ALREADY_EXISTS)
+    {
+        CloseHandle(hMap);
+        return NULL;
+    }
+
+    *view = MapViewOfFile(
+        hMap,
+        FILE_MAP_WRITE,
+        0,
+        0,
+        size);
+    if (*view == NULL)
+    {
+        CloseHandle(hMap);
+        return NULL;
+    }
+
+    return (void *)hMap;
+}
+
+//--------------------------------------------------------------------------
+void gnx_os_shm_free(
+    void *shm,
+    void *view)
+{
+    UnmapViewOfFile(view);
+    CloseHandle((HANDLE)shm);
+}
+
+//--------------------------------------------------------------------------
+void *gnx_os_file_create(const char *path)
+{
+    HANDLE hFile = CreateFileA(
+        path,
+        GENERIC_WRITE,
+        FILE_SHARE_READ,
+        NULL,
+        CREATE_ALWAYS,
+        FILE_ATTRIBUTE_NORMAL,
+        NULL);
+
+    return hFile == INVALID_HANDLE_VALUE ? NULL : (void *)hFile;
+}
+
+//--------------------------------------------------------------------------
+gnx_err_t gnx_os_file_write(
+    void *file,
+    const void *buf,
+    size_t size)
+{
+    const uint8_t *p = (const uint8_t *)buf;
+    while (size != 0)
+    {
+        DWORD chunk = size > 0x10000000 ? 0x10000000 : (DWORD)size, written;
+        if (!WriteFile((HANDLE)file, p, chunk, &written, NULL) || written == 0)
+            return GNX_ERR_FAILED;
+
+        p += written;
+        size -= written;
+    }
+    return GNX_ERR_OK;
+}
+
+//--------------------------------------------------------------------------
+void gnx_os_file_close(void *file)
+{
+    CloseHandle((HANDLE)file);
+}
+
+//--------------------------------------------------------------------------
+bool gnx_os_perf_map_path(
+    char *path,
+    size_t size)
+{
+    // The temporary directory ends with a backslash
+    DWORD len = GetTempPathA((DWORD)size, path);
+    if (len == 0 || len >= size)
+        return false;
+
+    int n = snprintf(path + len, size - len, "perf-%lu.map", (unsigned long)GetCurrentProcessId());
+    return n > 0 && (size_t)n < size - len;
+}
+
+//--------------------------------------------------------------------------
+// CodeView PDB 7.0 debug information
+typedef struct __win_cv_rsds_t
+{
+    DWORD signature; // 'RSDS'
+    GUID guid;
+    DWORD age;
+} win_cv_rsds_t;
+
+#define WIN_CV_RSDS_SIGNATURE 0x53445352
+
+//--------------------------------------------------------------------------
+// Fill the module information from the loaded image headers.
+// The build identifier is the PDB GUID and age (they change on every link).
+// When there is no debug information, the link time stamp, image size and checksum are used.
+static bool win_get_module_info(
+    HMODULE hmod,
+    gnx_os_module_t *mod)
+{
+    const uint8_t *base = (const uint8_t *)hmod;
+    const IMAGE_DOS_HEADER *dos = (const IMAGE_DOS_HEADER *)base;
+    if (dos->e_magic != IMAGE_DOS_SIGNATURE)
+        return false;
+
+    const IMAGE_NT_HEADERS *nt = (const IMAGE_NT_HEADERS *)(base + dos->e_lfanew);
+    if (nt->Signature != IMAGE_NT_SIGNATURE)
+        return false;
+
+    mod->base = base;
+    mod->size = nt->OptionalHeader.SizeOfImage;
+
+    memset(mod->id, 0, sizeof(mod->id));
+    memcpy(mod->id + 0, &nt->FileHeader.TimeDateStamp, sizeof(DWORD));
+    memcpy(mod->id + 4, &nt->OptionalHeader.SizeOfImage, sizeof(DWORD));
+    memcpy(mod->id + 8, &nt->OptionalHeader.CheckSum, sizeof(DWORD));
+
+    const IMAGE_DATA_DIRECTORY *dd = &nt->OptionalHeader.DataDirectory[IMAGE_DIRECTORY_ENTRY_DEBUG];
+    const IMAGE_DEBUG_DIRECTORY *dbg = (const IMAGE_DEBUG_DIRECTORY *)(base + dd->VirtualAddress);
+    for (size_t i = 0, c = dd->VirtualAddress == 0 ? 0 : dd->Size / sizeof(*dbg); i < c; i++, dbg++)
+    {
+        if (dbg->Type != IMAGE_DEBUG_TYPE_CODEVIEW || dbg->AddressOfRawData == 0 || dbg->SizeOfData < sizeof(win_cv_rsds_t))
+            continue;
+
+        const win_cv_rsds_t *rsds = (const win_cv_rsds_t *)(base + dbg->AddressOfRawData);
+        if (rsds->signature != WIN_CV_RSDS_SIGNATURE)
+            continue;
+
+        memcpy(mod->id, &rsds->guid, sizeof(GUID));
+        memcpy(mod->id + sizeof(GUID), &rsds->age, sizeof(DWORD));
+        break;
+    }
+
+    // Keep the base name only
+    char path[MAX_PATH];
+    DWORD len = GetModuleFileNameA(hmod, path, _countof(path));
+    if (len == 0 || len >= _countof(path))
+        return false;
+
+    const char *name = path + len;
+    while (name > path && name[-1] != '\\' && name[-1] != '/')
+        --name;
+
+    if (strlen(name) >= sizeof(mod->name))
+        return false;
+
+    strcpy_s(mod->name, sizeof(mod->name), name);
+    return true;
+}
+
+//--------------------------------------------------------------------------
+bool gnx_os_module_from_address(
+    const void *addr,
+    gnx_os_module_t *mod)
+{
+    HMODULE hmod;
+    if (!GetModuleHandleExA(
+            GET_MODULE_HANDLE_EX_FLAG_FROM_ADDRESS | GET_MODULE_HANDLE_EX_FLAG_UNCHANGED_REFCOUNT,
+            (LPCSTR)addr,
+            &hmod))
+    {
+        return false;
+    }
+    return win_get_module_info(hmod, mod);
+}
+
+//--------------------------------------------------------------------------
+bool gnx_os_module_from_name(
+    const char *name,
+    gnx_os_module_t *mod)
+{
+    HMODULE hmod = GetModuleHandleA(name);
+    if (hmod == NULL)
+        return false;
+
+    return win_get_module_info(hmod, mod);
+}
+
+//--------------------------------------------------------------------------
+// Walk the import descriptors of a loaded image for a function imported by name
+// \note The delay loaded imports are not walked
+static size_t win_find_import_slots(
+    const uint8_t *base,
+    const char *dll,
+    const char *symbol,
+    gnx_os_import_slot_proc_t proc,
+    void *ctx)
+{
+    const IMAGE_DOS_HEADER *dos = (const IMAGE_DOS_HEADER *)base;
+    if (dos->e_magic != IMAGE_DOS_SIGNATURE)
+        return 0;
+
+    const IMAGE_NT_HEADERS *nt = (const IMAGE_NT_HEADERS *)(base + dos->e_lfanew);
+    if (nt->Signature != IMAGE_NT_SIGNATURE)
+        return 0;
+
+    const IMAGE_DATA_DIRECTORY *dd = &nt->OptionalHeader.DataDirectory[IMAGE_DIRECTORY_ENTRY_IMPORT];
+    if (dd->VirtualAddress == 0)
+        return 0;
+
+    size_t nb_slots = 0;
+    for (const IMAGE_IMPORT_DESCRIPTOR *desc = (const IMAGE_IMPORT_DESCRIPTOR *)(base + dd->VirtualAddress);
+         desc->Name != 0;
+         desc++)
+    {
+        if (dll != NULL && _stricmp((const char *)(base + desc->Name), dll) != 0)
+            continue;
+
+        // The names are only in the lookup table (the bound address table is overwritten)
+        if (desc->OriginalFirstThunk == 0)
+            continue;
+
+        const IMAGE_THUNK_DATA *lookup = (const IMAGE_THUNK_DATA *)(base + desc->OriginalFirstThunk);
+        IMAGE_THUNK_DATA *iat = (IMAGE_THUNK_DATA *)(base + desc->FirstThunk);
+        for (; lookup->u1.AddressOfData != 0; lookup++, iat++)
+        {
+            if (IMAGE_SNAP_BY_ORDINAL(lookup->u1.Ordinal))
+                continue;
+
+            const IMAGE_IMPORT_BY_NAME *by_name = (const IMAGE_IMPORT_BY_NAME *)(base + lookup->u1.AddressOfData);
+            if (strcmp((const char *)by_name->Name, symbol) != 0)
+                continue;
+
+            proc(ctx, (void **)&iat->u1.Function);
+            ++nb_slots;
+        }
+    }
+
+    return nb_slots;
+}
+
+//--------------------------------------------------------------------------
+size_t gnx_os_find_import_slots(
+    const char *module,
+    const char *dll,
+    const char *symbol,
+    gnx_os_import_slot_proc_t proc,
+    void *ctx)
+{
+    if (module != NULL)
+    {
+        HMODULE hmod = GetModuleHandleA(module);
+        return hmod == NULL ? 0 : win_find_import_slots((const uint8_t *)hmod, dll, symbol, proc, ctx);
+    }
+
+    HANDLE hSnap = CreateToolhelp32Snapshot(TH32CS_SNAPMODULE, GetCurrentProcessId());
+    if (hSnap == INVALID_HANDLE_VALUE)
+        return 0;
+
+    size_t nb_slots = 0;
+
+    MODULEENTRY32 me;
+    me.dwSize = sizeof(me);
+    for (BOOL ok = Module32First(hSnap, &me); ok; ok = Module32Next(hSnap, &me))
+        nb_slots += win_find_import_slots((const uint8_t *)me.hModule, dll, symbol, proc, ctx);
+
+    CloseHandle(hSnap);
+    return nb_slots;
+}
+
+//--------------------------------------------------------------------------
+static int __cdecl win_compare_rvas(
+    const void *a,
+    const void *b)
+{
+    DWORD ra = *(const DWORD *)a;
+    DWORD rb = *(const DWORD *)b;
+
+    return ra < rb ? -1 : (ra > rb ? 1 : 0);
+}
+
+//--------------------------------------------------------------------------
+// Size of an exported function: up to the next exported function or the end of its section
+static size_t win_export_size(
+    const IMAGE_NT_HEADERS *nt,
+    const DWORD *sorted_rvas,
+    size_t nb_rvas,
+    DWORD rva)
+{
+    DWORD end = 0;
+    const IMAGE_SECTION_HEADER *sec = IMAGE_FIRST_SECTION(nt);
+    for (WORD i = 0; i < nt->FileHeader.NumberOfSections; i++, sec++)
+    {
+        if (rva >= sec->VirtualAddress && rva < sec->VirtualAddress + sec->Misc.VirtualSize)
+        {
+            end = sec->VirtualAddress + sec->Misc.VirtualSize;
+            break;
+        }
+    }
+
+    // The first exported function after this one
+    size_t lo = 0, hi = nb_rvas;
+    while (lo < hi)
+    {
+        size_t mid = (lo + hi) / 2;
+        if (sorted_rvas[mid] <= rva)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+
+    if (lo < nb_rvas && sorted_rvas[lo] < end)
+        end = sorted_rvas[lo];
+
+    return end > rva ? end - rva : 0;
+}
+
+//--------------------------------------------------------------------------
+gnx_err_t gnx_os_resolve_exports(
+    const char *module,
+    const char **names,
+    size_t nb_names,
+    void **addrs,
+    size_t *sizes)
+{
+    HMODULE hmod = GetModuleHandleA(module);
+    if (hmod == NULL)
+        return GNX_ERR_NOT_FOUND;
+
+    for (size_t i = 0; i < nb_names; i++)
+    {
+        addrs[i] = NULL;
+        if (sizes != NULL)
+            sizes[i] = 0;
+    }
+
+    const uint8_t *base = (const uint8_t *)hmod;
+    const IMAGE_DOS_HEADER *dos = (const IMAGE_DOS_HEADER *)base;
+    const IMAGE_NT_HEADERS *nt = (const IMAGE_NT_HEADERS *)(base + dos->e_lfanew);
+    if (dos->e_magic != IMAGE_DOS_SIGNATURE || nt->Signature != IMAGE_NT_SIGNATURE)
+        return GNX_ERR_FAILED;
+
+    const IMAGE_DATA_DIRECTORY *dd = &nt->OptionalHeader.DataDirectory[IMAGE_DIRECTORY_ENTRY_EXPORT];
+    if (dd->VirtualAddress == 0)
+        return nb_names == 0 ? GNX_ERR_OK : GNX_ERR_FAILED;
+
+    const IMAGE_EXPORT_DIRECTORY *exp = (const IMAGE_EXPORT_DIRECTORY *)(base + dd->VirtualAddress);
+    const DWORD *name_rvas = (const DWORD *)(base + exp->AddressOfNames);
+    const WORD *name_ords = (const WORD *)(base + exp->AddressOfNameOrdinals);
+    const DWORD *func_rvas = (const DWORD *)(base + exp->AddressOfFunctions);
+
+    // The functions sorted by address give their sizes (forwarders excluded)
+    DWORD *sorted_rvas = NULL;
+    size_t nb_rvas = 0;
+    if (sizes != NULL)
+    {
+        sorted_rvas = (DWORD *)gnx_malloc((exp->NumberOfFunctions + 1) * sizeof(DWORD));
+        if (sorted_rvas != NULL)
+        {
+            for (DWORD i = 0; i < exp->NumberOfFunctions; i++)
+            {
+                DWORD rva = func_rvas[i];
+                if (rva != 0 && (rva < dd->VirtualAddress || rva >= dd->VirtualAddress + dd->Size))
+                    sorted_rvas[nb_rvas++] = rva;
+            }
+
+            qsort(
+                sorted_rvas,
+                nb_rvas,
+                sizeof(DWORD),
+                win_compare_rvas);
+        }
+    }
+
+    size_t nb_found = 0;
+    for (size_t i = 0; i < nb_names; i++)
+    {
+        // The names table is sorted
+        size_t lo = 0, hi = exp->NumberOfNames;
+        while (lo < hi)
+        {
+            size_t mid = (lo + hi) / 2;
+            int cmp = strcmp(names[i], (const char *)(base + name_rvas[mid]));
+            if (cmp == 0)
+            {
+                lo = mid;
+                break;
+            }
+
+            if (cmp < 0)
+                hi = mid;
+            else
+                lo = mid + 1;
+        }
+
+        if (lo >= hi)
+            continue;
+
+        DWORD rva = func_rvas[name_ords[lo]];
+        if (rva >= dd->VirtualAddress && rva < dd->VirtualAddress + dd->Size)
+        {
+            // Forwarded to another module ("dll.function"): let the loader follow it
+            addrs[i] = (void *)GetProcAddress(hmod, names[i]);
+        }
+        else
+        {
+            addrs[i] = (void *)(base + rva);
+            if (sorted_rvas != NULL)
+                sizes[i] = win_export_size(nt, sorted_rvas, nb_rvas, rva);
+        }
+
+        if (addrs[i] != NULL)
+            ++nb_found;
+    }
+
+    gnx_mfree(sorted_rvas);
+
+    if (nb_found == nb_names)
+        return GNX_ERR_OK;
+
+    return nb_found == 0 ? GNX_ERR_NOT_FOUND : GNX_ERR_PARTIAL;
+}
+
+//--------------------------------------------------------------------------
+// Loader notifications (ntdll's LdrRegisterDllNotification)
+typedef struct __win_unicode_string_t
+{
+    USHORT Length;
+    USHORT MaximumLength;
+    PWSTR Buffer;
+} win_unicode_string_t;
+
+/// The loaded and unloaded notifications data are the same
+typedef struct __win_dll_notification_data_t
+{
+    ULONG Flags;
+    const win_unicode_string_t *FullDllName;
+    const win_unicode_string_t *BaseDllName;
+    PVOID DllBase;
+    ULONG SizeOfImage;
+} win_dll_notification_data_t;
+
+#define WIN_DLL_NOTIFICATION_REASON_LOADED   1
+#define WIN_DLL_NOTIFICATION_REASON_UNLOADED 2
+
+typedef VOID (CALLBACK *win_dll_notification_proc_t)(
+    ULONG reason,
+    const win_dll_notification_data_t *data,
+    PVOID ctx);
+
+typedef LONG (NTAPI *LdrRegisterDllNotification_proto)(
+    ULONG Flags,
+    win_dll_notification_proc_t proc,
+    PVOID ctx,
+    PVOID *cookie);
+
+typedef LONG (NTAPI *LdrUnregisterDllNotification_proto)(PVOID cookie);
+
+/// Modules notifications registration
+typedef struct __win_module_events_t
+{
+    gnx_os_module_event_proc_t proc;
+    void *ctx;
+    PVOID cookie;
+} win_module_events_t;
+
+//--------------------------------------------------------------------------
+static VOID CALLBACK win_dll_notification(
+    ULONG reason,
+    const win_dll_notification_data_t *data,
+    PVOID ctx)
+{
+    win_module_events_t *events = (win_module_events_t *)ctx;
+
+    gnx_os_module_t mod;
+    memset(&mod, 0, sizeof(mod));
+    mod.base = (const uint8_t *)data->DllBase;
+    mod.size = data->SizeOfImage;
+
+    int len = WideCharToMultiByte(
+        CP_ACP,
+        0,
+        data->BaseDllName->Buffer,
+        data->BaseDllName->Length / sizeof(WCHAR),
+        mod.name,
+        sizeof(mod.name) - 1,
+        NULL,
+        NULL);
+    if (len <= 0)
+        return;
+
+    mod.name[len] = '\0';
+
+    events->proc(
+        events->ctx,
+        reason == WIN_DLL_NOTIFICATION_REASON_LOADED,
+        &mod);
+}
+
+//--------------------------------------------------------------------------
+void *gnx_os_module_events_register(
+    gnx_os_module_event_proc_t proc,
+    void *ctx)
+{
+    LdrRegisterDllNotification_proto pLdrRegisterDllNotification = (LdrRegisterDllNotification_proto)GetProcAddress(
+        GetModuleHandleA("ntdll.dll"),
+        "LdrRegisterDllNotification");
+    if (pLdrRegisterDllNotification == NULL)
+        return NULL;
+
+    win_module_events_t *events = GNX_ALLOC(win_module_events_t);
+    if (events == NULL)
+        return NULL;
+
+    events->proc = proc;
+    events->ctx = ctx;
+    if (pLdrRegisterDllNotification(0, win_dll_notification, events, &events->cookie) < 0)
+    {
+        gnx_mfree(events);
+        return NULL;
+    }
+
+    return events;
+}
+
+//--------------------------------------------------------------------------
+void gnx_os_module_events_unregister(void *registration)
+{
+    win_module_events_t *events = (win_module_events_t *)registration;
+
+    LdrUnregisterDllNotification_proto pLdrUnregisterDllNotification = (LdrUnregisterDllNotification_proto)GetProcAddress(
+        GetModuleHandleA("ntdll.dll"),
+        "LdrUnregisterDllNotification");
+
+    // Unregistering takes the loader lock: no notification is running afterward
+    if (pLdrUnregisterDllNotification != NULL)
+        pLdrUnregisterDllNotification(events->cookie);
+
+    gnx_mfree(events);
+}
+
+//--------------------------------------------------------------------------
+// STATIC ASSERT: the opaque lock is a slim reader/writer lock
+typedef char __ASSERT_OS_LOCK_SIZE[sizeof(gnx_os_lock_t) == sizeof(SRWLOCK) ? 1 : -1];
+
+void gnx_os_lock_init(gnx_os_lock_t *lock)
+{
+    InitializeSRWLock((PSRWLOCK)lock);
+}
+
+void gnx_os_lock_acquire(gnx_os_lock_t *lock)
+{
+    AcquireSRWLockExclusive((PSRWLOCK)lock);
+}
+
+void gnx_os_lock_release(gnx_os_lock_t *lock)
+{
+    ReleaseSRWLockExclusive((PSRWLOCK)lock);
+}
+
+//--------------------------------------------------------------------------
+// Thread start parameters (freed by the thread)
+typedef struct __win_thread_start_t
+{
+    gnx_os_thread_proc_t proc;
+    void *ctx;
+} win_thread_start_t;
+
+static DWORD WINAPI win_thread_start(LPVOID param)
+{
+    win_thread_start_t start = *(win_thread_start_t *)param;
+    gnx_mfree(param);
+
+    start.proc(start.ctx);
+    return 0;
+}
+
+//--------------------------------------------------------------------------
+void *gnx_os_thread_create(
+    gnx_os_thread_proc_t proc,
+    void *ctx)
+{
+    win_thread_start_t *start = GNX_ALLOC(win_thread_start_t);
+    if (start == NULL)
+        return NULL;
+
+    start->proc = proc;
+    start->ctx = ctx;
+
+    HANDLE hThread = CreateThread(
+        NULL,
+        0,
+        win_thread_start,
+        start,
+        0,
+        NULL);
+    if (hThread == NULL)
+        gnx_mfree(start);
+
+    return (void *)hThread;
+}
+
+//--------------------------------------------------------------------------
+void gnx_os_thread_join(void *thread)
+{
+    WaitForSingleObject((HANDLE)thread, INFINITE);
+    CloseHandle((HANDLE)thread);
+}
+
+//--------------------------------------------------------------------------
+size_t gnx_os_cpu_count(void)
+{
+    SYSTEM_INFO si;
+    GetSystemInfo(&si);
+    return si.dwNumberOfProcessors == 0 ? 1 : si.dwNumberOfProcessors;
+}
+
+//--------------------------------------------------------------------------
+size_t gnx_os_page_size(void)
+{
+    SYSTEM_INFO si;
+    GetSystemInfo(&si);
+    return si.dwPageSize;
+}
+
+//--------------------------------------------------------------------------
+void *gnx_os_event_create(void)
+{
+    return (void *)CreateEventA(
+        NULL,
+        FALSE,
+        FALSE,
+        NULL);
+}
+
+//--------------------------------------------------------------------------
+void gnx_os_event_set(void *event)
+{
+    SetEvent((HANDLE)event);
+}
+
+//--------------------------------------------------------------------------
+void gnx_os_event_wait(void *event)
+{
+    WaitForSingleObject((HANDLE)event, INFINITE);
+}
+
+//--------------------------------------------------------------------------
+bool gnx_os_event_wait_timeout(
+    void *event,
+    uint32_t timeout_ms)
+{
+    return WaitForSingleObject((HANDLE)event, timeout_ms) == WAIT_OBJECT_0;
+}
+
+//--------------------------------------------------------------------------
+void gnx_os_event_free(void *event)
+{
+    CloseHandle((HANDLE)event);
+}
+
+//--------------------------------------------------------------------------
+// The first 64 slots live in the TEB (TlsSlots): the stubs read them with a single fs: load
+#if defined(_M_X64)
+    #define WIN_TEB_TLS_SLOTS 0x1480
+#else
+    #define WIN_TEB_TLS_SLOTS 0xE10
+#endif
+#define WIN_TEB_NB_TLS_SLOTS 64
+
+gnx_err_t gnx_os_tls_alloc(
+    uint32_t *index,
+    uint32_t *ofs)
+{
+    DWORD idx = TlsAlloc();
+    if (idx == TLS_OUT_OF_INDEXES)
+        return GNX_ERR_NO_MEM;
+
+    // An expansion slot is not directly addressable
+    if (idx >= WIN_TEB_NB_TLS_SLOTS)
+    {
+        TlsFree(idx);
+        return GNX_ERR_NO_MEM;
+    }
+
+    *index = (uint32_t)idx;
+    *ofs = (uint32_t)(WIN_TEB_TLS_SLOTS + idx * sizeof(void *));
+
+    return GNX_ERR_OK;
+}
+
+//--------------------------------------------------------------------------
+void gnx_os_tls_set(
+    uint32_t index,
+    void *value)
+{
+    TlsSetValue(index, value);
+}
+
+//--------------------------------------------------------------------------
+void *gnx_os_tls_get(uint32_t index)
+{
+    return TlsGetValue(index);
+}
+
+//--------------------------------------------------------------------------
+void gnx_os_tls_free(uint32_t index)
+{
+    TlsFree(index);
+}
+
+//--------------------------------------------------------------------------
+void gnx_os_yield(void)
+{
+    SwitchToThread();
+}
+
+//--------------------------------------------------------------------------
+void gnx_os_serialize_cpus(void)
+{
+    // Interrupts every processor running a thread of the process: the interrupt
+    // serializes their instruction stream
+    FlushProcessWriteBuffers();
+}
+
+//--------------------------------------------------------------------------
+static gnx_os_bp_handler_t win_bp_handler = NULL;
+
+static LONG CALLBACK win_bp_exception_handler(PEXCEPTION_POINTERS ep)
+{
+    if (ep->ExceptionRecord->ExceptionCode != EXCEPTION_BREAKPOINT)
+        return EXCEPTION_CONTINUE_SEARCH;
+
+    const void *resume;
+    if (!win_bp_handler(ep->ExceptionRecord->ExceptionAddress, &resume))
+        return EXCEPTION_CONTINUE_SEARCH;
+
+#if defined(GANXO_ARCH_X86)
+    ep->ContextRecord->Eip = (DWORD)(uintptr_t)resume;
+#elif defined(GANXO_ARCH_X64)
+    ep->ContextRecord->Rip = (DWORD64)(uintptr_t)resume;
+#endif
+    return EXCEPTION_CONTINUE_EXECUTION;
+}
+
+//--------------------------------------------------------------------------
+gnx_err_t gnx_os_bp_handler_install(gnx_os_bp_handler_t handler)
+{
+    // Already installed
+    if (gnx_atomic_cas_ptr(&win_bp_handler, handler, NULL) != NULL)
+        return GNX_ERR_OK;
+
+    // First in the handlers chain: the breakpoints must be handled before any other handler sees them
+    if (AddVectoredExceptionHandler(1, win_bp_exception_handler) == NULL)
+    {
+        win_bp_handler = NULL;
+        return GNX_ERR_FAILED;
+    }
+    return GNX_ERR_OK;
+}
+
+//--------------------------------------------------------------------------
+// Suspended thread
+typedef struct __win_stopped_thread_t
+{
+    HANDLE hThread;         ///< NULL if the thread exited before it could be suspended
+    DWORD tid;
+    bool suspended;
+} win_stopped_thread_t;
+
+// Open the threads of the snapshot that are not in the array yet (they keep running)
+// \return The count of newly opened threads
+static size_t win_open_new_threads(
+    win_stopped_thread_t *threads,
+    size_t *nb_threads,
+    size_t capacity,
+    bool *overflow)
+{
+    DWORD pid = GetCurrentProcessId(), self = GetCurrentThreadId();
+
+    HANDLE hSnap = CreateToolhelp32Snapshot(TH32CS_SNAPTHREAD, 0);
+    if (hSnap == INVALID_HANDLE_VALUE)
+    {
+        *overflow = true;
+        return 0;
+    }
+
+    size_t nb_new = 0;
+    THREADENTRY32 te;
+    te.dwSize = sizeof(te);
+    for (BOOL ok = Thread32First(hSnap, &te); ok; ok = Thread32Next(hSnap, &te))
+    {
+        if (te.th32OwnerProcessID != pid || te.th32ThreadID == self)
+            continue;
+
+        size_t i;
+        for (i = 0; i < *nb_threads && threads[i].tid != te.th32ThreadID; i++)
+            ;
+        if (i < *nb_threads)
+            continue;
+
+        if (*nb_threads == capacity)
+        {
+            *overflow = true;
+            break;
+        }
+
+        HANDLE hThread = OpenThread(
+            THREAD_SUSPEND_RESUME | THREAD_GET_CONTEXT | THREAD_SET_CONTEXT | THREAD_QUERY_INFORMATION,
+            FALSE,
+            te.th32ThreadID);
+
+        // The thread exited meanwhile
+        if (hThread == NULL)
+            continue;
+
+        threads[*nb_threads].hThread = hThread;
+        threads[*nb_threads].tid = te.th32ThreadID;
+        threads[*nb_threads].suspended = false;
+        ++*nb_threads;
+        ++nb_new;
+    }
+
+    CloseHandle(hSnap);
+    return nb_new;
+}
+
+//--------------------------------------------------------------------------
+// Allocate the threads array, before any thread is suspended (it may own the heap lock)
+static win_stopped_thread_t *win_alloc_threads(size_t *capacity)
+{
+    *capacity = 0;
+    DWORD pid = GetCurrentProcessId();
+    HANDLE hSnap = CreateToolhelp32Snapshot(TH32CS_SNAPTHREAD, 0);
+    if (hSnap == INVALID_HANDLE_VALUE)
+        return NULL;
+
+    THREADENTRY32 te;
+    te.dwSize = sizeof(te);
+    for (BOOL ok = Thread32First(hSnap, &te); ok; ok = Thread32Next(hSnap, &te))
+    {
+        if (te.th32OwnerProcessID == pid)
+            ++*capacity;
+    }
+    CloseHandle(hSnap);
+
+    // Some room for the threads created meanwhile
+    *capacity += 64;
+    return (win_stopped_thread_t *)gnx_malloc(*capacity * sizeof(win_stopped_thread_t));
+}
+
+// Suspend all the other threads: the ones already opened by win_open_new_threads, then the ones created meanwhile
+// \param overflow In/out: true if some threads may still be running
+static void win_suspend_all(
+    win_stopped_thread_t *threads,
+    size_t *nb_threads,
+    size_t capacity,
+    bool *overflow)
+{
+    // Running threads may create new ones: suspend until no new thread shows up
+    size_t first = 0;
+    for (;;)
+    {
+        for (size_t i = first; i < *nb_threads; i++)
+        {
+            win_stopped_thread_t *thread = &threads[i];
+            thread->suspended = SuspendThread(thread->hThread) != (DWORD)-1;
+            if (!thread->suspended)
+            {
+                CloseHandle(thread->hThread);
+                thread->hThread = NULL;
+            }
+        }
+
+        if (*overflow)
+            break;
+
+        first = *nb_threads;
+        if (win_open_new_threads(threads, nb_threads, capacity, overflow) == 0)
+            break;
+    }
+
+    // SuspendThread() is asynchronous: getting the context waits for the thread to be actually suspended
+    CONTEXT context;
+    for (size_t i = 0; i < *nb_threads; i++)
+    {
+        if (!threads[i].suspended)
+            continue;
+
+        context.ContextFlags = CONTEXT_CONTROL;
+        GetThreadContext(threads[i].hThread, &context);
+    }
+}
+
+// Resume the threads suspended by win_suspend_all
+static void win_resume_all(
+    win_stopped_thread_t *threads,
+    size_t nb_threads)
+{
+    for (size_t i = 0; i < nb_threads; i++)
+    {
+        if (threads[i].suspended)
+            ResumeThread(threads[i].hThread);
+    }
+}
+
+// Close the threads handles and free the array
+static void win_free_threads(
+    win_stopped_thread_t *threads,
+    size_t nb_threads)
+{
+    for (size_t i = 0; i < nb_threads; i++)
+    {
+        if (threads[i].hThread != NULL)
+            CloseHandle(threads[i].hThread);
+    }
+
+    gnx_mfree(threads);
+}
+
+//--------------------------------------------------------------------------
+gnx_err_t gnx_os_stop_threads(
+    gnx_os_stw_proc_t proc,
+    gnx_os_ip_fixup_t fixup,
+    void *ctx,
+    uint64_t *pause_ns)
+{
+    size_t capacity;
+    win_stopped_thread_t *threads = win_alloc_threads(&capacity);
+    if (threads == NULL)
+        return GNX_ERR_NO_MEM;
+
+    // The snapshot and the handles are taken while the threads still run: only the pause is timed
+    bool overflow = false;
+    size_t nb_threads = 0;
+    win_open_new_threads(threads, &nb_threads, capacity, &overflow);
+
+    LARGE_INTEGER freq, start, end;
+    QueryPerformanceFrequency(&freq);
+    QueryPerformanceCounter(&start);
+
+    win_suspend_all(threads, &nb_threads, capacity, &overflow);
+
+    CONTEXT context;
+    if (!overflow)
+    {
+        proc(ctx);
+
+        for (size_t i = 0; i < nb_threads; i++)
+        {
+            if (!threads[i].suspended)
+                continue;
+
+            context.ContextFlags = CONTEXT_CONTROL;
+            if (!GetThreadContext(threads[i].hThread, &context))
+                continue;
+
+#if defined(GANXO_ARCH_X86)
+            const void *ip = (const void *)(uintptr_t)context.Eip;
+            if (fixup(ctx, &ip))
+            {
+                context.Eip = (DWORD)(uintptr_t)ip;
+                SetThreadContext(threads[i].hThread, &context);
+            }
+#elif defined(GANXO_ARCH_X64)
+            const void *ip = (const void *)(uintptr_t)context.Rip;
+            if (fixup(ctx, &ip))
+            {
+                context.Rip = (DWORD64)(uintptr_t)ip;
+                SetThreadContext(threads[i].hThread, &context);
+            }
+#endif
+        }
+    }
+
+    win_resume_all(threads, nb_threads);
+
+    QueryPerformanceCounter(&end);
+    *pause_ns = (uint64_t)((end.QuadPart - start.QuadPart) * 1000000000.0 / freq.QuadPart);
+
+    win_free_threads(threads, nb_threads);
+
+    return overflow ? GNX_ERR_FAILED : GNX_ERR_OK;
+}
+
+//--------------------------------------------------------------------------
+// ntdll's NtQueryInformationThread(ThreadBasicInformation): the thread environment block of a thread
+typedef LONG (NTAPI *NtQueryInformationThread_proto)(
+    HANDLE ThreadHandle,
+    ULONG ThreadInformationClass,
+    PVOID ThreadInformation,
+    ULONG ThreadInformationLength,
+    PULONG ReturnLength);
+
+typedef struct __win_thread_basic_info_t
+{
+    LONG ExitStatus;
+    NT_TIB *TebBaseAddress;
+    HANDLE ClientId[2];
+    ULONG_PTR AffinityMask;
+    LONG Priority;
+    LONG BasePriority;
+} win_thread_basic_info_t;
+
+//--------------------------------------------------------------------------
+gnx_err_t gnx_os_scan_threads(
+    gnx_os_thread_scan_t scan,
+    void *ctx)
+{
+    // Resolved before suspending: GetProcAddress may take the loader lock
+    NtQueryInformationThread_proto pNtQueryInformationThread = (NtQueryInformationThread_proto)GetProcAddress(
+        GetModuleHandleA("ntdll.dll"),
+        "NtQueryInformationThread");
+
+    if (pNtQueryInformationThread == NULL)
+        return GNX_ERR_NOT_SUPPORTED;
+
+    // The calling thread's own stack, from here
+    uintptr_t here = 0;
+    scan(ctx, NULL, 0, &here, (const uintptr_t *)((NT_TIB *)NtCurrentTeb())->StackBase);
+
+    size_t capacity;
+    win_stopped_thread_t *threads = win_alloc_threads(&capacity);
+    if (threads == NULL)
+        return GNX_ERR_NO_MEM;
+
+    bool overflow = false;
+    size_t nb_threads = 0;
+    win_suspend_all(threads, &nb_threads, capacity, &overflow);
+
+    gnx_err_t err = overflow ? GNX_ERR_FAILED : GNX_ERR_OK;
+    for (size_t i = 0; i < nb_threads && err == GNX_ERR_OK; i++)
+    {
+        // The thread exited before it could be suspended
+        if (!threads[i].suspended)
+            continue;
+
+        CONTEXT context;
+        context.ContextFlags = CONTEXT_CONTROL | CONTEXT_INTEGER;
+
+        win_thread_basic_info_t info;
+        if (    !GetThreadContext(threads[i].hThread, &context)
+            ||  pNtQueryInformationThread(threads[i].hThread, 0, &info, sizeof(info), NULL) < 0)
+        {
+            // A thread that cannot be scanned may reference anything
+            err = GNX_ERR_FAILED;
+            break;
+        }
+
+        uintptr_t regs[16];
+        size_t nb_regs = 0;
+#if defined(GANXO_ARCH_X86)
+        regs[nb_regs++] = context.Eip;
+        regs[nb_regs++] = context.Eax;
+        regs[nb_regs++] = context.Ebx;
+        regs[nb_regs++] = context.Ecx;
+        regs[nb_regs++] = context.Edx;
+        regs[nb_regs++] = context.Esi;
+        regs[nb_regs++] = context.Edi;
+        regs[nb_regs++] = context.Ebp;
+        const uintptr_t *sp = (const uintptr_t *)(uintptr_t)context.Esp;
+#elif defined(GANXO_ARCH_X64)
+        regs[nb_regs++] = context.Rip;
+        regs[nb_regs++] = context.Rax;
+        regs[nb_regs++] = context.Rbx;
+        regs[nb_regs++] = context.Rcx;
+        regs[nb_regs++] = context.Rdx;
+        regs[nb_regs++] = context.Rsi;
+        regs[nb_regs++] = context.Rdi;
+        regs[nb_regs++] = context.Rbp;
+        regs[nb_regs++] = context.R8;
+        regs[nb_regs++] = context.R9;
+        regs[nb_regs++] = context.R10;
+        regs[nb_regs++] = context.R11;
+        regs[nb_regs++] = context.R12;
+        regs[nb_regs++] = context.R13;
+        regs[nb_regs++] = context.R14;
+        regs[nb_regs++] = context.R15;
+        const uintptr_t *sp = (const uintptr_t *)(uintptr_t)context.Rsp;
+#endif
+
+        scan(ctx, regs, nb_regs, sp, (const uintptr_t *)info.TebBaseAddress->StackBase);
+    }
+
+    win_resume_all(threads, nb_threads);
+    win_free_threads(threads, nb_threads);
+
+    return err;
+}
@@ -0,0 +1,569 @@
+#include "stdafx.h"
+
+#define RET_ON_ERR(err) if ((err) != GNX_ERR_OK) return (err);
+
+//-------------------------------------------------------------------------
+// Synthetic functions
+//-------------------------------------------------------------------------
+
+/// Count of synthetic functions to hook
+#define BENCH_NB_FUNCS 100000
+
+/// Synthetic function size (including the alignment bytes)
+#define BENCH_FUNC_SIZE 32
+
+static uint8_t *g_funcs = NULL;
+static void *g_pfuncs[BENCH_NB_FUNCS];
+static gnx_hook_desc_t g_descs[BENCH_NB_FUNCS];
+
+void my_func()
+{
+}
+
+//-------------------------------------------------------------------------
+// Generate the synthetic functions with a few different prologues:
+//
+// 55                   push ebp
+// 8B EC                mov ebp, esp
+// 83 EC xx             sub esp, xx         ; (a) or
+// 81 EC xx xx 00 00    sub esp, xxxx       ; (b) or
+// 33 C0                xor eax, eax        ; (c)
+// B8 xx xx xx xx       mov eax, i
+// 8B E5                mov esp, ebp
+// 5D                   pop ebp
+// C3                   ret
+// CC ...               alignment
+bool gen_functions()
+{
+    g_funcs = (uint8_t *)VirtualAlloc(
+        NULL,
+        BENCH_NB_FUNCS * BENCH_FUNC_SIZE,
+        MEM_COMMIT | MEM_RESERVE,
+        PAGE_EXECUTE_READWRITE);
+    if (g_funcs == NULL)
+        return false;
+
+    memset(g_funcs, 0xCC, BENCH_NB_FUNCS * BENCH_FUNC_SIZE);
+
+    for (uint32_t i = 0; i < BENCH_NB_FUNCS; i++)
+    {
+        uint8_t *p = g_funcs + i * BENCH_FUNC_SIZE;
+        g_pfuncs[i] = p;
+
+        *p++ = 0x55;
+        *p++ = 0x8B; *p++ = 0xEC;
+        switch (i % 3)
+        {
+            case 0:
+                *p++ = 0x83; *p++ = 0xEC; *p++ = (uint8_t)(i * 4);
+                break;
+            case 1:
+                *p++ = 0x81; *p++ = 0xEC; *(uint32_t *)p = (i & 0xFFFF) * 4; p += 4;
+                break;
+            case 2:
+                *p++ = 0x33; *p++ = 0xC0;
+                break;
+        }
+        *p++ = 0xB8; *(uint32_t *)p = i; p += 4;
+        *p++ = 0x8B; *p++ = 0xE5;
+        *p++ = 0x5D;
+        *p++ = 0xC3;
+    }
+    return true;
+}
+
+//-------------------------------------------------------------------------
+// Hook all the synthetic functions at once and return the elapsed time in milliseconds
+gnx_err_t bench_add_hooks(
+    size_t nb_workers,
+    bool cache,
+    double *elapsed_ms)
+{
+    gnx_handle_t gnx;
+    gnx_err_t err = gnx_open(&gnx);
+    RET_ON_ERR(err);
+
+    gnx_set_option(gnx, GNX_OPT_WORKER_THREADS, nb_workers);
+    gnx_set_option(gnx, GNX_OPT_SPRINGBOARD_CACHE, cache ? 1 : 0);
+
+    for (size_t i = 0; i < BENCH_NB_FUNCS; i++)
+    {
+        g_pfuncs[i] = g_funcs + i * BENCH_FUNC_SIZE;
+        g_descs[i].psrc = &g_pfuncs[i];
+        g_descs[i].hook = my_func;
+        g_descs[i].func_size = BENCH_FUNC_SIZE;
+    }
+
+    gnx_handle_t transaction;
+    err = gnx_transaction_begin(gnx, &transaction);
+    if (err == GNX_ERR_OK)
+    {
+        LARGE_INTEGER freq, start, end;
+        QueryPerformanceFrequency(&freq);
+        QueryPerformanceCounter(&start);
+
+        err = gnx_transaction_add_hooks(
+            transaction,
+            g_descs,
+            BENCH_NB_FUNCS,
+            NULL);
+
+        QueryPerformanceCounter(&end);
+        *elapsed_ms = (double)(end.QuadPart - start.QuadPart) * 1000.0 / (double)freq.QuadPart;
+
+        // Every synthetic function now points to its springboard
+        for (size_t i = 0; err == GNX_ERR_OK && i < BENCH_NB_FUNCS; i++)
+        {
+            if (g_pfuncs[i] == g_funcs + i * BENCH_FUNC_SIZE)
+                err = GNX_ERR_FAILED;
+        }
+
+        // Nothing needs to be patched
+        gnx_transaction_abort(transaction);
+    }
+
+    gnx_close(gnx);
+    return err;
+}
+
+//-------------------------------------------------------------------------
+// Report the bulk hooks 1 -> N threads speedup
+gnx_err_t bench_bulk_hooks()
+{
+    SYSTEM_INFO si;
+    GetSystemInfo(&si);
+    size_t nb_cpus = si.dwNumberOfProcessors;
+
+    printf("Bulk hooks: %u functions, %u processors\n", BENCH_NB_FUNCS, (unsigned)nb_cpus);
+
+    for (int cache = 1; cache >= 0; cache--)
+    {
+        double base_ms = 0;
+        for (size_t nb_workers = 1; nb_workers <= nb_cpus; nb_workers *= 2)
+        {
+            double ms;
+            gnx_err_t err = bench_add_hooks(nb_workers, cache != 0, &ms);
+            RET_ON_ERR(err);
+
+            if (nb_workers == 1)
+                base_ms = ms;
+
+            printf(
+                "  cache %-3s  %2u thread(s): %8.2f ms  speedup x%.2f\n",
+                cache ? "on" : "off",
+                (unsigned)nb_workers,
+                ms,
+                base_ms / ms);
+
+            // Make sure the last measure uses all the processors
+            if (nb_workers < nb_cpus && nb_workers * 2 > nb_cpus)
+                nb_workers = nb_cpus / 2;
+        }
+    }
+    return GNX_ERR_OK;
+}
+
+//-------------------------------------------------------------------------
+// Concurrent transaction building
+//-------------------------------------------------------------------------
+
+struct add_thread_ctx_t
+{
+    gnx_handle_t transaction;
+    HANDLE start;
+    size_t first, last;
+    gnx_err_t err;
+};
+
+static DWORD WINAPI add_hooks_thread(LPVOID param)
+{
+    add_thread_ctx_t *ctx = (add_thread_ctx_t *)param;
+
+    // All the threads start together to contend on the transaction
+    WaitForSingleObject(ctx->start, INFINITE);
+
+    ctx->err = GNX_ERR_OK;
+    for (size_t i = ctx->first; i < ctx->last && ctx->err == GNX_ERR_OK; i++)
+    {
+        ctx->err = gnx_transaction_add_hook(
+            ctx->transaction,
+            &g_pfuncs[i],
+            my_func);
+    }
+    return 0;
+}
+
+//-------------------------------------------------------------------------
+// Hook all the synthetic functions from several threads sharing the same transaction
+gnx_err_t bench_concurrent_add(
+    size_t nb_threads,
+    double *elapsed_ms)
+{
+    gnx_handle_t gnx;
+    gnx_err_t err = gnx_open(&gnx);
+    RET_ON_ERR(err);
+
+    for (size_t i = 0; i < BENCH_NB_FUNCS; i++)
+        g_pfuncs[i] = g_funcs + i * BENCH_FUNC_SIZE;
+
+    gnx_handle_t transaction;
+    err = gnx_transaction_begin(gnx, &transaction);
+    if (err == GNX_ERR_OK)
+    {
+        add_thread_ctx_t ctxs[64];
+        HANDLE threads[64];
+        HANDLE start = CreateEvent(NULL, TRUE, FALSE, NULL);
+
+        size_t per_thread = BENCH_NB_FUNCS / nb_threads;
+        for (size_t t = 0; t < nb_threads; t++)
+        {
+            ctxs[t].transaction = transaction;
+            ctxs[t].start = start;
+            ctxs[t].first = t * per_thread;
+            ctxs[t].last = t == nb_threads - 1 ? BENCH_NB_FUNCS : ctxs[t].first + per_thread;
+            threads[t] = CreateThread(NULL, 0, add_hooks_thread, &ctxs[t], 0, NULL);
+        }
+
+        LARGE_INTEGER freq, begin, end;
+        QueryPerformanceFrequency(&freq);
+        QueryPerformanceCounter(&begin);
+
+        SetEvent(start);
+        WaitForMultipleObjects((DWORD)nb_threads, threads, TRUE, INFINITE);
+
+        QueryPerformanceCounter(&end);
+        *elapsed_ms = (double)(end.QuadPart - begin.QuadPart) * 1000.0 / (double)freq.QuadPart;
+
+        for (size_t t = 0; t < nb_threads; t++)
+        {
+            CloseHandle(threads[t]);
+            if (ctxs[t].err != GNX_ERR_OK)
+                err = ctxs[t].err;
+        }
+        CloseHandle(start);
+
+        // Every synthetic function now points to its springboard
+        for (size_t i = 0; err == GNX_ERR_OK && i < BENCH_NB_FUNCS; i++)
+        {
+            if (g_pfuncs[i] == g_funcs + i * BENCH_FUNC_SIZE)
+                err = GNX_ERR_FAILED;
+        }
+
+        gnx_transaction_abort(transaction);
+    }
+
+    gnx_close(gnx);
+    return err;
+}
+
+//-------------------------------------------------------------------------
+// Report the hooking throughput when 1 -> N threads share a transaction
+gnx_err_t bench_contention()
+{
+    SYSTEM_INFO si;
+    GetSystemInfo(&si);
+    size_t nb_cpus = si.dwNumberOfProcessors > 64 ? 64 : si.dwNumberOfProcessors;
+
+    printf("Concurrent transaction: %u functions\n", BENCH_NB_FUNCS);
+
+    double base_ms = 0;
+    for (size_t nb_threads = 1; nb_threads <= nb_cpus; nb_threads *= 2)
+    {
+        double ms;
+        gnx_err_t err = bench_concurrent_add(nb_threads, &ms);
+        RET_ON_ERR(err);
+
+        if (nb_threads == 1)
+            base_ms = ms;
+
+        printf(
+            "  %2u thread(s): %8.2f ms  %8.0f hooks/ms  speedup x%.2f\n",
+            (unsigned)nb_threads,
+            ms,
+            BENCH_NB_FUNCS / ms,
+            base_ms / ms);
+    }
+    return GNX_ERR_OK;
+}
+
+//-------------------------------------------------------------------------
+// Stop-the-world commit pause
+//-------------------------------------------------------------------------
+
+/// Count of hooks committed at once
+#define BENCH_NB_COMMIT_HOOKS 1000
+
+/// Pause goal for a BENCH_NB_COMMIT_HOOKS hooks commit
+#define BENCH_PAUSE_GOAL_US 100
+
+//-------------------------------------------------------------------------
+// Report how long the other threads are suspended to commit 1000 hooks
+gnx_err_t bench_commit_pause()
+{
+    gnx_handle_t gnx;
+    gnx_err_t err = gnx_open(&gnx);
+    RET_ON_ERR(err);
+
+    gnx_set_option(gnx, GNX_OPT_COMMIT_MODE, GNX_COMMIT_STOP_THREADS);
+
+    for (size_t i = 0; i < BENCH_NB_COMMIT_HOOKS; i++)
+        g_pfuncs[i] = g_funcs + i * BENCH_FUNC_SIZE;
+
+    gnx_stats_t stats;
+    stats.cb = sizeof(stats);
+
+    for (int op = 0; op < 2 && err == GNX_ERR_OK; op++)
+    {
+        gnx_handle_t transaction;
+        err = gnx_transaction_begin(gnx, &transaction);
+        if (err != GNX_ERR_OK)
+            break;
+
+        for (size_t i = 0; i < BENCH_NB_COMMIT_HOOKS && err == GNX_ERR_OK; i++)
+        {
+            err = op == 0 
+                ? gnx_transaction_add_hook(transaction, &g_pfuncs[i], my_func)
+                : gnx_transaction_remove_hook(transaction, &g_pfuncs[i]);
+        }
+
+        if (err != GNX_ERR_OK)
+        {
+            gnx_transaction_abort(transaction);
+            break;
+        }
+
+        err = gnx_transaction_commit(transaction);
+        if (err == GNX_ERR_OK)
+            err = gnx_get_stats(gnx, &stats);
+
+        if (err == GNX_ERR_OK)
+        {
+            printf(
+                "Stop threads commit of %u %s: paused %u us (goal %u us)\n",
+                BENCH_NB_COMMIT_HOOKS,
+                op == 0 ? "hooks" : "unhooks",
+                (unsigned)stats.last_pause_us,
+                BENCH_PAUSE_GOAL_US);
+        }
+    }
+
+    gnx_close(gnx);
+    return err;
+}
+
+//-------------------------------------------------------------------------
+// Unhook all when closing
+//-------------------------------------------------------------------------
+
+/// Count of hooks installed when closing the workspace
+#define BENCH_NB_CLOSE_HOOKS 50000
+
+//-------------------------------------------------------------------------
+// Report how long closing a workspace takes to unhook 50k hooks
+gnx_err_t bench_close_unhook()
+{
+    gnx_handle_t gnx;
+    gnx_err_t err = gnx_open(&gnx);
+    RET_ON_ERR(err);
+
+    for (size_t i = 0; i < BENCH_NB_CLOSE_HOOKS; i++)
+    {
+        g_pfuncs[i] = g_funcs + i * BENCH_FUNC_SIZE;
+        g_descs[i].psrc = &g_pfuncs[i];
+        g_descs[i].hook = my_func;
+        g_descs[i].func_size = BENCH_FUNC_SIZE;
+    }
+
+    gnx_handle_t transaction;
+    err = gnx_transaction_begin(gnx, &transaction);
+    if (err == GNX_ERR_OK)
+    {
+        err = gnx_transaction_add_hooks(
+            transaction,
+            g_descs,
+            BENCH_NB_CLOSE_HOOKS,
+            NULL);
+
+        if (err == GNX_ERR_OK)
+            err = gnx_transaction_commit(transaction);
+        else
+            gnx_transaction_abort(transaction);
+    }
+
+    if (err != GNX_ERR_OK)
+    {
+        gnx_close(gnx);
+        return err;
+    }
+
+    LARGE_INTEGER freq, start, end;
+    QueryPerformanceFrequency(&freq);
+    QueryPerformanceCounter(&start);
+
+    err = gnx_close_ex(gnx, GNX_CLOSE_UNHOOK);
+
+    QueryPerformanceCounter(&end);
+
+    // Every synthetic function is restored
+    for (size_t i = 0; err == GNX_ERR_OK && i < BENCH_NB_CLOSE_HOOKS; i++)
+    {
+        if (g_pfuncs[i] != g_funcs + i * BENCH_FUNC_SIZE || g_funcs[i * BENCH_FUNC_SIZE] != 0x55)
+            err = GNX_ERR_FAILED;
+    }
+
+    if (err == GNX_ERR_OK)
+    {
+        printf(
+            "Close and unhook %u hooks: %.2f ms\n",
+            BENCH_NB_CLOSE_HOOKS,
+            (double)(end.QuadPart - start.QuadPart) * 1000.0 / (double)freq.QuadPart);
+    }
+
+    return err;
+}
+
+//-------------------------------------------------------------------------
+// Filtered hook overhead
+//-------------------------------------------------------------------------
+
+/// Calls of the hooked function per measure
+#define BENCH_NB_FILTERED_CALLS 10000000
+
+typedef int (__cdecl *bench_target_proto)(int handle, int size);
+
+__declspec(noinline) int __cdecl bench_target(int handle, int size)
+{
+    return handle + size;
+}
+
+static bench_target_proto g_orig_target = bench_target;
+static volatile long g_target_hook_calls = 0;
+
+// A typical hook: it only cares about one handle, then calls the original function
+int __cdecl bench_target_hook(int handle, int size)
+{
+    if (handle == 1234)
+        ++g_target_hook_calls;
+
+    return g_orig_target(handle, size);
+}
+
+//-------------------------------------------------------------------------
+// Call the function and return the time per call in nanoseconds
+static double measure_target_calls()
+{
+    volatile bench_target_proto p_target = bench_target;
+
+    LARGE_INTEGER freq, start, end;
+    QueryPerformanceFrequency(&freq);
+    QueryPerformanceCounter(&start);
+
+    for (int i = 0; i < BENCH_NB_FILTERED_CALLS; i++)
+        p_target(i & 0xFF, i);
+
+    QueryPerformanceCounter(&end);
+
+    return (double)(end.QuadPart - start.QuadPart) * 1000000000.0 / (double)freq.QuadPart / BENCH_NB_FILTERED_CALLS;
+}
+
+//-------------------------------------------------------------------------
+// Hook the function (filtered or not), measure its calls, then unhook it
+static gnx_err_t measure_hooked_calls(
+    gnx_handle_t gnx,
+    const char *filter,
+    double *ns_per_call)
+{
+    gnx_handle_t transaction;
+    gnx_err_t err = gnx_transaction_begin(gnx, &transaction);
+    RET_ON_ERR(err);
+
+    err = filter != NULL
+        ? gnx_transaction_add_filtered_hook(transaction, (void **)&g_orig_target, bench_target_hook, filter)
+        : gnx_transaction_add_hook(transaction, (void **)&g_orig_target, bench_target_hook);
+
+    if (err != GNX_ERR_OK)
+    {
+        gnx_transaction_abort(transaction);
+        return err;
+    }
+
+    err = gnx_transaction_commit(transaction);
+    RET_ON_ERR(err);
+
+    *ns_per_call = measure_target_calls();
+
+    err = gnx_transaction_begin(gnx, &transaction);
+    RET_ON_ERR(err);
+
+    err = gnx_transaction_remove_hook(transaction, (void **)&g_orig_target);
+    if (err != GNX_ERR_OK)
+    {
+        gnx_transaction_abort(transaction);
+        return err;
+    }
+
+    return gnx_transaction_commit(transaction);
+}
+
+//-------------------------------------------------------------------------
+// Report the cost of a call that the hook does not care about, with and without a filter
+gnx_err_t bench_filtered_hook()
+{
+    gnx_handle_t gnx;
+    gnx_err_t err = gnx_open(&gnx);
+    RET_ON_ERR(err);
+
+    double unhooked_ns = measure_target_calls();
+    double hooked_ns = 0, filtered_ns = 0;
+
+    err = measure_hooked_calls(gnx, NULL, &hooked_ns);
+    if (err == GNX_ERR_OK)
+        err = measure_hooked_calls(gnx, "arg0 == 1234", &filtered_ns);
+
+    if (err == GNX_ERR_OK)
+    {
+        printf(
+            "Non matching call: unhooked %.2f ns, hooked %.2f ns, filtered hook %.2f ns\n",
+            unhooked_ns,
+            hooked_ns,
+            filtered_ns);
+    }
+
+    gnx_close(gnx);
+    return err;
+}
+
+//-------------------------------------------------------------------------
+int main()
+{
+    if (gnx_init() != GNX_ERR_OK)
+    {
+        printf("Failed to initialize!\n");
+        return -1;
+    }
+
+    if (!gen_functions())
+    {
+        printf("Failed to generate the synthetic functions\n");
+        return -1;
+    }
+
+    gnx_err_t err = bench_bulk_hooks();
+    RET_ON_ERR(err);
+
+    err = bench_contention();
+    RET_ON_ERR(err);
+
+    err = bench_commit_pause();
+    RET_ON_ERR(err);
+
+    err = bench_close_unhook();
+    RET_ON_ERR(err);
+
+    err = bench_filtered_hook();
+    RET_ON_ERR(err);
+
+    VirtualFree(g_funcs, 0, MEM_RELEASE);
+
+    return 0;
+}
@@ -1,332 +1,3016 @@
-#include "stdafx.h"
-
-#define RET_ON_ERR(err) if ((err) != GNX_ERR_OK) return (err);
-
-//--------------------------------------------------------------------------
-typedef VOID(WINAPI *Sleep_proto)(DWORD);
-Sleep_proto orig_Sleep[2];
-
-static DWORD g_SleepCount = 0;
-VOID WINAPI My_Sleep(DWORD dwMilliSecs)
-{
-    ++g_SleepCount;
-    orig_Sleep[0](10);
-}
-
-VOID WINAPI My_Sleep2(DWORD dwMilliSecs)
-{
-    ++g_SleepCount;
-    orig_Sleep[1](10);
-}
-
-//-------------------------------------------------------------------------
-typedef BOOL (WINAPI *DeleteFileA_proto)(LPCSTR lpFileName);
-
-DeleteFileA_proto orig_DeleteFileA = DeleteFileA;
-
-BOOL WINAPI my_DeleteFileA(LPCSTR lpFileName)
-{
-    return TRUE;
-}
-
-//-------------------------------------------------------------------------
-typedef HANDLE(WINAPI *CreateFileA_proto)(
-    LPCSTR lpFileName,
-    DWORD dwDesiredAccess,
-    DWORD dwShareMode,
-    LPSECURITY_ATTRIBUTES lpSecurityAttributes,
-    DWORD dwCreationDisposition,
-    DWORD dwFlagsAndAttributes,
-    HANDLE hTemplateFile);
-
-CreateFileA_proto orig_CreateFileA = CreateFileA;
-HANDLE WINAPI my_CreateFileA(
-    LPCSTR lpFileName,
-    DWORD dwDesiredAccess,
-    DWORD dwShareMode,
-    LPSECURITY_ATTRIBUTES lpSecurityAttributes,
-    DWORD dwCreationDisposition,
-    DWORD dwFlagsAndAttributes,
-    HANDLE hTemplateFile)
-{
-    //printf("Opening('%s')\n", lpFileName);
-    return INVALID_HANDLE_VALUE;
-}
-
-char g_szExeName[MAX_PATH];
-
-//-------------------------------------------------------------------------
-bool check_open_self()
-{
-    HANDLE hFile = CreateFileA(g_szExeName, GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE, NULL, OPEN_EXISTING, 0, NULL);
-    if (hFile != INVALID_HANDLE_VALUE)
-    {
-        CloseHandle(hFile);
-        return true;
-    }
-    return false;
-}
-
-//-------------------------------------------------------------------------
-gnx_err_t test_hook_unhook_complete(gnx_handle_t gnx)
-{
-    auto c_orig_CreateFileA = ::CreateFileA;
-
-    gnx_err_t err;
-
-    gnx_handle_t transaction;
-    err = gnx_transaction_begin(gnx, &transaction);
-    RET_ON_ERR(err);
-
-    // Hook
-    err = gnx_transaction_add_hook(
-        transaction,
-        (void **)&orig_CreateFileA,
-        my_CreateFileA);
-    RET_ON_ERR(err);
-
-    if (c_orig_CreateFileA == orig_CreateFileA)
-    {
-        printf("Springboard not created!\n");
-        return GNX_ERR_FAILED;
-    }
-
-    err = gnx_transaction_commit(transaction);
-    RET_ON_ERR(err);
-    
-    if (check_open_self())
-    {
-        printf("Hook does not seem to be working...\n");
-        return GNX_ERR_FAILED;
-    }
-
-    // Unhook
-    err = gnx_transaction_begin(gnx, &transaction);
-    RET_ON_ERR(err);
-
-    err = gnx_transaction_remove_hook(
-        transaction,
-        (void **)&orig_CreateFileA);
-    RET_ON_ERR(err);
-
-    gnx_transaction_commit(transaction);
-
-    if (c_orig_CreateFileA != orig_CreateFileA)
-    {
-        printf("Springboard not destroyed!\n");
-        return GNX_ERR_FAILED;
-    }
-
-    return err;
-}
-
-//-------------------------------------------------------------------------
-gnx_err_t test_hook_abort(gnx_handle_t gnx)
-{
-    gnx_err_t err;
-
-    gnx_handle_t transaction;
-    err = gnx_transaction_begin(gnx, &transaction);
-    RET_ON_ERR(err);
-
-    auto c_orig_CreateFileA = CreateFileA;
-
-    err = gnx_transaction_add_hook(
-        transaction,
-        (void **)&orig_CreateFileA,
-        my_CreateFileA);
-    RET_ON_ERR(err);
-
-    if (c_orig_CreateFileA == orig_CreateFileA)
-    {
-        printf("Springboard not created!\n");
-        return GNX_ERR_FAILED;
-    }
-
-    // Should succeed
-    bool ok = check_open_self();
-    if (!ok)
-        return GNX_ERR_FAILED;
-
-    err = gnx_transaction_abort(transaction);
-    RET_ON_ERR(err);
-
-    if (c_orig_CreateFileA != orig_CreateFileA)
-    {
-        printf("Springboard not destroyed!\n");
-        return GNX_ERR_FAILED;
-    }
-
-    return err;
-}
-
-//-------------------------------------------------------------------------
-gnx_err_t test_mixed_hook_unhook_complete(gnx_handle_t gnx)
-{
-    auto c_orig_CreateFileA = ::CreateFileA;
-    auto c_orig_DeleteFileA = ::DeleteFileA;
-
-    gnx_err_t err;
-
-    gnx_handle_t transaction;
-    err = gnx_transaction_begin(gnx, &transaction);
-    RET_ON_ERR(err);
-
-    // Hook - 1
-    err = gnx_transaction_add_hook(
-        transaction,
-        (void **)&orig_CreateFileA,
-        my_CreateFileA);
-    RET_ON_ERR(err);
-
-    if (c_orig_CreateFileA == orig_CreateFileA)
-    {
-        printf("CreateFileA springboard not created!\n");
-        return GNX_ERR_FAILED;
-    }
-
-    err = gnx_transaction_commit(transaction);
-    RET_ON_ERR(err);
-
-    if (check_open_self())
-    {
-        printf("Hook does not seem to be working...\n");
-        return GNX_ERR_FAILED;
-    }
-
-    // Cannot delete self
-    BOOL expected_del = DeleteFileA(g_szExeName);
-
-    // Hook and unhook
-    err = gnx_transaction_begin(gnx, &transaction);
-    RET_ON_ERR(err);
-
-    err = gnx_transaction_remove_hook(
-        transaction,
-        (void **)&orig_CreateFileA);
-    RET_ON_ERR(err);
-
-    err = gnx_transaction_add_hook(
-        transaction,
-        (void **)&orig_DeleteFileA,
-        my_DeleteFileA);
-
-    if (c_orig_DeleteFileA == orig_DeleteFileA)
-    {
-        printf("DeleteFileA springboard not created!\n");
-        return GNX_ERR_FAILED;
-    }
-
-    err = gnx_transaction_remove_hook(
-        transaction,
-        (void **)&orig_CreateFileA);
-    RET_ON_ERR(err);
-
-    err = gnx_transaction_commit(transaction);
-    RET_ON_ERR(err);
-
-    if (DeleteFileA(g_szExeName) == expected_del)
-    {
-        printf("DeleteFileA does not seem to be hooked\n");
-        return err;
-    }
-
-    if (c_orig_CreateFileA != orig_CreateFileA)
-    {
-        printf("CreateFileA springboard not destroyed!\n");
-        return GNX_ERR_FAILED;
-    }
-
-    return err;
-}
-
-//-------------------------------------------------------------------------
-gnx_err_t test_hook2_unhook2_complete(gnx_handle_t gnx)
-{
-    Sleep_proto hook_Sleep[2] = { My_Sleep, My_Sleep2 };
-    gnx_err_t err;
-
-    g_SleepCount = 0;
-    int accul = 0;
-    gnx_handle_t transaction;
-    for (int i = 0;i<_countof(orig_Sleep); i++)
-    {
-        err = gnx_transaction_begin(gnx, &transaction);
-        RET_ON_ERR(err);
-
-        // Hook
-        orig_Sleep[i] = Sleep;
-        err = gnx_transaction_add_hook(
-            transaction,
-            (void **)&orig_Sleep[i],
-            hook_Sleep[i]);
-
-        RET_ON_ERR(err);
-
-        err = gnx_transaction_commit(transaction);
-        RET_ON_ERR(err);
-
-        Sleep(10);
-
-        accul += i + 1;
-        if (g_SleepCount != accul)
-        {
-            printf("Hook does not seem to be working\n");
-            return GNX_ERR_FAILED;
-        }
-    }
-
-    // Unhook
-    err = gnx_transaction_begin(gnx, &transaction);
-    RET_ON_ERR(err);
-
-    err = gnx_transaction_remove_hook(
-        transaction,
-        (void **)&orig_Sleep);
-    RET_ON_ERR(err);
-
-    gnx_transaction_commit(transaction);
-
-    return err;
-}
-
-//-------------------------------------------------------------------------
-int main()
-{
-    GetModuleFileNameA(
-        GetModuleHandle(NULL),
-        g_szExeName,
-        _countof(g_szExeName));
-
-    gnx_err_t err = gnx_init();
-
-    if (err != GNX_ERR_OK)
-    {
-        printf("Failed to initialize!\n");
-        return -1;
-    }
-
-    // Create a new workspace instance
-    gnx_handle_t gnx;
-    if (gnx_open(&gnx) != GNX_ERR_OK)
-    {
-        printf("Failed to create workspace\n");
-        return -1;
-    }
-
-    err = test_hook_unhook_complete(gnx);
-    RET_ON_ERR(err);
-
-    err = test_hook_abort(gnx);
-    RET_ON_ERR(err);
-
-    err = test_mixed_hook_unhook_complete(gnx);
-    RET_ON_ERR(err);
-
-    err = test_hook2_unhook2_complete(gnx);
-    RET_ON_ERR(err);
-
-    gnx_close(gnx);
-
-    return 0;
+#include "stdafx.h"
+
+#define RET_ON_ERR(err) if ((err) != GNX_ERR_OK) return (err);
+
+//--------------------------------------------------------------------------
+typedef VOID(WINAPI *Sleep_proto)(DWORD);
+Sleep_proto orig_Sleep[2];
+
+static DWORD g_SleepCount = 0;
+VOID WINAPI My_Sleep(DWORD dwMilliSecs)
+{
+    ++g_SleepCount;
+    orig_Sleep[0](10);
+}
+
+VOID WINAPI My_Sleep2(DWORD dwMilliSecs)
+{
+    ++g_SleepCount;
+    orig_Sleep[1](10);
+}
+
+//-------------------------------------------------------------------------
+typedef BOOL (WINAPI *DeleteFileA_proto)(LPCSTR lpFileName);
+
+DeleteFileA_proto orig_DeleteFileA = DeleteFileA;
+
+BOOL WINAPI my_DeleteFileA(LPCSTR lpFileName)
+{
+    return TRUE;
+}
+
+//-------------------------------------------------------------------------
+typedef HANDLE(WINAPI *CreateFileA_proto)(
+    LPCSTR lpFileName,
+    DWORD dwDesiredAccess,
+    DWORD dwShareMode,
+    LPSECURITY_ATTRIBUTES lpSecurityAttributes,
+    DWORD dwCreationDisposition,
+    DWORD dwFlagsAndAttributes,
+    HANDLE hTemplateFile);
+
+CreateFileA_proto orig_CreateFileA = CreateFileA;
+HANDLE WINAPI my_CreateFileA(
+    LPCSTR lpFileName,
+    DWORD dwDesiredAccess,
+    DWORD dwShareMode,
+    LPSECURITY_ATTRIBUTES lpSecurityAttributes,
+    DWORD dwCreationDisposition,
+    DWORD dwFlagsAndAttributes,
+    HANDLE hTemplateFile)
+{
+    //printf("Opening('%s')\n", lpFileName);
+    return INVALID_HANDLE_VALUE;
+}
+
+//-------------------------------------------------------------------------
+typedef int (__cdecl *leaf_max_proto)(int a, int b);
+
+__declspec(noinline) int __cdecl leaf_max(int a, int b)
+{
+    return a > b ? a : b;
+}
+
+leaf_max_proto orig_leaf_max = leaf_max;
+
+int __cdecl my_leaf_max(int a, int b)
+{
+    return -orig_leaf_max(a, b);
+}
+
+//-------------------------------------------------------------------------
+// Two functions with the same prologue: the second springboard comes from the templates cache
+typedef int (__stdcall *twin_proto)(int a, int b);
+
+__declspec(noinline) int __stdcall twin_add(int a, int b)
+{
+    int r = a;
+    for (int i = 0; i < b; i++)
+        ++r;
+    return r;
+}
+
+__declspec(noinline) int __stdcall twin_sub(int a, int b)
+{
+    int r = a;
+    for (int i = 0; i < b; i++)
+        --r;
+    return r;
+}
+
+twin_proto orig_twin[2] = { twin_add, twin_sub };
+
+int __stdcall my_twin_add(int a, int b)
+{
+    return orig_twin[0](a, b) * 10;
+}
+
+int __stdcall my_twin_sub(int a, int b)
+{
+    return orig_twin[1](a, b) * 100;
+}
+
+// Hooks chained on twin_sub (\ref gnx_hook_chain_insert)
+twin_proto orig_chain_inc, orig_chain_dbl;
+
+int __stdcall chain_inc(int a, int b)
+{
+    return orig_chain_inc(a, b) + 1;
+}
+
+int __stdcall chain_dbl(int a, int b)
+{
+    return orig_chain_dbl(a, b) * 2;
+}
+
+char g_szExeName[MAX_PATH];
+
+//-------------------------------------------------------------------------
+bool check_open_self()
+{
+    HANDLE hFile = CreateFileA(g_szExeName, GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE, NULL, OPEN_EXISTING, 0, NULL);
+    if (hFile != INVALID_HANDLE_VALUE)
+    {
+        CloseHandle(hFile);
+        return true;
+    }
+    return false;
+}
+
+//-------------------------------------------------------------------------
+gnx_err_t test_hook_unhook_complete(gnx_handle_t gnx)
+{
+    auto c_orig_CreateFileA = ::CreateFileA;
+
+    gnx_err_t err;
+
+    gnx_handle_t transaction;
+    err = gnx_transaction_begin(gnx, &transaction);
+    RET_ON_ERR(err);
+
+    // Hook
+    err = gnx_transaction_add_hook(
+        transaction,
+        (void **)&orig_CreateFileA,
+        my_CreateFileA);
+    RET_ON_ERR(err);
+
+    if (c_orig_CreateFileA == orig_CreateFileA)
+    {
+        printf("Springboard not created!\n");
+        return GNX_ERR_FAILED;
+    }
+
+    err = gnx_transaction_commit(transaction);
+    RET_ON_ERR(err);
+    
+    if (check_open_self())
+    {
+        printf("Hook does not seem to be working...\n");
+        return GNX_ERR_FAILED;
+    }
+
+    // Unhook
+    err = gnx_transaction_begin(gnx, &transaction);
+    RET_ON_ERR(err);
+
+    err = gnx_transaction_remove_hook(
+        transaction,
+        (void **)&orig_CreateFileA);
+    RET_ON_ERR(err);
+
+    gnx_transaction_commit(transaction);
+
+    if (c_orig_CreateFileA != orig_CreateFileA)
+    {
+        printf("Springboard not destroyed!\n");
+        return GNX_ERR_FAILED;
+    }
+
+    return err;
+}
+
+//-------------------------------------------------------------------------
+gnx_err_t test_hook_abort(gnx_handle_t gnx)
+{
+    gnx_err_t err;
+
+    gnx_handle_t transaction;
+    err = gnx_transaction_begin(gnx, &transaction);
+    RET_ON_ERR(err);
+
+    auto c_orig_CreateFileA = CreateFileA;
+
+    err = gnx_transaction_add_hook(
+        transaction,
+        (void **)&orig_CreateFileA,
+        my_CreateFileA);
+    RET_ON_ERR(err);
+
+    if (c_orig_CreateFileA == orig_CreateFileA)
+    {
+        printf("Springboard not created!\n");
+        return GNX_ERR_FAILED;
+    }
+
+    // Should succeed
+    bool ok = check_open_self();
+    if (!ok)
+        return GNX_ERR_FAILED;
+
+    err = gnx_transaction_abort(transaction);
+    RET_ON_ERR(err);
+
+    if (c_orig_CreateFileA != orig_CreateFileA)
+    {
+        printf("Springboard not destroyed!\n");
+        return GNX_ERR_FAILED;
+    }
+
+    // Aborting a removal keeps the hook installed
+    volatile twin_proto p_twin = twin_sub;
+    err = gnx_transaction_begin(gnx, &transaction);
+    RET_ON_ERR(err);
+
+    err = gnx_transaction_add_hook(transaction, GNX_ADD_HOOK_PARAMS(orig_twin[1], my_twin_sub));
+    RET_ON_ERR(err);
+
+    err = gnx_transaction_commit(transaction);
+    RET_ON_ERR(err);
+
+    twin_proto springboard = orig_twin[1];
+    err = gnx_transaction_begin(gnx, &transaction);
+    RET_ON_ERR(err);
+
+    err = gnx_transaction_remove_hook(transaction, (void **)&orig_twin[1]);
+    RET_ON_ERR(err);
+
+    err = gnx_transaction_abort(transaction);
+    RET_ON_ERR(err);
+
+    gnx_hook_info_t info;
+    info.cb = sizeof(info);
+    if (    orig_twin[1] != springboard
+        ||  p_twin(10, 2) != 800
+        ||  !gnx_hook_find_by_target(gnx, (const void *)twin_sub, &info)
+        ||  info.springboard != (void *)springboard)
+    {
+        printf("Aborted removal changed the hook!\n");
+        return GNX_ERR_FAILED;
+    }
+
+    err = gnx_transaction_begin(gnx, &transaction);
+    RET_ON_ERR(err);
+
+    err = gnx_transaction_remove_hook(transaction, (void **)&orig_twin[1]);
+    RET_ON_ERR(err);
+
+    return gnx_transaction_commit(transaction);
+}
+
+//-------------------------------------------------------------------------
+gnx_err_t test_mixed_hook_unhook_complete(gnx_handle_t gnx)
+{
+    auto c_orig_CreateFileA = ::CreateFileA;
+    auto c_orig_DeleteFileA = ::DeleteFileA;
+
+    gnx_err_t err;
+
+    gnx_handle_t transaction;
+    err = gnx_transaction_begin(gnx, &transaction);
+    RET_ON_ERR(err);
+
+    // Hook - 1
+    err = gnx_transaction_add_hook(
+        transaction,
+        (void **)&orig_CreateFileA,
+        my_CreateFileA);
+    RET_ON_ERR(err);
+
+    if (c_orig_CreateFileA == orig_CreateFileA)
+    {
+        printf("CreateFileA springboard not created!\n");
+        return GNX_ERR_FAILED;
+    }
+
+    err = gnx_transaction_commit(transaction);
+    RET_ON_ERR(err);
+
+    if (check_open_self())
+    {
+        printf("Hook does not seem to be working...\n");
+        return GNX_ERR_FAILED;
+    }
+
+    // Cannot delete self
+    BOOL expected_del = DeleteFileA(g_szExeName);
+
+    // Hook and unhook
+    err = gnx_transaction_begin(gnx, &transaction);
+    RET_ON_ERR(err);
+
+    err = gnx_transaction_remove_hook(
+        transaction,
+        (void **)&orig_CreateFileA);
+    RET_ON_ERR(err);
+
+    err = gnx_transaction_add_hook(
+        transaction,
+        (void **)&orig_DeleteFileA,
+        my_DeleteFileA);
+
+    if (c_orig_DeleteFileA == orig_DeleteFileA)
+    {
+        printf("DeleteFileA springboard not created!\n");
+        return GNX_ERR_FAILED;
+    }
+
+    err = gnx_transaction_remove_hook(
+        transaction,
+        (void **)&orig_CreateFileA);
+    RET_ON_ERR(err);
+
+    err = gnx_transaction_commit(transaction);
+    RET_ON_ERR(err);
+
+    if (DeleteFileA(g_szExeName) == expected_del)
+    {
+        printf("DeleteFileA does not seem to be hooked\n");
+        return err;
+    }
+
+    if (c_orig_CreateFileA != orig_CreateFileA)
+    {
+        printf("CreateFileA springboard not destroyed!\n");
+        return GNX_ERR_FAILED;
+    }
+
+    return err;
+}
+
+//-------------------------------------------------------------------------
+// Hook Sleep twice: the second hook joins the first one's chain
+static gnx_err_t hook_sleep_twice(gnx_handle_t gnx)
+{
+    Sleep_proto hook_Sleep[2] = { My_Sleep, My_Sleep2 };
+    gnx_err_t err;
+
+    g_SleepCount = 0;
+    int accul = 0;
+    gnx_handle_t transaction;
+    for (int i = 0;i<_countof(orig_Sleep); i++)
+    {
+        err = gnx_transaction_begin(gnx, &transaction);
+        RET_ON_ERR(err);
+
+        // Hook
+        orig_Sleep[i] = Sleep;
+        err = gnx_transaction_add_hook(
+            transaction,
+            (void **)&orig_Sleep[i],
+            hook_Sleep[i]);
+
+        RET_ON_ERR(err);
+
+        err = gnx_transaction_commit(transaction);
+        RET_ON_ERR(err);
+
+        Sleep(10);
+
+        accul += i + 1;
+        if (g_SleepCount != accul)
+        {
+            printf("Hook does not seem to be working\n");
+            return GNX_ERR_FAILED;
+        }
+    }
+
+    // One patch and one springboard: the first hook continues to the second one, which continues
+    // to the springboard
+    gnx_hook_info_t sb_info, patch_info;
+    sb_info.cb = patch_info.cb = sizeof(gnx_hook_info_t);
+    if (    !gnx_hook_find_by_pc(gnx, orig_Sleep[1], &sb_info)
+        ||  !sb_info.in_springboard
+        ||  sb_info.springboard != orig_Sleep[1]
+        ||  orig_Sleep[0] != My_Sleep2
+        ||  !gnx_hook_find_by_target(gnx, sb_info.func_addr, &patch_info)
+        ||  patch_info.springboard != sb_info.springboard)
+    {
+        printf("The second hook did not join the first one\n");
+        return GNX_ERR_FAILED;
+    }
+
+    return GNX_ERR_OK;
+}
+
+//-------------------------------------------------------------------------
+// Remove one of the Sleep hooks
+// \param nb_calls The count of hooks still called by Sleep
+static gnx_err_t unhook_sleep(
+    gnx_handle_t gnx,
+    int i,
+    DWORD nb_calls)
+{
+    gnx_handle_t transaction;
+    gnx_err_t err = gnx_transaction_begin(gnx, &transaction);
+    RET_ON_ERR(err);
+
+    err = gnx_transaction_remove_hook(
+        transaction,
+        (void **)&orig_Sleep[i]);
+    RET_ON_ERR(err);
+
+    err = gnx_transaction_commit(transaction);
+    RET_ON_ERR(err);
+
+    if (orig_Sleep[i] != Sleep)
+    {
+        printf("Unhook did not restore the function pointer\n");
+        return GNX_ERR_FAILED;
+    }
+
+    g_SleepCount = 0;
+    Sleep(10);
+
+    if (g_SleepCount != nb_calls)
+    {
+        printf("Hook %d removal broke the hooks chain\n", i);
+        return GNX_ERR_FAILED;
+    }
+
+    return GNX_ERR_OK;
+}
+
+//-------------------------------------------------------------------------
+gnx_err_t test_hook2_unhook2_complete(gnx_handle_t gnx)
+{
+    // Either hook may be removed first: the first one hands its patch over to the joined one,
+    // the joined one is only unlinked
+    for (int first = 0; first < _countof(orig_Sleep); first++)
+    {
+        gnx_err_t err = hook_sleep_twice(gnx);
+        RET_ON_ERR(err);
+
+        err = unhook_sleep(gnx, first, 1);
+        RET_ON_ERR(err);
+
+        err = unhook_sleep(gnx, 1 - first, 0);
+        RET_ON_ERR(err);
+    }
+
+    return GNX_ERR_OK;
+}
+
+//-------------------------------------------------------------------------
+gnx_err_t test_leaf_hook_unhook(gnx_handle_t gnx)
+{
+    // Called through a pointer so the calls are not optimized away
+    volatile leaf_max_proto p_leaf_max = leaf_max;
+
+    gnx_err_t err = gnx_set_option(
+        gnx, 
+        GNX_OPT_LEAF_RELOC_MAX_SIZE, 
+        GANXO_MAX_LEAF_FUNCTION_SIZE + 1);
+    if (err != GNX_ERR_INVALID_ARGS)
+    {
+        printf("Leaf relocation size not validated!\n");
+        return GNX_ERR_FAILED;
+    }
+
+    err = gnx_set_option(
+        gnx,
+        GNX_OPT_LEAF_RELOC_MAX_SIZE,
+        GANXO_MAX_LEAF_FUNCTION_SIZE);
+    RET_ON_ERR(err);
+
+    gnx_handle_t transaction;
+    err = gnx_transaction_begin(gnx, &transaction);
+    RET_ON_ERR(err);
+
+    err = gnx_transaction_add_hook(
+        transaction,
+        GNX_ADD_HOOK_PARAMS(orig_leaf_max, my_leaf_max));
+    RET_ON_ERR(err);
+
+    err = gnx_transaction_commit(transaction);
+    RET_ON_ERR(err);
+
+    // Both the hook and the (possibly fully relocated) original should work
+    if (p_leaf_max(1, 2) != -2 || p_leaf_max(7, 3) != -7 || orig_leaf_max(3, 1) != 3)
+    {
+        printf("Leaf hook does not seem to be working...\n");
+        return GNX_ERR_FAILED;
+    }
+
+    // The whole function is relocated: a regular springboard is much smaller than the function
+    gnx_hook_info_t info;
+    info.cb = sizeof(info);
+    if (    !gnx_hook_find_by_pc(gnx, (const void *)orig_leaf_max, &info)
+        ||  !info.in_springboard
+        ||  info.springboard_size <= GANXO_MAX_LEAF_FUNCTION_SIZE)
+    {
+        printf("Leaf function not relocated as a whole\n");
+        return GNX_ERR_FAILED;
+    }
+
+    // Unhook
+    err = gnx_transaction_begin(gnx, &transaction);
+    RET_ON_ERR(err);
+
+    err = gnx_transaction_remove_hook(
+        transaction,
+        (void **)&orig_leaf_max);
+    RET_ON_ERR(err);
+
+    err = gnx_transaction_commit(transaction);
+    RET_ON_ERR(err);
+
+    if (p_leaf_max(1, 2) != 2 || orig_leaf_max != leaf_max)
+    {
+        printf("Leaf hook not removed!\n");
+        return GNX_ERR_FAILED;
+    }
+
+    return gnx_set_option(
+        gnx, 
+        GNX_OPT_LEAF_RELOC_MAX_SIZE, 
+        0);
+}
+
+//-------------------------------------------------------------------------
+gnx_err_t test_springboard_cache(gnx_handle_t gnx)
+{
+    twin_proto hook_twin[2] = { my_twin_add, my_twin_sub };
+    volatile twin_proto p_twin[2] = { twin_add, twin_sub };
+    gnx_err_t err;
+
+    // Run once with the cache and once without it
+    for (size_t use_cache = 2; use_cache-- > 0; )
+    {
+        err = gnx_set_option(gnx, GNX_OPT_SPRINGBOARD_CACHE, use_cache);
+        RET_ON_ERR(err);
+
+        gnx_stats_t stats;
+        stats.cb = sizeof(stats);
+        err = gnx_get_stats(gnx, &stats);
+        RET_ON_ERR(err);
+        uint32_t hits = stats.nb_sb_cache_hits;
+
+        gnx_handle_t transaction;
+        err = gnx_transaction_begin(gnx, &transaction);
+        RET_ON_ERR(err);
+
+        for (int i = 0; i < _countof(orig_twin); i++)
+        {
+            err = gnx_transaction_add_hook(
+                transaction,
+                GNX_ADD_HOOK_PARAMS(orig_twin[i], hook_twin[i]));
+            RET_ON_ERR(err);
+        }
+
+        err = gnx_transaction_commit(transaction);
+        RET_ON_ERR(err);
+
+        if (p_twin[0](5, 2) != 70 || p_twin[1](5, 2) != 300)
+        {
+            printf("Hooks with the same prologue are not working (cache=%d)\n", (int)use_cache);
+            return GNX_ERR_FAILED;
+        }
+
+        // The second function reuses the template of the first one, only through the cache
+        err = gnx_get_stats(gnx, &stats);
+        RET_ON_ERR(err);
+
+        if ((stats.nb_sb_cache_hits != hits) != (use_cache != 0))
+        {
+            printf("Wrong springboard cache hits: %u (cache=%d)\n", stats.nb_sb_cache_hits - hits, (int)use_cache);
+            return GNX_ERR_FAILED;
+        }
+
+        err = gnx_transaction_begin(gnx, &transaction);
+        RET_ON_ERR(err);
+
+        for (int i = 0; i < _countof(orig_twin); i++)
+        {
+            err = gnx_transaction_remove_hook(
+                transaction,
+                (void **)&orig_twin[i]);
+            RET_ON_ERR(err);
+        }
+
+        err = gnx_transaction_commit(transaction);
+        RET_ON_ERR(err);
+
+        if (p_twin[0](5, 2) != 7 || p_twin[1](5, 2) != 3)
+        {
+            printf("Hooks with the same prologue not removed (cache=%d)\n", (int)use_cache);
+            return GNX_ERR_FAILED;
+        }
+    }
+
+    // Restore the default
+    return gnx_set_option(gnx, GNX_OPT_SPRINGBOARD_CACHE, 1);
+}
+
+//-------------------------------------------------------------------------
+gnx_err_t test_overlapping_hooks(gnx_handle_t gnx)
+{
+    volatile twin_proto p_twin = twin_add;
+    twin_proto twin_copy = twin_add;
+    gnx_err_t err;
+
+    gnx_handle_t transaction;
+    err = gnx_transaction_begin(gnx, &transaction);
+    RET_ON_ERR(err);
+
+    err = gnx_transaction_add_hook(
+        transaction,
+        GNX_ADD_HOOK_PARAMS(orig_twin[0], my_twin_add));
+    RET_ON_ERR(err);
+
+    // The same function again in the same transaction: rejected, the first hook is kept
+    err = gnx_transaction_add_hook(
+        transaction,
+        GNX_ADD_HOOK_PARAMS(twin_copy, my_twin_add));
+    if (err != GNX_ERR_INVALID_ARGS || twin_copy != twin_add)
+    {
+        printf("Overlapping hook not rejected\n");
+        gnx_transaction_abort(transaction);
+        return GNX_ERR_FAILED;
+    }
+
+    err = gnx_transaction_commit(transaction);
+    RET_ON_ERR(err);
+
+    // Indexed, so that it can be found and removed
+    gnx_hook_info_t info;
+    info.cb = sizeof(info);
+    if (p_twin(5, 2) != 70 || !gnx_hook_find_by_target(gnx, (const void *)twin_add, &info))
+    {
+        printf("Hook not installed next to an overlapping one\n");
+        return GNX_ERR_FAILED;
+    }
+
+    err = gnx_transaction_begin(gnx, &transaction);
+    RET_ON_ERR(err);
+
+    err = gnx_transaction_remove_hook(
+        transaction,
+        (void **)&orig_twin[0]);
+    RET_ON_ERR(err);
+
+    err = gnx_transaction_commit(transaction);
+    RET_ON_ERR(err);
+
+    if (p_twin(5, 2) != 7)
+    {
+        printf("Hook next to an overlapping one not removed\n");
+        return GNX_ERR_FAILED;
+    }
+
+    return GNX_ERR_OK;
+}
+
+//-------------------------------------------------------------------------
+gnx_err_t test_plan_export_load(gnx_handle_t gnx)
+{
+    auto c_orig_CreateFileA = ::CreateFileA;
+
+    char plan_path[MAX_PATH];
+    GetTempPathA(_countof(plan_path), plan_path);
+    strcat_s(plan_path, "ganxo-test.plan");
+
+    gnx_err_t err;
+    gnx_handle_t transaction;
+
+    // Hook, export the plan then unhook; the second round runs from the loaded plan
+    for (int round = 0; round < 2; round++)
+    {
+        err = gnx_transaction_begin(gnx, &transaction);
+        RET_ON_ERR(err);
+
+        err = gnx_transaction_add_hook(
+            transaction,
+            GNX_ADD_HOOK_PARAMS(orig_CreateFileA, my_CreateFileA));
+        RET_ON_ERR(err);
+
+        err = gnx_transaction_commit(transaction);
+        RET_ON_ERR(err);
+
+        if (check_open_self())
+        {
+            printf("Hook does not seem to be working (round %d)...\n", round);
+            return GNX_ERR_FAILED;
+        }
+
+        if (round == 0)
+        {
+            err = gnx_plan_export(gnx, plan_path);
+            RET_ON_ERR(err);
+        }
+
+        err = gnx_transaction_begin(gnx, &transaction);
+        RET_ON_ERR(err);
+
+        err = gnx_transaction_remove_hook(
+            transaction,
+            (void **)&orig_CreateFileA);
+        RET_ON_ERR(err);
+
+        err = gnx_transaction_commit(transaction);
+        RET_ON_ERR(err);
+
+        if (!check_open_self() || c_orig_CreateFileA != orig_CreateFileA)
+        {
+            printf("Hook not removed (round %d)!\n", round);
+            return GNX_ERR_FAILED;
+        }
+
+        if (round == 0)
+        {
+            err = gnx_plan_load(gnx, plan_path);
+            RET_ON_ERR(err);
+        }
+    }
+
+    gnx_plan_unload(gnx);
+    DeleteFileA(plan_path);
+
+    return GNX_ERR_OK;
+}
+
+//-------------------------------------------------------------------------
+gnx_err_t test_bulk_hooks(gnx_handle_t gnx)
+{
+    volatile twin_proto p_twin[2] = { twin_add, twin_sub };
+    gnx_err_t err;
+
+    // Spread over two workers: the merge must still follow the descriptors order
+    err = gnx_set_option(gnx, GNX_OPT_WORKER_THREADS, 2);
+    RET_ON_ERR(err);
+
+    gnx_hook_desc_t descs[2] =
+    {
+        { (void **)&orig_twin[0], (void *)my_twin_add, 0 },
+        { (void **)&orig_twin[1], (void *)my_twin_sub, 0 },
+    };
+    gnx_err_t results[_countof(descs)];
+
+    gnx_handle_t transaction;
+    err = gnx_transaction_begin(gnx, &transaction);
+    RET_ON_ERR(err);
+
+    err = gnx_transaction_add_hooks(
+        transaction,
+        descs,
+        _countof(descs),
+        results);
+    RET_ON_ERR(err);
+
+    if (results[0] != GNX_ERR_OK || results[1] != GNX_ERR_OK)
+    {
+        printf("Bulk hooks results are wrong\n");
+        return GNX_ERR_FAILED;
+    }
+
+    err = gnx_transaction_commit(transaction);
+    RET_ON_ERR(err);
+
+    if (p_twin[0](5, 2) != 70 || p_twin[1](5, 2) != 300)
+    {
+        printf("Bulk hooks are not working\n");
+        return GNX_ERR_FAILED;
+    }
+
+    err = gnx_transaction_begin(gnx, &transaction);
+    RET_ON_ERR(err);
+
+    for (int i = 0; i < _countof(orig_twin); i++)
+    {
+        err = gnx_transaction_remove_hook(
+            transaction,
+            (void **)&orig_twin[i]);
+        RET_ON_ERR(err);
+    }
+
+    err = gnx_transaction_commit(transaction);
+    RET_ON_ERR(err);
+
+    if (p_twin[0](5, 2) != 7 || p_twin[1](5, 2) != 3)
+    {
+        printf("Bulk hooks not removed\n");
+        return GNX_ERR_FAILED;
+    }
+
+    // Restore the default
+    return gnx_set_option(gnx, GNX_OPT_WORKER_THREADS, 0);
+}
+
+//-------------------------------------------------------------------------
+// Keep calling the twin functions while the hooks are being committed
+static volatile bool g_traffic_stop = false;
+static volatile LONG g_traffic_errors = 0;
+
+DWORD WINAPI twin_traffic_thread(LPVOID)
+{
+    volatile twin_proto p_twin[2] = { twin_add, twin_sub };
+    while (!g_traffic_stop)
+    {
+        int a = p_twin[0](5, 2), s = p_twin[1](5, 2);
+        if ((a != 7 && a != 70) || (s != 3 && s != 300))
+            InterlockedIncrement(&g_traffic_errors);
+    }
+    return 0;
+}
+
+//-------------------------------------------------------------------------
+gnx_err_t test_live_commit(gnx_handle_t gnx)
+{
+    volatile twin_proto p_twin[2] = { twin_add, twin_sub };
+    gnx_err_t err;
+
+    err = gnx_set_option(gnx, GNX_OPT_COMMIT_MODE, GNX_COMMIT_LIVE);
+    RET_ON_ERR(err);
+
+    g_traffic_stop = false;
+    HANDLE hThread = CreateThread(NULL, 0, twin_traffic_thread, NULL, 0, NULL);
+
+    for (int round = 0; round < 100; round++)
+    {
+        gnx_handle_t transaction;
+        err = gnx_transaction_begin(gnx, &transaction);
+        RET_ON_ERR(err);
+
+        err = gnx_transaction_add_hook(transaction, GNX_ADD_HOOK_PARAMS(orig_twin[0], my_twin_add));
+        RET_ON_ERR(err);
+        err = gnx_transaction_add_hook(transaction, GNX_ADD_HOOK_PARAMS(orig_twin[1], my_twin_sub));
+        RET_ON_ERR(err);
+
+        err = gnx_transaction_commit(transaction);
+        RET_ON_ERR(err);
+
+        if (p_twin[0](5, 2) != 70 || p_twin[1](5, 2) != 300)
+        {
+            printf("Live committed hooks are not working\n");
+            InterlockedIncrement(&g_traffic_errors);
+        }
+
+        err = gnx_transaction_begin(gnx, &transaction);
+        RET_ON_ERR(err);
+
+        for (int i = 0; i < _countof(orig_twin); i++)
+        {
+            err = gnx_transaction_remove_hook(transaction, (void **)&orig_twin[i]);
+            RET_ON_ERR(err);
+        }
+
+        err = gnx_transaction_commit(transaction);
+        RET_ON_ERR(err);
+    }
+
+    g_traffic_stop = true;
+    WaitForSingleObject(hThread, INFINITE);
+    CloseHandle(hThread);
+
+    if (g_traffic_errors != 0)
+    {
+        printf("Live commit errors: %ld\n", g_traffic_errors);
+        return GNX_ERR_FAILED;
+    }
+
+    if (p_twin[0](5, 2) != 7 || p_twin[1](5, 2) != 3)
+    {
+        printf("Live committed hooks not removed\n");
+        return GNX_ERR_FAILED;
+    }
+
+    // Restore the default
+    return gnx_set_option(gnx, GNX_OPT_COMMIT_MODE, GNX_COMMIT_PLAIN);
+}
+
+//-------------------------------------------------------------------------
+// Instruction pointer of a thread that never ran
+static const uint8_t *get_thread_ip(HANDLE hThread)
+{
+    CONTEXT context;
+    context.ContextFlags = CONTEXT_CONTROL;
+    if (!GetThreadContext(hThread, &context))
+        return NULL;
+#ifdef _WIN64
+    return (const uint8_t *)context.Rip;
+#else
+    return (const uint8_t *)context.Eip;
+#endif
+}
+
+//-------------------------------------------------------------------------
+// Create a suspended thread parked at 'ip' (it is terminated without ever running)
+static HANDLE park_thread(const void *ip)
+{
+    HANDLE hThread = CreateThread(NULL, 0, twin_traffic_thread, NULL, CREATE_SUSPENDED, NULL);
+    if (hThread == NULL)
+        return NULL;
+
+    CONTEXT context;
+    context.ContextFlags = CONTEXT_CONTROL;
+    if (GetThreadContext(hThread, &context))
+    {
+#ifdef _WIN64
+        context.Rip = (DWORD64)ip;
+#else
+        context.Eip = (DWORD)ip;
+#endif
+        if (SetThreadContext(hThread, &context) && get_thread_ip(hThread) == ip)
+            return hThread;
+    }
+
+    TerminateThread(hThread, 0);
+    CloseHandle(hThread);
+    return NULL;
+}
+
+//-------------------------------------------------------------------------
+// A thread stopped inside the patched prologue is moved to the same instruction of the springboard, and back
+static gnx_err_t test_stop_threads_ip_fixup(gnx_handle_t gnx)
+{
+    // The second instruction of twin_add is inside the patched bytes
+    gnx_handle_t dis = gnx_disasm_create();
+    const uint8_t *func = (const uint8_t *)gnx_disasm_skip_jumps(dis, (const void *)twin_add);
+    size_t first_sz;
+    gnx_err_t err = gnx_disasm_instruction(dis, func, &first_sz);
+    gnx_disasm_free(dis);
+    RET_ON_ERR(err);
+
+    HANDLE hThread = park_thread(func + first_sz);
+    if (hThread == NULL)
+    {
+        printf("Cannot park a thread in twin_add\n");
+        return GNX_ERR_FAILED;
+    }
+
+    gnx_stats_t stats;
+    stats.cb = sizeof(stats);
+    do
+    {
+        err = gnx_get_stats(gnx, &stats);
+        if (err != GNX_ERR_OK)
+            break;
+        uint32_t nb_fixups = stats.nb_ip_fixups;
+
+        gnx_handle_t transaction;
+        err = gnx_transaction_begin(gnx, &transaction);
+        if (err != GNX_ERR_OK)
+            break;
+
+        err = gnx_transaction_add_hook(transaction, GNX_ADD_HOOK_PARAMS(orig_twin[0], my_twin_add));
+        if (err == GNX_ERR_OK)
+            err = gnx_transaction_commit(transaction);
+        if (err != GNX_ERR_OK)
+            break;
+
+        const uint8_t *springboard = (const uint8_t *)orig_twin[0];
+        const uint8_t *hooked_ip = get_thread_ip(hThread);
+
+        err = gnx_transaction_begin(gnx, &transaction);
+        if (err != GNX_ERR_OK)
+            break;
+
+        err = gnx_transaction_remove_hook(transaction, (void **)&orig_twin[0]);
+        if (err == GNX_ERR_OK)
+            err = gnx_transaction_commit(transaction);
+        if (err != GNX_ERR_OK)
+            break;
+
+        err = gnx_get_stats(gnx, &stats);
+        if (err != GNX_ERR_OK)
+            break;
+
+        if (    hooked_ip != springboard + first_sz
+            ||  get_thread_ip(hThread) != func + first_sz
+            ||  stats.nb_ip_fixups != nb_fixups + 2)
+        {
+            printf("Stopped thread not moved out of the patched prologue\n");
+            err = GNX_ERR_FAILED;
+        }
+    } while (false);
+
+    TerminateThread(hThread, 0);
+    CloseHandle(hThread);
+    return err;
+}
+
+//-------------------------------------------------------------------------
+gnx_err_t test_stop_threads_commit(gnx_handle_t gnx)
+{
+    volatile twin_proto p_twin[2] = { twin_add, twin_sub };
+    gnx_err_t err;
+
+    err = gnx_set_option(gnx, GNX_OPT_COMMIT_MODE, GNX_COMMIT_STOP_THREADS);
+    RET_ON_ERR(err);
+
+    g_traffic_stop = false;
+    g_traffic_errors = 0;
+    HANDLE hThread = CreateThread(NULL, 0, twin_traffic_thread, NULL, 0, NULL);
+
+    for (int round = 0; round < 100; round++)
+    {
+        gnx_handle_t transaction;
+        err = gnx_transaction_begin(gnx, &transaction);
+        RET_ON_ERR(err);
+
+        err = gnx_transaction_add_hook(transaction, GNX_ADD_HOOK_PARAMS(orig_twin[0], my_twin_add));
+        RET_ON_ERR(err);
+        err = gnx_transaction_add_hook(transaction, GNX_ADD_HOOK_PARAMS(orig_twin[1], my_twin_sub));
+        RET_ON_ERR(err);
+
+        err = gnx_transaction_commit(transaction);
+        RET_ON_ERR(err);
+
+        if (p_twin[0](5, 2) != 70 || p_twin[1](5, 2) != 300)
+        {
+            printf("Hooks committed with the threads stopped are not working\n");
+            InterlockedIncrement(&g_traffic_errors);
+        }
+
+        err = gnx_transaction_begin(gnx, &transaction);
+        RET_ON_ERR(err);
+
+        for (int i = 0; i < _countof(orig_twin); i++)
+        {
+            err = gnx_transaction_remove_hook(transaction, (void **)&orig_twin[i]);
+            RET_ON_ERR(err);
+        }
+
+        err = gnx_transaction_commit(transaction);
+        RET_ON_ERR(err);
+    }
+
+    g_traffic_stop = true;
+    WaitForSingleObject(hThread, INFINITE);
+    CloseHandle(hThread);
+
+    if (g_traffic_errors != 0)
+    {
+        printf("Stop threads commit errors: %ld\n", g_traffic_errors);
+        return GNX_ERR_FAILED;
+    }
+
+    // The pause is measured
+    gnx_stats_t stats;
+    stats.cb = sizeof(stats);
+    err = gnx_get_stats(gnx, &stats);
+    RET_ON_ERR(err);
+
+    if (stats.max_pause_us < stats.last_pause_us)
+    {
+        printf("Wrong commit pause statistics\n");
+        return GNX_ERR_FAILED;
+    }
+
+    err = test_stop_threads_ip_fixup(gnx);
+    RET_ON_ERR(err);
+
+    // Restore the default
+    return gnx_set_option(gnx, GNX_OPT_COMMIT_MODE, GNX_COMMIT_PLAIN);
+}
+
+//-------------------------------------------------------------------------
+gnx_err_t test_slot_hook(gnx_handle_t gnx)
+{
+    volatile twin_proto p_twin = twin_add;
+    gnx_err_t err;
+
+    gnx_handle_t transaction;
+    err = gnx_transaction_begin(gnx, &transaction);
+    RET_ON_ERR(err);
+
+    // Hooked but disabled: the calls go through the springboard
+    gnx_handle_t hook;
+    err = gnx_transaction_add_slot_hook(transaction, GNX_ADD_HOOK_PARAMS(orig_twin[0], my_twin_add), false, &hook);
+    RET_ON_ERR(err);
+
+    err = gnx_transaction_commit(transaction);
+    RET_ON_ERR(err);
+
+    if (p_twin(5, 2) != 7)
+    {
+        printf("Disabled slot hook is called\n");
+        return GNX_ERR_FAILED;
+    }
+
+    // Switch the hook while another thread keeps calling it
+    g_traffic_stop = false;
+    g_traffic_errors = 0;
+    HANDLE hThread = CreateThread(NULL, 0, twin_traffic_thread, NULL, 0, NULL);
+
+    for (int round = 0; round < 10000; round++)
+    {
+        err = gnx_hook_enable(hook);
+        RET_ON_ERR(err);
+
+        if (p_twin(5, 2) != 70)
+        {
+            printf("Enabled slot hook is not called\n");
+            InterlockedIncrement(&g_traffic_errors);
+        }
+
+        err = gnx_hook_disable(hook);
+        RET_ON_ERR(err);
+
+        if (p_twin(5, 2) != 7)
+        {
+            printf("Disabled slot hook is called\n");
+            InterlockedIncrement(&g_traffic_errors);
+        }
+    }
+
+    g_traffic_stop = true;
+    WaitForSingleObject(hThread, INFINITE);
+    CloseHandle(hThread);
+
+    if (g_traffic_errors != 0)
+    {
+        printf("Slot hook errors: %ld\n", g_traffic_errors);
+        return GNX_ERR_FAILED;
+    }
+
+    err = gnx_transaction_begin(gnx, &transaction);
+    RET_ON_ERR(err);
+
+    err = gnx_transaction_remove_hook(transaction, (void **)&orig_twin[0]);
+    RET_ON_ERR(err);
+
+    err = gnx_transaction_commit(transaction);
+    RET_ON_ERR(err);
+
+    if (p_twin(5, 2) != 7 || orig_twin[0] != twin_add)
+    {
+        printf("Slot hook not removed\n");
+        return GNX_ERR_FAILED;
+    }
+
+    return GNX_ERR_OK;
+}
+
+//-------------------------------------------------------------------------
+gnx_err_t test_hook_chain(gnx_handle_t gnx)
+{
+    volatile twin_proto p_twin = twin_sub;
+    gnx_err_t err;
+
+    gnx_handle_t transaction;
+    err = gnx_transaction_begin(gnx, &transaction);
+    RET_ON_ERR(err);
+
+    gnx_handle_t hook;
+    err = gnx_transaction_add_slot_hook(transaction, GNX_ADD_HOOK_PARAMS(orig_twin[1], my_twin_sub), true, &hook);
+    RET_ON_ERR(err);
+
+    err = gnx_transaction_commit(transaction);
+    RET_ON_ERR(err);
+
+    // Chain: inc -> slot hook -> twin_sub
+    gnx_handle_t inc, dbl;
+    err = gnx_hook_chain_insert(hook, NULL, (void **)&orig_chain_inc, chain_inc, &inc);
+    RET_ON_ERR(err);
+
+    if (p_twin(5, 2) != 301)
+    {
+        printf("First chained hook is not called\n");
+        return GNX_ERR_FAILED;
+    }
+
+    // Chain: inc -> dbl -> slot hook -> twin_sub
+    err = gnx_hook_chain_insert(hook, inc, (void **)&orig_chain_dbl, chain_dbl, &dbl);
+    RET_ON_ERR(err);
+
+    if (p_twin(5, 2) != 601)
+    {
+        printf("Hook chained in the middle is not called\n");
+        return GNX_ERR_FAILED;
+    }
+
+    // Chain: dbl -> slot hook -> twin_sub
+    err = gnx_hook_chain_remove(hook, inc);
+    RET_ON_ERR(err);
+
+    if (p_twin(5, 2) != 600)
+    {
+        printf("Unchained hook is still called\n");
+        return GNX_ERR_FAILED;
+    }
+
+    // The whole chain is switched off and on
+    err = gnx_hook_disable(hook);
+    RET_ON_ERR(err);
+
+    if (p_twin(5, 2) != 3)
+    {
+        printf("Disabled hook chain is called\n");
+        return GNX_ERR_FAILED;
+    }
+
+    err = gnx_hook_enable(hook);
+    RET_ON_ERR(err);
+
+    if (p_twin(5, 2) != 600)
+    {
+        printf("Enabled hook chain is not called\n");
+        return GNX_ERR_FAILED;
+    }
+
+    // Removing the slot hook removes the chain
+    err = gnx_transaction_begin(gnx, &transaction);
+    RET_ON_ERR(err);
+
+    err = gnx_transaction_remove_hook(transaction, (void **)&orig_twin[1]);
+    RET_ON_ERR(err);
+
+    err = gnx_transaction_commit(transaction);
+    RET_ON_ERR(err);
+
+    if (p_twin(5, 2) != 3 || orig_twin[1] != twin_sub || orig_chain_dbl != twin_sub)
+    {
+        printf("Hook chain not removed\n");
+        return GNX_ERR_FAILED;
+    }
+
+    return GNX_ERR_OK;
+}
+
+//-------------------------------------------------------------------------
+gnx_err_t test_hook_index(gnx_handle_t gnx)
+{
+    gnx_err_t err;
+
+    gnx_handle_t transaction;
+    err = gnx_transaction_begin(gnx, &transaction);
+    RET_ON_ERR(err);
+
+    err = gnx_transaction_add_hook(transaction, GNX_ADD_HOOK_PARAMS(orig_twin[0], my_twin_add));
+    RET_ON_ERR(err);
+
+    // Only the committed hooks are indexed
+    gnx_hook_info_t info;
+    info.cb = sizeof(info);
+    if (gnx_hook_find_by_pc(gnx, orig_twin[0], &info))
+    {
+        printf("Uncommitted hook is indexed\n");
+        return GNX_ERR_FAILED;
+    }
+
+    err = gnx_transaction_commit(transaction);
+    RET_ON_ERR(err);
+
+    // The patched bytes
+    if (    !gnx_hook_find_by_target(gnx, (const uint8_t *)twin_add + 1, &info)
+        ||  info.in_springboard
+        ||  info.func_addr != twin_add
+        ||  info.springboard != orig_twin[0]
+        ||  info.slot_hook != GNX_INVALID_HANDLE)
+    {
+        printf("Hooked function not found\n");
+        return GNX_ERR_FAILED;
+    }
+
+    // The springboard
+    if (    gnx_hook_find_by_target(gnx, orig_twin[0], &info)
+        ||  !gnx_hook_find_by_pc(gnx, (const uint8_t *)orig_twin[0] + 1, &info)
+        ||  !info.in_springboard
+        ||  info.func_addr != twin_add)
+    {
+        printf("Springboard not found\n");
+        return GNX_ERR_FAILED;
+    }
+
+    err = gnx_transaction_begin(gnx, &transaction);
+    RET_ON_ERR(err);
+
+    // Not a springboard
+    twin_proto not_hooked = twin_sub;
+    if (gnx_transaction_remove_hook(transaction, (void **)&not_hooked) != GNX_ERR_INVALID_ARGS)
+    {
+        printf("Removed a function that is not hooked\n");
+        return GNX_ERR_FAILED;
+    }
+
+    err = gnx_transaction_remove_hook(transaction, (void **)&orig_twin[0]);
+    RET_ON_ERR(err);
+
+    err = gnx_transaction_commit(transaction);
+    RET_ON_ERR(err);
+
+    if (gnx_hook_find_by_target(gnx, twin_add, &info))
+    {
+        printf("Removed hook is still indexed\n");
+        return GNX_ERR_FAILED;
+    }
+
+    return GNX_ERR_OK;
+}
+
+//-------------------------------------------------------------------------
+// Registered callers: they report a quiescent point between two calls
+DWORD WINAPI churn_caller_thread(LPVOID param)
+{
+    gnx_handle_t gnx = (gnx_handle_t)param;
+    volatile twin_proto p_twin = twin_add;
+
+    gnx_handle_t thread;
+    if (gnx_thread_register(gnx, &thread) != GNX_ERR_OK)
+    {
+        InterlockedIncrement(&g_traffic_errors);
+        return 0;
+    }
+
+    while (!g_traffic_stop)
+    {
+        int a = p_twin(5, 2);
+        if (a != 7 && a != 70)
+            InterlockedIncrement(&g_traffic_errors);
+
+        gnx_thread_quiescent(thread);
+    }
+
+    gnx_thread_unregister(thread);
+    return 0;
+}
+
+//-------------------------------------------------------------------------
+// No thread registered: a retired springboard is freed once no thread stack nor register points into it
+static uint32_t get_nb_limbo(gnx_handle_t gnx)
+{
+    gnx_stats_t stats;
+    stats.cb = sizeof(stats);
+    if (gnx_get_stats(gnx, &stats) != GNX_ERR_OK)
+        return (uint32_t)-1;
+
+    return stats.nb_limbo;
+}
+
+// Hook then unhook twin_add, keeping the springboard address
+static gnx_err_t unhook_referenced(
+    gnx_handle_t gnx,
+    volatile uintptr_t *springboard)
+{
+    twin_proto orig = twin_add;
+
+    gnx_handle_t transaction;
+    gnx_err_t err = gnx_transaction_begin(gnx, &transaction);
+    RET_ON_ERR(err);
+
+    err = gnx_transaction_add_hook(transaction, (void **)&orig, my_twin_add);
+    RET_ON_ERR(err);
+
+    err = gnx_transaction_commit(transaction);
+    RET_ON_ERR(err);
+
+    *springboard = (uintptr_t)orig;
+
+    err = gnx_transaction_begin(gnx, &transaction);
+    RET_ON_ERR(err);
+
+    err = gnx_transaction_remove_hook(transaction, (void **)&orig);
+    RET_ON_ERR(err);
+
+    return gnx_transaction_commit(transaction);
+}
+
+gnx_err_t test_untracked_reclaim()
+{
+    gnx_err_t err;
+
+    gnx_handle_t gnx;
+    err = gnx_open(&gnx);
+    RET_ON_ERR(err);
+
+    // As a thread returning into the springboard would: its address is on this thread's stack
+    volatile uintptr_t springboard;
+    err = unhook_referenced(gnx, &springboard);
+    RET_ON_ERR(err);
+
+    gnx_handle_t transaction;
+    err = gnx_transaction_begin(gnx, &transaction);
+    RET_ON_ERR(err);
+
+    err = gnx_transaction_abort(transaction);
+    RET_ON_ERR(err);
+
+    if (get_nb_limbo(gnx) != 1)
+    {
+        printf("Referenced springboard freed\n");
+        return GNX_ERR_FAILED;
+    }
+
+    springboard = 0;
+
+    err = gnx_transaction_begin(gnx, &transaction);
+    RET_ON_ERR(err);
+
+    err = gnx_transaction_abort(transaction);
+    RET_ON_ERR(err);
+
+    if (get_nb_limbo(gnx) != 0)
+    {
+        printf("Unreferenced springboard not freed\n");
+        return GNX_ERR_FAILED;
+    }
+
+    // No registered thread left: the epochs pass the springboard at once, the unregistered threads
+    // are still scanned
+    gnx_handle_t thread;
+    err = gnx_thread_register(gnx, &thread);
+    RET_ON_ERR(err);
+
+    gnx_thread_unregister(thread);
+
+    err = unhook_referenced(gnx, &springboard);
+    RET_ON_ERR(err);
+
+    err = gnx_transaction_begin(gnx, &transaction);
+    RET_ON_ERR(err);
+
+    err = gnx_transaction_abort(transaction);
+    RET_ON_ERR(err);
+
+    if (get_nb_limbo(gnx) != 1)
+    {
+        printf("Springboard referenced by an unregistered thread freed\n");
+        return GNX_ERR_FAILED;
+    }
+
+    // Unless only the registered threads run the hooks
+    err = gnx_set_option(gnx, GNX_OPT_REGISTERED_THREADS_ONLY, 1);
+    RET_ON_ERR(err);
+
+    err = gnx_transaction_begin(gnx, &transaction);
+    RET_ON_ERR(err);
+
+    err = gnx_transaction_abort(transaction);
+    RET_ON_ERR(err);
+
+    if (get_nb_limbo(gnx) != 0)
+    {
+        printf("Springboard not freed on the epochs alone\n");
+        return GNX_ERR_FAILED;
+    }
+
+    springboard = 0;
+
+    gnx_close(gnx);
+
+    return GNX_ERR_OK;
+}
+
+//-------------------------------------------------------------------------
+gnx_err_t test_unhook_churn(gnx_handle_t gnx)
+{
+    gnx_err_t err;
+
+    err = gnx_set_option(gnx, GNX_OPT_COMMIT_MODE, GNX_COMMIT_LIVE);
+    RET_ON_ERR(err);
+
+    g_traffic_stop = false;
+    g_traffic_errors = 0;
+
+    HANDLE hThreads[4];
+    for (int i = 0; i < _countof(hThreads); i++)
+        hThreads[i] = CreateThread(NULL, 0, churn_caller_thread, gnx, 0, NULL);
+
+    for (int round = 0; round < 2000; round++)
+    {
+        gnx_handle_t transaction;
+        err = gnx_transaction_begin(gnx, &transaction);
+        RET_ON_ERR(err);
+
+        err = gnx_transaction_add_hook(transaction, GNX_ADD_HOOK_PARAMS(orig_twin[0], my_twin_add));
+        RET_ON_ERR(err);
+
+        err = gnx_transaction_commit(transaction);
+        RET_ON_ERR(err);
+
+        // The unhooked springboard may still be running: it goes to limbo
+        err = gnx_transaction_begin(gnx, &transaction);
+        RET_ON_ERR(err);
+
+        err = gnx_transaction_remove_hook(transaction, (void **)&orig_twin[0]);
+        RET_ON_ERR(err);
+
+        err = gnx_transaction_commit(transaction);
+        RET_ON_ERR(err);
+    }
+
+    g_traffic_stop = true;
+    WaitForMultipleObjects(_countof(hThreads), hThreads, TRUE, INFINITE);
+    for (int i = 0; i < _countof(hThreads); i++)
+        CloseHandle(hThreads[i]);
+
+    if (g_traffic_errors != 0)
+    {
+        printf("Hook churn errors: %ld\n", g_traffic_errors);
+        return GNX_ERR_FAILED;
+    }
+
+    // No thread is registered anymore: the next transaction frees the limbo
+    gnx_handle_t transaction;
+    err = gnx_transaction_begin(gnx, &transaction);
+    RET_ON_ERR(err);
+
+    err = gnx_transaction_abort(transaction);
+    RET_ON_ERR(err);
+
+    gnx_stats_t stats;
+    stats.cb = sizeof(stats);
+    err = gnx_get_stats(gnx, &stats);
+    RET_ON_ERR(err);
+
+    if (stats.nb_limbo != 0)
+    {
+        printf("Unhooked springboards not freed: %u\n", stats.nb_limbo);
+        return GNX_ERR_FAILED;
+    }
+
+    // Restore the default
+    return gnx_set_option(gnx, GNX_OPT_COMMIT_MODE, GNX_COMMIT_PLAIN);
+}
+
+//-------------------------------------------------------------------------
+// Asynchronous commits completion
+struct async_commit_ctx_t
+{
+    volatile LONG nb_done;
+    gnx_err_t err;
+    size_t nb_results;
+    gnx_commit_result_t result;
+};
+
+void GANXO_API on_commit_done(
+    void *ctx,
+    gnx_err_t err,
+    const gnx_commit_result_t *results,
+    size_t nb_results)
+{
+    async_commit_ctx_t *done = (async_commit_ctx_t *)ctx;
+
+    done->err = err;
+    done->nb_results = nb_results;
+    if (nb_results != 0)
+        done->result = results[0];
+
+    InterlockedIncrement(&done->nb_done);
+}
+
+//-------------------------------------------------------------------------
+gnx_err_t test_commit_async(gnx_handle_t gnx)
+{
+    gnx_err_t err;
+    volatile twin_proto p_twin[2] = { twin_add, twin_sub };
+
+    HANDLE hDone = (HANDLE)gnx_transaction_commit_event(gnx);
+    if (hDone == NULL)
+        return GNX_ERR_FAILED;
+
+    async_commit_ctx_t done[2];
+    memset(done, 0, sizeof(done));
+
+    gnx_handle_t transaction;
+    err = gnx_transaction_begin(gnx, &transaction);
+    RET_ON_ERR(err);
+
+    err = gnx_transaction_add_hook(transaction, GNX_ADD_HOOK_PARAMS(orig_twin[0], my_twin_add));
+    RET_ON_ERR(err);
+
+    err = gnx_transaction_commit_async(transaction, on_commit_done, &done[0]);
+    RET_ON_ERR(err);
+
+    while (done[0].nb_done == 0)
+        WaitForSingleObject(hDone, INFINITE);
+
+    if (    done[0].err != GNX_ERR_OK 
+        ||  done[0].nb_results != 1 
+        ||  done[0].result.psrc != (void **)&orig_twin[0]
+        ||  done[0].result.remove
+        ||  done[0].result.err != GNX_ERR_OK
+        ||  p_twin[0](1, 2) != 30)
+    {
+        printf("Asynchronous commit failed\n");
+        return GNX_ERR_FAILED;
+    }
+
+    // Two queued transactions, likely committed together
+    gnx_handle_t transactions[2];
+    err = gnx_transaction_begin(gnx, &transactions[0]);
+    RET_ON_ERR(err);
+
+    err = gnx_transaction_remove_hook(transactions[0], (void **)&orig_twin[0]);
+    RET_ON_ERR(err);
+
+    err = gnx_transaction_begin(gnx, &transactions[1]);
+    RET_ON_ERR(err);
+
+    err = gnx_transaction_add_hook(transactions[1], GNX_ADD_HOOK_PARAMS(orig_twin[1], my_twin_sub));
+    RET_ON_ERR(err);
+
+    for (int i = 0; i < 2; i++)
+    {
+        err = gnx_transaction_commit_async(transactions[i], on_commit_done, &done[i]);
+        RET_ON_ERR(err);
+    }
+
+    while (done[0].nb_done != 2 || done[1].nb_done != 1)
+        WaitForSingleObject(hDone, INFINITE);
+
+    if (    done[0].err != GNX_ERR_OK 
+        ||  !done[0].result.remove
+        ||  done[1].err != GNX_ERR_OK 
+        ||  done[1].result.psrc != (void **)&orig_twin[1]
+        ||  p_twin[0](1, 2) != 3
+        ||  p_twin[1](10, 2) != 800)
+    {
+        printf("Batched asynchronous commits failed\n");
+        return GNX_ERR_FAILED;
+    }
+
+    err = gnx_transaction_begin(gnx, &transaction);
+    RET_ON_ERR(err);
+
+    err = gnx_transaction_remove_hook(transaction, (void **)&orig_twin[1]);
+    RET_ON_ERR(err);
+
+    return gnx_transaction_commit(transaction);
+}
+
+//-------------------------------------------------------------------------
+// Two transactions hooking the same function: only one may patch it
+twin_proto overlap_orig[2] = { twin_add, twin_add };
+
+int __stdcall my_overlap_add0(int a, int b)
+{
+    return overlap_orig[0](a, b) * 10;
+}
+
+int __stdcall my_overlap_add1(int a, int b)
+{
+    return overlap_orig[1](a, b) * 100;
+}
+
+struct overlap_commit_ctx_t
+{
+    HANDLE hStart;
+    gnx_handle_t transaction;
+    gnx_err_t err;
+};
+
+DWORD WINAPI overlap_commit_thread(LPVOID param)
+{
+    overlap_commit_ctx_t *ctx = (overlap_commit_ctx_t *)param;
+    WaitForSingleObject(ctx->hStart, INFINITE);
+    ctx->err = gnx_transaction_commit(ctx->transaction);
+    return 0;
+}
+
+// Check that a single hook of twin_add won, then remove it
+static gnx_err_t check_overlap_winner(
+    gnx_handle_t gnx,
+    const gnx_err_t errs[2],
+    gnx_err_t loser_err)
+{
+    volatile twin_proto p_twin = twin_add;
+    const int expected[2] = { 30, 300 };
+
+    if ((errs[0] == GNX_ERR_OK) == (errs[1] == GNX_ERR_OK))
+    {
+        printf("Overlapping commits: %d and %d\n", errs[0], errs[1]);
+        return GNX_ERR_FAILED;
+    }
+
+    int winner = errs[0] == GNX_ERR_OK ? 0 : 1;
+    gnx_hook_info_t info;
+    info.cb = sizeof(info);
+    if (    errs[1 - winner] != loser_err
+        ||  p_twin(1, 2) != expected[winner]
+        ||  overlap_orig[1 - winner] != twin_add
+        ||  !gnx_hook_find_by_target(gnx, (const void *)twin_add, &info)
+        ||  info.springboard != (void *)overlap_orig[winner])
+    {
+        printf("Overlapping commits: the rejected hook was patched\n");
+        return GNX_ERR_FAILED;
+    }
+
+    gnx_handle_t transaction;
+    gnx_err_t err = gnx_transaction_begin(gnx, &transaction);
+    RET_ON_ERR(err);
+
+    err = gnx_transaction_remove_hook(transaction, (void **)&overlap_orig[winner]);
+    RET_ON_ERR(err);
+
+    err = gnx_transaction_commit(transaction);
+    RET_ON_ERR(err);
+
+    if (p_twin(1, 2) != 3)
+    {
+        printf("Overlapping commits: hook not removed\n");
+        return GNX_ERR_FAILED;
+    }
+    return GNX_ERR_OK;
+}
+
+gnx_err_t test_overlapping_commits(gnx_handle_t gnx)
+{
+    twin_proto hooks[2] = { my_overlap_add0, my_overlap_add1 };
+    gnx_handle_t transactions[2];
+    gnx_err_t err;
+
+    // Two threads committing at once: whichever goes second is rejected under the commit lock
+    for (int i = 0; i < 2; i++)
+    {
+        err = gnx_transaction_begin(gnx, &transactions[i]);
+        RET_ON_ERR(err);
+
+        err = gnx_transaction_add_hook(transactions[i], GNX_ADD_HOOK_PARAMS(overlap_orig[i], hooks[i]));
+        RET_ON_ERR(err);
+    }
+
+    overlap_commit_ctx_t ctx;
+    ctx.hStart = CreateEvent(NULL, TRUE, FALSE, NULL);
+    ctx.transaction = transactions[1];
+    ctx.err = GNX_ERR_FAILED;
+
+    HANDLE hThread = CreateThread(NULL, 0, overlap_commit_thread, &ctx, 0, NULL);
+    if (hThread == NULL)
+        return GNX_ERR_FAILED;
+
+    gnx_err_t errs[2];
+    SetEvent(ctx.hStart);
+    errs[0] = gnx_transaction_commit(transactions[0]);
+
+    WaitForSingleObject(hThread, INFINITE);
+    CloseHandle(hThread);
+    CloseHandle(ctx.hStart);
+    errs[1] = ctx.err;
+
+    err = check_overlap_winner(gnx, errs, GNX_ERR_FAILED);
+    RET_ON_ERR(err);
+
+    // Two asynchronous commits, likely batched together: the item of the later one is rejected
+    HANDLE hDone = (HANDLE)gnx_transaction_commit_event(gnx);
+    if (hDone == NULL)
+        return GNX_ERR_FAILED;
+
+    async_commit_ctx_t done[2];
+    memset(done, 0, sizeof(done));
+
+    for (int i = 0; i < 2; i++)
+    {
+        err = gnx_transaction_begin(gnx, &transactions[i]);
+        RET_ON_ERR(err);
+
+        err = gnx_transaction_add_hook(transactions[i], GNX_ADD_HOOK_PARAMS(overlap_orig[i], hooks[i]));
+        RET_ON_ERR(err);
+    }
+
+    for (int i = 0; i < 2; i++)
+    {
+        err = gnx_transaction_commit_async(transactions[i], on_commit_done, &done[i]);
+        RET_ON_ERR(err);
+    }
+
+    while (done[0].nb_done != 1 || done[1].nb_done != 1)
+        WaitForSingleObject(hDone, INFINITE);
+
+    errs[0] = done[0].result.err;
+    errs[1] = done[1].result.err;
+    return check_overlap_winner(gnx, errs, GNX_ERR_INVALID_ARGS);
+}
+
+//-------------------------------------------------------------------------
+typedef DWORD (WINAPI *GetTickCount_proto)(VOID);
+GetTickCount_proto orig_GetTickCount;
+
+DWORD WINAPI my_GetTickCount(VOID)
+{
+    return 1234;
+}
+
+//-------------------------------------------------------------------------
+// Redirect the test's own imports
+gnx_err_t test_iat_hook(gnx_handle_t gnx)
+{
+    gnx_err_t err;
+
+    const char *exe_name = strrchr(g_szExeName, '\\');
+    exe_name = exe_name != NULL ? exe_name + 1 : g_szExeName;
+
+    gnx_handle_t transaction;
+    err = gnx_transaction_begin(gnx, &transaction);
+    RET_ON_ERR(err);
+
+    void *not_imported;
+    if (gnx_transaction_add_iat_hook(transaction, exe_name, "kernel32.dll!NotAnExport", my_GetTickCount, &not_imported) != GNX_ERR_NOT_FOUND)
+    {
+        printf("Hooked an import that does not exist\n");
+        return GNX_ERR_FAILED;
+    }
+
+    err = gnx_transaction_add_iat_hook(transaction, exe_name, "kernel32.dll!GetTickCount", my_GetTickCount, (void **)&orig_GetTickCount);
+    RET_ON_ERR(err);
+
+    // Nothing is written until committed
+    if (GetTickCount() == 1234 || orig_GetTickCount == NULL)
+    {
+        printf("Import slot written before the commit\n");
+        return GNX_ERR_FAILED;
+    }
+
+    err = gnx_transaction_commit(transaction);
+    RET_ON_ERR(err);
+
+    if (GetTickCount() != 1234 || orig_GetTickCount() == 1234)
+    {
+        printf("Import slot not redirected\n");
+        return GNX_ERR_FAILED;
+    }
+
+    // Back to the original function
+    void *hook;
+    err = gnx_transaction_begin(gnx, &transaction);
+    RET_ON_ERR(err);
+
+    err = gnx_transaction_add_iat_hook(transaction, exe_name, "kernel32.dll!GetTickCount", orig_GetTickCount, &hook);
+    RET_ON_ERR(err);
+
+    err = gnx_transaction_commit(transaction);
+    RET_ON_ERR(err);
+
+    if (hook != my_GetTickCount || GetTickCount() == 1234)
+    {
+        printf("Import slot not restored\n");
+        return GNX_ERR_FAILED;
+    }
+
+    return GNX_ERR_OK;
+}
+
+//-------------------------------------------------------------------------
+// Resolve exported functions by name
+gnx_err_t test_resolve_symbols()
+{
+    const char *names[] = { "GetTickCount", "Sleep", "NotAnExport", "CreateFileA" };
+    void *addrs[_countof(names)];
+    size_t sizes[_countof(names)];
+
+    if (gnx_resolve_symbols("not-loaded.dll", names, _countof(names), addrs, sizes) != GNX_ERR_NOT_FOUND)
+    {
+        printf("Resolved the symbols of a module that is not loaded\n");
+        return GNX_ERR_FAILED;
+    }
+
+    if (gnx_resolve_symbols("kernel32.dll", names, _countof(names), addrs, sizes) != GNX_ERR_PARTIAL)
+    {
+        printf("Failed to resolve the exports\n");
+        return GNX_ERR_FAILED;
+    }
+
+    HMODULE hKernel32 = GetModuleHandleA("kernel32.dll");
+    for (size_t i = 0; i < _countof(names); i++)
+    {
+        if (addrs[i] != (void *)GetProcAddress(hKernel32, names[i]))
+        {
+            printf("Wrong address for %s\n", names[i]);
+            return GNX_ERR_FAILED;
+        }
+    }
+
+    if (sizes[2] != 0)
+    {
+        printf("Size of a function that is not exported\n");
+        return GNX_ERR_FAILED;
+    }
+
+    return GNX_ERR_OK;
+}
+
+//-------------------------------------------------------------------------
+typedef DWORD (WINAPI *timeGetTime_proto)(VOID);
+timeGetTime_proto orig_timeGetTime = NULL;
+
+DWORD WINAPI my_timeGetTime(VOID)
+{
+    return 4321;
+}
+
+//-------------------------------------------------------------------------
+// Hook a function of a module once it is loaded
+gnx_err_t test_pending_hooks(gnx_handle_t gnx)
+{
+    // The module must not be loaded yet
+    if (GetModuleHandleA("winmm.dll") != NULL)
+        return GNX_ERR_OK;
+
+    // Named as for LoadLibrary: ".dll" is implied
+    gnx_pending_hook_desc_t desc;
+    desc.module = "WinMM";
+    desc.symbol = "timeGetTime";
+    desc.psrc = (void **)&orig_timeGetTime;
+    desc.hook = my_timeGetTime;
+
+    gnx_err_t err = gnx_add_pending_hooks(gnx, &desc, 1);
+    RET_ON_ERR(err);
+
+    if (orig_timeGetTime != NULL)
+    {
+        printf("Pending hook installed before the module is loaded\n");
+        return GNX_ERR_FAILED;
+    }
+
+    HMODULE hWinmm = LoadLibraryA("winmm.dll");
+    if (hWinmm == NULL)
+        return GNX_ERR_FAILED;
+
+    timeGetTime_proto p_timeGetTime = (timeGetTime_proto)GetProcAddress(hWinmm, "timeGetTime");
+    if (orig_timeGetTime == NULL || p_timeGetTime() != 4321 || orig_timeGetTime() == 4321)
+    {
+        printf("Pending hook not installed when the module is loaded\n");
+        return GNX_ERR_FAILED;
+    }
+
+    FreeLibrary(hWinmm);
+
+    // Dropped with the module (unless something else keeps it loaded)
+    if (GetModuleHandleA("winmm.dll") == NULL && orig_timeGetTime != NULL)
+    {
+        printf("Hook of an unloaded module not dropped\n");
+        return GNX_ERR_FAILED;
+    }
+
+    return GNX_ERR_OK;
+}
+
+//-------------------------------------------------------------------------
+// Close a workspace with its hooks still installed
+gnx_err_t test_close_unhook()
+{
+    gnx_err_t err;
+    volatile twin_proto p_twin[2] = { twin_add, twin_sub };
+
+    gnx_handle_t gnx;
+    err = gnx_open(&gnx);
+    RET_ON_ERR(err);
+
+    gnx_handle_t transaction;
+    err = gnx_transaction_begin(gnx, &transaction);
+    RET_ON_ERR(err);
+
+    err = gnx_transaction_add_hook(transaction, GNX_ADD_HOOK_PARAMS(orig_twin[0], my_twin_add));
+    RET_ON_ERR(err);
+
+    err = gnx_transaction_add_hook(transaction, GNX_ADD_HOOK_PARAMS(orig_twin[1], my_twin_sub));
+    RET_ON_ERR(err);
+
+    err = gnx_transaction_commit(transaction);
+    RET_ON_ERR(err);
+
+    if (p_twin[0](1, 2) != 30 || p_twin[1](10, 2) != 800)
+    {
+        printf("Hooks not installed\n");
+        return GNX_ERR_FAILED;
+    }
+
+    err = gnx_close_ex(gnx, GNX_CLOSE_UNHOOK);
+    RET_ON_ERR(err);
+
+    // The functions and the original function pointers are restored
+    if (    p_twin[0](1, 2) != 3 
+        ||  p_twin[1](10, 2) != 8
+        ||  orig_twin[0] != twin_add
+        ||  orig_twin[1] != twin_sub)
+    {
+        printf("Hooks not removed when closing\n");
+        return GNX_ERR_FAILED;
+    }
+
+    return GNX_ERR_OK;
+}
+
+//-------------------------------------------------------------------------
+#define COUNTED_CALLS 1000
+
+static DWORD WINAPI counted_calls_thread(LPVOID param)
+{
+    volatile twin_proto p_twin = twin_add;
+    for (int i = 0; i < COUNTED_CALLS; i++)
+        p_twin(i, 1);
+
+    return 0;
+}
+
+gnx_err_t test_counter_hook()
+{
+    gnx_err_t err;
+    volatile twin_proto p_twin = twin_add;
+    twin_proto orig = twin_add;
+
+    gnx_handle_t gnx;
+    err = gnx_open(&gnx);
+    RET_ON_ERR(err);
+
+    gnx_handle_t thread;
+    err = gnx_thread_register(gnx, &thread);
+    RET_ON_ERR(err);
+
+    gnx_handle_t transaction;
+    err = gnx_transaction_begin(gnx, &transaction);
+    RET_ON_ERR(err);
+
+    gnx_handle_t counter;
+    err = gnx_transaction_add_counter_hook(transaction, (void **)&orig, GNX_COUNT_CYCLES, &counter);
+    RET_ON_ERR(err);
+
+    err = gnx_transaction_commit(transaction);
+    RET_ON_ERR(err);
+
+    // Counted and timed by this (registered) thread, only counted by the other one
+    for (int i = 0; i < COUNTED_CALLS; i++)
+    {
+        if (p_twin(i, 2) != i + 2)
+        {
+            printf("Counted function result changed\n");
+            return GNX_ERR_FAILED;
+        }
+    }
+
+    HANDLE hThread = CreateThread(NULL, 0, counted_calls_thread, NULL, 0, NULL);
+    WaitForSingleObject(hThread, INFINITE);
+    CloseHandle(hThread);
+
+    gnx_hook_counters_t counts;
+    err = gnx_hook_get_counters(gnx, counter, &counts);
+    RET_ON_ERR(err);
+
+    if (counts.calls != 2 * COUNTED_CALLS || counts.cycles == 0)
+    {
+        printf("Wrong counts: %llu calls, %llu cycles\n", counts.calls, counts.cycles);
+        return GNX_ERR_FAILED;
+    }
+
+    // The thread's counts are kept once it unregistered
+    gnx_thread_unregister(thread);
+    err = gnx_hook_get_counters(gnx, counter, &counts);
+    RET_ON_ERR(err);
+
+    if (counts.calls != 2 * COUNTED_CALLS)
+    {
+        printf("Counts lost when unregistering\n");
+        return GNX_ERR_FAILED;
+    }
+
+    return gnx_close_ex(gnx, GNX_CLOSE_UNHOOK);
+}
+
+//-------------------------------------------------------------------------
+#define TRACED_CALLS 100
+
+gnx_err_t test_trace_hook()
+{
+    gnx_err_t err;
+    volatile twin_proto p_twin = twin_sub;
+    twin_proto orig = twin_sub;
+
+    char trace_path[MAX_PATH];
+    sprintf_s(trace_path, "%s.trace", g_szExeName);
+
+    gnx_handle_t gnx;
+    err = gnx_open(&gnx);
+    RET_ON_ERR(err);
+
+    gnx_handle_t thread;
+    err = gnx_thread_register(gnx, &thread);
+    RET_ON_ERR(err);
+
+    gnx_handle_t transaction;
+    err = gnx_transaction_begin(gnx, &transaction);
+    RET_ON_ERR(err);
+
+    err = gnx_transaction_add_trace_hook(transaction, (void **)&orig, 7, GNX_TRACE_RETURNS | GNX_TRACE_ARGS(2));
+    RET_ON_ERR(err);
+
+    err = gnx_transaction_commit(transaction);
+    RET_ON_ERR(err);
+
+    err = gnx_trace_start(gnx, trace_path, 1024 * 1024, 0);
+    RET_ON_ERR(err);
+
+    for (int i = 0; i < TRACED_CALLS; i++)
+        p_twin(i, 1);
+
+    err = gnx_trace_stop(gnx);
+    RET_ON_ERR(err);
+
+    gnx_thread_unregister(thread);
+
+    err = gnx_close_ex(gnx, GNX_CLOSE_UNHOOK);
+    RET_ON_ERR(err);
+
+    // A call record and a return record per call
+    FILE *fp;
+    if (fopen_s(&fp, trace_path, "rb") != 0)
+        return GNX_ERR_FAILED;
+
+    gnx_trace_file_header_t header;
+    gnx_trace_record_t records[2 * TRACED_CALLS];
+    bool ok =       fread(&header, sizeof(header), 1, fp) == 1
+                &&  header.magic == GNX_TRACE_FILE_MAGIC
+                &&  header.nb_records == 2 * TRACED_CALLS
+                &&  header.nb_dropped == 0
+                &&  fread(records, sizeof(records), 1, fp) == 1;
+    fclose(fp);
+    DeleteFileA(trace_path);
+
+    for (int i = 0; ok && i < TRACED_CALLS; i++)
+    {
+        const gnx_trace_record_t *call = &records[2 * i], *ret = &records[2 * i + 1];
+        ok =        call->hook_id == 7
+                &&  call->thread_id == GetCurrentThreadId()
+                &&  call->args[0] == (uint32_t)i
+                &&  call->args[1] == 1
+                &&  ret->hook_id == (7 | GNX_TRACE_RETURN_RECORD)
+                &&  ret->args[0] == (uint32_t)(i - 1)
+                &&  ret->tsc >= call->tsc;
+    }
+
+    if (!ok)
+    {
+        printf("Wrong trace records\n");
+        return GNX_ERR_FAILED;
+    }
+
+    return GNX_ERR_OK;
+}
+
+//-------------------------------------------------------------------------
+// A timed __stdcall function calling another timed __stdcall function: both return with ret 8
+static volatile twin_proto g_nested_inner = twin_add;
+
+__declspec(noinline) int __stdcall twin_nested(int a, int b)
+{
+    return g_nested_inner(a, b) + 1;
+}
+
+gnx_err_t test_stdcall_timed_nesting()
+{
+    gnx_err_t err;
+    volatile twin_proto p_nested = twin_nested;
+    twin_proto orig[2] = { twin_add, twin_nested };
+
+    gnx_handle_t gnx;
+    err = gnx_open(&gnx);
+    RET_ON_ERR(err);
+
+    gnx_handle_t thread;
+    err = gnx_thread_register(gnx, &thread);
+    RET_ON_ERR(err);
+
+    gnx_handle_t transaction;
+    err = gnx_transaction_begin(gnx, &transaction);
+    RET_ON_ERR(err);
+
+    gnx_handle_t counter[2];
+    for (int i = 0; i < 2; i++)
+    {
+        err = gnx_transaction_add_counter_hook(transaction, (void **)&orig[i], GNX_COUNT_CYCLES, &counter[i]);
+        RET_ON_ERR(err);
+    }
+
+    err = gnx_transaction_commit(transaction);
+    RET_ON_ERR(err);
+
+    for (int i = 0; i < COUNTED_CALLS; i++)
+    {
+        if (p_nested(i, 2) != i + 3 || g_nested_inner(i, 2) != i + 2)
+        {
+            printf("Timed __stdcall function result changed\n");
+            return GNX_ERR_FAILED;
+        }
+    }
+
+    // Every call returned through its own frame: all of them are timed
+    static const uint64_t expected_calls[2] = { 2 * COUNTED_CALLS, COUNTED_CALLS };
+    for (int i = 0; i < 2; i++)
+    {
+        gnx_hook_counters_t counts;
+        err = gnx_hook_get_counters(gnx, counter[i], &counts);
+        RET_ON_ERR(err);
+
+        uint64_t timed = 0;
+        for (int j = 0; j < GNX_HOOK_HISTOGRAM_SIZE; j++)
+            timed += counts.histogram[j];
+
+        if (counts.calls != expected_calls[i] || timed != expected_calls[i])
+        {
+            printf("Wrong __stdcall timings: %llu calls, %llu timed\n", counts.calls, timed);
+            return GNX_ERR_FAILED;
+        }
+    }
+
+    gnx_thread_unregister(thread);
+
+    return gnx_close_ex(gnx, GNX_CLOSE_UNHOOK);
+}
+
+//-------------------------------------------------------------------------
+// A traced __stdcall function calling a timed __stdcall function: their exit thunks share the shadow stack
+gnx_err_t test_stdcall_traced_nesting()
+{
+    gnx_err_t err;
+    volatile twin_proto p_nested = twin_nested;
+    twin_proto orig_inner = twin_add, orig_outer = twin_nested;
+
+    char trace_path[MAX_PATH];
+    sprintf_s(trace_path, "%s.nested.trace", g_szExeName);
+
+    gnx_handle_t gnx;
+    err = gnx_open(&gnx);
+    RET_ON_ERR(err);
+
+    gnx_handle_t thread;
+    err = gnx_thread_register(gnx, &thread);
+    RET_ON_ERR(err);
+
+    gnx_handle_t transaction;
+    err = gnx_transaction_begin(gnx, &transaction);
+    RET_ON_ERR(err);
+
+    gnx_handle_t counter;
+    err = gnx_transaction_add_counter_hook(transaction, (void **)&orig_inner, GNX_COUNT_CYCLES, &counter);
+    RET_ON_ERR(err);
+
+    err = gnx_transaction_add_trace_hook(transaction, (void **)&orig_outer, 9, GNX_TRACE_RETURNS | GNX_TRACE_ARGS(2));
+    RET_ON_ERR(err);
+
+    err = gnx_transaction_commit(transaction);
+    RET_ON_ERR(err);
+
+    err = gnx_trace_start(gnx, trace_path, 1024 * 1024, 0);
+    RET_ON_ERR(err);
+
+    for (int i = 0; i < TRACED_CALLS; i++)
+    {
+        if (p_nested(i, 2) != i + 3 || g_nested_inner(i, 2) != i + 2)
+        {
+            printf("Timed __stdcall function result changed\n");
+            return GNX_ERR_FAILED;
+        }
+    }
+
+    err = gnx_trace_stop(gnx);
+    RET_ON_ERR(err);
+
+    // Every call returned through its own frame: all of them are timed
+    gnx_hook_counters_t counts;
+    err = gnx_hook_get_counters(gnx, counter, &counts);
+    RET_ON_ERR(err);
+
+    uint64_t timed = 0;
+    for (int j = 0; j < GNX_HOOK_HISTOGRAM_SIZE; j++)
+        timed += counts.histogram[j];
+
+    gnx_thread_unregister(thread);
+
+    err = gnx_close_ex(gnx, GNX_CLOSE_UNHOOK);
+    RET_ON_ERR(err);
+
+    if (counts.calls != 2 * TRACED_CALLS || timed != 2 * TRACED_CALLS)
+    {
+        printf("Wrong __stdcall timings: %llu calls, %llu timed\n", counts.calls, timed);
+        return GNX_ERR_FAILED;
+    }
+
+    FILE *fp;
+    if (fopen_s(&fp, trace_path, "rb") != 0)
+        return GNX_ERR_FAILED;
+
+    gnx_trace_file_header_t header;
+    gnx_trace_record_t records[2 * TRACED_CALLS];
+    bool ok =       fread(&header, sizeof(header), 1, fp) == 1
+                &&  header.nb_records == 2 * TRACED_CALLS
+                &&  fread(records, sizeof(records), 1, fp) == 1;
+    fclose(fp);
+    DeleteFileA(trace_path);
+
+    // The returns go back to the callers of the traced calls
+    for (int i = 0; ok && i < TRACED_CALLS; i++)
+    {
+        const gnx_trace_record_t *call = &records[2 * i], *ret = &records[2 * i + 1];
+        ok =        call->hook_id == 9
+                &&  ret->hook_id == (9 | GNX_TRACE_RETURN_RECORD)
+                &&  ret->ret == call->ret
+                &&  ret->args[0] == (uint32_t)(i + 3);
+    }
+
+    if (!ok)
+    {
+        printf("Wrong __stdcall trace records\n");
+        return GNX_ERR_FAILED;
+    }
+
+    return GNX_ERR_OK;
+}
+
+//-------------------------------------------------------------------------
+gnx_err_t test_shared_counters()
+{
+    gnx_err_t err;
+    volatile twin_proto p_twin = twin_add;
+    twin_proto orig = twin_add;
+
+    char name[64];
+    sprintf_s(name, "Local\\ganxo-test-%u", GetCurrentProcessId());
+
+    gnx_handle_t gnx;
+    err = gnx_open(&gnx);
+    RET_ON_ERR(err);
+
+    err = gnx_counters_share(gnx, name, 4);
+    RET_ON_ERR(err);
+
+    gnx_handle_t thread;
+    err = gnx_thread_register(gnx, &thread);
+    RET_ON_ERR(err);
+
+    gnx_handle_t transaction;
+    err = gnx_transaction_begin(gnx, &transaction);
+    RET_ON_ERR(err);
+
+    gnx_handle_t counter;
+    err = gnx_transaction_add_counter_hook(transaction, (void **)&orig, GNX_COUNT_CYCLES, &counter);
+    RET_ON_ERR(err);
+
+    err = gnx_transaction_commit(transaction);
+    RET_ON_ERR(err);
+
+    for (int i = 0; i < COUNTED_CALLS; i++)
+        p_twin(i, 2);
+
+    // Read the counters like a monitor would
+    HANDLE hMap = OpenFileMappingA(FILE_MAP_READ, FALSE, name);
+    const uint8_t *view = hMap != NULL ? (const uint8_t *)MapViewOfFile(hMap, FILE_MAP_READ, 0, 0, 0) : NULL;
+    if (view == NULL)
+    {
+        printf("Shared counters not found\n");
+        return GNX_ERR_FAILED;
+    }
+
+    const gnx_shared_counters_t *header = (const gnx_shared_counters_t *)view;
+    const gnx_shared_hook_t *hook = (const gnx_shared_hook_t *)(view + header->hooks_ofs);
+
+    uint64_t calls = 0, timed = 0;
+    for (uint32_t a = 0; a < header->nb_arrays; a++)
+    {
+        const gnx_hook_counters_t *counters = (const gnx_hook_counters_t *)(view + header->arrays_ofs + a * header->arrays_stride);
+        calls += counters[0].calls;
+        for (int j = 0; j < GNX_HOOK_HISTOGRAM_SIZE; j++)
+            timed += counters[0].histogram[j];
+    }
+
+    bool ok =       header->magic == GNX_SHARED_COUNTERS_MAGIC
+                &&  header->nb_hooks == 1
+                &&  hook->address == (uintptr_t)twin_add
+                &&  calls == COUNTED_CALLS
+                &&  timed == COUNTED_CALLS;
+
+    UnmapViewOfFile(view);
+    CloseHandle(hMap);
+
+    if (!ok)
+    {
+        printf("Wrong shared counters\n");
+        return GNX_ERR_FAILED;
+    }
+
+    gnx_thread_unregister(thread);
+
+    return gnx_close_ex(gnx, GNX_CLOSE_UNHOOK);
+}
+
+//-------------------------------------------------------------------------
+static uint32_t g_governed_sampling = GNX_SAMPLING_ALL;
+
+static void GANXO_API on_sampling_changed(
+    void *ctx,
+    gnx_handle_t counter,
+    uint32_t old_sampling,
+    uint32_t sampling)
+{
+    if (counter == *(gnx_handle_t *)ctx && old_sampling == g_governed_sampling)
+        g_governed_sampling = sampling;
+}
+
+static uint64_t timed_calls(const gnx_hook_counters_t *counts)
+{
+    uint64_t timed = 0;
+    for (int j = 0; j < GNX_HOOK_HISTOGRAM_SIZE; j++)
+        timed += counts->histogram[j];
+
+    return timed;
+}
+
+gnx_err_t test_governor()
+{
+    gnx_err_t err;
+    volatile twin_proto p_twin = twin_sub;
+    twin_proto orig = twin_sub;
+
+    gnx_handle_t gnx;
+    err = gnx_open(&gnx);
+    RET_ON_ERR(err);
+
+    gnx_handle_t thread;
+    err = gnx_thread_register(gnx, &thread);
+    RET_ON_ERR(err);
+
+    gnx_handle_t transaction;
+    err = gnx_transaction_begin(gnx, &transaction);
+    RET_ON_ERR(err);
+
+    gnx_handle_t counter;
+    err = gnx_transaction_add_counter_hook(transaction, (void **)&orig, GNX_COUNT_CYCLES, &counter);
+    RET_ON_ERR(err);
+
+    err = gnx_transaction_commit(transaction);
+    RET_ON_ERR(err);
+
+    // Calls costing far more than the budget: the hook is sampled as sparsely as allowed, then disabled
+    gnx_governor_options_t options = { 0 };
+    options.budget_permille = 1;
+    options.count_cost = 1000000;
+    options.timed_cost = 1000000;
+    options.max_sampling = 4;
+    options.callback = on_sampling_changed;
+    options.ctx = &counter;
+    err = gnx_governor_start(gnx, &options);
+    RET_ON_ERR(err);
+
+    for (int i = 0; i < COUNTED_CALLS; i++)
+        p_twin(i, 2);
+
+    err = gnx_governor_check(gnx);
+    RET_ON_ERR(err);
+
+    if (g_governed_sampling != GNX_SAMPLING_DISABLED)
+    {
+        printf("Hook not disabled by the governor\n");
+        return GNX_ERR_FAILED;
+    }
+
+    gnx_hook_counters_t before, after;
+    err = gnx_hook_get_counters(gnx, counter, &before);
+    RET_ON_ERR(err);
+
+    for (int i = 0; i < COUNTED_CALLS; i++)
+    {
+        if (p_twin(i, 2) != i - 2)
+        {
+            printf("Disabled hook changed the result\n");
+            return GNX_ERR_FAILED;
+        }
+    }
+
+    err = gnx_hook_get_counters(gnx, counter, &after);
+    RET_ON_ERR(err);
+
+    if (after.calls != before.calls)
+    {
+        printf("Disabled hook still counting\n");
+        return GNX_ERR_FAILED;
+    }
+
+    err = gnx_governor_stop(gnx);
+    RET_ON_ERR(err);
+
+    // Enabled again, timing 1 in 4 calls
+    err = gnx_hook_set_sampling(gnx, counter, 4);
+    RET_ON_ERR(err);
+
+    for (int i = 0; i < COUNTED_CALLS; i++)
+        p_twin(i, 2);
+
+    err = gnx_hook_get_counters(gnx, counter, &after);
+    RET_ON_ERR(err);
+
+    if (    after.calls != before.calls + COUNTED_CALLS
+        ||  timed_calls(&after) != timed_calls(&before) + COUNTED_CALLS / 4)
+    {
+        printf("Wrong sampled counts: %llu calls, %llu timed\n", after.calls - before.calls, timed_calls(&after) - timed_calls(&before));
+        return GNX_ERR_FAILED;
+    }
+
+    gnx_thread_unregister(thread);
+
+    return gnx_close_ex(gnx, GNX_CLOSE_UNHOOK);
+}
+
+//-------------------------------------------------------------------------
+typedef GNX_HOOK(&twin_add) twin_add_hook;
+
+int __stdcall my_typed_twin_add(int a, int b)
+{
+    return twin_add_hook::original(a, b) * 10;
+}
+
+struct twin_add_around
+{
+    static int entries;
+
+    static void on_entry(int, int)
+    {
+        ++entries;
+    }
+
+    static void on_exit(int &result, int, int)
+    {
+        result = -result;
+    }
+};
+
+int twin_add_around::entries = 0;
+
+// Reference parameters stay references through the generated thunk
+__declspec(noinline) void __stdcall ref_add(int &x, int n)
+{
+    for (int i = 0; i < n; i++)
+        ++x;
+}
+
+typedef GNX_HOOK(&ref_add) ref_add_hook;
+
+struct ref_add_around
+{
+    static void on_entry(int &x, int)
+    {
+        x *= 10;
+    }
+
+    static void on_exit(int &x, int)
+    {
+        x = -x;
+    }
+};
+
+gnx_err_t test_typed_hook(gnx_handle_t gnx)
+{
+    gnx_err_t err;
+    volatile twin_proto p_twin = twin_add;
+
+    // Typed detour calling the typed original
+    gnx_handle_t transaction;
+    err = gnx_transaction_begin(gnx, &transaction);
+    RET_ON_ERR(err);
+
+    err = twin_add_hook::add(transaction, my_typed_twin_add);
+    RET_ON_ERR(err);
+
+    err = gnx_transaction_commit(transaction);
+    RET_ON_ERR(err);
+
+    if (p_twin(1, 2) != 30)
+    {
+        printf("Typed hook not called\n");
+        return GNX_ERR_FAILED;
+    }
+
+    err = gnx_transaction_begin(gnx, &transaction);
+    RET_ON_ERR(err);
+
+    err = twin_add_hook::remove(transaction);
+    RET_ON_ERR(err);
+
+    err = gnx_transaction_commit(transaction);
+    RET_ON_ERR(err);
+
+    // Generated entry/exit thunk
+    err = gnx_transaction_begin(gnx, &transaction);
+    RET_ON_ERR(err);
+
+    err = twin_add_hook::add_around<twin_add_around>(transaction);
+    RET_ON_ERR(err);
+
+    err = gnx_transaction_commit(transaction);
+    RET_ON_ERR(err);
+
+    if (p_twin(1, 2) != -3 || twin_add_around::entries != 1 || twin_add_hook::original(1, 2) != 3)
+    {
+        printf("Typed entry/exit hook not called\n");
+        return GNX_ERR_FAILED;
+    }
+
+    err = gnx_transaction_begin(gnx, &transaction);
+    RET_ON_ERR(err);
+
+    err = twin_add_hook::remove(transaction);
+    RET_ON_ERR(err);
+
+    err = gnx_transaction_commit(transaction);
+    RET_ON_ERR(err);
+
+    if (p_twin(1, 2) != 3)
+    {
+        printf("Typed hook not removed\n");
+        return GNX_ERR_FAILED;
+    }
+
+    // The handlers and the original function see the caller's variable
+    err = gnx_transaction_begin(gnx, &transaction);
+    RET_ON_ERR(err);
+
+    err = ref_add_hook::add_around<ref_add_around>(transaction);
+    RET_ON_ERR(err);
+
+    err = gnx_transaction_commit(transaction);
+    RET_ON_ERR(err);
+
+    volatile decltype(&ref_add) p_ref_add = ref_add;
+    int x = 1;
+    p_ref_add(x, 2);
+    if (x != -12)
+    {
+        printf("Typed entry/exit hook copied a reference parameter: %d\n", x);
+        return GNX_ERR_FAILED;
+    }
+
+    err = gnx_transaction_begin(gnx, &transaction);
+    RET_ON_ERR(err);
+
+    err = ref_add_hook::remove(transaction);
+    RET_ON_ERR(err);
+
+    return gnx_transaction_commit(transaction);
+}
+
+//-------------------------------------------------------------------------
+static twin_proto orig_filtered = twin_sub;
+static int g_filtered_calls = 0;
+
+int __stdcall my_filtered_twin_sub(int a, int b)
+{
+    ++g_filtered_calls;
+    return orig_filtered(a, b);
+}
+
+gnx_err_t test_filtered_hook(gnx_handle_t gnx)
+{
+    gnx_err_t err;
+    volatile twin_proto p_twin = twin_sub;
+
+    gnx_handle_t transaction;
+    err = gnx_transaction_begin(gnx, &transaction);
+    RET_ON_ERR(err);
+
+    static const char *invalid_filters[] = { "arg0 == 7 &&", "arg0 == 0x100000000", "arg0 == 4294967296", "arg0 == 0x" };
+    for (int i = 0; i < _countof(invalid_filters); i++)
+    {
+        if (gnx_transaction_add_filtered_hook(transaction, (void **)&orig_filtered, my_filtered_twin_sub, invalid_filters[i]) != GNX_ERR_INVALID_ARGS)
+        {
+            printf("Invalid filter accepted: %s\n", invalid_filters[i]);
+            return GNX_ERR_FAILED;
+        }
+    }
+
+    // Leading zeros are decimal, not octal
+    err = gnx_transaction_add_filtered_hook(transaction, (void **)&orig_filtered, my_filtered_twin_sub, "arg0 == 010 || (arg1 & 0xFF00) > 0x300");
+    RET_ON_ERR(err);
+
+    err = gnx_transaction_commit(transaction);
+    RET_ON_ERR(err);
+
+    // Only the first two calls match
+    static const int args[][2] = { { 10, 1 }, { 1, 0x400 }, { 1, 0x3FF }, { 8, 5 } };
+    for (int i = 0; i < _countof(args); i++)
+    {
+        if (p_twin(args[i][0], args[i][1]) != args[i][0] - args[i][1])
+        {
+            printf("Filtered function result changed\n");
+            return GNX_ERR_FAILED;
+        }
+    }
+
+    if (g_filtered_calls != 2)
+    {
+        printf("Wrong filtered calls: %d\n", g_filtered_calls);
+        return GNX_ERR_FAILED;
+    }
+
+    err = gnx_transaction_begin(gnx, &transaction);
+    RET_ON_ERR(err);
+
+    err = gnx_transaction_remove_hook(transaction, (void **)&orig_filtered);
+    RET_ON_ERR(err);
+
+    return gnx_transaction_commit(transaction);
+}
+
+//-------------------------------------------------------------------------
+static twin_proto orig_thread_twin = twin_add;
+
+int __stdcall my_thread_twin_add(int a, int b)
+{
+    return orig_thread_twin(a, b) * 10;
+}
+
+static DWORD WINAPI thread_hook_other_thread(LPVOID param)
+{
+    volatile twin_proto p_twin = twin_add;
+    return p_twin(1, 2);
+}
+
+gnx_err_t test_thread_hook(gnx_handle_t gnx)
+{
+    gnx_err_t err;
+    volatile twin_proto p_twin = twin_add;
+
+    gnx_handle_t transaction;
+    err = gnx_transaction_begin(gnx, &transaction);
+    RET_ON_ERR(err);
+
+    gnx_handle_t thread_hook;
+    err = gnx_transaction_add_thread_hook(transaction, (void **)&orig_thread_twin, my_thread_twin_add, &thread_hook);
+    RET_ON_ERR(err);
+
+    err = gnx_transaction_commit(transaction);
+    RET_ON_ERR(err);
+
+    // Not enabled for any thread yet
+    if (p_twin(1, 2) != 3)
+    {
+        printf("Thread hook called before being enabled\n");
+        return GNX_ERR_FAILED;
+    }
+
+    err = gnx_hook_thread_enable(thread_hook, true);
+    RET_ON_ERR(err);
+
+    HANDLE hThread = CreateThread(NULL, 0, thread_hook_other_thread, NULL, 0, NULL);
+    WaitForSingleObject(hThread, INFINITE);
+
+    DWORD other_result = 0;
+    GetExitCodeThread(hThread, &other_result);
+    CloseHandle(hThread);
+
+    if (p_twin(1, 2) != 30 || other_result != 3)
+    {
+        printf("Thread hook not scoped to the enabled thread\n");
+        return GNX_ERR_FAILED;
+    }
+
+    err = gnx_hook_thread_enable(thread_hook, false);
+    RET_ON_ERR(err);
+
+    if (p_twin(1, 2) != 3)
+    {
+        printf("Thread hook still called once disabled\n");
+        return GNX_ERR_FAILED;
+    }
+
+    err = gnx_transaction_begin(gnx, &transaction);
+    RET_ON_ERR(err);
+
+    err = gnx_transaction_remove_hook(transaction, (void **)&orig_thread_twin);
+    RET_ON_ERR(err);
+
+    return gnx_transaction_commit(transaction);
+}
+
+//-------------------------------------------------------------------------
+// The guarded hooks call the hooked functions again: through the hooks, without the guard
+static volatile twin_proto g_guarded_add = twin_add, g_guarded_sub = twin_sub;
+static twin_proto orig_guarded_add = twin_add, orig_guarded_sub = twin_sub;
+static int g_guarded_calls = 0;
+
+int __stdcall my_guarded_add(int a, int b)
+{
+    ++g_guarded_calls;
+    return g_guarded_add(a, b) * 10;
+}
+
+int __stdcall my_guarded_sub(int a, int b)
+{
+    ++g_guarded_calls;
+    return g_guarded_sub(a, b) * 10 + g_guarded_add(a, b);
+}
+
+gnx_err_t test_guarded_hook(gnx_handle_t gnx)
+{
+    gnx_err_t err;
+
+    gnx_handle_t transaction;
+    err = gnx_transaction_begin(gnx, &transaction);
+    RET_ON_ERR(err);
+
+    err = gnx_transaction_add_guarded_hook(transaction, (void **)&orig_guarded_add, my_guarded_add, 0);
+    RET_ON_ERR(err);
+
+    err = gnx_transaction_add_guarded_hook(transaction, (void **)&orig_guarded_sub, my_guarded_sub, 0);
+    RET_ON_ERR(err);
+
+    err = gnx_transaction_commit(transaction);
+    RET_ON_ERR(err);
+
+    // Each call runs a single hook, the second call of twin_add is hooked again
+    if (    g_guarded_add(5, 2) != 70
+        ||  g_guarded_sub(5, 2) != 37
+        ||  g_guarded_add(5, 2) != 70)
+    {
+        printf("Guarded function result changed\n");
+        return GNX_ERR_FAILED;
+    }
+
+    if (g_guarded_calls != 3)
+    {
+        printf("Wrong guarded calls: %d\n", g_guarded_calls);
+        return GNX_ERR_FAILED;
+    }
+
+    err = gnx_transaction_begin(gnx, &transaction);
+    RET_ON_ERR(err);
+
+    err = gnx_transaction_remove_hook(transaction, (void **)&orig_guarded_add);
+    RET_ON_ERR(err);
+
+    err = gnx_transaction_remove_hook(transaction, (void **)&orig_guarded_sub);
+    RET_ON_ERR(err);
+
+    return gnx_transaction_commit(transaction);
+}
+
+//-------------------------------------------------------------------------
+static twin_proto orig_mapped_add = twin_add;
+static int g_mapped_springboards = 0;
+static const void *g_mapped_start = NULL;
+
+static void GANXO_API on_code_map(
+    void *ctx,
+    const void *start,
+    size_t size,
+    const char *name,
+    bool removed)
+{
+    if (!removed && strncmp(name, "gnx_springboard:", 16) == 0 && strstr(name, ".exe+0x") != NULL)
+    {
+        ++g_mapped_springboards;
+        g_mapped_start = start;
+    }
+}
+
+gnx_err_t test_code_map(gnx_handle_t gnx)
+{
+    gnx_err_t err;
+
+    // No file: only the callback
+    gnx_code_map_options_t options = { "", on_code_map, NULL };
+    err = gnx_code_map_start(gnx, &options);
+    RET_ON_ERR(err);
+
+    gnx_handle_t transaction;
+    err = gnx_transaction_begin(gnx, &transaction);
+    RET_ON_ERR(err);
+
+    err = gnx_transaction_add_hook(transaction, (void **)&orig_mapped_add, my_twin_add);
+    RET_ON_ERR(err);
+
+    err = gnx_transaction_commit(transaction);
+    RET_ON_ERR(err);
+
+    if (g_mapped_springboards != 1 || g_mapped_start != (const void *)orig_mapped_add)
+    {
+        printf("Springboard not described to the code map\n");
+        return GNX_ERR_FAILED;
+    }
+
+    err = gnx_code_map_stop(gnx);
+    RET_ON_ERR(err);
+
+    err = gnx_transaction_begin(gnx, &transaction);
+    RET_ON_ERR(err);
+
+    err = gnx_transaction_remove_hook(transaction, (void **)&orig_mapped_add);
+    RET_ON_ERR(err);
+
+    return gnx_transaction_commit(transaction);
+}
+
+//-------------------------------------------------------------------------
+int main()
+{
+    GetModuleFileNameA(
+        GetModuleHandle(NULL),
+        g_szExeName,
+        _countof(g_szExeName));
+
+    gnx_err_t err = gnx_init();
+
+    if (err != GNX_ERR_OK)
+    {
+        printf("Failed to initialize!\n");
+        return -1;
+    }
+
+    // Create a new workspace instance
+    gnx_handle_t gnx;
+    if (gnx_open(&gnx) != GNX_ERR_OK)
+    {
+        printf("Failed to create workspace\n");
+        return -1;
+    }
+
+    err = test_hook_unhook_complete(gnx);
+    RET_ON_ERR(err);
+
+    err = test_hook_abort(gnx);
+    RET_ON_ERR(err);
+
+    err = test_mixed_hook_unhook_complete(gnx);
+    RET_ON_ERR(err);
+
+    err = test_hook2_unhook2_complete(gnx);
+    RET_ON_ERR(err);
+
+    err = test_leaf_hook_unhook(gnx);
+    RET_ON_ERR(err);
+
+    err = test_springboard_cache(gnx);
+    RET_ON_ERR(err);
+
+    err = test_overlapping_hooks(gnx);
+    RET_ON_ERR(err);
+
+    err = test_plan_export_load(gnx);
+    RET_ON_ERR(err);
+
+    err = test_bulk_hooks(gnx);
+    RET_ON_ERR(err);
+
+    err = test_live_commit(gnx);
+    RET_ON_ERR(err);
+
+    err = test_stop_threads_commit(gnx);
+    RET_ON_ERR(err);
+
+    err = test_slot_hook(gnx);
+    RET_ON_ERR(err);
+
+    err = test_hook_chain(gnx);
+    RET_ON_ERR(err);
+
+    err = test_hook_index(gnx);
+    RET_ON_ERR(err);
+
+    err = test_untracked_reclaim();
+    RET_ON_ERR(err);
+
+    err = test_unhook_churn(gnx);
+    RET_ON_ERR(err);
+
+    err = test_commit_async(gnx);
+    RET_ON_ERR(err);
+
+    err = test_overlapping_commits(gnx);
+    RET_ON_ERR(err);
+
+    err = test_iat_hook(gnx);
+    RET_ON_ERR(err);
+
+    err = test_resolve_symbols();
+    RET_ON_ERR(err);
+
+    err = test_pending_hooks(gnx);
+    RET_ON_ERR(err);
+
+    err = test_close_unhook();
+    RET_ON_ERR(err);
+
+    err = test_counter_hook();
+    RET_ON_ERR(err);
+
+    err = test_trace_hook();
+    RET_ON_ERR(err);
+
+    err = test_stdcall_timed_nesting();
+    RET_ON_ERR(err);
+
+    err = test_stdcall_traced_nesting();
+    RET_ON_ERR(err);
+
+    err = test_shared_counters();
+    RET_ON_ERR(err);
+
+    err = test_governor();
+    RET_ON_ERR(err);
+
+    err = test_typed_hook(gnx);
+    RET_ON_ERR(err);
+
+    err = test_filtered_hook(gnx);
+    RET_ON_ERR(err);
+
+    err = test_thread_hook(gnx);
+    RET_ON_ERR(err);
+
+    err = test_guarded_hook(gnx);
+    RET_ON_ERR(err);
+
+    err = test_code_map(gnx);
+    RET_ON_ERR(err);
+
+    gnx_close(gnx);
+
+    return 0;
 }
\ No newline at end of file
@@ -1,16 +1,17 @@
-// stdafx.h : include file for standard system include files,
-// or project specific include files that are used frequently, but
-// are changed infrequently
-//
-
-#pragma once
-
-#include <stdio.h>
-#include <tchar.h>
-#include <windows.h>
-#include <stdlib.h>
-#include <assert.h>
-#include <inttypes.h>
-extern "C" {
-    #include <ganxo.h>
-}
\ No newline at end of file
+// stdafx.h : include file for standard system include files,
+// or project specific include files that are used frequently, but
+// are changed infrequently
+//
+
+#pragma once
+
+#include <stdio.h>
+#include <tchar.h>
+#include <windows.h>
+#include <stdlib.h>
+#include <assert.h>
+#include <inttypes.h>
+extern "C" {
+    #include <ganxo.h>
+}
+#include <ganxo.hpp>
\ No newline at end of file
@@ -1,21 +1,21 @@
-// stdafx.h : include file for standard system include files,
-// or project specific include files that are used frequently, but
-// are changed infrequently
-//
-
-#pragma once
-
-#include <stdio.h>
-#include <tchar.h>
-#include <windows.h>
-#include <string>
-#include <memory>
-#include <assert.h>
-#include <list>
-#include <algorithm>
-#include <inttypes.h>
-#include <fstream>
-#include <iostream>
-extern "C" {
-    #include <ganxo.h>
+// stdafx.h : include file for standard system include files,
+// or project specific include files that are used frequently, but
+// are changed infrequently
+//
+
+#pragma once
+
+#include <stdio.h>
+#include <tchar.h>
+#include <windows.h>
+#include <string>
+#include <memory>
+#include <assert.h>
+#include <list>
+#include <algorithm>
+#include <inttypes.h>
+#include <fstream>
+#include <iostream>
+extern "C" {
+    #include <ganxo.h>
 }
\ No newline at end of file
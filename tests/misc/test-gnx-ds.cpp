@@ -1,132 +1,172 @@
-namespace singly_list_test
-{
-//--------------------------------------------------------------------------
-struct my_struct
-{
-    char id;
-    GNX_SINGLY_LIST_ITEM_DEFINE;
-    int a;
-    my_struct(char a)
-    {
-        static int id = 0;
-        this->id = ++id;
-        this->a = a;
-    }
-};
-
-//--------------------------------------------------------------------------
-void create(gnx_singly_list_item_t *head)
-{
-    gnx_singly_list_init(head);
-    GNX_SINGLY_LIST_ITEM_PUSH(
-        head,
-        new my_struct('A'));
-
-    GNX_SINGLY_LIST_ITEM_PUSH(
-        head,
-        new my_struct('B'));
-
-    GNX_SINGLY_LIST_ITEM_PUSH(
-        head,
-        new my_struct('C'));
-
-    GNX_SINGLY_LIST_ITEM_PUSH(
-        head,
-        new my_struct('D'));
-}
-
-//--------------------------------------------------------------------------
-void test_push_pop()
-{
-    GNX_SINGLY_LIST_DECLARE(head);
-    create(&head);
-    auto s = GNX_SINGLY_LIST_ITEM_POP(&head, my_struct);
-
-    s = GNX_SINGLY_LIST_ITEM_POP(&head, my_struct);
-    s = GNX_SINGLY_LIST_ITEM_POP(&head, my_struct);
-    s = GNX_SINGLY_LIST_ITEM_POP(&head, my_struct);
-}
-
-//--------------------------------------------------------------------------
-void iterate(gnx_singly_list_item_t *head)
-{
-    for (auto cur = head->next; cur != NULL; cur = cur->next)
-    {
-        my_struct *s = GNX_SINGLY_LIST_RECORD(cur, my_struct);
-        printf("id = %c\n", s->a);
-    }
-}
-
-//--------------------------------------------------------------------------
-void delete_all(gnx_singly_list_item_t *head)
-{
-    for (auto cur = head->next; cur != NULL; )
-    {
-        my_struct *s = GNX_SINGLY_LIST_RECORD(cur, my_struct);
-        cur = cur->next;
-        delete s;
-    }
-    head->next = NULL;
-}
-
-//--------------------------------------------------------------------------
-void test_push_remove()
-{
-    GNX_SINGLY_LIST_DECLARE(head);
-    create(&head);
-
-    // Initial list
-    printf("Initial list:\n");
-    iterate(&head);
-
-    // Remove the last entry
-    auto entry = head.next;
-    my_struct *s = GNX_SINGLY_LIST_RECORD(
-        entry, 
-        my_struct);
-
-    gnx_singly_list_remove(
-        &head, 
-        entry);
-    delete s;
-
-    // Remove the first entry
-    printf("After last removal:\n");
-    iterate(&head);
-
-    // Get the first item
-    entry = head.next->next->next;
-    s = GNX_SINGLY_LIST_RECORD(
-        entry,
-        my_struct);
-    gnx_singly_list_remove(
-        &head,
-        entry);
-
-    printf("After head removal:\n");
-    iterate(&head);
-    delete_all(&head);
-    iterate(&head);
-
-    // Re-create anew
-    printf("Recreated list:\n");
-    create(&head);
-    iterate(&head);
-
-    printf("Remove from the middle:\n");
-    entry = head.next->next;
-    s = GNX_SINGLY_LIST_RECORD(
-        entry,
-        my_struct);
-
-    gnx_singly_list_remove(
-        &head,
-        entry
-    );
-    printf("s=%c\n", s->a);
-    delete s;
-
-    iterate(&head);
-}
-
-} // namespace
\ No newline at end of file
+namespace singly_list_test
+{
+//--------------------------------------------------------------------------
+struct my_struct
+{
+    char id;
+    GNX_SINGLY_LIST_ITEM_DEFINE;
+    int a;
+    my_struct(char a)
+    {
+        static int id = 0;
+        this->id = ++id;
+        this->a = a;
+    }
+};
+
+//--------------------------------------------------------------------------
+void create(gnx_singly_list_item_t *head)
+{
+    gnx_singly_list_init(head);
+    GNX_SINGLY_LIST_ITEM_PUSH(
+        head,
+        new my_struct('A'));
+
+    GNX_SINGLY_LIST_ITEM_PUSH(
+        head,
+        new my_struct('B'));
+
+    GNX_SINGLY_LIST_ITEM_PUSH(
+        head,
+        new my_struct('C'));
+
+    GNX_SINGLY_LIST_ITEM_PUSH(
+        head,
+        new my_struct('D'));
+}
+
+//--------------------------------------------------------------------------
+void test_push_pop()
+{
+    GNX_SINGLY_LIST_DECLARE(head);
+    create(&head);
+    auto s = GNX_SINGLY_LIST_ITEM_POP(&head, my_struct);
+
+    s = GNX_SINGLY_LIST_ITEM_POP(&head, my_struct);
+    s = GNX_SINGLY_LIST_ITEM_POP(&head, my_struct);
+    s = GNX_SINGLY_LIST_ITEM_POP(&head, my_struct);
+}
+
+//--------------------------------------------------------------------------
+void iterate(gnx_singly_list_item_t *head)
+{
+    for (auto cur = head->next; cur != NULL; cur = cur->next)
+    {
+        my_struct *s = GNX_SINGLY_LIST_RECORD(cur, my_struct);
+        printf("id = %c\n", s->a);
+    }
+}
+
+//--------------------------------------------------------------------------
+void delete_all(gnx_singly_list_item_t *head)
+{
+    for (auto cur = head->next; cur != NULL; )
+    {
+        my_struct *s = GNX_SINGLY_LIST_RECORD(cur, my_struct);
+        cur = cur->next;
+        delete s;
+    }
+    head->next = NULL;
+}
+
+//--------------------------------------------------------------------------
+void test_push_remove()
+{
+    GNX_SINGLY_LIST_DECLARE(head);
+    create(&head);
+
+    // Initial list
+    printf("Initial list:\n");
+    iterate(&head);
+
+    // Remove the last entry
+    auto entry = head.next;
+    my_struct *s = GNX_SINGLY_LIST_RECORD(
+        entry, 
+        my_struct);
+
+    gnx_singly_list_remove(
+        &head, 
+        entry);
+    delete s;
+
+    // Remove the first entry
+    printf("After last removal:\n");
+    iterate(&head);
+
+    // Get the first item
+    entry = head.next->next->next;
+    s = GNX_SINGLY_LIST_RECORD(
+        entry,
+        my_struct);
+    gnx_singly_list_remove(
+        &head,
+        entry);
+
+    printf("After head removal:\n");
+    iterate(&head);
+    delete_all(&head);
+    iterate(&head);
+
+    // Re-create anew
+    printf("Recreated list:\n");
+    create(&head);
+    iterate(&head);
+
+    printf("Remove from the middle:\n");
+    entry = head.next->next;
+    s = GNX_SINGLY_LIST_RECORD(
+        entry,
+        my_struct);
+
+    gnx_singly_list_remove(
+        &head,
+        entry
+    );
+    printf("s=%c\n", s->a);
+    delete s;
+
+    iterate(&head);
+}
+
+} // namespace
+namespace range_map_test
+{
+//--------------------------------------------------------------------------
+void test_update_find()
+{
+    static uint8_t mem[0x100];
+
+    gnx_handle_t map = gnx_range_map_create();
+
+    gnx_range_t added[3] =
+    {
+        { mem + 0x80, 0x10, (void *)3 },
+        { mem + 0x00, 0x10, (void *)1 },
+        { mem + 0x40, 0x08, (void *)2 },
+    };
+    gnx_range_map_update(map, added, _countof(added), NULL, 0);
+
+    gnx_range_t range;
+    printf("find(0x04) = %d\n", gnx_range_map_find(map, mem + 0x04, &range) && range.value == (void *)1);
+    printf("find(0x47) = %d\n", gnx_range_map_find(map, mem + 0x47, &range) && range.value == (void *)2);
+    printf("find(0x48) = %d (expected 0)\n", gnx_range_map_find(map, mem + 0x48, &range));
+
+    // Overlapping ranges are refused
+    gnx_range_t overlap = { mem + 0x44, 0x10, (void *)4 };
+    printf("overlap = %d (expected %d)\n", gnx_range_map_update(map, &overlap, 1, NULL, 0), GNX_ERR_INVALID_ARGS);
+
+    // Replace a range
+    const void *removed[1] = { mem + 0x40 };
+    gnx_range_map_update(map, &overlap, 1, removed, 1);
+    printf("find(0x50) = %d\n", gnx_range_map_find(map, mem + 0x50, &range) && range.value == (void *)4);
+
+    // Sorted copy
+    gnx_range_t copy[3];
+    size_t nb_ranges = gnx_range_map_copy(map, copy, _countof(copy));
+    printf("copy = %d\n", nb_ranges == 3 && copy[0].value == (void *)1 && copy[1].value == (void *)4 && copy[2].value == (void *)3);
+
+    gnx_range_map_free(map);
+}
+
+} // namespace
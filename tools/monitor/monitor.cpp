@@ -0,0 +1,179 @@
+#include "stdafx.h"
+
+//-------------------------------------------------------------------------
+// Ganxo counters monitor: maps the shared counters of a process (gnx_counters_share) read-only
+// and prints its top hooks by calls and by cycles. It never calls into the monitored process.
+//
+// Usage: monitor <shared memory name> [top count] [period in ms]
+//-------------------------------------------------------------------------
+
+/// Summed counts of a hook
+struct hook_sample_t
+{
+    const gnx_shared_hook_t *hook;
+    gnx_hook_counters_t counts;
+};
+
+//-------------------------------------------------------------------------
+static int compare_calls(const void *a, const void *b)
+{
+    uint64_t ca = ((const hook_sample_t *)a)->counts.calls, cb = ((const hook_sample_t *)b)->counts.calls;
+    return ca > cb ? -1 : (ca < cb ? 1 : 0);
+}
+
+//-------------------------------------------------------------------------
+static int compare_cycles(const void *a, const void *b)
+{
+    uint64_t ca = ((const hook_sample_t *)a)->counts.cycles, cb = ((const hook_sample_t *)b)->counts.cycles;
+    return ca > cb ? -1 : (ca < cb ? 1 : 0);
+}
+
+//-------------------------------------------------------------------------
+// Sum the counters of each hook over all the counters arrays
+static size_t sample(
+    const gnx_shared_counters_t *header,
+    hook_sample_t *samples)
+{
+    const uint8_t *base = (const uint8_t *)header;
+    const gnx_shared_hook_t *hooks = (const gnx_shared_hook_t *)(base + header->hooks_ofs);
+
+    size_t nb_hooks = header->nb_hooks;
+    for (size_t i = 0; i < nb_hooks; i++)
+    {
+        samples[i].hook = &hooks[i];
+        memset(&samples[i].counts, 0, sizeof(samples[i].counts));
+    }
+
+    for (uint32_t a = 0; a < header->nb_arrays; a++)
+    {
+        const gnx_hook_counters_t *counters = (const gnx_hook_counters_t *)(base + header->arrays_ofs + a * header->arrays_stride);
+        for (size_t i = 0; i < nb_hooks; i++)
+        {
+            samples[i].counts.calls += counters[i].calls;
+            samples[i].counts.cycles += counters[i].cycles;
+            for (int j = 0; j < GNX_HOOK_HISTOGRAM_SIZE; j++)
+                samples[i].counts.histogram[j] += counters[i].histogram[j];
+        }
+    }
+
+    return nb_hooks;
+}
+
+//-------------------------------------------------------------------------
+static void print_top(
+    const char *title,
+    hook_sample_t *samples,
+    size_t nb_samples,
+    size_t top,
+    int (__cdecl *compare)(const void *, const void *))
+{
+    qsort(samples, nb_samples, sizeof(hook_sample_t), compare);
+
+    printf("Top %u hooks by %s:\n", (unsigned)top, title);
+    printf("  %-40s %14s %16s %10s  histogram (16^i cycles)\n", "function", "calls", "cycles", "cycles/call");
+
+    for (size_t i = 0; i < nb_samples && i < top; i++)
+    {
+        const hook_sample_t *s = &samples[i];
+
+        char name[64];
+        if (s->hook->module[0] != '\0')
+            sprintf_s(name, "%.47s+0x%x", s->hook->module, s->hook->rva);
+        else
+            sprintf_s(name, "0x%" PRIx64, s->hook->address);
+
+        // The cycles only cover the timed calls (all of them unless sampled)
+        uint64_t timed = 0;
+        for (int j = 0; j < GNX_HOOK_HISTOGRAM_SIZE; j++)
+            timed += s->counts.histogram[j];
+
+        printf("  %-40s %14" PRIu64 " %16" PRIu64 " %10" PRIu64 " ",
+            name,
+            s->counts.calls,
+            s->counts.cycles,
+            timed != 0 ? s->counts.cycles / timed : 0);
+
+        for (int j = 0; j < GNX_HOOK_HISTOGRAM_SIZE; j++)
+            printf(" %u", s->counts.histogram[j]);
+
+        printf("\n");
+    }
+}
+
+//-------------------------------------------------------------------------
+static void print_stats(const gnx_shared_counters_t *header)
+{
+    // Read again if the process updated them meanwhile
+    gnx_stats_t stats;
+    uint32_t seq;
+    do
+    {
+        seq = header->stats_seq;
+        MemoryBarrier();
+        stats = header->stats;
+        MemoryBarrier();
+    } while ((seq & 1) != 0 || seq != header->stats_seq);
+
+    printf("Commits: last pause %" PRIu64 " us, max pause %" PRIu64 " us, %u ip fixups, %u springboards in limbo\n",
+        stats.last_pause_us,
+        stats.max_pause_us,
+        stats.nb_ip_fixups,
+        stats.nb_limbo);
+}
+
+//-------------------------------------------------------------------------
+int main(int argc, char *argv[])
+{
+    if (argc < 2)
+    {
+        printf("Usage: monitor <shared memory name> [top count] [period in ms]\n");
+        return -1;
+    }
+
+    size_t top = argc > 2 ? strtoul(argv[2], NULL, 0) : 10;
+    DWORD period = argc > 3 ? strtoul(argv[3], NULL, 0) : 0;
+
+    HANDLE hMap = OpenFileMappingA(FILE_MAP_READ, FALSE, argv[1]);
+    if (hMap == NULL)
+    {
+        printf("Cannot open the shared memory '%s'\n", argv[1]);
+        return -1;
+    }
+
+    const gnx_shared_counters_t *header = (const gnx_shared_counters_t *)MapViewOfFile(hMap, FILE_MAP_READ, 0, 0, 0);
+    if (header == NULL)
+    {
+        printf("Cannot map the shared memory\n");
+        return -1;
+    }
+
+    // The layout is described by the header: only its version must be known
+    if (    header->magic != GNX_SHARED_COUNTERS_MAGIC
+        ||  header->version != GNX_SHARED_COUNTERS_VERSION
+        ||  header->hook_size != sizeof(gnx_shared_hook_t)
+        ||  header->counter_size != sizeof(gnx_hook_counters_t))
+    {
+        printf("Unknown shared counters layout\n");
+        return -1;
+    }
+
+    hook_sample_t *samples = new hook_sample_t[header->max_hooks];
+
+    do
+    {
+        size_t nb_samples = sample(header, samples);
+
+        print_stats(header);
+        print_top("calls", samples, nb_samples, top, compare_calls);
+        print_top("cycles", samples, nb_samples, top, compare_cycles);
+        printf("\n");
+
+        Sleep(period);
+    } while (period != 0);
+
+    delete [] samples;
+    UnmapViewOfFile(header);
+    CloseHandle(hMap);
+
+    return 0;
+}